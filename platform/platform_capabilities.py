@@ -57,6 +57,9 @@ master_capability_set = {
     "HAS_ORIENTATION_MANAGER",
     "HAS_PRESSURE_SENSOR",
     "HAS_MODDABLE_XS",
+    "HAS_PFS_NAME_INDEX",
+    "HAS_FAST_CRC32",
+    "HAS_FLASH_READ_CACHE",
 }
 
 board_capability_dicts = [
@@ -83,6 +86,9 @@ board_capability_dicts = [
             "USE_PARALLEL_FLASH",
             "HAS_WEATHER",
             "HAS_FPGA_DISPLAY",
+            "HAS_PFS_NAME_INDEX",
+            "HAS_FLASH_READ_CACHE",
+            "HAS_FAST_CRC32",
         },
     },
     {
@@ -112,6 +118,9 @@ board_capability_dicts = [
             "HAS_FPGA_DISPLAY",
             "HAS_APP_SCALING",
             "HAS_MODDABLE_XS",
+            "HAS_PFS_NAME_INDEX",
+            "HAS_FLASH_READ_CACHE",
+            "HAS_FAST_CRC32",
         },
     },
     {
@@ -135,6 +144,9 @@ board_capability_dicts = [
             "USE_PARALLEL_FLASH",
             "HAS_WEATHER",
             "HAS_FPGA_DISPLAY",
+            "HAS_PFS_NAME_INDEX",
+            "HAS_FLASH_READ_CACHE",
+            "HAS_FAST_CRC32",
         },
     },
     {
@@ -158,6 +170,9 @@ board_capability_dicts = [
             "USE_PARALLEL_FLASH",
             "HAS_WEATHER",
             "HAS_FPGA_DISPLAY",
+            "HAS_PFS_NAME_INDEX",
+            "HAS_FLASH_READ_CACHE",
+            "HAS_FAST_CRC32",
         },
     },
     {
@@ -185,6 +200,9 @@ board_capability_dicts = [
             "HAS_FPGA_DISPLAY",
             "HAS_APP_SCALING",
             "HAS_MODDABLE_XS",
+            "HAS_PFS_NAME_INDEX",
+            "HAS_FLASH_READ_CACHE",
+            "HAS_FAST_CRC32",
         },
     },
     {
@@ -288,6 +306,9 @@ board_capability_dicts = [
             "HAS_APP_SCALING",
             "HAS_ORIENTATION_MANAGER",
             "HAS_MODDABLE_XS",
+            "HAS_PFS_NAME_INDEX",
+            "HAS_FLASH_READ_CACHE",
+            "HAS_FAST_CRC32",
         },
     },
     {
@@ -315,6 +336,9 @@ board_capability_dicts = [
             "HAS_APP_SCALING",
             "HAS_ORIENTATION_MANAGER",
             "HAS_MODDABLE_XS",
+            "HAS_PFS_NAME_INDEX",
+            "HAS_FLASH_READ_CACHE",
+            "HAS_FAST_CRC32",
         },
     },
 ]
@@ -3,7 +3,6 @@
 
 #include "kernel/event_loop.h"
 #include "kernel/events.h"
-#include "kernel/pbl_malloc.h"
 
 #include "services/common/comm_session/session_transport.h"
 
@@ -16,11 +15,15 @@
 #include "drivers/qemu/qemu_serial_private.h"
 
 #include "util/math.h"
+#include "util/size.h"
 
 #include <bluetooth/qemu_transport.h>
 
 #include <string.h>
 
+//! The number of contiguous buffers that get sent out in one QEMU packet
+#define QEMU_TRANSPORT_MAX_MBUFS (8)
+
 typedef struct {
   CommSession *session;
 } QemuTransport;
@@ -41,20 +44,17 @@ static void prv_send_next(Transport *transport) {
   CommSession *session = s_transport.session;
   PBL_ASSERTN(session);
   size_t bytes_remaining = comm_session_send_queue_get_length(session);
-  if (bytes_remaining == 0) {
-    return;
-  }
-
-  const size_t temp_buffer_size = MIN(bytes_remaining, QEMU_MAX_DATA_LEN);
-  uint8_t *temp_buffer = kernel_malloc_check(temp_buffer_size);
   while (bytes_remaining) {
-    const size_t bytes_to_copy = MIN(bytes_remaining, temp_buffer_size);
-    comm_session_send_queue_copy(session, 0 /* start_offset */, bytes_to_copy, temp_buffer);
-    qemu_serial_send(QemuProtocol_SPP, temp_buffer, bytes_to_copy);
-    comm_session_send_queue_consume(session, bytes_to_copy);
-    bytes_remaining -= bytes_to_copy;
+    // Point the serial driver straight at the queued messages instead of copying them out first
+    MBuf chain[QEMU_TRANSPORT_MAX_MBUFS];
+    const size_t bytes_to_send =
+        comm_session_send_queue_get_mbufs(session, 0 /* start_offset */,
+                                          MIN(bytes_remaining, QEMU_MAX_DATA_LEN),
+                                          chain, ARRAY_LENGTH(chain));
+    qemu_serial_send_mbuf_chain(QemuProtocol_SPP, chain);
+    comm_session_send_queue_consume(session, bytes_to_send);
+    bytes_remaining -= bytes_to_send;
   }
-  kernel_free(temp_buffer);
 }
 
 // -----------------------------------------------------------------------------------------
@@ -33,16 +33,3 @@ void framebuffer_clear(FrameBuffer *f) {
   framebuffer_dirty_all(f);
   f->is_dirty = true;
 }
-
-void framebuffer_mark_dirty_rect(FrameBuffer *f, GRect rect) {
-  if (!f->is_dirty) {
-    f->dirty_rect = rect;
-  } else {
-    f->dirty_rect = grect_union(&f->dirty_rect, &rect);
-  }
-
-  const GRect clip_rect = (GRect) { GPointZero, f->size };
-  grect_clip(&f->dirty_rect, &clip_rect);
-
-  f->is_dirty = true;
-}
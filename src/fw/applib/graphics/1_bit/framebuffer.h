@@ -9,10 +9,16 @@
 #define FRAMEBUFFER_BYTES_PER_ROW (FRAMEBUFFER_WORDS_PER_ROW * 4)
 #define FRAMEBUFFER_SIZE_BYTES (DISP_ROWS * FRAMEBUFFER_BYTES_PER_ROW)
 
+//! Number of disjoint dirty row spans tracked before neighbouring spans get merged
+#define FRAMEBUFFER_MAX_DIRTY_ROW_SPANS 4
+
 typedef struct FrameBuffer {
   uint32_t buffer[FRAMEBUFFER_SIZE_DWORDS];
   GSize size;
   GRect dirty_rect; //<! Smallest rect covering all dirty pixels.
+  //! Sorted, disjoint row spans covering all dirty pixels.
+  GRangeVertical dirty_rows[FRAMEBUFFER_MAX_DIRTY_ROW_SPANS];
+  uint8_t num_dirty_row_spans;
   bool is_dirty;
 } FrameBuffer;
 
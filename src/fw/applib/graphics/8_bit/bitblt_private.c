@@ -7,9 +7,12 @@
 #include "system/passert.h"
 #include "system/profiler.h"
 #include "util/graphics.h"
+#include "util/attributes.h"
 #include "util/bitset.h"
 #include "util/math.h"
 
+#include <string.h>
+
 #if !defined(__clang__)
 #pragma GCC optimize("O2")
 #endif
@@ -126,6 +129,61 @@ void bitblt_bitmap_into_bitmap_tiled_palette_to_8bit(GBitmap* dest_bitmap,
   }
 }
 
+// Masks for the 2-bit alpha component of four GColor8 pixels packed into a word
+#define WORD_ALPHA_HI_BITS 0x80808080
+#define WORD_ALPHA_LO_BITS 0x40404040
+#define WORD_PIXEL_LSBS    0x01010101
+
+static ALWAYS_INLINE uint32_t prv_load_word(const uint8_t *p) {
+  uint32_t word;
+  memcpy(&word, p, sizeof(word));
+  return word;
+}
+
+static ALWAYS_INLINE void prv_store_word(uint8_t *p, uint32_t word) {
+  memcpy(p, &word, sizeof(word));
+}
+
+// GCompOpSet for a contiguous run of pixels.
+// gcolor_alpha_blend() returns the dest for alpha 0 and the src for alpha 3, so a word whose
+// pixels are all either fully transparent or fully opaque reduces to a byte-wise select of src
+// over dest. Only words containing partially transparent pixels fall back to the blending LUT.
+static void prv_set_run(uint8_t *dest, const uint8_t *src, int16_t num_pixels) {
+  int16_t i = 0;
+  for (; i + 4 <= num_pixels; i += 4) {
+    const uint32_t src_word = prv_load_word(&src[i]);
+    const uint32_t alpha_hi = (src_word & WORD_ALPHA_HI_BITS) >> 7;
+    const uint32_t alpha_lo = (src_word & WORD_ALPHA_LO_BITS) >> 6;
+    if ((alpha_hi ^ alpha_lo) != 0) {
+      // At least one pixel has alpha 1 or 2 and needs blending
+      for (int j = i; j < i + 4; ++j) {
+        dest[j] = gcolor_alpha_blend((GColor8)src[j], (GColor8)dest[j]).argb;
+      }
+      continue;
+    }
+    if (alpha_hi == WORD_PIXEL_LSBS) {
+      prv_store_word(&dest[i], src_word);
+    } else if (alpha_hi != 0) {
+      const uint32_t opaque_mask = alpha_hi * 0xff;
+      const uint32_t dest_word = prv_load_word(&dest[i]);
+      prv_store_word(&dest[i], (src_word & opaque_mask) | (dest_word & ~opaque_mask));
+    }
+  }
+  for (; i < num_pixels; ++i) {
+    dest[i] = gcolor_alpha_blend((GColor8)src[i], (GColor8)dest[i]).argb;
+  }
+}
+
+// Returns true if the source row covers the full width of the source bounds and src_x starts
+// inside of it. In that case the row can be blitted as contiguous runs that only break where the
+// source wraps around horizontally, which is exactly what the per-pixel loops below do.
+static bool prv_src_row_is_contiguous(const GBitmap *src_bitmap, int16_t src_begin_x,
+                                      int16_t src_end_x, int16_t src_x) {
+  return (src_begin_x == src_bitmap->bounds.origin.x) &&
+         (src_end_x == grect_get_max_x(&src_bitmap->bounds)) &&
+         WITHIN(src_x, src_begin_x, src_end_x - 1);
+}
+
 void bitblt_bitmap_into_bitmap_tiled_8bit_to_8bit(GBitmap *dest_bitmap,
                                                   const GBitmap *src_bitmap,
                                                   GRect dest_rect,
@@ -170,6 +228,18 @@ void bitblt_bitmap_into_bitmap_tiled_8bit_to_8bit(GBitmap *dest_bitmap,
                                       src_row_info.max_x + 1);
 
         int16_t src_x = src_initial_x + src_origin_offset.x;
+        if (prv_src_row_is_contiguous(src_bitmap, src_begin_x, src_end_x, src_x)) {
+          // Fast path: copy the row in runs, one per horizontal tile
+          int16_t dest_x = dest_begin_x;
+          while (dest_x < dest_end_x) {
+            const int16_t run = MIN(dest_end_x - dest_x, src_end_x - src_x);
+            memcpy(&dest[dest_x], &src[src_x], run);
+            dest_x += run;
+            src_x = src_begin_x;
+          }
+          continue;
+        }
+
         for (int16_t dest_x = dest_begin_x; dest_x < dest_end_x; ++dest_x, ++src_x) {
           if (!WITHIN(src_x, src_begin_x, src_end_x - 1)) {
             // Check if content should wrap (under and over) for tiling
@@ -222,6 +292,19 @@ void bitblt_bitmap_into_bitmap_tiled_8bit_to_8bit(GBitmap *dest_bitmap,
                                       src_row_info.max_x + 1);
 
         int16_t src_x = src_initial_x + src_origin_offset.x;
+        if ((compositing_mode == GCompOpSet) &&
+            prv_src_row_is_contiguous(src_bitmap, src_begin_x, src_end_x, src_x)) {
+          // Fast path: blend the row in runs, one per horizontal tile
+          int16_t dest_x = dest_begin_x;
+          while (dest_x < dest_end_x) {
+            const int16_t run = MIN(dest_end_x - dest_x, src_end_x - src_x);
+            prv_set_run(&dest[dest_x], &src[src_x], run);
+            dest_x += run;
+            src_x = src_begin_x;
+          }
+          continue;
+        }
+
         for (int16_t dest_x = dest_begin_x; dest_x < dest_end_x; ++dest_x, ++src_x) {
           if (!WITHIN(src_x, src_begin_x, src_end_x - 1)) {
             // Check if content should wrap (under and over) for tiling
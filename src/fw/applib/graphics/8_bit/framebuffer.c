@@ -55,17 +55,3 @@ void framebuffer_clear(FrameBuffer *f) {
   memset(f->buffer, 0xff, framebuffer_get_size_bytes(f));
   framebuffer_dirty_all(f);
 }
-
-void framebuffer_mark_dirty_rect(FrameBuffer *f, GRect rect) {
-  PBL_ASSERTN(!gsize_equal(&f->size, &GSizeZero));
-  if (!f->is_dirty) {
-    f->dirty_rect = rect;
-  } else {
-    f->dirty_rect = grect_union(&f->dirty_rect, &rect);
-  }
-
-  const GRect clip_rect = (GRect) { GPointZero, f->size };
-  grect_clip(&f->dirty_rect, &clip_rect);
-
-  f->is_dirty = true;
-}
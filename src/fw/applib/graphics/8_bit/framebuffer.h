@@ -13,11 +13,17 @@
 #define FRAMEBUFFER_BYTES_PER_ROW DISP_COLS
 #define FRAMEBUFFER_SIZE_BYTES DISPLAY_FRAMEBUFFER_BYTES
 
+//! Number of disjoint dirty row spans tracked before neighbouring spans get merged
+#define FRAMEBUFFER_MAX_DIRTY_ROW_SPANS 4
+
 #ifndef UNITTEST
 typedef struct FrameBuffer {
   uint8_t buffer[FRAMEBUFFER_SIZE_BYTES];
   GSize size; //<! Active size of the framebuffer
   GRect dirty_rect; //<! Smallest rect covering all dirty pixels.
+  //! Sorted, disjoint row spans covering all dirty pixels.
+  GRangeVertical dirty_rows[FRAMEBUFFER_MAX_DIRTY_ROW_SPANS];
+  uint8_t num_dirty_row_spans;
   bool is_dirty;
 } FrameBuffer;
 #else // UNITTEST
@@ -26,6 +32,9 @@ typedef struct FrameBuffer {
 typedef struct PACKED FrameBuffer {
   GSize size; //<! Active size of the framebuffer
   GRect dirty_rect; //<! Smallest rect covering all dirty pixels.
+  //! Sorted, disjoint row spans covering all dirty pixels.
+  GRangeVertical dirty_rows[FRAMEBUFFER_MAX_DIRTY_ROW_SPANS];
+  uint8_t num_dirty_row_spans;
   bool is_dirty;
   uint8_t buffer[FRAMEBUFFER_SIZE_BYTES];
 } FrameBuffer;
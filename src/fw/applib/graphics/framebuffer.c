@@ -8,6 +8,11 @@
 
 #include "applib/graphics/framebuffer.h"
 #include "system/passert.h"
+#include "system/profiler.h"
+#include "util/math.h"
+#include "util/size.h"
+
+#include <string.h>
 
 void framebuffer_init(FrameBuffer *fb, const GSize *size) {
   PBL_ASSERTN(!gsize_equal(size, &GSizeZero));
@@ -42,15 +47,89 @@ GBitmap framebuffer_get_as_bitmap(FrameBuffer *fb, const GSize *size) {
   };
 }
 
+//! Adds the rows [y0, y1) to the sorted list of dirty row spans. Spans which overlap or touch
+//! the new rows are merged with it. If that still leaves us with too many spans, the two spans
+//! with the smallest gap between them are merged, which dirties the fewest clean rows.
+static void prv_add_dirty_rows(FrameBuffer *fb, int16_t y0, int16_t y1) {
+  GRangeVertical spans[FRAMEBUFFER_MAX_DIRTY_ROW_SPANS + 1];
+  int num_spans = 0;
+  bool inserted = false;
+  for (int i = 0; i < fb->num_dirty_row_spans; i++) {
+    const GRangeVertical *span = &fb->dirty_rows[i];
+    const int16_t span_end = span->origin_y + span->size_h;
+    if (span_end < y0) {
+      spans[num_spans++] = *span;
+    } else if (span->origin_y > y1) {
+      if (!inserted) {
+        spans[num_spans++] = (GRangeVertical) { y0, y1 - y0 };
+        inserted = true;
+      }
+      spans[num_spans++] = *span;
+    } else {
+      y0 = MIN(y0, span->origin_y);
+      y1 = MAX(y1, span_end);
+    }
+  }
+  if (!inserted) {
+    spans[num_spans++] = (GRangeVertical) { y0, y1 - y0 };
+  }
+
+  if (num_spans > FRAMEBUFFER_MAX_DIRTY_ROW_SPANS) {
+    int merge_idx = 0;
+    int16_t min_gap = INT16_MAX;
+    for (int i = 0; i < num_spans - 1; i++) {
+      const int16_t gap = spans[i + 1].origin_y - (spans[i].origin_y + spans[i].size_h);
+      if (gap < min_gap) {
+        min_gap = gap;
+        merge_idx = i;
+      }
+    }
+    spans[merge_idx].size_h = (spans[merge_idx + 1].origin_y + spans[merge_idx + 1].size_h) -
+                              spans[merge_idx].origin_y;
+    num_spans--;
+    memmove(&spans[merge_idx + 1], &spans[merge_idx + 2],
+            (num_spans - merge_idx - 1) * sizeof(spans[0]));
+  }
+
+  memcpy(fb->dirty_rows, spans, num_spans * sizeof(spans[0]));
+  fb->num_dirty_row_spans = num_spans;
+}
+
+void framebuffer_mark_dirty_rect(FrameBuffer *fb, GRect rect) {
+  PBL_ASSERTN(!gsize_equal(&fb->size, &GSizeZero));
+  PROFILER_NODE_START(dirty_rect);
+  if (!fb->is_dirty) {
+    fb->dirty_rect = rect;
+  } else {
+    fb->dirty_rect = grect_union(&fb->dirty_rect, &rect);
+  }
+
+  const GRect clip_rect = (GRect) { GPointZero, fb->size };
+  grect_clip(&fb->dirty_rect, &clip_rect);
+
+  grect_standardize(&rect);
+  const int16_t y0 = MAX(rect.origin.y, 0);
+  const int16_t y1 = MIN(rect.origin.y + rect.size.h, fb->size.h);
+  if ((y0 < y1) && (rect.size.w > 0)) {
+    prv_add_dirty_rows(fb, y0, y1);
+  }
+
+  fb->is_dirty = true;
+  PROFILER_NODE_STOP(dirty_rect);
+}
+
 void framebuffer_dirty_all(FrameBuffer *fb) {
   PBL_ASSERTN(!gsize_equal(&fb->size, &GSizeZero));
   fb->dirty_rect = (GRect) { GPointZero, fb->size };
+  fb->dirty_rows[0] = (GRangeVertical) { 0, fb->size.h };
+  fb->num_dirty_row_spans = 1;
   fb->is_dirty = true;
 }
 
 void framebuffer_reset_dirty(FrameBuffer *fb) {
   PBL_ASSERTN(!gsize_equal(&fb->size, &GSizeZero));
   fb->dirty_rect = GRectZero;
+  fb->num_dirty_row_spans = 0;
   fb->is_dirty = false;
 }
 
@@ -59,6 +138,21 @@ bool framebuffer_is_dirty(FrameBuffer *fb) {
   return fb->is_dirty;
 }
 
+bool framebuffer_is_row_dirty(FrameBuffer *fb, int16_t y) {
+  return (framebuffer_get_next_dirty_row(fb, y) == y);
+}
+
+int16_t framebuffer_get_next_dirty_row(FrameBuffer *fb, int16_t y) {
+  const int num_spans = MIN(fb->num_dirty_row_spans, FRAMEBUFFER_MAX_DIRTY_ROW_SPANS);
+  for (int i = 0; i < num_spans; i++) {
+    const GRangeVertical *span = &fb->dirty_rows[i];
+    if (y < span->origin_y + span->size_h) {
+      return MAX(y, span->origin_y);
+    }
+  }
+  return fb->size.h;
+}
+
 GSize framebuffer_get_size(FrameBuffer *fb) {
   return fb->size;
 }
@@ -39,6 +39,13 @@ void framebuffer_reset_dirty(FrameBuffer* f);
 //! Query the dirty status for this framebuffer
 bool framebuffer_is_dirty(FrameBuffer* f);
 
+//! Query whether the given row contains dirty pixels
+bool framebuffer_is_row_dirty(FrameBuffer *f, int16_t y);
+
+//! Find the first dirty row at or below the given row
+//! @return the index of the row, or the framebuffer height if there are no more dirty rows
+int16_t framebuffer_get_next_dirty_row(FrameBuffer *f, int16_t y);
+
 //! Creates a GBitmap struct that points to the framebuffer. Useful for using the framebuffer data
 //! with graphics routines. Note that updating this bitmap won't mark the appropriate lines as
 //! dirty in the framebuffer, so this will have to be done manually.
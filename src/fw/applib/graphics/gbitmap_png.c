@@ -29,7 +29,8 @@ bool gbitmap_png_data_is_png(const uint8_t *data, size_t data_size) {
   return false;
 }
 
-// ! Distance from current resource cursor to next IDAT/fdAT chunk including that chunks data
+// ! Distance from current resource cursor to next IDAT/fdAT chunk including the data of it and
+// ! any consecutive chunks of the same type
 int32_t png_seek_chunk_in_resource(uint32_t resource_id, uint32_t offset,
                                    bool seek_framedata, bool *found_actl) {
   ResAppNum app_num = sys_get_current_resource_num();
@@ -70,8 +71,21 @@ int32_t png_seek_chunk_in_resource_system(ResAppNum app_num, uint32_t resource_i
         if (found_actl) {
           *found_actl = actl_chunk_found;
         }
-        // current distance + data_length + chunk_parts
-        return (current_offset - offset + marker.length + CHUNK_META_SIZE);
+        // The frame data may be split across several consecutive chunks of the same type
+        const uint32_t data_chunk_type = marker.chunk_type;
+        current_offset += CHUNK_META_SIZE + marker.length;
+        while (current_offset + sizeof(marker) < max_size) {
+          if (sizeof(marker) != sys_resource_load_range(app_num, resource_id, current_offset,
+                                  (uint8_t*)&marker, sizeof(marker))) {
+            return -1;
+          }
+          if (ntohl(marker.chunk_type) != data_chunk_type) {
+            break;
+          }
+          current_offset += CHUNK_META_SIZE + ntohl(marker.length);
+        }
+        // current distance up to the end of the last data chunk of the frame
+        return (current_offset - offset);
       }
     } else {  // Seeking for data up to but not including FCTL or IDAT chunk (ie. image metadata)
       if (marker.chunk_type == CHUNK_IDAT || marker.chunk_type == CHUNK_FCTL) {
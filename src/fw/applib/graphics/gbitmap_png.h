@@ -105,7 +105,8 @@ int32_t png_seek_chunk_in_resource(uint32_t resource_id, uint32_t offset,
 
 //! @internal
 //! This function returns the distance from an offset in a resource, from the specified app number,
-//! to next IDAT/fdAT chunk including that chunks data
+//! to next IDAT/fdAT chunk including that chunks data and the data of any consecutive chunks of
+//! the same type, which together hold the image data of a frame
 //! @param app_num the app resource space from which to read the resource
 //! @param resource_id Resource to seek for PNG/APNG informational chunks
 //! @param offset Position in resource (in bytes) to start seeking from
@@ -113,7 +114,7 @@ int32_t png_seek_chunk_in_resource(uint32_t resource_id, uint32_t offset,
 //! or framedata and frame control (FCTL/IDAT)
 //! @param found_actl if not NULL, contains if the actl chunk was encountered during seeking
 //! @return If seek_framedata is true, returns offset to FDAT or IDAT chunk
-//! including chunk data size, otherwise returns offset to FCTL or IDAT
+//! including the size of all of the frame's data chunks, otherwise returns offset to FCTL or IDAT
 //! not including those chunks data size
 int32_t png_seek_chunk_in_resource_system(ResAppNum app_num, uint32_t resource_id, uint32_t offset,
                                           bool seek_framedata, bool *found_actl);
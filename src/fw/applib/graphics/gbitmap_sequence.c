@@ -191,6 +191,146 @@ static void prv_set_pixel_in_row(uint8_t *row_data, GBitmapFormat bitmap_format,
   }
 }
 
+typedef struct GBitmapSequenceFrameDecode {
+  GBitmapSequence *bitmap_sequence;
+  GBitmap *bitmap;
+  GBitmapFormat bitmap_format;
+  apng_fctl fctl;
+  bool has_fctl;
+  uint32_t bpp;
+  upng_format png_format;
+  int32_t transparent_gray;
+  bool frame_setup_done;
+} GBitmapSequenceFrameDecode;
+
+// Disposes of the previous frame and picks up the frame control data of the frame being decoded.
+// The sequence itself is only updated by prv_commit_frame() once the whole frame has decoded.
+static void prv_setup_frame(GBitmapSequenceFrameDecode *decode) {
+  GBitmapSequence *bitmap_sequence = decode->bitmap_sequence;
+  GBitmapSequencePNGDecoderData *png_decoder_data = &bitmap_sequence->png_decoder_data;
+  GBitmap *bitmap = decode->bitmap;
+  upng_t *upng = png_decoder_data->upng;
+
+  const bool bitmap_supports_transparency = (decode->bitmap_format != GBitmapFormat1Bit);
+
+  // DISPOSE_OP_BACKGROUND sets the background to black with transparency (0x00)
+  // If we don't support tranparency, just do nothing.
+  if (bitmap_supports_transparency &&
+      (png_decoder_data->last_dispose_op == APNG_DISPOSE_OP_BACKGROUND)) {
+    const uint32_t y_origin = bitmap->bounds.origin.y + png_decoder_data->previous_yoffset;
+    for (uint32_t y = y_origin; y < y_origin + png_decoder_data->previous_height; y++) {
+      const GBitmapDataRowInfo row_info = gbitmap_get_data_row_info(bitmap, y);
+      const uint32_t x_origin = bitmap->bounds.origin.x + png_decoder_data->previous_xoffset;
+      const int16_t min_x = MAX((uint32_t)row_info.min_x, x_origin);
+      const int16_t max_x = MIN((uint32_t)row_info.max_x,
+                                (x_origin + png_decoder_data->previous_width - 1));
+
+      const int16_t num_bytes = max_x - min_x + 1;
+      if (num_bytes > 0) {
+        memset(row_info.data + min_x, 0, num_bytes);
+      }
+    }
+  }
+
+  apng_fctl *fctl = &decode->fctl; // Defaults work for IDAT frame without fctl data
+
+  // If this frame doesn't have fctl, use the full width & height
+  decode->has_fctl = upng_get_apng_fctl(upng, fctl);
+  if (!decode->has_fctl) {
+    fctl->width = bitmap_sequence->bitmap_size.w;
+    fctl->height = bitmap_sequence->bitmap_size.h;
+  }
+
+  decode->frame_setup_done = true;
+}
+
+// Records the disposal and delay of a successfully decoded frame
+static void prv_commit_frame(GBitmapSequenceFrameDecode *decode) {
+  GBitmapSequence *bitmap_sequence = decode->bitmap_sequence;
+  GBitmapSequencePNGDecoderData *png_decoder_data = &bitmap_sequence->png_decoder_data;
+  apng_fctl *fctl = &decode->fctl;
+
+  if (!decode->has_fctl) {
+    // As a PNG image is only a single frame, display it forever
+    bitmap_sequence->current_frame_delay_ms = PLAY_DURATION_INFINITE;
+  } else {
+    png_decoder_data->last_dispose_op = fctl->dispose_op;
+    png_decoder_data->previous_xoffset = fctl->x_offset;
+    png_decoder_data->previous_yoffset = fctl->y_offset;
+    png_decoder_data->previous_width = fctl->width;
+    png_decoder_data->previous_height = fctl->height;
+
+    fctl->delay_den = (fctl->delay_den == 0) ? APNG_DEFAULT_DELAY_UNITS : fctl->delay_den;
+    // Update the current_frame_delay_ms for this frame
+    bitmap_sequence->current_frame_delay_ms =
+        ((uint32_t)fctl->delay_num * MS_PER_SECOND) / fctl->delay_den;
+  }
+}
+
+// Blits one decoded row of the frame straight into the destination bitmap
+static void prv_decode_row(void *context, uint32_t y, const uint8_t *row) {
+  GBitmapSequenceFrameDecode *decode = context;
+  if (!decode->frame_setup_done) {
+    prv_setup_frame(decode);
+  }
+
+  const apng_fctl *fctl = &decode->fctl;
+  GBitmap *bitmap = decode->bitmap;
+  const uint32_t bpp = decode->bpp;
+  if (y >= fctl->height) {
+    return;
+  }
+
+  const uint16_t corrected_dst_y = fctl->y_offset + y + bitmap->bounds.origin.y;
+  const GBitmapDataRowInfo row_info = gbitmap_get_data_row_info(bitmap, corrected_dst_y);
+
+  // delta_x is the first bit of data in this frame relative to the bitmap's coordinate system
+  const int16_t delta_x = fctl->x_offset + bitmap->bounds.origin.x;
+
+  if (decode->png_format >= UPNG_INDEXED1 && decode->png_format <= UPNG_INDEXED8) {
+    const GColor8 *palette = decode->bitmap_sequence->png_decoder_data.palette;
+
+    for (int32_t x = MAX(0, row_info.min_x - delta_x);
+         x < MIN((int32_t)fctl->width, row_info.max_x - delta_x + 1);
+         x++) {
+      const uint32_t corrected_dst_x = x + delta_x;
+      const uint8_t palette_index = raw_image_get_value_for_bitdepth(row, x, 0, 0, bpp);
+
+      const GColor8 src = palette[palette_index];
+      GColor8 *const dst = (GColor8 *)(row_info.data + corrected_dst_x);
+      if (fctl->blend_op == APNG_BLEND_OP_OVER) {
+        prv_gbitmap_sequence_blend_over(src, dst);
+      } else {
+        *dst = src;
+      }
+    }
+  } else if (decode->png_format >= UPNG_LUMINANCE1 && decode->png_format <= UPNG_LUMINANCE8) {
+    const int32_t transparent_gray = decode->transparent_gray;
+
+    // for each pixel in this frame, clipping to the bitmap geometry
+    for (int32_t x = MAX(0, row_info.min_x - delta_x);
+         x < MIN((int32_t)fctl->width, row_info.max_x - delta_x + 1);
+         x++) {
+
+      const uint32_t corrected_dst_x = x + delta_x;
+      uint8_t channel = raw_image_get_value_for_bitdepth(row, x, 0, 0, bpp);
+      if (transparent_gray >= 0 && channel == transparent_gray) {
+        // Grayscale only has fully transparent, so only modify pixels
+        // during OP_SOURCE to make the area transparent
+        if (fctl->blend_op == APNG_BLEND_OP_SOURCE) {
+          prv_set_pixel_in_row(row_info.data, decode->bitmap_format, corrected_dst_x,
+                               GColorClear);
+        }
+      } else {
+        channel = (channel * 255) / ~(~0U << bpp);  // Convert to 8-bit value
+        const GColor8 color = GColorFromRGB(channel, channel, channel);
+
+        prv_set_pixel_in_row(row_info.data, decode->bitmap_format, corrected_dst_x, color);
+      }
+    }
+  }
+}
+
 bool gbitmap_sequence_update_bitmap_next_frame(GBitmapSequence *bitmap_sequence,
                                                GBitmap *bitmap, uint32_t *delay_ms) {
   bool retval = false;
@@ -259,7 +399,20 @@ bool gbitmap_sequence_update_bitmap_next_frame(GBitmapSequence *bitmap_sequence,
   png_decoder_data->read_cursor += metadata_bytes;
 
   upng_load_bytes(upng, buffer, metadata_bytes);
-  upng_error upng_state = upng_decode_image(upng);
+
+  // Rows are decoded straight into the destination bitmap. If the frame turns out to be corrupt
+  // part way through, the bitmap keeps the rows drawn so far but the frame index, delay and
+  // disposal state are left as they were. upng stays in its error state, so any further updates
+  // fail as well.
+  GBitmapSequenceFrameDecode decode = {
+    .bitmap_sequence = bitmap_sequence,
+    .bitmap = bitmap,
+    .bitmap_format = bitmap_format,
+    .bpp = upng_get_bpp(upng),
+    .png_format = upng_get_format(upng),
+    .transparent_gray = gbitmap_png_get_transparent_gray_value(upng),
+  };
+  upng_error upng_state = upng_decode_image_rows(upng, prv_decode_row, &decode);
   if (upng_state != UPNG_EOK) {
     APP_LOG(APP_LOG_LEVEL_ERROR,
             (upng_state == UPNG_ENOMEM) ? APNG_MEMORY_ERROR : APNG_DECODE_ERROR);
@@ -269,120 +422,17 @@ bool gbitmap_sequence_update_bitmap_next_frame(GBitmapSequence *bitmap_sequence,
 
   bitmap_sequence->current_frame++;
 
-  const uint32_t width = bitmap_sequence->bitmap_size.w;
-  const uint32_t height = bitmap_sequence->bitmap_size.h;
-
-  const bool bitmap_supports_transparency = (bitmap_format != GBitmapFormat1Bit);
-
-  // DISPOSE_OP_BACKGROUND sets the background to black with transparency (0x00)
-  // If we don't support tranparency, just do nothing.
-  if (bitmap_supports_transparency &&
-      (png_decoder_data->last_dispose_op == APNG_DISPOSE_OP_BACKGROUND)) {
-    const uint32_t y_origin = bitmap->bounds.origin.y + png_decoder_data->previous_yoffset;
-    for (uint32_t y = y_origin; y < y_origin + png_decoder_data->previous_height; y++) {
-      const GBitmapDataRowInfo row_info = gbitmap_get_data_row_info(bitmap, y);
-      const uint32_t x_origin = bitmap->bounds.origin.x + png_decoder_data->previous_xoffset;
-      const int16_t min_x = MAX((uint32_t)row_info.min_x, x_origin);
-      const int16_t max_x = MIN((uint32_t)row_info.max_x,
-                                (x_origin + png_decoder_data->previous_width - 1));
-
-      const int16_t num_bytes = max_x - min_x + 1;
-      if (num_bytes > 0) {
-        memset(row_info.data + min_x, 0, num_bytes);
-      }
-    }
-  }
-
-  apng_fctl fctl = {0}; // Defaults work for IDAT frame without fctl data
-
-  // If this frame doesn't have fctl, use the full width & height
-  if (!upng_get_apng_fctl(upng, &fctl)) {
-    fctl.width = width;
-    fctl.height = height;
-    // As a PNG image is only a single frame, display it forever
-    bitmap_sequence->current_frame_delay_ms = PLAY_DURATION_INFINITE;
-  } else {
-    png_decoder_data->last_dispose_op = fctl.dispose_op;
-    png_decoder_data->previous_xoffset = fctl.x_offset;
-    png_decoder_data->previous_yoffset = fctl.y_offset;
-    png_decoder_data->previous_width = fctl.width;
-    png_decoder_data->previous_height = fctl.height;
-
-    fctl.delay_den = (fctl.delay_den == 0) ? APNG_DEFAULT_DELAY_UNITS : fctl.delay_den;
-    // Update the current_frame_delay_ms for this frame
-    bitmap_sequence->current_frame_delay_ms =
-        ((uint32_t)fctl.delay_num * MS_PER_SECOND) / fctl.delay_den;
+  // A frame without any rows still has to update the disposal and delay
+  if (!decode.frame_setup_done) {
+    prv_setup_frame(&decode);
   }
+  prv_commit_frame(&decode);
 
   // Return the delay_ms for the new frame
   if (delay_ms != NULL) {
     *delay_ms = bitmap_sequence->current_frame_delay_ms;
   }
 
-  uint32_t bpp = upng_get_bpp(upng);
-  upng_format png_format = upng_get_format(upng);
-  uint8_t *upng_buffer = (uint8_t*)upng_get_buffer(upng);
-
-  // Byte aligned rows for image at bpp
-  uint16_t row_stride_bytes = (fctl.width *  bpp + 7) / 8;
-
-  if (png_format >= UPNG_INDEXED1 && png_format <= UPNG_INDEXED8) {
-    const GColor8 *palette = png_decoder_data->palette;
-
-    for (uint32_t y = 0; y < fctl.height; y++) {
-      const uint16_t corrected_dst_y = fctl.y_offset + y + bitmap->bounds.origin.y;
-      const GBitmapDataRowInfo row_info = gbitmap_get_data_row_info(bitmap, corrected_dst_y);
-      int16_t delta_x = fctl.x_offset + bitmap->bounds.origin.x;
-      for (int32_t x = MAX(0, row_info.min_x - delta_x);
-           x < MIN((int32_t)fctl.width, row_info.max_x - delta_x + 1);
-           x++) {
-        const uint32_t corrected_dst_x = x + delta_x;
-        const uint8_t palette_index = raw_image_get_value_for_bitdepth(upng_buffer, x, y,
-            row_stride_bytes, bpp);
-
-        const GColor8 src = palette[palette_index];
-        GColor8 *const dst = (GColor8 *)(row_info.data + corrected_dst_x);
-        if (fctl.blend_op == APNG_BLEND_OP_OVER) {
-          prv_gbitmap_sequence_blend_over(src, dst);
-        } else {
-          *dst = src;
-        }
-      }
-    }
-  } else if (png_format >= UPNG_LUMINANCE1 && png_format <= UPNG_LUMINANCE8) {
-    const int32_t transparent_gray = gbitmap_png_get_transparent_gray_value(upng);
-
-    for (uint32_t y = 0; y < fctl.height; y++) {
-      const uint16_t corrected_y = fctl.y_offset + y + bitmap->bounds.origin.y;
-      const GBitmapDataRowInfo row_info = gbitmap_get_data_row_info(bitmap, corrected_y);
-
-      // delta_x is the first bit of data in this frame relative to the bitmap's coordinate system
-      const int16_t delta_x = fctl.x_offset + bitmap->bounds.origin.x;
-
-      // for each pixel in this frame, clipping to the bitmap geometry
-      for (int32_t x = MAX(0, row_info.min_x - delta_x);
-           x < MIN((int32_t)fctl.width, row_info.max_x - delta_x + 1);
-           x++) {
-
-        const uint32_t corrected_dst_x = x + delta_x;
-        uint8_t channel = raw_image_get_value_for_bitdepth(upng_buffer, x, y,
-                                                           row_stride_bytes, bpp);
-        if (transparent_gray >= 0 && channel == transparent_gray) {
-          // Grayscale only has fully transparent, so only modify pixels
-          // during OP_SOURCE to make the area transparent
-          if (fctl.blend_op == APNG_BLEND_OP_SOURCE) {
-            prv_set_pixel_in_row(row_info.data, bitmap_format, corrected_dst_x, GColorClear);
-          }
-        } else {
-          channel = (channel * 255) / ~(~0U << bpp);  // Convert to 8-bit value
-          const GColor8 color = GColorFromRGB(channel, channel, channel);
-
-          prv_set_pixel_in_row(row_info.data, bitmap_format, corrected_dst_x, color);
-        }
-      }
-    }
-  }
-
   // Successfully updated gbitmap from sequence
   retval = true;
 
@@ -72,7 +72,8 @@ bool gbitmap_sequence_restart(GBitmapSequence *bitmap_sequence);
 //! @param[out] delay_ms If not NULL, returns the delay in milliseconds until the next frame.
 //! @return True if frame was rendered.  False if all frames (and loops) have been rendered
 //! for the sequence.  Will also return false if frame could not be rendered
-//! (includes out of memory errors).
+//! (includes out of memory errors). If the frame data is corrupt, the bitmap may hold part of
+//! the frame.
 //! @note GBitmap must be large enough to accommodate the bitmap_sequence image
 //! \ref gbitmap_sequence_get_bitmap_size
 bool gbitmap_sequence_update_bitmap_next_frame(GBitmapSequence *bitmap_sequence,
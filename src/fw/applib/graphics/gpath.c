@@ -11,6 +11,7 @@
 #include "system/logging.h"
 #include "system/passert.h"
 #include "util/math.h"
+#include "util/sort.h"
 #include "util/swap.h"
 #include "util/trig.h"
 
@@ -60,16 +61,6 @@ static GPoint rotate_offset_point(const GPoint *orig, int32_t rotation, const GP
   return result;
 }
 
-static void sort16(int16_t *values, size_t length) {
-  for (unsigned int i = 0; i < length; i++) {
-    for (unsigned int j = i+1; j < length; j++) {
-      if (values[i] > values[j]) {
-        swap16(&values[i], &values[j]);
-      }
-    }
-  }
-}
-
 #if PBL_COLOR
 static void swapIntersections(Intersection *a, Intersection *b) {
   Intersection t = *a;
@@ -88,6 +79,146 @@ static void sortIntersections(Intersection *values, size_t length) {
 }
 #endif
 
+//! A non-horizontal path segment in the edge table of the scanline fill.
+//! The end points are looked up in the rotated points of the path, which keeps the table at a
+//! few bytes per point.
+typedef struct GPathEdge {
+  int16_t y_min; //!< First scanline the segment is intersected with
+  int16_t y_max; //!< Last scanline the segment is intersected with
+  int16_t x; //!< Intersection with the current scanline
+  uint16_t index; //!< Position of the segment in the path, it starts at points[index]
+  Fixed_S16_3 delta; //!< Antialiasing gradient width, only used by the antialiased fill
+  bool is_down;
+} GPathEdge;
+
+//! The edges of a path sorted by y_min, and the list of edges that intersect the current
+//! scanline, which is kept sorted by x.
+//! The antialiased fill uses points_precise, everything else uses points.
+typedef struct GPathEdgeTable {
+  const GPoint *points;
+  const GPointPrecise *points_precise;
+  uint32_t num_points;
+  GPathEdge **active;
+  GPathEdge *edges;
+  uint32_t num_edges;
+  uint32_t next_edge;
+  uint32_t num_active;
+} GPathEdgeTable;
+
+static bool prv_edge_table_init(GPathEdgeTable *table, const GPoint *points,
+                                const GPointPrecise *points_precise, uint32_t num_points) {
+  *table = (GPathEdgeTable) {
+    .points = points,
+    .points_precise = points_precise,
+    .num_points = num_points,
+  };
+  if (num_points > UINT16_MAX) {
+    return false;
+  }
+  // a path has at most one edge per point, the edges share the allocation of the active list
+  GPathEdge **active = applib_malloc(num_points * (sizeof(GPathEdge *) + sizeof(GPathEdge)));
+  table->active = active;
+  table->edges = (GPathEdge *)&active[num_points];
+  return (active != NULL);
+}
+
+static void prv_edge_table_deinit(GPathEdgeTable *table) {
+  applib_free(table->active);
+}
+
+static uint32_t prv_edge_end_index(const GPathEdgeTable *table, const GPathEdge *edge) {
+  // wrap to the first point
+  return (edge->index + 1u < table->num_points) ? (edge->index + 1u) : 0;
+}
+
+//! Intersection of the edge with scanline y, in raw Fixed_S16_3 units for the antialiased fill
+static int16_t prv_edge_x(const GPathEdgeTable *table, const GPathEdge *edge, int16_t y) {
+  // linear interpolation of the line intersection
+  if (table->points_precise) {
+    const GPointPrecise *start = &table->points_precise[edge->index];
+    const GPointPrecise *end = &table->points_precise[prv_edge_end_index(table, edge)];
+    const int16_t delta_x = end->x.raw_value - start->x.raw_value;
+    const int16_t delta_y = end->y.raw_value - start->y.raw_value;
+    return start->x.raw_value + delta_x * (y * FIXED_S16_3_ONE.raw_value - start->y.raw_value) /
+           delta_y;
+  } else {
+    const GPoint *start = &table->points[edge->index];
+    const GPoint *end = &table->points[prv_edge_end_index(table, edge)];
+    return start->x + (end->x - start->x) * (y - start->y) / (end->y - start->y);
+  }
+}
+
+//! Adds the segment starting at points[index] to the table if it spans more than one scanline.
+//! start_row and end_row are the scanlines of the two end points.
+//! The start point isn't intersected if the previous non-horizontal segment went in the same
+//! direction, as the previous segment already covers that scanline.
+//! @return the new edge, or NULL for horizontal segments which never get intersected
+static GPathEdge *prv_edge_table_add(GPathEdgeTable *table, uint32_t index, int16_t start_row,
+                                     int16_t end_row, bool *last_is_down) {
+  if (start_row == end_row) {
+    return NULL;
+  }
+  const bool is_down = end_row > start_row;
+  const bool skip_start = (*last_is_down == is_down);
+  *last_is_down = is_down;
+
+  GPathEdge *edge = &table->edges[table->num_edges++];
+  *edge = (GPathEdge) {
+    .index = index,
+    .y_min = is_down ? (start_row + (skip_start ? 1 : 0)) : end_row,
+    .y_max = is_down ? end_row : (start_row - (skip_start ? 1 : 0)),
+    .is_down = is_down,
+  };
+  return edge;
+}
+
+static int prv_edge_y_min_comparator(const void *a, const void *b) {
+  return ((const GPathEdge *)a)->y_min - ((const GPathEdge *)b)->y_min;
+}
+
+static void prv_edge_table_start(GPathEdgeTable *table) {
+  sort_heap(table->edges, table->num_edges, sizeof(GPathEdge), prv_edge_y_min_comparator);
+  table->next_edge = 0;
+  table->num_active = 0;
+}
+
+//! Advances the active edge list to scanline y, which has to be larger than the last one
+static void prv_edge_table_advance(GPathEdgeTable *table, int16_t y) {
+  // drop the edges that ended and intersect the remaining ones with this scanline
+  uint32_t num_active = 0;
+  for (uint32_t i = 0; i < table->num_active; i++) {
+    GPathEdge *edge = table->active[i];
+    if (edge->y_max >= y) {
+      edge->x = prv_edge_x(table, edge, y);
+      table->active[num_active++] = edge;
+    }
+  }
+
+  // pick up the edges that start at (or, after clipping, above) this scanline
+  for (; table->next_edge < table->num_edges &&
+         table->edges[table->next_edge].y_min <= y; table->next_edge++) {
+    GPathEdge *edge = &table->edges[table->next_edge];
+    // edges that ended above the clip box are dropped right away
+    if (edge->y_max >= y) {
+      edge->x = prv_edge_x(table, edge, y);
+      table->active[num_active++] = edge;
+    }
+  }
+  table->num_active = num_active;
+
+  // edges rarely cross, so the list is nearly sorted from the previous scanline apart from the
+  // new edges at the end
+  for (uint32_t i = 1; i < table->num_active; i++) {
+    GPathEdge *edge = table->active[i];
+    uint32_t j = i;
+    while (j > 0 && table->active[j - 1]->x > edge->x) {
+      table->active[j] = table->active[j - 1];
+      j--;
+    }
+    table->active[j] = edge;
+  }
+}
+
 static inline bool prv_is_in_range(int16_t min_a, int16_t max_a, int16_t min_b, int16_t max_b) {
   return (max_a >= min_b) && (min_a <= max_b);
 }
@@ -198,6 +329,63 @@ GRect gpath_outer_rect(GPath *path) {
 }
 
 #if PBL_COLOR
+//! Intersection of an edge with the current scanline, along with the gradient to draw there
+static Intersection prv_edge_intersection(const GPathEdgeTable *table, const GPathEdge *edge) {
+  const Fixed_S16_3 x = (Fixed_S16_3){.raw_value = edge->x};
+  Fixed_S16_3 delta = edge->delta;
+
+  if (delta.integer > 1) {
+    // this is where we try to fix edges diving in and out of paths
+    const int16_t x_start = table->points_precise[edge->index].x.raw_value;
+    const int16_t x_end = table->points_precise[prv_edge_end_index(table, edge)].x.raw_value;
+    const int16_t min_x = MIN(x_start, x_end);
+    const int16_t max_x = MAX(x_start, x_end);
+
+    if (x.raw_value - (delta.raw_value / 2) < min_x) {
+      delta.raw_value = (x.raw_value - min_x) * 2;
+    }
+
+    if (x.raw_value + (delta.raw_value / 2) > max_x) {
+      delta.raw_value = (max_x - x.raw_value) * 2;
+    }
+  }
+
+  return (Intersection) { .x = x, .delta = delta };
+}
+
+//! Splits the intersections with the current scanline up by the direction of their segments
+//! @return whether there are intersections in the same direction at the same x but with different
+//!   gradients, whose order depends on the order of the active list
+static bool prv_collect_intersections(const GPathEdgeTable *table,
+                                      Intersection *intersections_up, int *up_count,
+                                      Intersection *intersections_down, int *down_count) {
+  bool has_gradient_ties = false;
+  *up_count = 0;
+  *down_count = 0;
+  for (uint32_t i = 0; i < table->num_active; i++) {
+    const GPathEdge *edge = table->active[i];
+    Intersection *intersections = edge->is_down ? intersections_down : intersections_up;
+    int *count = edge->is_down ? down_count : up_count;
+
+    const Intersection intersection = prv_edge_intersection(table, edge);
+    if (*count > 0) {
+      const Intersection *prev = &intersections[*count - 1];
+      has_gradient_ties |= (prev->x.raw_value == intersection.x.raw_value &&
+                            prev->delta.raw_value != intersection.delta.raw_value);
+    }
+    intersections[(*count)++] = intersection;
+  }
+  return has_gradient_ties;
+}
+
+static int prv_active_edge_index_comparator(const void *a, const void *b) {
+  return (*(GPathEdge * const *)a)->index - (*(GPathEdge * const *)b)->index;
+}
+
+static int prv_active_edge_x_comparator(const void *a, const void *b) {
+  return (*(GPathEdge * const *)a)->x - (*(GPathEdge * const *)b)->x;
+}
+
 void prv_fill_path_with_cb_aa(GContext *ctx, GPath *path, GPathDrawFilledCallback cb,
                               void *user_data) {
   /*
@@ -205,10 +393,11 @@ void prv_fill_path_with_cb_aa(GContext *ctx, GPath *path, GPathDrawFilledCallbac
    *
    * Custom linescanner using simple mathematic trick to determine anti-aliased edges
    *  1. Rotate all points in path
-   *  2. Progress line-by-line finding intersections with paths
-   *  2.1 Calculate delta (angle) of the intersecting lines
-   *  2.2 Sort intersections
-   *  2.3 Draw lines between intersections
+   *  2. Build a table of the path segments sorted by their topmost scanline
+   *  2.1 Calculate delta (angle) of each segment
+   *  3. Progress line-by-line keeping a list of the segments intersecting the line
+   *  3.1 Intersect the segments of the list with the next line and keep it sorted
+   *  3.2 Draw lines between intersections
    *
    * This algorithm relies on few tricks:
    *  - For intersections with delta less than 1 (angle is less than 45°) we will use exact
@@ -236,6 +425,7 @@ void prv_fill_path_with_cb_aa(GContext *ctx, GPath *path, GPathDrawFilledCallbac
   GPointPrecise rot_start, rot_end;
   bool found_start_direction = false;
   bool start_is_down = false;
+  GPathEdgeTable edges = {};
   Intersection *intersections_up = NULL;
   Intersection *intersections_down = NULL;
 
@@ -275,18 +465,35 @@ void prv_fill_path_with_cb_aa(GContext *ctx, GPath *path, GPathDrawFilledCallbac
   }
 
   // x-intersections of path segments whose direction is up
-  intersections_up = applib_zalloc(path->num_points * sizeof(Intersection));
+  intersections_up = applib_malloc(path->num_points * sizeof(Intersection));
   // x-intersections of path segments whose direction is down
-  intersections_down = applib_zalloc(path->num_points * sizeof(Intersection));
+  intersections_down = applib_malloc(path->num_points * sizeof(Intersection));
 
-  // If either malloc failed, log message and cleanup
-  if (!intersections_up || !intersections_down) {
+  // If any malloc failed, log message and cleanup
+  if (!prv_edge_table_init(&edges, NULL, rot_points, path->num_points) || !intersections_up ||
+      !intersections_down) {
     APP_LOG(APP_LOG_LEVEL_ERROR, GPATH_ERROR);
     goto cleanup;
   }
 
-  int intersection_up_count;
-  int intersection_down_count;
+  // horizontal path segments don't have a direction and depend
+  // upon the last path segment's direction
+  // keep track of the last path direction for horizontal path segments to use
+  bool last_is_down = start_is_down;
+  for (uint32_t j = 0; j < path->num_points; ++j) {
+    rot_start = rot_points[j];
+    // wrap to the first point
+    rot_end = rot_points[(j + 1 < path->num_points) ? (j + 1) : 0];
+
+    GPathEdge *edge = prv_edge_table_add(&edges, j, rot_start.y.integer, rot_end.y.integer,
+                                         &last_is_down);
+    if (edge) {
+      const int16_t delta_x = rot_end.x.raw_value - rot_start.x.raw_value;
+      const int16_t delta_y = rot_end.y.raw_value - rot_start.y.raw_value;
+      edge->delta = (Fixed_S16_3){.raw_value = ABS(delta_x / delta_y) *
+                                               FIXED_S16_3_ONE.raw_value};
+    }
+  }
 
   // convert clip coordinates to drawing coordinates
   const int16_t clip_min_y = ctx->draw_state.clip_box.origin.y
@@ -299,79 +506,30 @@ void prv_fill_path_with_cb_aa(GContext *ctx, GPath *path, GPathDrawFilledCallbac
   GColor tmp = ctx->draw_state.stroke_color;
   ctx->draw_state.stroke_color = ctx->draw_state.fill_color;
 
+  int intersection_up_count;
+  int intersection_down_count;
+
   // find all of the horizontal intersections and draw them
+  prv_edge_table_start(&edges);
   for (int16_t i = min_y; i <= max_y; ++i) {
-    // initialize with 0 intersections
-    intersection_down_count = 0;
-    intersection_up_count = 0;
-
-    // horizontal path segments don't have a direction and depend
-    // upon the last path segment's direction
-    // keep track of the last path direction for horizontal path segments to use
-    bool last_is_down = start_is_down;
-    rot_end = rot_points[0];
-
-    // find the intersections
-    for (uint32_t j = 0; j < path->num_points; ++j) {
-      rot_start = rot_points[j];
-      if (j + 1 < path->num_points) {
-        rot_end = rot_points[j + 1];
-      } else {
-        // wrap to the first point
-        rot_end = rot_points[0];
-      }
-
-      // if the line is on/crosses this height
-      if ((rot_start.y.integer - i) * (rot_end.y.integer - i) <= 0) {
-        bool is_down = rot_end.y.integer != rot_start.y.integer ?
-                       rot_end.y.integer > rot_start.y.integer : last_is_down;
-        // don't count end points in the same direction to avoid double intersections
-        if (!(rot_start.y.integer == i && last_is_down == is_down)) {
-          // linear interpolation of the line intersection
-
-          int16_t delta_x = rot_end.x.raw_value - rot_start.x.raw_value;
-          int16_t delta_y = rot_end.y.raw_value - rot_start.y.raw_value;
-
-          Fixed_S16_3 x = (Fixed_S16_3){.raw_value = rot_start.x.raw_value + delta_x
-                          * (i * FIXED_S16_3_ONE.raw_value - rot_start.y.raw_value) / delta_y};
-
-          Fixed_S16_3 delta = (Fixed_S16_3){.raw_value = ABS(delta_x / delta_y) *
-                                                          FIXED_S16_3_ONE.raw_value};
-
-          if (delta.integer > 1) {
-            // this is where we try to fix edges diving in and out of paths
-            int16_t min_x = rot_end.x.raw_value < rot_start.x.raw_value ?
-                              rot_end.x.raw_value : rot_start.x.raw_value;
-            int16_t max_x = rot_end.x.raw_value > rot_start.x.raw_value ?
-                              rot_end.x.raw_value : rot_start.x.raw_value;
-
-            if (x.raw_value - (delta.raw_value / 2) < min_x) {
-              delta.raw_value = (x.raw_value - min_x) * 2;
-            }
-
-            if (x.raw_value + (delta.raw_value / 2) > max_x) {
-              delta.raw_value = (max_x - x.raw_value) * 2;
-            }
-          }
-
-          if (is_down) {
-            intersections_down[intersection_down_count].x.raw_value = x.raw_value;
-            intersections_down[intersection_down_count].delta = delta;
-            intersection_down_count++;
-          } else {
-            intersections_up[intersection_up_count].x.raw_value = x.raw_value;
-            intersections_up[intersection_up_count].delta = delta;
-            intersection_up_count++;
-          }
-        }
-        last_is_down = is_down;
-      }
+    prv_edge_table_advance(&edges, i);
+
+    // the active list is sorted by x, so the intersections come out sorted as well
+    if (prv_collect_intersections(&edges, intersections_up, &intersection_up_count,
+                                  intersections_down, &intersection_down_count)) {
+      // which of the gradients at the same x gets drawn first has always been decided by the
+      // order of the segments in the path, sort the same way as before to not change rendering
+      sort_heap(edges.active, edges.num_active, sizeof(GPathEdge *),
+                prv_active_edge_index_comparator);
+      prv_collect_intersections(&edges, intersections_up, &intersection_up_count,
+                                intersections_down, &intersection_down_count);
+      sortIntersections(intersections_up, intersection_up_count);
+      sortIntersections(intersections_down, intersection_down_count);
+      // the order of edges at the same x doesn't matter to the active list
+      sort_heap(edges.active, edges.num_active, sizeof(GPathEdge *),
+                prv_active_edge_x_comparator);
     }
 
-    // sort the intersections
-    sortIntersections(intersections_up, intersection_up_count);
-    sortIntersections(intersections_down, intersection_down_count);
-
     // draw the line segments
     for (int j = 0; j < MIN(intersection_up_count, intersection_down_count); j++) {
       Intersection x_a = intersections_up[j];
@@ -396,6 +554,7 @@ cleanup:
   applib_free(rot_points);
   applib_free(intersections_up);
   applib_free(intersections_down);
+  prv_edge_table_deinit(&edges);
 }
 #endif // PBL_COLOR
 
@@ -416,8 +575,7 @@ void gpath_draw_filled_with_cb(GContext *ctx, GPath *path, GPathDrawFilledCallba
   GPoint rot_start, rot_end;
   bool found_start_direction = false;
   bool start_is_down = false;
-  int16_t *intersections_up = NULL;
-  int16_t *intersections_down = NULL;
+  GPathEdgeTable edges = {};
 
   rot_points[0] = rot_end = rotate_offset_point(&path->points[0], path->rotation, &path->offset);
   min_x = max_x = rot_points[0].x;
@@ -453,19 +611,21 @@ void gpath_draw_filled_with_cb(GContext *ctx, GPath *path, GPathDrawFilledCallba
     goto cleanup;
   }
 
-  // x-intersections of path segments whose direction is up
-  intersections_up = applib_zalloc(path->num_points * sizeof(int16_t));
-  // x-intersections of path segments whose direction is down
-  intersections_down = applib_zalloc(path->num_points * sizeof(int16_t));
-
-  // If either malloc failed, log message and cleanup
-  if (!intersections_up || !intersections_down) {
+  if (!prv_edge_table_init(&edges, rot_points, NULL, path->num_points)) {
     APP_LOG(APP_LOG_LEVEL_ERROR, GPATH_ERROR);
     goto cleanup;
   }
 
-  int intersection_up_count;
-  int intersection_down_count;
+  // horizontal path segments don't have a direction and depend upon the last path segment's direction
+  // keep track of the last path direction for horizontal path segments to use
+  bool last_is_down = start_is_down;
+  for (uint32_t j = 0; j < path->num_points; ++j) {
+    rot_start = rot_points[j];
+    // wrap to the first point
+    rot_end = rot_points[(j + 1 < path->num_points) ? (j + 1) : 0];
+
+    prv_edge_table_add(&edges, j, rot_start.y, rot_end.y, &last_is_down);
+  }
 
   const int16_t clip_min_y = ctx->draw_state.clip_box.origin.y
       - ctx->draw_state.drawing_box.origin.y;
@@ -474,53 +634,26 @@ void gpath_draw_filled_with_cb(GContext *ctx, GPath *path, GPathDrawFilledCallba
   max_y = MIN(max_y, clip_max_y);
 
   // find all of the horizontal intersections and draw them
+  prv_edge_table_start(&edges);
   for (int16_t i = min_y; i <= max_y; ++i) {
-    // initialize with 0 intersections
-    intersection_down_count = 0;
-    intersection_up_count = 0;
-
-    // horizontal path segments don't have a direction and depend upon the last path segment's direction
-    // keep track of the last path direction for horizontal path segments to use
-    bool last_is_down = start_is_down;
-    rot_end = rot_points[0];
-
-    // find the intersections
-    for (uint32_t j = 0; j < path->num_points; ++j) {
-      rot_start = rot_points[j];
-      if (j + 1 < path->num_points) {
-        rot_end = rot_points[j + 1];
-      } else {
-        // wrap to the first point
-        rot_end = rot_points[0];
+    prv_edge_table_advance(&edges, i);
+
+    // draw the line segments, pairing the n-th intersection of the segments going up with
+    // the n-th intersection of the segments going down
+    uint32_t up = 0;
+    uint32_t down = 0;
+    while (true) {
+      while (up < edges.num_active && edges.active[up]->is_down) {
+        up++;
       }
-
-      // if the line is on/crosses this height
-      if ((rot_start.y - i) * (rot_end.y - i) <= 0) {
-        bool is_down = rot_end.y != rot_start.y ? rot_end.y > rot_start.y : last_is_down;
-        // don't count end points in the same direction to avoid double intersections
-        if (!(rot_start.y == i && last_is_down == is_down)) {
-          // linear interpolation of the line intersection
-          int16_t x = rot_start.x + (rot_end.x - rot_start.x) * (i - rot_start.y) / (rot_end.y - rot_start.y);
-          if (is_down) {
-            intersections_down[intersection_down_count] = x;
-            intersection_down_count++;
-          } else {
-            intersections_up[intersection_up_count] = x;
-            intersection_up_count++;
-          }
-        }
-        last_is_down = is_down;
+      while (down < edges.num_active && !edges.active[down]->is_down) {
+        down++;
       }
-    }
-
-    // sort the intersections
-    sort16(intersections_up, intersection_up_count);
-    sort16(intersections_down, intersection_down_count);
-
-    // draw the line segments
-    for (int j = 0; j < MIN(intersection_up_count, intersection_down_count); j++) {
-      int16_t x_a = intersections_up[j];
-      int16_t x_b = intersections_down[j];
+      if (up == edges.num_active || down == edges.num_active) {
+        break;
+      }
+      int16_t x_a = edges.active[up++]->x;
+      int16_t x_b = edges.active[down++]->x;
       if (x_a != x_b) {
         if (x_a > x_b) {
           swap16(&x_a, &x_b);
@@ -532,8 +665,7 @@ void gpath_draw_filled_with_cb(GContext *ctx, GPath *path, GPathDrawFilledCallba
   }
 cleanup:
   applib_free(rot_points);
-  applib_free(intersections_up);
-  applib_free(intersections_down);
+  prv_edge_table_deinit(&edges);
 }
 
 void gpath_fill_precise_internal(GContext *ctx, GPointPrecise *points, size_t num_points) {
@@ -112,6 +112,12 @@ typedef struct {
 //! Pointer to opaque text layout cache data structure
 typedef TextLayout* GTextLayoutCacheRef;
 
+//! @internal
+//! Where the lines of a text start, used to skip the lines above the clip box when drawing a
+//! long text that is scrolled.
+//! @see graphics_draw_text_with_line_cache
+typedef struct TextLayoutLineCache TextLayoutLineCache;
+
 //! Describes various characteristics for text rendering and measurement.
 //! @see graphics_draw_text
 //! @see graphics_text_attributes_create
@@ -208,6 +214,34 @@ void graphics_text_layout_cache_init(GTextLayoutCacheRef *layout_cache);
 //! Free a text layout cache
 void graphics_text_layout_cache_deinit(GTextLayoutCacheRef *layout_cache);
 
+//! @internal
+//! Malloc a text layout cache that can also hold a line cache, see
+//! \ref graphics_text_layout_get_line_cache. Falls back to a plain text layout cache for 2.x apps.
+void graphics_text_layout_cache_init_with_line_cache(GTextLayoutCacheRef *layout_cache);
+
+//! @internal
+//! Free a text layout cache created with \ref graphics_text_layout_cache_init_with_line_cache,
+//! along with its line cache
+void graphics_text_layout_cache_deinit_with_line_cache(GTextLayoutCacheRef *layout_cache);
+
+//! @internal
+//! Return the line cache of a text layout cache created with
+//! \ref graphics_text_layout_cache_init_with_line_cache, allocating it on first use
+//! @return the line cache, or NULL if there wasn't enough memory or this is a 2.x app
+TextLayoutLineCache *graphics_text_layout_get_line_cache(GTextLayoutCacheRef layout_cache);
+
+//! @internal
+//! Does the same as \ref graphics_draw_text, but remembers where the lines start in line_cache.
+//! Later calls with the same text, font, box size and alignment start laying out the text close to
+//! the first line visible in the clip box instead of at the start of the text. The cache is reset
+//! automatically when any of those change. It isn't used when text flow or paging are enabled.
+//! @param line_cache The line cache to use, or NULL to behave exactly like graphics_draw_text
+void graphics_draw_text_with_line_cache(GContext *ctx, const char *text, GFont const font,
+                                        const GRect box, const GTextOverflowMode overflow_mode,
+                                        const GTextAlignment alignment,
+                                        GTextAttributes *text_attributes,
+                                        TextLayoutLineCache *line_cache);
+
 //! Creates an instance of GTextAttributes for advanced control when rendering text.
 //! @return New instance of GTextAttributes
 //! @see \ref graphics_draw_text
@@ -974,14 +974,80 @@ static void prv_apply_orphan_state(const OrphanLineState *state, Line *line) {
   line->width_px = state->width_px;
 }
 
+//! Move the line iterator to the last line in the cache that ends above the clip box
+//! @return the index of the line the iterator has been moved to
+static int prv_line_cache_restore(const TextLayoutLineCache *line_cache,
+                                  LineIterState *line_iter_state,
+                                  const TextBoxParams *text_box_params) {
+  GContext *ctx = line_iter_state->ctx;
+  Line *line = line_iter_state->current;
+  const int32_t clip_box_min_y = ctx->draw_state.clip_box.origin.y;
+
+  int entry_index = line_cache->num_entries - 1;
+  for (; entry_index > 0; entry_index--) {
+    // Same condition as the one that decides whether a line gets rendered
+    const int32_t line_max_y = text_box_params->box.origin.y +
+                               line_cache->entries[entry_index].origin_y + line->height_px +
+                               TEXT_LINE_DESCENDER_LINE(line) +
+                               text_box_params->line_spacing_delta;
+    if (line_max_y <= clip_box_min_y) {
+      break;
+    }
+  }
+  if (entry_index <= 0) {
+    return 0;
+  }
+
+  const TextLayoutLineCacheEntry *entry = &line_cache->entries[entry_index];
+  utf8_t *text = text_box_params->utf8_bounds->start;
+  WordIterState *word_iter_state = (WordIterState *)line_iter_state->word_iter.state;
+  word_iter_state->current = (Word) {
+    .start = text + entry->word_start,
+    .end = text + entry->word_end,
+    .width_px = entry->word_width_px,
+  };
+  line->origin.y = text_box_params->box.origin.y + entry->origin_y;
+  return entry_index * line_cache->lines_per_entry;
+}
+
+//! Remember where the line with the given index starts, if it's the next one the cache needs
+static void prv_line_cache_record(TextLayoutLineCache *line_cache, int line_index,
+                                  const Word *word, const Line *line,
+                                  const TextBoxParams *text_box_params) {
+  if (line_index != line_cache->num_entries * line_cache->lines_per_entry ||
+      !word->start || !word->end) {
+    return;
+  }
+
+  if (line_cache->num_entries == TEXT_LAYOUT_LINE_CACHE_NUM_ENTRIES) {
+    // Keep every other line so that the cache covers twice as many lines from now on
+    for (int i = 0; i < TEXT_LAYOUT_LINE_CACHE_NUM_ENTRIES / 2; i++) {
+      line_cache->entries[i] = line_cache->entries[2 * i];
+    }
+    line_cache->num_entries = TEXT_LAYOUT_LINE_CACHE_NUM_ENTRIES / 2;
+    line_cache->lines_per_entry *= 2;
+  }
+
+  const utf8_t *text = text_box_params->utf8_bounds->start;
+  line_cache->entries[line_cache->num_entries++] = (TextLayoutLineCacheEntry) {
+    .word_start = word->start - text,
+    .word_end = word->end - text,
+    .word_width_px = word->width_px,
+    .origin_y = line->origin.y - text_box_params->box.origin.y,
+  };
+}
+
 //! Iterate over lines in the text box
 static inline void prv_walk_lines_down(Iterator* const line_iter, TextLayout* const layout,
-                                       WalkLinesCallbacks* const callbacks) {
+                                       WalkLinesCallbacks* const callbacks,
+                                       TextLayoutLineCache* const line_cache) {
   LineIterState* line_iter_state = (LineIterState*) line_iter->state;
   GContext* ctx = line_iter_state->ctx;
   const GSize ctx_size = graphics_context_get_framebuffer_size(ctx);
   const TextBoxParams* const text_box_params = &ctx->text_draw_state.text_box;
   Line* line = line_iter_state->current;
+  int line_index = line_cache ? prv_line_cache_restore(line_cache, line_iter_state,
+                                                       text_box_params) : 0;
 
   const TextLayoutFlowData *flow_data = graphics_text_layout_get_flow_data(layout);
   const bool uses_paging = flow_data->paging.page_on_screen.size_h != 0;
@@ -1046,6 +1112,10 @@ static inline void prv_walk_lines_down(Iterator* const line_iter, TextLayout* co
     const Word word_before_rendering = *current_word_ref;
     const OrphanLineState orphan_state = prv_capture_orphan_state(line);
 
+    if (line_cache) {
+      prv_line_cache_record(line_cache, line_index, current_word_ref, line, text_box_params);
+    }
+
     // When repeating text to prevent orhpans we could run into the situation where repeating text
     // pushes down the remaining text far enough so it ends up on yet another page. This would
     // enter an infinite loop.
@@ -1104,6 +1174,7 @@ render_line: {} // this {} is just an empty statement that both C and our linter
 
     // Shouldn't have rendered the line if there was insufficient space
     PBL_ASSERTN(iter_next(line_iter));
+    line_index++;
   }
 }
 
@@ -1278,7 +1349,8 @@ static bool prv_text_layout_is_fresh(TextLayout* layout, GFont const font, const
 }
 
 static inline void prv_text_walk_lines(GContext* ctx, TextLayout* const layout,
-                                       WalkLinesCallbacks* callbacks) {
+                                       WalkLinesCallbacks* callbacks,
+                                       TextLayoutLineCache* const line_cache) {
 
   TextBoxParams *text_box = &ctx->text_draw_state.text_box;
 
@@ -1313,7 +1385,7 @@ static inline void prv_text_walk_lines(GContext* ctx, TextLayout* const layout,
   Iterator line_iter;
   line_iter_init(&line_iter, &ctx->text_draw_state.line_iter_state, ctx);
 
-  prv_walk_lines_down(&line_iter, layout, callbacks);
+  prv_walk_lines_down(&line_iter, layout, callbacks, line_cache);
 }
 
 static void prv_graphics_text_layout_update(GContext* ctx, const char* text, GFont const font,
@@ -1358,7 +1430,7 @@ static void prv_graphics_text_layout_update(GContext* ctx, const char* text, GFo
     .line_spacing_delta = line_spacing_delta,
   };
 
-  prv_text_walk_lines(ctx, layout, &callbacks);
+  prv_text_walk_lines(ctx, layout, &callbacks, NULL);
 }
 
 // helper macro to avoid source code duplication
@@ -1408,9 +1480,53 @@ GSize graphics_text_layout_get_max_used_size(GContext *ctx, const char *text, GF
   return text_layout->max_used_size;
 }
 
-void graphics_draw_text(GContext* ctx, const char* text, GFont const font,
-                        GRect box, const GTextOverflowMode overflow_mode,
-                        const GTextAlignment alignment, GTextLayoutCacheRef const layout) {
+//! @return the line cache if it can be used for this text, reset if the text or any of the
+//! parameters that affect where the lines start have changed since it was last used
+static TextLayoutLineCache *prv_line_cache_prepare(TextLayoutLineCache *line_cache,
+                                                   const Utf8Bounds *utf8_bounds,
+                                                   GTextLayoutCacheRef layout,
+                                                   const TextBoxParams *text_box_params) {
+  if (!line_cache) {
+    return NULL;
+  }
+
+  // Text flow and paging move lines around depending on where they are on the screen
+  const TextLayoutFlowData *flow_data = graphics_text_layout_get_flow_data(layout);
+  if (flow_data->perimeter.impl || flow_data->paging.page_on_screen.size_h != 0) {
+    return NULL;
+  }
+
+  const int str_len_bytes = (utf8_bounds->end - utf8_bounds->start);
+  if (str_len_bytes > UINT16_MAX) {
+    return NULL;
+  }
+
+  const uint32_t text_hash = hash((const uint8_t *)utf8_bounds->start, str_len_bytes);
+  if (text_hash != line_cache->hash ||
+      !gsize_equal(&text_box_params->box.size, &line_cache->box_size) ||
+      text_box_params->font != line_cache->font ||
+      text_box_params->overflow_mode != line_cache->overflow_mode ||
+      text_box_params->alignment != line_cache->alignment ||
+      text_box_params->line_spacing_delta != line_cache->line_spacing_delta ||
+      line_cache->lines_per_entry == 0) {
+    *line_cache = (TextLayoutLineCache) {
+      .hash = text_hash,
+      .box_size = text_box_params->box.size,
+      .font = text_box_params->font,
+      .overflow_mode = text_box_params->overflow_mode,
+      .alignment = text_box_params->alignment,
+      .line_spacing_delta = text_box_params->line_spacing_delta,
+      .lines_per_entry = 1,
+    };
+  }
+  return line_cache;
+}
+
+void graphics_draw_text_with_line_cache(GContext* ctx, const char* text, GFont const font,
+                                        const GRect box, const GTextOverflowMode overflow_mode,
+                                        const GTextAlignment alignment,
+                                        GTextLayoutCacheRef const layout,
+                                        TextLayoutLineCache *line_cache) {
   if (ctx->lock) {
     return;
   }
@@ -1452,7 +1568,16 @@ void graphics_draw_text(GContext* ctx, const char* text, GFont const font,
     .line_spacing_delta = line_spacing_delta,
   };
 
-  prv_text_walk_lines(ctx, layout, &callbacks);
+  line_cache = prv_line_cache_prepare(line_cache, &utf8_bounds, layout,
+                                      &ctx->text_draw_state.text_box);
+  prv_text_walk_lines(ctx, layout, &callbacks, line_cache);
+}
+
+void graphics_draw_text(GContext* ctx, const char* text, GFont const font,
+                        GRect box, const GTextOverflowMode overflow_mode,
+                        const GTextAlignment alignment, GTextLayoutCacheRef const layout) {
+  graphics_draw_text_with_line_cache(ctx, text, font, box, overflow_mode, alignment, layout,
+                                     NULL);
 }
 
 void graphics_text_layout_cache_init(GTextLayoutCacheRef* layout) {
@@ -1471,6 +1596,39 @@ void graphics_text_layout_cache_deinit(GTextLayoutCacheRef* layout) {
   *layout = NULL;
 }
 
+//! A text layout cache that also remembers where its lines start. The layout comes first so that
+//! a pointer to this can be used as a GTextLayoutCacheRef.
+typedef struct {
+  TextLayoutExtended layout;
+  TextLayoutLineCache *line_cache;
+} TextLayoutWithLineCache;
+
+void graphics_text_layout_cache_init_with_line_cache(GTextLayoutCacheRef *layout) {
+  if (process_manager_compiled_with_legacy2_sdk()) {
+    graphics_text_layout_cache_init(layout);
+    return;
+  }
+  *layout = applib_zalloc(sizeof(TextLayoutWithLineCache));
+}
+
+void graphics_text_layout_cache_deinit_with_line_cache(GTextLayoutCacheRef *layout) {
+  if (*layout && !process_manager_compiled_with_legacy2_sdk()) {
+    applib_free(((TextLayoutWithLineCache *)*layout)->line_cache);
+  }
+  graphics_text_layout_cache_deinit(layout);
+}
+
+TextLayoutLineCache *graphics_text_layout_get_line_cache(GTextLayoutCacheRef layout) {
+  if (!layout || process_manager_compiled_with_legacy2_sdk()) {
+    return NULL;
+  }
+  TextLayoutWithLineCache *layout_with_line_cache = (TextLayoutWithLineCache *)layout;
+  if (!layout_with_line_cache->line_cache) {
+    layout_with_line_cache->line_cache = applib_zalloc(sizeof(TextLayoutLineCache));
+  }
+  return layout_with_line_cache->line_cache;
+}
+
 GTextAttributes *graphics_text_attributes_create(void) {
   GTextAttributes *result;
   graphics_text_layout_cache_init(&result);
@@ -85,6 +85,33 @@ typedef struct {
   LineIterState line_iter_state;
 } TextDrawState;
 
+//! Number of lines that can be remembered by a TextLayoutLineCache. Once it's full, every other
+//! entry is dropped and only every second line is remembered from then on.
+#define TEXT_LAYOUT_LINE_CACHE_NUM_ENTRIES (32)
+
+//! State of the word iterator and the line at the start of a line
+typedef struct {
+  uint16_t word_start; //<! Offset of the first word of the line from the start of the text
+  uint16_t word_end; //<! Offset of the end of that word from the start of the text
+  int16_t word_width_px;
+  int16_t origin_y; //<! Relative to text_box_params origin
+} TextLayoutLineCacheEntry;
+
+struct TextLayoutLineCache {
+  //! Invalidate the cache if these parameters have changed
+  uint32_t hash;
+  GSize box_size;
+  GFont font;
+  GTextOverflowMode overflow_mode;
+  GTextAlignment alignment;
+  int16_t line_spacing_delta;
+
+  //! Entry i holds the start of line i * lines_per_entry
+  uint16_t lines_per_entry;
+  uint16_t num_entries;
+  TextLayoutLineCacheEntry entries[TEXT_LAYOUT_LINE_CACHE_NUM_ENTRIES];
+};
+
 void char_iter_init(Iterator* char_iter, CharIterState* char_iter_state, const TextBoxParams* const text_box_params, utf8_t* start);
 void word_iter_init(Iterator* word_iter, WordIterState* word_iter_state, GContext* ctx, const TextBoxParams* const text_box_params, utf8_t* start);
 void line_iter_init(Iterator* line_iter, LineIterState* line_iter_state, GContext* ctx);
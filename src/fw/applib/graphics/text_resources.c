@@ -367,12 +367,26 @@ static const GlyphData *prv_get_glyph_metadata_from_spi(Codepoint codepoint,
   PBL_LOG_D_DBG(LOG_DOMAIN_TEXT, "looking up cp: %"PRIx32", key:%"PRIx32,
             codepoint, cache_key);
 
+  if (!font_cache->line_cache.buffer) {
+    lru_cache_init(&font_cache->line_cache, sizeof(LineCacheData), font_cache->cache_buffer,
+                   sizeof(font_cache->cache_buffer));
+  }
+
   // If the glyph_buffer doesn't match this glyph, or we have bitmap caching, check the
-  // keyed_circular_cache for this glyph.
+  // line_cache for this glyph.
   if (!cached) {
-    cached = keyed_circular_cache_get(&font_cache->line_cache, cache_key);
+    // Both nodes time the lookup, only the one matching its outcome is stopped so that their
+    // counts are the number of hits and misses
+    SYS_PROFILER_NODE_START(text_render_glyph_cache_hit);
+    SYS_PROFILER_NODE_START(text_render_glyph_cache_miss);
+    cached = lru_cache_get(&font_cache->line_cache, cache_key);
+    if (cached) {
+      SYS_PROFILER_NODE_STOP(text_render_glyph_cache_hit);
+    } else {
+      SYS_PROFILER_NODE_STOP(text_render_glyph_cache_miss);
+    }
 #if !CAPABILITY_HAS_GLYPH_BITMAP_CACHING
-    // If we don't have bitmap caching, the keyed_circular_cache entry cannot store the bitmap.
+    // If we don't have bitmap caching, the line_cache entry cannot store the bitmap.
     // Therefore, we need to copy the matched entry into `glyph_buffer` which does have the space
     // to store the bitmap.
     if (cached) {
@@ -407,7 +421,7 @@ static const GlyphData *prv_get_glyph_metadata_from_spi(Codepoint codepoint,
   if (data->resource_offset == 0) {
     PBL_LOG_D_DBG(LOG_DOMAIN_TEXT, "offset for cp: %"PRIx32" is NULL", codepoint);
     // Put the missing character into our cache so we don't waste time looking for it again
-    keyed_circular_cache_push(&font_cache->line_cache, cache_key, data);
+    lru_cache_put(&font_cache->line_cache, cache_key, data);
     return NULL;
   }
 
@@ -446,7 +460,7 @@ static const GlyphData *prv_get_glyph_metadata_from_spi(Codepoint codepoint,
   // Copy the info into the glyph_buffer.
   // This must be done _before_ loading the bitmap, otherwise loading the bitmap may modify the
   // metadata! We will use `glyph_buffer` as the final data, and leave `data` as the uncooked
-  // version, that way we can push `data` into the circular cache.
+  // version, that way we can put `data` into the line_cache.
   memcpy(font_cache->glyph_buffer, data, sizeof(LineCacheData));
   font_cache->glyph_buffer_key = cache_key;
 
@@ -460,12 +474,12 @@ static const GlyphData *prv_get_glyph_metadata_from_spi(Codepoint codepoint,
     return NULL;
   }
 
-  // We push `data`, which will be cooked data if the bitmap is stored along with it, or
+  // We put `data`, which will be cooked data if the bitmap is stored along with it, or
   // the uncooked data if it's not. In reality, this only matters to compressed glyphs, since
   // compressed glyphs are the only case where the metadata gets modified.
   // The only time the data is cooked is when loading a bitmap and the glyph is compressed, in
   // which case the `num_rle_units` field is turned back into `height_px`.
-  keyed_circular_cache_push(&font_cache->line_cache, cache_key, data);
+  lru_cache_put(&font_cache->line_cache, cache_key, data);
 
   // We return `final_data` though, because that has the actual metadata info that needs to be
   // used.
@@ -5,7 +5,7 @@
 
 #include "applib/fonts/fonts_private.h"
 #include "applib/fonts/codepoint.h"
-#include "util/keyed_circular_cache.h"
+#include "util/lru_cache.h"
 
 #include <stdint.h>
 
@@ -85,6 +85,10 @@ typedef struct {
 
 #define LINE_CACHE_SIZE 30
 
+//! Size of a glyph cache buffer that holds `num_glyphs` glyphs
+#define LINE_CACHE_BUFFER_SIZE(num_glyphs) \
+    ((num_glyphs) * (sizeof(CacheEntry) + sizeof(LineCacheData)))
+
 // Allow 1K max for offset tables
 #define OFFSET_TABLE_MAX_SIZE (1024)
 
@@ -99,10 +103,8 @@ typedef struct FontCache {
     OffsetTableEntry_4_2 offsets_buffer_4_2[OFFSET_TABLE_MAX_SIZE / sizeof(OffsetTableEntry_4_2)];
     OffsetTableEntry_4_4 offsets_buffer_4_4[OFFSET_TABLE_MAX_SIZE / sizeof(OffsetTableEntry_4_4)];
   };
-  //! line_cache's backing storage for keys
-  KeyedCircularCacheKey cache_keys[LINE_CACHE_SIZE];
-  //! line_cache's backing storage for data
-  LineCacheData cache_data[LINE_CACHE_SIZE];
+  //! line_cache's backing storage
+  uint8_t cache_buffer[LINE_CACHE_BUFFER_SIZE(LINE_CACHE_SIZE)];
   //! some scratch space so we don't need to create a LineCacheData on the stack
   LineCacheData cache_data_scratch;
 
@@ -113,7 +115,9 @@ typedef struct FontCache {
   //! data for the last used glyph
   uint8_t glyph_buffer[sizeof(LineCacheData) + CACHE_GLYPH_SIZE];
 #endif
-  KeyedCircularCache line_cache;
+  //! Glyph metadata (and bitmaps with CAPABILITY_HAS_GLYPH_BITMAP_CACHING) by cache key. This is
+  //! set up with cache_buffer the first time a glyph is looked up.
+  LRUCache line_cache;
   const FontResource *cached_font;
 } FontCache;
 
@@ -670,8 +670,31 @@ static HealthValue prv_compute_aggregate_using_minute_history(
     }
   }
 
+  // Most ranges can be answered from the activity service's summary index of the minute data,
+  // which saves us from fetching every minute in the range
+  ActivityMinuteAggregate minute_aggregate;
+  const bool have_aggregate = sys_activity_get_minute_aggregate(time_start, time_end,
+                                                                &minute_aggregate);
+  if (have_aggregate && (minute_aggregate.heart_rate_samples > 0)) {
+    num_samples += minute_aggregate.heart_rate_samples;
+    switch (aggregation) {
+      case HealthAggregationAvg:
+        value += minute_aggregate.heart_rate_sum_bpm;
+        break;
+      case HealthAggregationMax:
+        value = MAX(value, minute_aggregate.heart_rate_max_bpm);
+        break;
+      case HealthAggregationMin:
+        value = MIN(value, minute_aggregate.heart_rate_min_bpm);
+        break;
+      case HealthAggregationSum:
+        WTF;
+        break;
+    }
+  }
+
   HealthMinuteData *minute_data = state->cache->minute_data;
-  bool more_data = true;
+  bool more_data = !have_aggregate;
   while (more_data && (time_start < time_end)) {
     uint32_t num_records = ARRAY_LENGTH(state->cache->minute_data);
     PBL_LOG_DBG("Fetching %"PRIu32" minute records for %d to %d...", num_records,
@@ -727,6 +750,60 @@ static HealthValue prv_compute_aggregate_using_minute_history(
   return value;
 }
 
+// ----------------------------------------------------------------------------------------------
+// Compute the sum of the given metric from the activity service's summary index of the minute
+// data. Returns false if the metric is not kept in the index or the time range reaches back
+// further than the index covers.
+static bool prv_compute_sum_using_minute_aggregate(HealthMetric metric, time_t time_start,
+                                                   time_t time_end, HealthValue *result) {
+  switch (metric) {
+    case HealthMetricStepCount:
+    case HealthMetricActiveSeconds:
+    case HealthMetricWalkedDistanceMeters:
+    case HealthMetricRestingKCalories:
+    case HealthMetricActiveKCalories:
+      break;
+    default:
+      return false;
+  }
+
+  const time_t now_utc = sys_get_time();
+  if ((now_utc - time_start) > ACTIVITY_MINUTE_AGGREGATE_MAX_AGE_SEC) {
+    return false;
+  }
+  // Today's total is exact already, no need to add it up
+  if ((time_start == sys_time_start_of_today()) && (time_end >= now_utc)) {
+    return false;
+  }
+
+  ActivityMinuteAggregate aggregate;
+  if (!sys_activity_get_minute_aggregate(time_start, time_end, &aggregate)) {
+    return false;
+  }
+
+  const int k_cm_per_meter = 100;
+  switch (metric) {
+    case HealthMetricStepCount:
+      *result = aggregate.steps;
+      break;
+    case HealthMetricActiveSeconds:
+      *result = aggregate.active_minutes * SECONDS_PER_MINUTE;
+      break;
+    case HealthMetricWalkedDistanceMeters:
+      *result = ROUND(aggregate.distance_cm, k_cm_per_meter);
+      break;
+    case HealthMetricRestingKCalories:
+      *result = ROUND(aggregate.resting_calories, ACTIVITY_CALORIES_PER_KCAL);
+      break;
+    case HealthMetricActiveKCalories:
+      *result = ROUND(aggregate.active_calories, ACTIVITY_CALORIES_PER_KCAL);
+      break;
+    default:
+      WTF;
+  }
+  return true;
+}
+
 // ---------------------------------------------------------------------------------------------
 // Init a metric alert info structure
 static void prv_init_metric_alert(HealthServiceState *state, HealthMetric metric,
@@ -1120,6 +1197,15 @@ HealthValue health_service_aggregate_averaged(HealthMetric metric, time_t time_s
     return result;
   }
 
+  // --------
+  // Sums over the last few hours are answered from the summary index of the minute data
+  if ((scope == HealthServiceTimeScopeOnce) && (aggregation == HealthAggregationSum)) {
+    HealthValue result;
+    if (prv_compute_sum_using_minute_aggregate(metric, time_start, time_end, &result)) {
+      return result;
+    }
+  }
+
   // --------
   // Default handling is to use daily totals
   if (scope == HealthServiceTimeScopeOnce) {
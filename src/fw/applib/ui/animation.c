@@ -64,6 +64,106 @@ static bool prv_handle_list_filter(ListNode* node, void* data) {
   return animation->handle == data;
 }
 
+static uint32_t prv_handle_table_slot(AnimationAuxState *aux, Animation *handle) {
+  // Handles are handed out sequentially, so the low bits spread them evenly across the table
+  return (uintptr_t)handle & (aux->handle_table_size - 1);
+}
+
+static void prv_handle_table_insert(AnimationAuxState *aux, AnimationPrivate *animation) {
+  uint32_t slot = prv_handle_table_slot(aux, animation->handle);
+  while (aux->handle_table[slot]) {
+    slot = (slot + 1) & (aux->handle_table_size - 1);
+  }
+  aux->handle_table[slot] = animation;
+  aux->handle_table_count++;
+}
+
+static void prv_handle_table_insert_list(AnimationAuxState *aux, ListNode *head) {
+  for (ListNode *node = head; node; node = list_get_next(node)) {
+    prv_handle_table_insert(aux, (AnimationPrivate *)node);
+  }
+}
+
+// Reallocate the handle table, sized for all the animations in the lists, and fill it from them.
+// If the allocation fails, the table is dropped and lookups go back to walking the lists.
+static void prv_handle_table_rebuild(AnimationState *state) {
+  AnimationAuxState *aux = state->aux;
+  const uint32_t count = list_count(state->unscheduled_head) + list_count(state->scheduled_head);
+  // Keep the table at most 3/4 full so that probe sequences stay short
+  uint32_t size = ANIMATION_HANDLE_TABLE_MIN_SIZE;
+  while (count * 4 > size * 3) {
+    size *= 2;
+  }
+
+  applib_free(aux->handle_table);
+  aux->handle_table = (size <= UINT16_MAX) ? applib_zalloc(size * sizeof(AnimationPrivate *))
+                                           : NULL;
+  aux->handle_table_size = aux->handle_table ? size : 0;
+  aux->handle_table_count = 0;
+  if (!aux->handle_table) {
+    return;
+  }
+  prv_handle_table_insert_list(aux, state->unscheduled_head);
+  prv_handle_table_insert_list(aux, state->scheduled_head);
+}
+
+// Must be called after the animation has been added to one of the lists
+static void prv_handle_index_add(AnimationState *state, AnimationPrivate *animation) {
+  AnimationAuxState *aux = state->aux;
+  if ((aux->handle_table_count + 1) * 4 > aux->handle_table_size * 3) {
+    // This picks up the new animation from the lists
+    prv_handle_table_rebuild(state);
+    return;
+  }
+  prv_handle_table_insert(aux, animation);
+}
+
+static void prv_handle_index_remove(AnimationState *state, AnimationPrivate *animation) {
+  AnimationAuxState *aux = state->aux;
+  if (!aux->handle_table) {
+    return;
+  }
+  const uint32_t mask = aux->handle_table_size - 1;
+  uint32_t slot = prv_handle_table_slot(aux, animation->handle);
+  while (aux->handle_table[slot] != animation) {
+    if (!aux->handle_table[slot]) {
+      return;
+    }
+    slot = (slot + 1) & mask;
+  }
+
+  // Shift later entries of the probe sequence back into the hole so that lookups, which stop at
+  // the first empty slot, still find them
+  uint32_t hole = slot;
+  for (uint32_t next = (hole + 1) & mask; aux->handle_table[next]; next = (next + 1) & mask) {
+    const uint32_t home = prv_handle_table_slot(aux, aux->handle_table[next]->handle);
+    if (((next - home) & mask) >= ((next - hole) & mask)) {
+      aux->handle_table[hole] = aux->handle_table[next];
+      hole = next;
+    }
+  }
+  aux->handle_table[hole] = NULL;
+  aux->handle_table_count--;
+}
+
+static AnimationPrivate *prv_handle_index_find(AnimationState *state, Animation *handle) {
+  AnimationAuxState *aux = state->aux;
+  if (!aux->handle_table) {
+    // Look for this animation by id. It could either be in the unscheduled or scheduled list
+    ListNode* node = list_find(state->unscheduled_head, prv_handle_list_filter, (void*)handle);
+    if (!node) {
+      node = list_find(state->scheduled_head, prv_handle_list_filter, (void*)handle);
+    }
+    return (AnimationPrivate *)node;
+  }
+
+  uint32_t slot = prv_handle_table_slot(aux, handle);
+  while (aux->handle_table[slot] && aux->handle_table[slot]->handle != handle) {
+    slot = (slot + 1) & (aux->handle_table_size - 1);
+  }
+  return aux->handle_table[slot];
+}
+
 
 // ------------------------------------------------------------------------------------
 // Find annotation by handle. If quiet is true, don't print out a log error message if we detect
@@ -79,18 +179,14 @@ static AnimationPrivate* prv_find_animation_by_handle(AnimationState *state, Ani
     state = prv_animation_state_get(PebbleTask_Current);
   }
 
-  // Look for this animation by id. It could either be in the unscheduled or scheduled list
-  ListNode* node = list_find(state->unscheduled_head, prv_handle_list_filter, (void*)handle);
-  if (!node) {
-    node = list_find(state->scheduled_head, prv_handle_list_filter, (void*)handle);
-  }
-  if (!node) {
+  AnimationPrivate *animation = prv_handle_index_find(state, handle);
+  if (!animation) {
     if (!quiet) {
       APP_LOG(APP_LOG_LEVEL_ERROR, "Animation %d does not exist", (int)handle);
     }
     return NULL;
   }
-  return (AnimationPrivate *)node;
+  return animation;
 }
 
 
@@ -149,6 +245,7 @@ static void prv_unlink_and_free(AnimationState *state, AnimationPrivate *animati
   // It's an error if it's scheduled
   PBL_ASSERTN(list_contains(state->unscheduled_head, &animation->list_node));
   list_remove(&animation->list_node, &state->unscheduled_head /* &head */, NULL /* &tail */);
+  prv_handle_index_remove(state, animation);
 
   ANIMATION_LOG_DEBUG("destroying %d (%p) ", (int)animation->handle, animation);
   applib_free(animation);
@@ -1079,6 +1176,7 @@ void animation_private_state_init(AnimationState *state) {
 void animation_private_state_deinit(AnimationState *state) {
 
   if (!process_manager_compiled_with_legacy2_sdk()) {
+    applib_free(state->aux->handle_table);
     applib_free(state->aux);
   }
 }
@@ -1116,6 +1214,7 @@ Animation *animation_private_animation_init(AnimationPrivate *animation) {
   PBL_ASSERTN(animation->handle);
 
   state->unscheduled_head = list_insert_before(state->unscheduled_head, &animation->list_node);
+  prv_handle_index_add(state, animation);
   ANIMATION_LOG_DEBUG("creating %d (%p)", (int)animation->handle, animation);
   return (Animation *)(animation->handle);
 }
@@ -11,6 +11,7 @@
 #define ANIMATION_MAX_CHILDREN  256
 #define ANIMATION_PLAY_COUNT_INFINITE_STORED ((uint16_t)~0)
 #define ANIMATION_MAX_CREATE_VARGS  20
+#define ANIMATION_HANDLE_TABLE_MIN_SIZE  16
 
 typedef enum {
   AnimationTypePrimitive,
@@ -92,6 +93,13 @@ typedef struct {
   //! The next Animation to be iterated, NULL if at end of iteration or not iterating.
   //! This allows arbitrarily unscheduling any animation at any time.
   ListNode *iter_next;
+
+  //! Open addressed hash table of all animations, scheduled or not, keyed by handle. It is
+  //! allocated separately so that it can grow with the number of animations. NULL if it could
+  //! not be allocated, in which case lookups fall back to walking the lists.
+  AnimationPrivate **handle_table;
+  uint16_t handle_table_size;   //! Number of slots, always a power of 2
+  uint16_t handle_table_count;  //! Number of slots in use
 } AnimationAuxState;
 
 
@@ -77,7 +77,17 @@ void layer_destroy(Layer* layer) {
   applib_free(layer);
 }
 
+//! Flags the area covered by a layer for layer_render_tree_dirty_region(). Layers that don't clip
+//! can draw outside of their frame, so the flag goes to the closest ancestor that clips.
+static void prv_mark_dirty_region(Layer *layer) {
+  while (!layer->clips && layer->parent) {
+    layer = layer->parent;
+  }
+  layer->is_dirty = true;
+}
+
 void layer_mark_dirty(Layer *layer) {
+  prv_mark_dirty_region(layer);
   if (layer->property_changed_proc) {
     layer->property_changed_proc(layer);
   }
@@ -153,20 +163,52 @@ Layer *__layer_tree_traverse_next__test_accessor(Layer *stack[],
   return prv_layer_tree_traverse_next(stack, max_depth, current_depth, descend);
 }
 
-void layer_render_tree(Layer *node, GContext *ctx) {
+//! Derives the draw state of a layer from the draw state of its parent
+static void prv_layer_tree_draw_state_apply(const Layer *layer, const LayerTreeDrawState *parent,
+                                            LayerTreeDrawState *state) {
+  state->clip_box = parent->clip_box;
+  if (layer->clips) {
+    const GRect frame_in_ctx_space = {
+      // drawing_origin is expected to be setup as the bounds of the parent:
+      .origin = gpoint_add(parent->drawing_origin, layer->frame.origin),
+      .size = layer->frame.size,
+    };
+    grect_clip(&state->clip_box, &frame_in_ctx_space);
+  }
+  // translate the drawing_box to the bounds of the layer:
+  state->drawing_origin = gpoint_add(gpoint_add(parent->drawing_origin, layer->frame.origin),
+                                     layer->bounds.origin);
+}
+
+//! Called for every visible layer whose clip box isn't empty, with ctx->draw_state set up for
+//! the layer. Returns whether to descend into the layer's children.
+typedef bool (*LayerTreeVisitor)(Layer *node, GContext *ctx, const LayerTreeDrawState *state,
+                                 void *context);
+
+static void prv_layer_tree_walk(Layer *node, GContext *ctx, const GRect *clip_box,
+                                LayerTreeVisitor visitor, void *context) {
   // NOTE: make sure to restore ctx->draw_state before leaving this function
   const GDrawState root_draw_state = ctx->draw_state;
+  const LayerTreeDrawState root_state = {
+    .clip_box = *clip_box,
+    .drawing_origin = root_draw_state.drawing_box.origin,
+  };
   uint8_t current_depth = 0;
 
   // We render our layout tree using a stack as opposed to using recursion to optimize for task
   // stack usage. We can't allocate this stack on the stack anymore without blowing our stack
   // up when doing a few common operations. We don't want to allocate this on the app heap as we
   // didn't before and that would cause less RAM to be available to apps after a firmware upgrade.
+  // The draw state of every level is kept next to it so that each layer's draw state only has to
+  // be derived from its parent's.
   Layer **stack;
+  LayerTreeDrawState *draw_states;
   if (pebble_task_get_current() == PebbleTask_App) {
     stack = app_state_get_layer_tree_stack();
+    draw_states = app_state_get_layer_tree_draw_state_stack();
   } else {
     stack = kernel_applib_get_layer_tree_stack();
+    draw_states = kernel_applib_get_layer_tree_draw_state_stack();
   }
   stack[0] = node;
 
@@ -175,45 +217,17 @@ void layer_render_tree(Layer *node, GContext *ctx) {
     if (node->hidden) {
       goto node_hidden_do_not_descend;
     }
-    // prepare draw_state for the current layer
-    // it will not be stored and restored but recalculated from the root
-    // for every layer
-    for (unsigned int level = 0; level <= current_depth; level++) {
-      const Layer *levels_layer = stack[level];
-      if (levels_layer->clips) {
-        const GRect levels_layer_frame_in_ctx_space = {
-            .origin = {
-                // drawing_box is expected to be setup as the bounds of the parent:
-                .x = ctx->draw_state.drawing_box.origin.x + levels_layer->frame.origin.x,
-                .y = ctx->draw_state.drawing_box.origin.y + levels_layer->frame.origin.y,
-            },
-            .size = levels_layer->frame.size,
-        };
-        grect_clip(&ctx->draw_state.clip_box, &levels_layer_frame_in_ctx_space);
-      }
-
-      // translate the drawing_box to the bounds of the layer:
-      ctx->draw_state.drawing_box.origin.x +=
-          levels_layer->frame.origin.x + levels_layer->bounds.origin.x;
-      ctx->draw_state.drawing_box.origin.y +=
-          levels_layer->frame.origin.y + levels_layer->bounds.origin.y;
-      ctx->draw_state.drawing_box.size = levels_layer->bounds.size;
-    }
-
-    if (!grect_is_empty(&ctx->draw_state.clip_box)) {
-      // call the current node's render procedure
-      if (node->update_proc) {
-        node->update_proc(node, ctx);
-      }
-
-      // if client has forgotten to release frame buffer
-      if (ctx->lock) {
-        graphics_release_frame_buffer(ctx, &ctx->dest_bitmap);
-        APP_LOG(APP_LOG_LEVEL_WARNING,
-            "Frame buffer was not released. "
-            "Make sure to call graphics_release_frame_buffer before leaving update_proc.");
-      }
-      descend = true;
+    LayerTreeDrawState *state = &draw_states[current_depth];
+    prv_layer_tree_draw_state_apply(node, current_depth ? &draw_states[current_depth - 1]
+                                                        : &root_state, state);
+
+    if (!grect_is_empty(&state->clip_box)) {
+      ctx->draw_state.clip_box = state->clip_box;
+      ctx->draw_state.drawing_box = (GRect) {
+        .origin = state->drawing_origin,
+        .size = node->bounds.size,
+      };
+      descend = visitor(node, ctx, state, context);
     }
 
 node_hidden_do_not_descend:
@@ -223,6 +237,66 @@ node_hidden_do_not_descend:
   }
 }
 
+static bool prv_render_layer(Layer *node, GContext *ctx, const LayerTreeDrawState *state,
+                             void *context) {
+  const bool *clear_dirty = context;
+  if (*clear_dirty) {
+    // Cleared before calling update_proc so that it can mark the layer dirty again
+    node->is_dirty = false;
+  }
+
+  // call the current node's render procedure
+  if (node->update_proc) {
+    node->update_proc(node, ctx);
+  }
+
+  // if client has forgotten to release frame buffer
+  if (ctx->lock) {
+    graphics_release_frame_buffer(ctx, &ctx->dest_bitmap);
+    APP_LOG(APP_LOG_LEVEL_WARNING,
+        "Frame buffer was not released. "
+        "Make sure to call graphics_release_frame_buffer before leaving update_proc.");
+  }
+  return true;
+}
+
+void layer_render_tree(Layer *node, GContext *ctx) {
+  bool clear_dirty = true;
+  prv_layer_tree_walk(node, ctx, &ctx->draw_state.clip_box, prv_render_layer, &clear_dirty);
+}
+
+static bool prv_collect_dirty_layer(Layer *node, GContext *ctx, const LayerTreeDrawState *state,
+                                    void *context) {
+  GRect *dirty_rect = context;
+  if (node->is_dirty) {
+    node->is_dirty = false;
+    if (grect_is_empty(dirty_rect)) {
+      *dirty_rect = state->clip_box;
+    } else {
+      // Bounding box of both, can't use grect_union() as it's limited to 8 bit coordinates
+      const int16_t min_x = MIN(dirty_rect->origin.x, state->clip_box.origin.x);
+      const int16_t min_y = MIN(dirty_rect->origin.y, state->clip_box.origin.y);
+      const int16_t max_x = MAX(grect_get_max_x(dirty_rect), grect_get_max_x(&state->clip_box));
+      const int16_t max_y = MAX(grect_get_max_y(dirty_rect), grect_get_max_y(&state->clip_box));
+      *dirty_rect = GRect(min_x, min_y, max_x - min_x, max_y - min_y);
+    }
+  }
+  return true;
+}
+
+void layer_render_tree_dirty_region(Layer *node, GContext *ctx) {
+  GRect dirty_rect = GRectZero;
+  prv_layer_tree_walk(node, ctx, &ctx->draw_state.clip_box, prv_collect_dirty_layer,
+                      &dirty_rect);
+  if (grect_is_empty(&dirty_rect)) {
+    return;
+  }
+  grect_clip(&dirty_rect, &ctx->draw_state.clip_box);
+
+  bool clear_dirty = false;
+  prv_layer_tree_walk(node, ctx, &dirty_rect, prv_render_layer, &clear_dirty);
+}
+
 void layer_property_changed_tree(Layer *node) {
   layer_process_tree(node, NULL, layer_property_changed_tree_node);
 }
@@ -239,6 +313,10 @@ void layer_set_frame(Layer *layer, const GRect *frame) {
   const bool bounds_in_sync = gpoint_equal(&layer->bounds.origin, &GPointZero) &&
                               gsize_equal(&layer->bounds.size, &layer->frame.size);
 
+  // The area the layer is moving away from has to be redrawn as well
+  if (layer->parent) {
+    prv_mark_dirty_region(layer->parent);
+  }
   layer->frame = *frame;
 
   if (bounds_in_sync && !process_manager_compiled_with_legacy2_sdk()) {
@@ -336,6 +414,7 @@ void layer_remove_from_parent(Layer *child) {
   if (!child || child->parent == NULL) {
     return;
   }
+  prv_mark_dirty_region(child->parent);
   if (child->parent->window) {
     window_schedule_render(child->parent->window);
   }
@@ -372,6 +451,7 @@ void layer_add_child(Layer *parent, Layer *child) {
   PBL_ASSERTN(child->next_sibling == NULL);
   child->parent = parent;
   layer_set_window(child, parent->window);
+  prv_mark_dirty_region(child);
   if (child->window) {
     window_schedule_render(child->window);
   }
@@ -408,6 +488,7 @@ void layer_insert_below_sibling(Layer *layer_to_insert, Layer *below_layer) {
   PBL_ASSERTN(layer_to_insert->next_sibling == NULL);
   layer_to_insert->parent = below_layer->parent;
   layer_set_window(layer_to_insert, below_layer->window);
+  prv_mark_dirty_region(layer_to_insert);
   if (layer_to_insert->window) {
     window_schedule_render(layer_to_insert->window);
   }
@@ -435,6 +516,7 @@ void layer_insert_above_sibling(Layer *layer_to_insert, Layer *above_layer) {
   PBL_ASSERTN(layer_to_insert->next_sibling == NULL);
   layer_to_insert->parent = above_layer->parent;
   layer_set_window(layer_to_insert, above_layer->window);
+  prv_mark_dirty_region(layer_to_insert);
   if (layer_to_insert->window) {
     window_schedule_render(layer_to_insert->window);
   }
@@ -462,6 +544,10 @@ void layer_set_clips(Layer *layer, bool clips) {
     return;
   }
   layer->clips = clips;
+  // A layer that stops clipping may have drawn outside of its frame before
+  if (layer->parent) {
+    prv_mark_dirty_region(layer->parent);
+  }
   layer_mark_dirty(layer);
 }
 
@@ -14,6 +14,16 @@ struct Animation;
 //! How deep our layer tree is allowed to be.
 #define LAYER_TREE_STACK_SIZE 16
 
+//! @internal
+//! The part of the draw state that layer_render_tree() derives from the layer hierarchy. One of
+//! these is kept per level of the tree while rendering so that each layer's draw state is
+//! computed from its parent's instead of from the root.
+typedef struct LayerTreeDrawState {
+  GRect clip_box;
+  //! Origin of the layer's drawing_box, its size is always the layer's bounds size
+  GPoint drawing_origin;
+} LayerTreeDrawState;
+
 //! @file layer.h
 //! @addtogroup UI
 //! @{
@@ -101,6 +111,9 @@ typedef struct Layer {
       bool hidden:1;
       bool has_data:1;
       bool is_highlighted:1; //!< Indicates the highlight status of a \ref MenuLayer cell
+      //! Set by layer_mark_dirty() and friends when the area covered by the layer has to be
+      //! redrawn, see \ref layer_render_tree_dirty_region()
+      bool is_dirty:1;
     };
   };
 
@@ -180,6 +193,12 @@ void layer_destroy(Layer* layer);
 //! Renders a tree of layers to a graphics context
 void layer_render_tree(Layer *root, GContext *ctx);
 
+//! @internal
+//! Renders only the parts of a tree of layers that were marked dirty since it was last rendered.
+//! The clip box is limited to the bounding box of the dirty layers and layers outside of it are
+//! skipped. Relies on the framebuffer still holding the previous render of the tree.
+void layer_render_tree_dirty_region(Layer *root, GContext *ctx);
+
 //! @internal
 //! Process the PropertyChangedProc callback for a tree of layers
 void layer_property_changed_tree(Layer *root);
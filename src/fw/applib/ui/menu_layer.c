@@ -577,6 +577,148 @@ static void prv_menu_layer_walk_upward_from_iterator(MenuIterator *it) {
   } // for() sections
 }
 
+//////////////////////
+// Geometry index
+//
+// NOTES: With the index enabled, menu_layer_update_caches() records the y offset of every row
+// while it walks the whole menu to compute the content size anyway. Selecting an index or
+// scrolling far away then looks the row up instead of walking all the rows in between from the
+// cached cursor, asking the client for the height of each one of them.
+
+static void prv_geometry_index_free(MenuLayer *menu_layer) {
+  applib_free(menu_layer->geometry_index);
+  menu_layer->geometry_index = NULL;
+}
+
+//! Allocates an index for the current number of rows, the offsets are recorded by the caller
+static MenuLayerGeometryIndex *prv_geometry_index_create(MenuLayer *menu_layer) {
+  const uint16_t num_sections = prv_menu_layer_get_num_sections(menu_layer);
+  uint32_t num_rows = 0;
+  for (uint16_t section = 0; section < num_sections; section++) {
+    num_rows += prv_menu_layer_get_num_rows(menu_layer, section);
+  }
+  if (num_rows > UINT16_MAX) {
+    return NULL;
+  }
+
+  MenuLayerGeometryIndex *index = applib_malloc(sizeof(MenuLayerGeometryIndex) +
+                                                num_rows * sizeof(int16_t) +
+                                                (num_sections + 1) * sizeof(uint16_t));
+  if (!index) {
+    return NULL;
+  }
+  index->num_sections = num_sections;
+  index->num_rows = num_rows;
+  index->section_start = (uint16_t *)&index->row_y[num_rows];
+  uint16_t section_start = 0;
+  for (uint16_t section = 0; section < num_sections; section++) {
+    index->section_start[section] = section_start;
+    section_start += prv_menu_layer_get_num_rows(menu_layer, section);
+  }
+  index->section_start[num_sections] = section_start;
+  return index;
+}
+
+//! @return The position of the row in row_y, or -1 if the index doesn't know about it
+static int prv_geometry_index_get_row(const MenuLayerGeometryIndex *index,
+                                      const MenuIndex *cell_index) {
+  if (!index || cell_index->section >= index->num_sections) {
+    return -1;
+  }
+  const int row = index->section_start[cell_index->section] + cell_index->row;
+  if (row >= index->section_start[cell_index->section + 1]) {
+    return -1;
+  }
+  return row;
+}
+
+//! @return The row at the given content y offset, or the closest one if there is none
+static MenuIndex prv_geometry_index_find_row(const MenuLayerGeometryIndex *index, int16_t y) {
+  // Last row that starts at or above y
+  int lo = 0;
+  int hi = index->num_rows - 1;
+  while (lo < hi) {
+    const int mid = (lo + hi + 1) / 2;
+    if (index->row_y[mid] <= y) {
+      lo = mid;
+    } else {
+      hi = mid - 1;
+    }
+  }
+  // Last section that starts at or before that row, which skips over empty sections
+  int section_lo = 0;
+  int section_hi = index->num_sections - 1;
+  while (section_lo < section_hi) {
+    const int mid = (section_lo + section_hi + 1) / 2;
+    if (index->section_start[mid] <= lo) {
+      section_lo = mid;
+    } else {
+      section_hi = mid - 1;
+    }
+  }
+  return MenuIndex(section_lo, lo - index->section_start[section_lo]);
+}
+
+//! @return The separator height above a row, as prv_menu_layer_walk_downward_from_iterator() and
+//! menu_layer_update_caches() leave it in the cursor when reaching the row
+static int16_t prv_geometry_index_get_separator_height_above(MenuLayer *menu_layer,
+                                                             const MenuIndex *cell_index) {
+  if (cell_index->row > 0) {
+    MenuIndex above = MenuIndex(cell_index->section, cell_index->row - 1);
+    return prv_menu_layer_get_separator_height(menu_layer, &above);
+  }
+  const MenuLayerGeometryIndex *index = menu_layer->geometry_index;
+  for (uint16_t section = cell_index->section; section > 0; section--) {
+    MenuIndex header = MenuIndex(section, 0);
+    if (prv_menu_layer_get_header_height(menu_layer, section) > 0) {
+      return prv_menu_layer_get_separator_height(menu_layer, &header);
+    }
+    const uint16_t num_rows_above = index->section_start[section] -
+                                    index->section_start[section - 1];
+    if (num_rows_above > 0) {
+      MenuIndex above = MenuIndex(section - 1, num_rows_above - 1);
+      return prv_menu_layer_get_separator_height(menu_layer, &above);
+    }
+  }
+  return prv_menu_layer_get_separator_height(menu_layer, NULL);
+}
+
+//! Looks up the geometry of a row, except for its height which depends on the selection
+//! @return True if the index knows about the row, false if the caller needs to walk to it
+static bool prv_geometry_index_get_span(MenuLayer *menu_layer, const MenuIndex *cell_index,
+                                        MenuCellSpan *span) {
+  const int row = prv_geometry_index_get_row(menu_layer->geometry_index, cell_index);
+  if (row < 0) {
+    return false;
+  }
+  *span = (MenuCellSpan) {
+    .y = menu_layer->geometry_index->row_y[row],
+    .sep = prv_geometry_index_get_separator_height_above(menu_layer, cell_index),
+    .index = *cell_index,
+  };
+  return true;
+}
+
+//! Moves the render cursor to the top of the visible content if it is more than a screen away
+static void prv_geometry_index_seek_cache_cursor(MenuLayer *menu_layer, int16_t content_top_y,
+                                                 int16_t content_bottom_y) {
+  const MenuLayerGeometryIndex *index = menu_layer->geometry_index;
+  if (!index || index->num_rows == 0) {
+    return;
+  }
+  const int32_t frame_height = content_bottom_y - content_top_y;
+  const int32_t cursor_y = menu_layer->cache.cursor.y;
+  if (cursor_y >= content_top_y - frame_height && cursor_y <= content_bottom_y + frame_height) {
+    return;
+  }
+  const MenuIndex top_index = prv_geometry_index_find_row(index, content_top_y);
+  MenuCellSpan span;
+  if (prv_geometry_index_get_span(menu_layer, &top_index, &span)) {
+    span.h = prv_menu_layer_get_cell_height(menu_layer, &span.index, true);
+    menu_layer->cache.cursor = span;
+  }
+}
+
 static void NOINLINE prv_draw_background(MenuLayer *menu_layer, GContext *ctx,
                                 Layer *bg_layer, bool highlight) {
   GDrawState prev_state = graphics_context_get_drawing_state(ctx);
@@ -616,6 +758,8 @@ void menu_layer_update_proc(Layer *scroll_content_layer, GContext* ctx) {
   if (menu_layer->center_focused) {
     // in this mode, the selected row is always the best candidate for the cache
     menu_layer->cache.cursor = menu_layer->selection;
+  } else {
+    prv_geometry_index_seek_cache_cursor(menu_layer, content_top_y, content_bottom_y);
   }
 
   *render_iter = (MenuRenderIterator) {
@@ -724,6 +868,7 @@ void menu_layer_pad_bottom_enable(MenuLayer *menu_layer, bool enable) {
 
 void menu_layer_deinit(MenuLayer *menu_layer) {
   prv_cancel_selection_animation(menu_layer);
+  prv_geometry_index_free(menu_layer);
   layer_deinit(&menu_layer->inverter.layer);
   scroll_layer_deinit(&menu_layer->scroll_layer);
 }
@@ -747,6 +892,9 @@ ScrollLayer* menu_layer_get_scroll_layer(const MenuLayer *menu_layer) {
 typedef struct MenuPrimeCacheIterator {
   MenuIterator it;
   bool cache_set;
+  //! Index to record the row offsets into, if enabled
+  MenuLayerGeometryIndex *geometry_index;
+  uint32_t num_rows_recorded;
 } MenuPrimeCacheIterator;
 
 static void prv_menu_layer_iterator_noop_callback(MenuIterator *it) {
@@ -762,6 +910,12 @@ static void prv_menu_layer_iterator_prime_cache_callback(MenuIterator *iterator)
     it->it.menu_layer->selection = it->it.cursor;
     it->cache_set = true;
   }
+  if (it->geometry_index) {
+    if (it->num_rows_recorded < it->geometry_index->num_rows) {
+      it->geometry_index->row_y[it->num_rows_recorded] = it->it.cursor.y;
+    }
+    it->num_rows_recorded++;
+  }
 }
 
 //! Calculate the total height of all row cells and section headers,
@@ -770,6 +924,8 @@ static void prv_menu_layer_iterator_prime_cache_callback(MenuIterator *iterator)
 void menu_layer_update_caches(MenuLayer *menu_layer) {
   // Save the currently selected cell index.
   MenuIndex selected_index = menu_layer_get_selected_index(menu_layer);
+  // The offsets of the rows might have changed, record them again while walking the menu
+  prv_geometry_index_free(menu_layer);
   MenuPrimeCacheIterator it = {
     .it = {
       .menu_layer = menu_layer,
@@ -783,6 +939,8 @@ void menu_layer_update_caches(MenuLayer *menu_layer) {
       },
     },
     .cache_set = false,
+    .geometry_index = menu_layer->geometry_index_enabled ?
+                      prv_geometry_index_create(menu_layer) : NULL,
   };
 
   if (prv_menu_layer_get_header_height(menu_layer, 0) != 0) {
@@ -800,6 +958,12 @@ void menu_layer_update_caches(MenuLayer *menu_layer) {
   }
 
   prv_menu_layer_walk_downward_from_iterator(&it.it);
+  if (it.geometry_index && it.num_rows_recorded == it.geometry_index->num_rows) {
+    menu_layer->geometry_index = it.geometry_index;
+  } else {
+    // The number of rows changed while walking, don't trust the offsets
+    applib_free(it.geometry_index);
+  }
   int16_t total_height = it.it.cursor.y;
   if (menu_layer->pad_bottom) {
     total_height += MENU_LAYER_BOTTOM_PADDING;
@@ -1234,6 +1398,22 @@ static MenuLayerBeforeSelectionChangeState prv_capture_state_and_cancel_center_f
   };
 }
 
+//! Selects a row by looking up its geometry instead of walking to it
+//! @return True if the index knows about the row, false if the caller needs to walk to it
+static bool prv_geometry_index_select(MenuLayer *menu_layer, const MenuIndex *index) {
+  MenuCellSpan span;
+  if (!prv_geometry_index_get_span(menu_layer, index, &span)) {
+    return false;
+  }
+  if (menu_layer->center_focused) {
+    // like prv_walk_with_iterator(), the new row is asked for its height as the selected row
+    menu_layer->selection.index = *index;
+  }
+  span.h = prv_menu_layer_get_cell_height(menu_layer, &span.index, true);
+  menu_layer->selection = span;
+  return true;
+}
+
 void menu_layer_set_selected_index(MenuLayer *menu_layer, MenuIndex index, MenuRowAlign scroll_align, bool animated) {
   const MenuLayerBeforeSelectionChangeState before_state =
       prv_capture_state_and_cancel_center_focus_animation(menu_layer);
@@ -1260,24 +1440,30 @@ void menu_layer_set_selected_index(MenuLayer *menu_layer, MenuIndex index, MenuR
   const bool is_invalid_section = menu_layer->selection.index.section == MENU_INDEX_NOT_FOUND;
   const int16_t comp = is_invalid_section ? 1 :
                        menu_index_compare(&index, &menu_layer->selection.index);
-  MenuSelectIndexIterator it = {
-    .it = {
-      .menu_layer = menu_layer,
-      .row_callback_after_geometry = prv_menu_layer_iterator_selection_index_callback,
-      .section_callback = prv_menu_layer_iterator_noop_callback,
-      .should_continue = true,
-      .cursor = is_invalid_section ? (MenuCellSpan){} : menu_layer->selection,
-    },
-    .selection = {
-      .index = index,
-    },
-    .did_change_selection = false,
-  };
+  bool did_change_selection;
+  if (comp != 0 && prv_geometry_index_select(menu_layer, &index)) {
+    did_change_selection = true;
+  } else {
+    MenuSelectIndexIterator it = {
+      .it = {
+        .menu_layer = menu_layer,
+        .row_callback_after_geometry = prv_menu_layer_iterator_selection_index_callback,
+        .section_callback = prv_menu_layer_iterator_noop_callback,
+        .should_continue = true,
+        .cursor = is_invalid_section ? (MenuCellSpan){} : menu_layer->selection,
+      },
+      .selection = {
+        .index = index,
+      },
+      .did_change_selection = false,
+    };
 
-  prv_walk_with_iterator((int8_t)comp, &it.it);
+    prv_walk_with_iterator((int8_t)comp, &it.it);
+    did_change_selection = it.did_change_selection;
+  }
 
   const bool up = (comp == -1);
-  prv_apply_selection_change(menu_layer, scroll_align, up, it.did_change_selection,
+  prv_apply_selection_change(menu_layer, scroll_align, up, did_change_selection,
                              &before_state.prev_selection, before_state.was_animating, animated);
 }
 
@@ -1424,4 +1610,16 @@ void menu_layer_set_scroll_vibe_on_blocked(MenuLayer *menu_layer, bool scroll_vi
     menu_layer->scroll_vibe_on_wrap_around = false;
   }
   menu_layer->scroll_vibe_on_blocked = scroll_vibe_on_blocked;
-}
\ No newline at end of file
+}
+
+void menu_layer_set_geometry_index_enabled(MenuLayer *menu_layer, bool enabled) {
+  if (!menu_layer) {
+    return;
+  }
+  menu_layer->geometry_index_enabled = enabled;
+  if (!enabled) {
+    prv_geometry_index_free(menu_layer);
+  } else if (!menu_layer->geometry_index && menu_layer->callbacks.get_num_rows) {
+    menu_layer_reload_data(menu_layer);
+  }
+}
@@ -357,6 +357,8 @@ enum {
 //! @note However there are a few caveats:
 //! * Do not try to change to bounds or frame of a \ref MenuLayer, after
 //! initializing it.
+struct MenuLayerGeometryIndex;
+
 typedef struct MenuLayer {
   ScrollLayer scroll_layer;
   InverterLayer inverter;
@@ -396,6 +398,11 @@ typedef struct MenuLayer {
     MenuCellSpan new_selection;
   } animation;
 
+  //! @internal
+  //! Prefix sum of the row offsets, only allocated while the index is enabled and current
+  //! @see \ref menu_layer_set_geometry_index_enabled
+  struct MenuLayerGeometryIndex *geometry_index;
+
   //! @internal
   //! If true, there will be padding after the bottom item in the menu
   //! Defaults to 'true'
@@ -423,10 +430,13 @@ typedef struct MenuLayer {
   //! If True, a vibration will occur when cursor is getting blocked at the top or bottom
   bool scroll_vibe_on_blocked:1;
 
+  //! If True, the row offsets are kept in \ref geometry_index after every reload
+  bool geometry_index_enabled:1;
+
   //! Add some padding to keep track of the \ref MenuLayer size budget.
   //! As long as the size stays within this budget, 2.x apps can safely use the 3.x MenuLayer type.
   //! When padding is removed, the assertion below should also be removed.
-  uint8_t padding[40];
+  uint8_t padding[36];
 } MenuLayer;
 
 //! Padding used below the last item in pixels
@@ -671,6 +681,18 @@ void menu_layer_set_scroll_vibe_on_wrap(MenuLayer *menu_layer, bool scroll_vibe_
 //! @see \ref menu_layer_set_scroll_vibe_on_wrap
 void menu_layer_set_scroll_vibe_on_blocked(MenuLayer *menu_layer, bool scroll_vibe_on_blocked);
 
+//! @internal
+//! Controls if the \ref MenuLayer keeps an index with the y offset of every row.
+//! The index is rebuilt by \ref menu_layer_reload_data, while walking the rows to compute the
+//! content size. It lets the menu select an index or scroll far away without asking the
+//! callbacks for the geometry of all the rows in between, which matters for menus with
+//! thousands of rows. It costs 2 bytes per row and per section on the app heap.
+//! @note Only enable this for menus whose cell heights don't depend on the selection.
+//! Defaults to false for every platform
+//! @param menu_layer The menu layer for which to enable or disable the index.
+//! @param enabled true = keep the index, false = free it and walk the rows instead.
+void menu_layer_set_geometry_index_enabled(MenuLayer *menu_layer, bool enabled);
+
 //!     @} // end addtogroup MenuLayer
 //!   @} // end addtogroup Layer
 //! @} // end addtogroup UI
@@ -29,3 +29,13 @@ typedef struct MenuRenderIterator {
   MenuCellSpan new_cache;
   Layer cell_layer;
 } MenuRenderIterator;
+
+//! Prefix sum of the row offsets of a MenuLayer, see menu_layer_set_geometry_index_enabled()
+typedef struct MenuLayerGeometryIndex {
+  uint16_t num_sections;
+  uint16_t num_rows;
+  //! Index of the first row of each section in row_y, plus num_rows as the last entry
+  uint16_t *section_start;
+  //! Content y offset of each row, section by section
+  int16_t row_y[];
+} MenuLayerGeometryIndex;
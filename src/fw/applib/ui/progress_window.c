@@ -269,6 +269,8 @@ void progress_window_init(ProgressWindow *data) {
   Window *window = &data->window;
   window_init(window, WINDOW_NAME("Progress Window"));
   window_set_background_color(window, PBL_IF_COLOR_ELSE(GColorLightGray, GColorWhite));
+  // Progress updates only touch the bar, so skip redrawing the rest of the window for them
+  window_set_render_dirty_region_only(window, true);
 
   const GRect *bounds = &window->layer.bounds;
   GPoint center = grect_center_point(bounds);
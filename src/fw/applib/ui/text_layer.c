@@ -24,6 +24,26 @@ static GTextLayoutCacheRef prv_text_layer_get_cache_handle(TextLayer *text_layer
   return text_layer->should_cache_layout ? text_layer->layout_cache : NULL;
 }
 
+static void prv_text_layer_deinit_layout_cache(TextLayer *text_layer) {
+  // The layout cache may also have been handed to us by the owner of the TextLayer
+  if (text_layer->layout_cache_has_line_cache) {
+    graphics_text_layout_cache_deinit_with_line_cache(&text_layer->layout_cache);
+  } else {
+    graphics_text_layout_cache_deinit(&text_layer->layout_cache);
+  }
+  text_layer->layout_cache = NULL;
+  text_layer->layout_cache_has_line_cache = false;
+}
+
+static TextLayoutLineCache *prv_text_layer_get_line_cache(TextLayer *text_layer, GContext *ctx) {
+  // Only worth it for long texts that are scrolled through, i.e. don't fit in the clip box
+  if (!text_layer->should_cache_layout || !text_layer->layout_cache_has_line_cache ||
+      text_layer->layer.bounds.size.h <= ctx->draw_state.clip_box.size.h) {
+    return NULL;
+  }
+  return graphics_text_layout_get_line_cache(text_layer->layout_cache);
+}
+
 void text_layer_update_proc(TextLayer *text_layer, GContext* ctx) {
   PBL_ASSERTN(text_layer);
   const GColor bg_color = text_layer->background_color;
@@ -33,9 +53,10 @@ void text_layer_update_proc(TextLayer *text_layer, GContext* ctx) {
   }
   if (text_layer->text && strlen(text_layer->text) > 0) {
     graphics_context_set_text_color(ctx, text_layer->text_color);
-    graphics_draw_text(ctx, text_layer->text, text_layer->font,
+    graphics_draw_text_with_line_cache(ctx, text_layer->text, text_layer->font,
         text_layer->layer.bounds, text_layer->overflow_mode,
-        text_layer->text_alignment, prv_text_layer_get_cache_handle(text_layer));
+        text_layer->text_alignment, prv_text_layer_get_cache_handle(text_layer),
+        prv_text_layer_get_line_cache(text_layer, ctx));
   }
 }
 
@@ -98,8 +119,7 @@ void text_layer_destroy(TextLayer* text_layer) {
 void text_layer_deinit(TextLayer *text_layer) {
   PBL_ASSERTN(text_layer);
   layer_deinit(&text_layer->layer);
-  graphics_text_layout_cache_deinit(&text_layer->layout_cache);
-  text_layer->layout_cache = NULL;
+  prv_text_layer_deinit_layout_cache(text_layer);
 }
 
 Layer* text_layer_get_layer(TextLayer *text_layer) {
@@ -183,10 +203,10 @@ void text_layer_set_should_cache_layout(TextLayer *text_layer, bool should_cache
 
   if (text_layer->should_cache_layout) {
     PBL_LOG_DBG("Init layout");
-    graphics_text_layout_cache_init(&text_layer->layout_cache);
+    graphics_text_layout_cache_init_with_line_cache(&text_layer->layout_cache);
+    text_layer->layout_cache_has_line_cache = true;
   } else {
-    graphics_text_layout_cache_deinit(&text_layer->layout_cache);
-    text_layer->layout_cache = NULL;
+    prv_text_layer_deinit_layout_cache(text_layer);
   }
 }
 
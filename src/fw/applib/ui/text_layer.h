@@ -44,6 +44,8 @@ typedef struct TextLayer {
   GTextOverflowMode overflow_mode:2;
   GTextAlignment text_alignment:2;
   bool should_cache_layout:1;
+  //! layout_cache was created by the TextLayer with room for a line cache
+  bool layout_cache_has_line_cache:1;
 } TextLayer;
 
 //! Initializes the TextLayer with given frame
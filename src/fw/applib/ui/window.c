@@ -127,7 +127,12 @@ void window_render(Window *window, GContext *ctx) {
   DrawingStateOrigins saved_state;
   prv_adjust_drawing_state_for_legacy2_apps(&saved_state, ctx, window);
 
-  layer_render_tree(&window->layer, ctx);
+  if (window->render_dirty_region_only && !window->needs_full_render) {
+    layer_render_tree_dirty_region(&window->layer, ctx);
+  } else {
+    layer_render_tree(&window->layer, ctx);
+  }
+  window->needs_full_render = false;
 
   prv_restore_drawing_state(&saved_state, ctx);
 
@@ -150,6 +155,15 @@ void window_schedule_render(Window *window) {
   window->is_render_scheduled = true;
 }
 
+void window_set_render_dirty_region_only(Window *window, bool enabled) {
+  window->render_dirty_region_only = enabled;
+  window_invalidate(window);
+}
+
+void window_invalidate(Window *window) {
+  window->needs_full_render = true;
+}
+
 GRect window_calc_frame(bool fullscreen) {
   GContext *ctx = graphics_context_get_current_context();
   GRect result = (GRect) {
@@ -188,6 +202,7 @@ void window_init(Window *window, const char* debug_name) {
   window->background_color = GColorWhite;
   window->in_click_config_provider = false;
   window->is_waiting_for_click_config = false;
+  window->needs_full_render = true;
   window->parent_window_stack = NULL;
 }
 
@@ -410,6 +425,7 @@ void window_set_on_screen(Window *window, bool new_on_screen, bool call_window_a
   // Provides internal signaling to ui elements of appear/disappear
   layer_property_changed_tree(&window->layer);
   window->on_screen = new_on_screen;
+  window_invalidate(window);
 
   if (window->on_screen) {
     window_schedule_render(window);
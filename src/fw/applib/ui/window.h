@@ -141,6 +141,16 @@ typedef struct Window {
   //! windows within the same window stack.
   bool is_unfocusable:1;
 
+  //! @internal
+  //! If the window only redraws the layers that were marked dirty since its last render instead
+  //! of the whole window. @see \ref window_set_render_dirty_region_only()
+  bool render_dirty_region_only:1;
+
+  //! @internal
+  //! Set when the framebuffer might no longer hold the window's last render, which makes the next
+  //! render redraw the whole window even if render_dirty_region_only is set.
+  bool needs_full_render:1;
+
   //! @internal
   //! Back pointer to the window stack that this Window is residing on.
   //! @see \ref WindowStack
@@ -11,6 +11,20 @@
 //! @param window Pointer to the window to schedule
 void window_schedule_render(Window *window);
 
+//! Opt a window into only redrawing the layers that were marked dirty since its last render, see
+//! \ref layer_render_tree_dirty_region(). Windows render everything by default, as 3rd party
+//! update_procs may depend on being called every frame.
+//! @note Only for windows that are the only thing drawing into their framebuffer, i.e. app
+//! windows, as the parts of the framebuffer that aren't dirty are left untouched.
+//! @param window Pointer to the window
+//! @param enabled Whether the window should only render its dirty region
+void window_set_render_dirty_region_only(Window *window, bool enabled);
+
+//! Makes the next render of the window redraw the whole window. Needed whenever something other
+//! than the window's own render has drawn into its framebuffer, e.g. a window transition.
+//! @param window Pointer to the window
+void window_invalidate(Window *window);
+
 //! Setup the click config provider
 //! @param window Pointer to the window to setup the click config provider
 void window_setup_click_config_provider(Window *window);
@@ -93,8 +93,10 @@ static Animation *prv_window_transition_move(WindowTransitioningContext *ctx,
 }
 
 static void prv_window_transition_move_render(WindowTransitioningContext *context, GContext *ctx) {
+  // Both windows are drawn at a different position in the framebuffer every frame
   Window *window_from = context->window_from;
   if (window_from) {
+    window_invalidate(window_from);
     window_render(window_from, ctx);
     graphics_patch_trace_of_moving_rect(ctx, &context->window_from_last_x,
                                         window_from->layer.frame);
@@ -102,6 +104,7 @@ static void prv_window_transition_move_render(WindowTransitioningContext *contex
 
   Window *window_to = context->window_to;
   if (window_to) {
+    window_invalidate(window_to);
     window_render(window_to, ctx);
     graphics_patch_trace_of_moving_rect(ctx, &context->window_to_last_x, window_to->layer.frame);
   }
@@ -43,6 +43,7 @@ static void prv_window_transition_render(WindowTransitioningContext *context, GC
     context->window_to_last_x = new_x;
 
     // render window_from
+    window_invalidate(window_to);
     window_render(window_to, ctx);
 
     // cover whole movement with a ring that distracts from the simple movement
@@ -0,0 +1,96 @@
+/* SPDX-FileCopyrightText: 2024 Google LLC */
+/* SPDX-License-Identifier: Apache-2.0 */
+
+#include "tests.h"
+
+static void prv_setup(Window *window);
+static void prv_test_full(Layer *layer, GContext* ctx);
+static void prv_test_dirty_region(Layer *layer, GContext* ctx);
+static void prv_teardown(Window *window);
+
+// Both tests change a single cell of a grid and redraw the layer tree, either completely or only
+// the dirty region.
+GfxTest g_gfx_test_layer_tree_full = {
+  .name = "Layer tree full",
+  .duration = 2,
+  .unit_multiple = 1,
+  .test_proc = prv_test_full,
+  .setup = prv_setup,
+  .teardown = prv_teardown,
+};
+
+GfxTest g_gfx_test_layer_tree_dirty_region = {
+  .name = "Layer tree dirty",
+  .duration = 2,
+  .unit_multiple = 1,
+  .test_proc = prv_test_dirty_region,
+  .setup = prv_setup,
+  .teardown = prv_teardown,
+};
+
+#define NUM_ROWS (6)
+#define NUM_COLUMNS (4)
+#define NUM_CELLS (NUM_ROWS * NUM_COLUMNS)
+
+static Layer s_root;
+static Layer s_cells[NUM_CELLS];
+static Layer s_cell_contents[NUM_CELLS];
+static uint8_t s_cell_colors[NUM_CELLS];
+
+static void prv_cell_update_proc(Layer *layer, GContext *ctx) {
+  graphics_context_set_fill_color(ctx, GColorLightGray);
+  graphics_fill_rect(ctx, &layer->bounds);
+}
+
+static void prv_cell_contents_update_proc(Layer *layer, GContext *ctx) {
+  const int index = layer - s_cell_contents;
+  graphics_context_set_fill_color(ctx, (GColor) { .argb = s_cell_colors[index] });
+  graphics_fill_rect(ctx, &layer->bounds);
+  graphics_context_set_stroke_color(ctx, GColorBlack);
+  graphics_draw_circle(ctx, grect_center_point(&layer->bounds), layer->bounds.size.h / 2);
+}
+
+static void prv_setup(Window *window) {
+  const GRect bounds = window->layer.bounds;
+  layer_init(&s_root, &bounds);
+  const int16_t cell_w = bounds.size.w / NUM_COLUMNS;
+  const int16_t cell_h = bounds.size.h / NUM_ROWS;
+  for (int i = 0; i < NUM_CELLS; i++) {
+    const GRect frame = GRect((i % NUM_COLUMNS) * cell_w, (i / NUM_COLUMNS) * cell_h,
+                              cell_w, cell_h);
+    layer_init(&s_cells[i], &frame);
+    layer_set_update_proc(&s_cells[i], prv_cell_update_proc);
+    layer_add_child(&s_root, &s_cells[i]);
+
+    const GRect contents_frame = grect_inset(s_cells[i].bounds, GEdgeInsets(2));
+    layer_init(&s_cell_contents[i], &contents_frame);
+    layer_set_update_proc(&s_cell_contents[i], prv_cell_contents_update_proc);
+    layer_add_child(&s_cells[i], &s_cell_contents[i]);
+  }
+}
+
+static void prv_change_random_cell(void) {
+  const int index = rand() % NUM_CELLS;
+  s_cell_colors[index] = (uint8_t) rand();
+  layer_mark_dirty(&s_cell_contents[index]);
+}
+
+static void prv_test_full(Layer *layer, GContext* ctx) {
+  prv_change_random_cell();
+  layer_render_tree(&s_root, ctx);
+}
+
+static void prv_test_dirty_region(Layer *layer, GContext* ctx) {
+  prv_change_random_cell();
+  layer_render_tree_dirty_region(&s_root, ctx);
+}
+
+static void prv_teardown(Window *window) {
+  // The tests run from within the render of the test window, which reuses the layer tree stack
+  // that rendering s_root just wrote to. Leave s_root without children so that the window's
+  // render has nothing left to descend into.
+  for (int i = 0; i < NUM_CELLS; i++) {
+    layer_remove_child_layers(&s_cells[i]);
+  }
+  layer_remove_child_layers(&s_root);
+}
@@ -7,6 +7,8 @@
 GFX_TEST(single_line)
 GFX_TEST(text)
 GFX_TEST(text_clipping)
+GFX_TEST(layer_tree_full)
+GFX_TEST(layer_tree_dirty_region)
 GFX_TEST(annulus_even_fill_angles)
 GFX_TEST(annulus_odd_fill_angles)
 GFX_TEST(annulus_even_fill)
@@ -202,7 +202,7 @@ void timeline_model_init(time_t timestamp, TimelineModel *model) {
   s_model_data->last_index = TIMELINE_NUM_VISIBLE_ITEMS;
   for (int i = 0; i < TIMELINE_NUM_VISIBLE_ITEMS; i++) {
     rv = timeline_iter_init(prv_get_iter(i), timeline_model_get_iter_state(i),
-      &s_model_data->timeline, s_model_data->direction, timestamp);
+      s_model_data->direction, timestamp);
     if (FAILED(rv)) {
       PBL_LOG_ERR("Timeline iterator failed to init!");
     }
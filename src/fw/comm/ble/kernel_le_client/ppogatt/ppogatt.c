@@ -10,6 +10,7 @@
 
 #include <bluetooth/gatt.h>
 
+#include "drivers/rtc.h"
 #include "kernel/pbl_malloc.h"
 #include "services/common/analytics/analytics.h"
 #include "services/common/comm_session/session_transport.h"
@@ -98,16 +99,39 @@ typedef struct PPoGATTClient {
     uint8_t tx_window_size;
     uint8_t rx_window_size;
 
+    //! Congestion window: the number of data packets that may be in flight right now.
+    //! Grows towards tx_window_size while packets get Ack'd and shrinks when rolling back.
+    uint8_t cwnd;
+    //! Below this threshold the window grows by one for every Ack'd packet, above it by one for
+    //! every window's worth of Ack'd packets.
+    uint8_t ssthresh;
+    //! Number of packets Ack'd since the window last grew, when above ssthresh
+    uint8_t cwnd_acked_count;
+
+    //! Round trip time is measured for one packet at a time and never for retransmitted ones,
+    //! because it's ambiguous which transmission an Ack belongs to.
+    bool rtt_sample_active;
+    uint8_t rtt_sample_sn;
+    RtcTicks rtt_sample_start_ticks;
+    //! Smoothed round trip time, 0 if nothing has been measured yet
+    uint32_t srtt_ms;
+
     AckTimeoutState ack_timeout_state;
 
     //! Number of consecutive timeouts so far
     uint8_t timeouts_counter;
+    //! Number of times the last Ack has been repeated by the server since it was first received
+    uint8_t dup_ack_count;
+    //! True if we've rolled back because of repeated Acks, without getting anything Ack'd since
+    bool fast_retransmitted;
 
     uint8_t next_expected_ack_sn;
     uint8_t next_data_sn;
 
     bool send_rx_ack_now; //! True if we want to flush the Ack immediately!
-    uint8_t outstanding_rx_ack_count; //! Count of how many data packets we have yet to Ack
+    //! Count of how many data packets we have yet to Ack. The Ack for the last in-order packet
+    //! covers all the ones before it, so only one Ack is sent for all of them.
+    uint8_t outstanding_rx_ack_count;
   } out;
 
   //! Number of consecutive resets so far
@@ -271,6 +295,83 @@ static void prv_clear_payload_sizes_up_to(PPoGATTClient *client,
   }
 }
 
+// -------------------------------------------------------------------------------------------------
+// Congestion window & round trip time
+
+//! The window never shrinks below the size that all PPoGATT servers have been handling since V0.
+static uint8_t prv_min_congestion_window(const PPoGATTClient *client) {
+  return MIN(PPOGATT_V0_WINDOW_SIZE, client->out.tx_window_size);
+}
+
+static void prv_set_congestion_window(PPoGATTClient *client, uint8_t cwnd) {
+  if (client->out.cwnd == cwnd) {
+    return;
+  }
+  client->out.cwnd = cwnd;
+  if (client->session) {
+    comm_session_analytics_set_tx_window(client->session, cwnd);
+  }
+}
+
+static void prv_init_congestion_window(PPoGATTClient *client) {
+  client->out.ssthresh = client->out.tx_window_size;
+  client->out.cwnd_acked_count = 0;
+  prv_set_congestion_window(client, prv_min_congestion_window(client));
+}
+
+static void prv_grow_congestion_window(PPoGATTClient *client, uint32_t num_acked) {
+  if (client->out.cwnd >= client->out.tx_window_size) {
+    return;
+  }
+  uint8_t cwnd = client->out.cwnd;
+  if (cwnd < client->out.ssthresh) {
+    cwnd = MIN(cwnd + num_acked, client->out.ssthresh);
+  } else {
+    client->out.cwnd_acked_count += num_acked;
+    if (client->out.cwnd_acked_count >= cwnd) {
+      client->out.cwnd_acked_count = 0;
+      ++cwnd;
+    }
+  }
+  prv_set_congestion_window(client, MIN(cwnd, client->out.tx_window_size));
+}
+
+static void prv_shrink_congestion_window(PPoGATTClient *client) {
+  client->out.ssthresh = MAX(client->out.cwnd / 2, prv_min_congestion_window(client));
+  client->out.cwnd_acked_count = 0;
+  prv_set_congestion_window(client, client->out.ssthresh);
+}
+
+static void prv_start_rtt_sample_if_idle(PPoGATTClient *client, uint32_t sn) {
+  if (client->out.rtt_sample_active) {
+    return;
+  }
+  client->out.rtt_sample_active = true;
+  client->out.rtt_sample_sn = sn;
+  client->out.rtt_sample_start_ticks = rtc_get_ticks();
+}
+
+//! @param next_sn The sn after the last one that got Ack'd
+static void prv_finish_rtt_sample_if_acked(PPoGATTClient *client, uint32_t next_sn) {
+  if (!client->out.rtt_sample_active ||
+      prv_sn_distance(client->out.next_expected_ack_sn, client->out.rtt_sample_sn) >=
+          prv_sn_distance(client->out.next_expected_ack_sn, next_sn)) {
+    return;
+  }
+  client->out.rtt_sample_active = false;
+  const RtcTicks rtt_ticks = rtc_get_ticks() - client->out.rtt_sample_start_ticks;
+  const uint32_t rtt_ms = (rtt_ticks * MS_PER_SECOND) / RTC_TICKS_HZ;
+  if (client->out.srtt_ms == 0) {
+    client->out.srtt_ms = rtt_ms;
+  } else {
+    // Exponentially weighted moving average, with the same 1/8 gain as TCP uses (RFC 6298)
+    client->out.srtt_ms = (7 * client->out.srtt_ms + rtt_ms) / 8;
+  }
+  if (client->session) {
+    comm_session_analytics_set_rtt(client->session, client->out.srtt_ms);
+  }
+}
+
 // -------------------------------------------------------------------------------------------------
 // Ack Time-out related things.
 // The effective timeout duration will be between 2 and 3 seconds, depending on when in the second
@@ -280,16 +381,17 @@ static void prv_reset_ack_timeout(PPoGATTClient *client) {
   client->out.ack_timeout_state = AckTimeoutState_Active;
 }
 
-static void prv_roll_back(PPoGATTClient *client, uint32_t sn) {
-  if (++client->out.timeouts_counter >= PPOGATT_TIMEOUT_COUNT_MAX) {
-    PBL_LOG_ERR("Resetting because max timeouts reached...");
-    prv_start_reset(client);
-    return;
-  }
-
+static void prv_rewind(PPoGATTClient *client, uint32_t sn) {
   PBL_LOG_WRN("Rolling back from (%u, %u) to %"PRIu32,
           client->out.next_data_sn, client->out.next_expected_ack_sn, sn);
 
+  if (client->session) {
+    comm_session_analytics_inc_retransmits(client->session, prv_num_packets_in_flight(client));
+  }
+  // Packets getting dropped is the only sign of congestion we get, back off:
+  prv_shrink_congestion_window(client);
+  client->out.rtt_sample_active = false;
+
   // Go back and send again:
   // No need to worry about the timeouts of these packets hitting, because prv_check_timeouts uses
   // next_data_sn and next_expected_ack_sn to determine which packets can time-out.
@@ -301,6 +403,15 @@ static void prv_roll_back(PPoGATTClient *client, uint32_t sn) {
   prv_send_next_packets_async(client);
 }
 
+static void prv_roll_back(PPoGATTClient *client, uint32_t sn) {
+  if (++client->out.timeouts_counter >= PPOGATT_TIMEOUT_COUNT_MAX) {
+    PBL_LOG_ERR("Resetting because max timeouts reached...");
+    prv_start_reset(client);
+    return;
+  }
+  prv_rewind(client, sn);
+}
+
 static bool prv_has_timeout(const PPoGATTClient *client) {
   return (client->out.ack_timeout_state != AckTimeoutState_Inactive &&
           client->out.ack_timeout_state >= AckTimeoutState_TimedOut);
@@ -603,6 +714,7 @@ static void prv_handle_reset_complete(PPoGATTClient *client, const PPoGATTPacket
       client->out.rx_window_size = MIN(client->out.rx_window_size, payload->ppogatt_max_tx_window);
     }
   }
+  prv_init_congestion_window(client);
 
   PBL_LOG_DBG("Hurray! PPoGATT Session is opened (Vers: %d TXW: %d RXW: %d)!",
           client->version, client->out.tx_window_size, client->out.rx_window_size);
@@ -614,16 +726,21 @@ static void prv_handle_ack(PPoGATTClient *client, uint32_t sn) {
   if (prv_is_packet_with_sn_awaiting_ack(client, sn)) {
     client->out.timeouts_counter = 0;
     client->out.ack_timeout_state = AckTimeoutState_Inactive;
+    client->out.dup_ack_count = 0;
+    client->out.fast_retransmitted = false;
 
     // Ack'd one of the packets in flight
     const uint32_t next_sn = prv_next_sn(sn);
+    prv_finish_rtt_sample_if_acked(client, next_sn);
+    prv_grow_congestion_window(client, prv_sn_distance(client->out.next_expected_ack_sn, next_sn));
     const uint16_t num_bytes_acked = prv_total_num_bytes_awaiting_ack_up_to(client, next_sn);
     comm_session_send_queue_consume(client->session, num_bytes_acked);
 
     // If next_data_sn is before the Ack'd sn, the packet pending retransmission has just been
-    // Ack'd. We can determine whether or not a packet is pending retransmission by checking if the
-    // payload size for next_data_sn is not 0. This means the packet has been enqueued to get sent
-    if (prv_is_packet_with_sn_awaiting_ack(client, client->out.next_data_sn)) {
+    // Ack'd. Note that the payload size for next_data_sn can't tell us this: after rolling back,
+    // the packets that are being retransmitted still have the sizes of their first transmission.
+    if (prv_sn_distance(client->out.next_expected_ack_sn, client->out.next_data_sn) <
+        prv_sn_distance(client->out.next_expected_ack_sn, next_sn)) {
       client->out.next_data_sn = next_sn;
     }
 
@@ -642,7 +759,17 @@ static void prv_handle_ack(PPoGATTClient *client, uint32_t sn) {
     // Data we had sent got dropped causing the other side to re-ACK the last data it had received.
     // Don't roll back directly to avoid creating an Sorcerer's Apprentice bug
     // https://en.wikipedia.org/wiki/Sorcerer%27s_Apprentice_Syndrome
-    // We'll rely on the ACK timeout for the next data packet to fire and roll back.
+    // With V1+, roll back once after a couple of these (every packet that arrived after the
+    // dropped one gets re-Acked), instead of waiting seconds for the Ack timeout to fire.
+    // Otherwise we'll rely on the ACK timeout for the next data packet to fire and roll back.
+    if (prv_client_supports_enhanced_throughput_features(client) &&
+        !client->out.fast_retransmitted &&
+        prv_num_packets_in_flight(client) != 0 &&
+        ++client->out.dup_ack_count >= PPOGATT_FAST_RETRANSMIT_DUP_ACK_COUNT) {
+      client->out.fast_retransmitted = true;
+      prv_rewind(client, client->out.next_expected_ack_sn);
+      return;
+    }
     PBL_LOG_WRN("Received retransmitted Ack for sn:%"PRIu32". Ignoring it.", sn);
   } else {
     PBL_LOG_ERR("Ack'd packet out of range %"PRIu32", [%u-%u].",
@@ -660,6 +787,7 @@ static void prv_handle_data(PPoGATTClient *client,
       .sn = client->in.next_expected_data_sn,
       .type = PPoGATTPacketTypeAck,
     };
+    client->out.outstanding_rx_ack_count++;
     prv_send_next_packets(client);
 
     client->in.next_expected_data_sn = prv_next_sn(client->in.next_expected_data_sn);
@@ -669,6 +797,12 @@ static void prv_handle_data(PPoGATTClient *client,
     PBL_LOG_DBG("packet->sn != next_expected_data_sn (%u != %u)",
             packet->sn, client->in.next_expected_data_sn);
     // Rely on the server retransmitting on Ack time-out
+    if (client->out.ack_packet_byte != 0) {
+      // Don't hold on to a coalesced Ack: if the server learns what did arrive before it times
+      // out, it only needs to retransmit from the missing packet onwards.
+      client->out.send_rx_ack_now = true;
+      prv_send_next_packets(client);
+    }
   }
 }
 
@@ -1125,12 +1259,9 @@ static const PPoGATTPacket * prv_prepare_next_packet(PPoGATTClient *client,
 
     if (!prv_client_supports_enhanced_throughput_features(client)) {
       client->out.send_rx_ack_now = true;
-    } else {
-      client->out.outstanding_rx_ack_count++;
-      if (client->out.outstanding_rx_ack_count >= (client->out.rx_window_size / 2)) {
-        // we want to ACK data before the other side is blocking waiting for an ACK
-        client->out.send_rx_ack_now = true;
-      }
+    } else if (client->out.outstanding_rx_ack_count >= (client->out.rx_window_size / 2)) {
+      // we want to ACK data before the other side is blocking waiting for an ACK
+      client->out.send_rx_ack_now = true;
     }
 
     if (client->out.send_rx_ack_now) {
@@ -1154,7 +1285,7 @@ static const PPoGATTPacket * prv_prepare_next_packet(PPoGATTClient *client,
   if (client->state != StateConnectedOpen) {
     return NULL;
   };
-  if (prv_num_packets_in_flight(client) >= client->out.tx_window_size) {
+  if (prv_num_packets_in_flight(client) >= client->out.cwnd) {
     // Max number of data packets in flight, try again when we got some of them Ack'd.
     return NULL;
   }
@@ -1212,6 +1343,10 @@ static void prv_finalize_queued_packet(PPoGATTClient *client, uint16_t payload_s
     client->out.outstanding_rx_ack_count = 0;
   } else { // we are sending a data packet
     const uint32_t sn = client->out.next_data_sn;
+    const bool is_retransmission = (prv_get_payload_size_for_sn(client, sn) != 0);
+    if (!is_retransmission) {
+      prv_start_rtt_sample_if_idle(client, sn);
+    }
     prv_set_payload_size_for_sn(client, sn, payload_size);
     if (client->out.ack_timeout_state == AckTimeoutState_Inactive) {
       prv_reset_ack_timeout(client); // Enable timeout if we don't already have it set
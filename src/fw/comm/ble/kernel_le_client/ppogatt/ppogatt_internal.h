@@ -28,6 +28,9 @@
 #define PPOGATT_RESET_COUNT_MAX (5)
 //! Number of maximum consecutive disconnects without getting a packet Ack'd
 #define PPOGATT_DISCONNECT_COUNT_MAX (2)
+//! Number of times the server has to repeat an Ack, before PPoGATT (V1+) retransmits the packets
+//! after it without waiting for the Ack timeout.
+#define PPOGATT_FAST_RETRANSMIT_DUP_ACK_COUNT (3)
 //! Maximum amount of time PPoGATT will wait before sending an Ack for received data
 #define PPOGATT_MAX_DATA_ACK_LATENCY_MS (200)
 
@@ -205,7 +205,7 @@ static bool prv_calc_stats_and_print(const SlaveConnEventStats *orig_stats,
 }
 
 void bluetooth_analytics_handle_put_bytes_stats(bool successful, uint8_t type, uint32_t total_size,
-                                                uint32_t elapsed_time_ms,
+                                                uint32_t elapsed_time_ms, uint32_t commit_time_ms,
                                                 const SlaveConnEventStats *orig_stats) {
   SlaveConnEventStats new_stats = {};
   prv_calc_stats_and_print(orig_stats, &new_stats, true /* is_putbytes */);
@@ -214,7 +214,7 @@ void bluetooth_analytics_handle_put_bytes_stats(bool successful, uint8_t type, u
     comm_session_get_system_session(), successful, type,
     total_size, elapsed_time_ms, new_stats.num_conn_events,
     new_stats.num_sync_errors, new_stats.num_conn_events_skipped,
-    prv_calc_other_errors(&new_stats));
+    prv_calc_other_errors(&new_stats), commit_time_ms);
 }
 
 void bluetooth_analytics_handle_get_bytes_stats(uint8_t type, uint32_t total_size,
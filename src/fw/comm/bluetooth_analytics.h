@@ -38,7 +38,7 @@ void bluetooth_analytics_handle_connection_disconnection_event(
     AnalyticsEvent type, uint8_t reason, const BleRemoteVersionInfo *vers_info);
 
 void bluetooth_analytics_handle_put_bytes_stats(bool successful, uint8_t type, uint32_t total_size,
-                                                uint32_t elapsed_time_ms,
+                                                uint32_t elapsed_time_ms, uint32_t commit_time_ms,
                                                 const SlaveConnEventStats *orig_stats);
 
 void bluetooth_analytics_handle_get_bytes_stats(uint8_t type, uint32_t total_size,
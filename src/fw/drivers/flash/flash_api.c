@@ -7,6 +7,7 @@
 #include <inttypes.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "drivers/flash/flash_impl.h"
 #include "drivers/task_watchdog.h"
@@ -21,6 +22,7 @@
 #include "system/logging.h"
 #include "system/passert.h"
 #include "kernel/util/sleep.h"
+#include "util/math.h"
 
 #include "FreeRTOS.h"
 #include "semphr.h"
@@ -53,6 +55,30 @@ static uint32_t s_system_analytics_read_bytes_count = 0;
 static uint32_t s_system_analytics_write_bytes_count = 0;
 static uint8_t s_system_analytics_erase_count = 0;
 
+#if CAPABILITY_HAS_FLASH_READ_CACHE
+//! PFS headers, settings file records, resource tables and font offset tables are read a few bytes
+//! at a time, and every one of these reads pays the command overhead of the flash part. Reads of
+//! up to FLASH_READ_CACHE_MAX_READ_BYTES are served from a few lines of flash kept in RAM instead.
+//! Larger reads bypass the cache so they don't evict the lines of the small ones.
+#define FLASH_READ_CACHE_LINE_BYTES (256)
+#define FLASH_READ_CACHE_NUM_LINES (4)
+#define FLASH_READ_CACHE_MAX_READ_BYTES (32)
+
+typedef struct {
+  bool valid;
+  uint32_t addr; //!< Flash address of the first byte of the line, aligned to the line size
+  uint32_t last_used; //!< Value of s_read_cache_clock when the line was used last
+  uint8_t data[FLASH_READ_CACHE_LINE_BYTES];
+} FlashReadCacheLine;
+
+static FlashReadCacheLine s_read_cache[FLASH_READ_CACHE_NUM_LINES];
+static uint32_t s_read_cache_clock;
+
+static uint32_t s_system_analytics_read_cache_hit_count = 0;
+static uint32_t s_system_analytics_read_cache_miss_count = 0;
+static uint32_t s_system_analytics_read_cache_saved_bytes_count = 0;
+#endif
+
 void analytics_external_collect_system_flash_statistics(void) {
   analytics_set(ANALYTICS_DEVICE_METRIC_FLASH_READ_BYTES_COUNT,
                 s_system_analytics_read_bytes_count, AnalyticsClient_System);
@@ -60,6 +86,18 @@ void analytics_external_collect_system_flash_statistics(void) {
                 s_system_analytics_write_bytes_count, AnalyticsClient_System);
   analytics_set(ANALYTICS_DEVICE_METRIC_FLASH_ERASE_COUNT,
                 s_system_analytics_erase_count, AnalyticsClient_System);
+#if CAPABILITY_HAS_FLASH_READ_CACHE
+  analytics_set(ANALYTICS_DEVICE_METRIC_FLASH_READ_CACHE_HIT_COUNT,
+                s_system_analytics_read_cache_hit_count, AnalyticsClient_System);
+  analytics_set(ANALYTICS_DEVICE_METRIC_FLASH_READ_CACHE_MISS_COUNT,
+                s_system_analytics_read_cache_miss_count, AnalyticsClient_System);
+  analytics_set(ANALYTICS_DEVICE_METRIC_FLASH_READ_CACHE_SAVED_BYTES_COUNT,
+                s_system_analytics_read_cache_saved_bytes_count, AnalyticsClient_System);
+
+  s_system_analytics_read_cache_hit_count = 0;
+  s_system_analytics_read_cache_miss_count = 0;
+  s_system_analytics_read_cache_saved_bytes_count = 0;
+#endif
 
   s_system_analytics_read_bytes_count = 0;
   s_system_analytics_write_bytes_count = 0;
@@ -112,9 +150,37 @@ static status_t prv_try_restart_interrupted_erase(bool is_subsector,
   }
 }
 
+#if CAPABILITY_HAS_FLASH_READ_CACHE
+//! Assumes that s_flash_lock is held.
+static void prv_read_cache_invalidate(uint32_t start_addr, uint32_t num_bytes) {
+  for (int i = 0; i < FLASH_READ_CACHE_NUM_LINES; i++) {
+    FlashReadCacheLine *line = &s_read_cache[i];
+    if (line->valid && (line->addr < start_addr + num_bytes) &&
+        (start_addr < line->addr + FLASH_READ_CACHE_LINE_BYTES)) {
+      line->valid = false;
+    }
+  }
+}
+
+//! Assumes that s_flash_lock is held.
+static void prv_read_cache_invalidate_all(void) {
+  for (int i = 0; i < FLASH_READ_CACHE_NUM_LINES; i++) {
+    s_read_cache[i].valid = false;
+  }
+}
+
+static uint32_t prv_erase_size(bool is_subsector) {
+  return is_subsector ? SUBSECTOR_SIZE_BYTES : SECTOR_SIZE_BYTES;
+}
+#endif
+
 void flash_init(void) {
   flash_impl_init(false /* coredump_mode */);
 
+#if CAPABILITY_HAS_FLASH_READ_CACHE
+  prv_read_cache_invalidate_all();
+#endif
+
   s_flash_lock = mutex_create();
   s_erase_semphr = xSemaphoreCreateBinary();
   xSemaphoreGive(s_erase_semphr);
@@ -168,12 +234,8 @@ static void prv_erase_suspend_timer_cb(void *unused) {
   mutex_unlock(s_flash_lock);
 }
 
-void flash_read_bytes(uint8_t* buffer, uint32_t start_addr,
-                      uint32_t buffer_size) {
-  mutex_lock(s_flash_lock);
-  s_analytics_read_count++;
-  s_analytics_read_bytes_count += buffer_size;
-  s_system_analytics_read_bytes_count += buffer_size;
+//! Assumes that s_flash_lock is held.
+static void prv_read_sync(uint8_t *buffer, uint32_t start_addr, uint32_t buffer_size) {
   // TODO: use DMA when possible
   // TODO: be smarter about pausing erases. Some flash chips allow concurrent
   // reads while an erase is in progress, as long as the read is to another bank
@@ -185,6 +247,77 @@ void flash_read_bytes(uint8_t* buffer, uint32_t start_addr,
   stop_mode_disable(InhibitorFlash);
   flash_impl_read_sync(buffer, start_addr, buffer_size);
   stop_mode_enable(InhibitorFlash);
+}
+
+#if CAPABILITY_HAS_FLASH_READ_CACHE
+//! Assumes that s_flash_lock is held.
+//! @return the line holding the data at line_addr, or NULL if it can't be cached because it's
+//! being erased
+static FlashReadCacheLine *prv_read_cache_get_line(uint32_t line_addr, uint32_t num_bytes) {
+  FlashReadCacheLine *lru_line = &s_read_cache[0];
+  for (int i = 0; i < FLASH_READ_CACHE_NUM_LINES; i++) {
+    FlashReadCacheLine *line = &s_read_cache[i];
+    if (line->valid && line->addr == line_addr) {
+      s_system_analytics_read_cache_hit_count++;
+      s_system_analytics_read_cache_saved_bytes_count += num_bytes;
+      return line;
+    }
+    if (!line->valid || (lru_line->valid && line->last_used < lru_line->last_used)) {
+      lru_line = line;
+    }
+  }
+
+  // The contents of a sector change until its erase has finished, so don't keep them around
+  const uint32_t erase_end = s_erase.address + prv_erase_size(s_erase.is_subsector);
+  if (s_erase.in_progress && (line_addr < erase_end) &&
+      (s_erase.address < line_addr + FLASH_READ_CACHE_LINE_BYTES)) {
+    return NULL;
+  }
+
+  s_system_analytics_read_cache_miss_count++;
+  prv_read_sync(lru_line->data, line_addr, FLASH_READ_CACHE_LINE_BYTES);
+  lru_line->addr = line_addr;
+  lru_line->valid = true;
+  return lru_line;
+}
+
+//! Assumes that s_flash_lock is held.
+//! @return false if the read is too large to go through the cache
+static bool prv_read_cache_read(uint8_t *buffer, uint32_t start_addr, uint32_t buffer_size) {
+  if (buffer_size > FLASH_READ_CACHE_MAX_READ_BYTES) {
+    return false;
+  }
+  while (buffer_size) {
+    const uint32_t line_addr = start_addr & ~(FLASH_READ_CACHE_LINE_BYTES - 1);
+    const uint32_t offset = start_addr - line_addr;
+    const uint32_t num_bytes = MIN(buffer_size, FLASH_READ_CACHE_LINE_BYTES - offset);
+    FlashReadCacheLine *line = prv_read_cache_get_line(line_addr, num_bytes);
+    if (line) {
+      line->last_used = ++s_read_cache_clock;
+      memcpy(buffer, &line->data[offset], num_bytes);
+    } else {
+      prv_read_sync(buffer, start_addr, num_bytes);
+    }
+    buffer += num_bytes;
+    start_addr += num_bytes;
+    buffer_size -= num_bytes;
+  }
+  return true;
+}
+#endif
+
+void flash_read_bytes(uint8_t* buffer, uint32_t start_addr,
+                      uint32_t buffer_size) {
+  mutex_lock(s_flash_lock);
+  s_analytics_read_count++;
+  s_analytics_read_bytes_count += buffer_size;
+  s_system_analytics_read_bytes_count += buffer_size;
+#if CAPABILITY_HAS_FLASH_READ_CACHE
+  if (!prv_read_cache_read(buffer, start_addr, buffer_size))
+#endif
+  {
+    prv_read_sync(buffer, start_addr, buffer_size);
+  }
   mutex_unlock(s_flash_lock);
 }
 
@@ -201,6 +334,9 @@ void flash_write_bytes(const uint8_t *buffer, uint32_t start_addr,
   stop_mode_disable(InhibitorFlash);  // FIXME: PBL-18028
   s_analytics_write_bytes_count += buffer_size;
   s_system_analytics_write_bytes_count += buffer_size;
+#if CAPABILITY_HAS_FLASH_READ_CACHE
+  prv_read_cache_invalidate(start_addr, buffer_size);
+#endif
   prv_erase_pause();
   if (s_erase.suspended) {
     new_timer_start(s_erase_suspend_timer, 50, prv_erase_suspend_timer_cb, NULL, 0);
@@ -290,6 +426,9 @@ static uint32_t prv_flash_erase_start(uint32_t addr,
   analytics_inc(ANALYTICS_APP_METRIC_FLASH_SUBSECTOR_ERASE_COUNT,
                 AnalyticsClient_CurrentTask);
   s_system_analytics_erase_count++;
+#if CAPABILITY_HAS_FLASH_READ_CACHE
+  prv_read_cache_invalidate(s_erase.address, prv_erase_size(is_subsector));
+#endif
   status = is_subsector? flash_impl_erase_subsector_begin(addr)
                        : flash_impl_erase_sector_begin(addr);
 
@@ -7,18 +7,28 @@
 #include "system/logging.h"
 #include "util/crc32.h"
 #include "util/legacy_checksum.h"
+#include "util/math.h"
 
 #include <stdint.h>
 
-static size_t prv_allocate_crc_buffer(void **buffer) {
-  // Try to allocate a big buffer for reading flash data. If we can't,
-  // use a smaller one.
-  unsigned int chunk_size = 1024;
+#define CRC_BUFFER_LARGE_SIZE (4096)
+#define CRC_BUFFER_MEDIUM_SIZE (1024)
+#define CRC_BUFFER_SMALL_SIZE (128)
+
+static size_t prv_allocate_crc_buffer(void **buffer, uint32_t num_bytes) {
+  // Try to allocate a big buffer for reading flash data, so that the per-read cost of taking the
+  // flash lock and pausing any erase is spread over as many bytes as possible. There is no point
+  // in allocating more than the region being read. If we can't, use a smaller one.
+  unsigned int chunk_size = MAX(MIN(num_bytes, CRC_BUFFER_LARGE_SIZE), CRC_BUFFER_SMALL_SIZE);
   *buffer = kernel_malloc(chunk_size);
+  if (!*buffer && chunk_size > CRC_BUFFER_MEDIUM_SIZE) {
+    chunk_size = CRC_BUFFER_MEDIUM_SIZE;
+    *buffer = kernel_malloc(chunk_size);
+  }
   if (!*buffer) {
     PBL_LOG_WRN("Insufficient memory for a large CRC buffer, going slow");
 
-    chunk_size = 128;
+    chunk_size = CRC_BUFFER_SMALL_SIZE;
     *buffer = kernel_malloc_check(chunk_size);
   }
   return chunk_size;
@@ -26,7 +36,7 @@ static size_t prv_allocate_crc_buffer(void **buffer) {
 
 uint32_t flash_crc32(uint32_t flash_addr, uint32_t num_bytes) {
   void *buffer;
-  unsigned int chunk_size = prv_allocate_crc_buffer(&buffer);
+  unsigned int chunk_size = prv_allocate_crc_buffer(&buffer, num_bytes);
 
   uint32_t crc = CRC32_INIT;
   while (num_bytes > chunk_size) {
@@ -48,7 +58,7 @@ uint32_t flash_crc32(uint32_t flash_addr, uint32_t num_bytes) {
 uint32_t flash_calculate_legacy_defective_checksum(uint32_t flash_addr,
                                                    uint32_t num_bytes) {
   void *buffer;
-  unsigned int chunk_size = prv_allocate_crc_buffer(&buffer);
+  unsigned int chunk_size = prv_allocate_crc_buffer(&buffer, num_bytes);
 
   LegacyChecksum checksum;
   legacy_defective_checksum_init(&checksum);
@@ -297,7 +297,7 @@ static void prv_send(const uint8_t *data, uint32_t len) {
 
 
 // -----------------------------------------------------------------------------------------
-void qemu_serial_send(QemuProtocol protocol, const uint8_t *data, uint32_t len) {
+void qemu_serial_send_mbuf_chain(QemuProtocol protocol, MBuf *chain) {
   if (!s_qemu_state.initialized) {
     return;
   }
@@ -308,12 +308,14 @@ void qemu_serial_send(QemuProtocol protocol, const uint8_t *data, uint32_t len)
   QemuCommChannelHdr hdr = (QemuCommChannelHdr) {
     .signature = htons(QEMU_HEADER_SIGNATURE),
     .protocol = htons(protocol),
-    .len = htons(len)
+    .len = htons(mbuf_get_chain_length(chain))
   };
   prv_send((uint8_t *)&hdr, sizeof(hdr));
 
   // Send the data
-  prv_send(data, len);
+  for (MBuf *m = chain; m; m = mbuf_get_next(m)) {
+    prv_send(mbuf_get_data(m), mbuf_get_length(m));
+  }
 
   // Send the footer
   QemuCommChannelFooter footer = (QemuCommChannelFooter) {
@@ -323,3 +325,10 @@ void qemu_serial_send(QemuProtocol protocol, const uint8_t *data, uint32_t len)
 
   mutex_unlock(s_qemu_state.qemu_comm_lock);
 }
+
+// -----------------------------------------------------------------------------------------
+void qemu_serial_send(QemuProtocol protocol, const uint8_t *data, uint32_t len) {
+  MBuf mbuf = MBUF_EMPTY;
+  mbuf_set_data(&mbuf, (void *)data, len);
+  qemu_serial_send_mbuf_chain(protocol, &mbuf);
+}
@@ -11,6 +11,7 @@
 #include "applib/preferred_content_size.h"
 #include "drivers/button_id.h"
 #include "util/attributes.h"
+#include "util/mbuf.h"
 
 // The QEMU protocols implemented
 typedef enum {
@@ -118,3 +119,6 @@ _Static_assert(sizeof(PreferredContentSize) == sizeof(((QemuProtocolContentSizeH
 void qemu_serial_init(void);
 
 void qemu_serial_send(QemuProtocol protocol, const uint8_t *data, uint32_t len);
+
+//! Sends the data of an MBuf chain as a single packet
+void qemu_serial_send_mbuf_chain(QemuProtocol protocol, MBuf *chain);
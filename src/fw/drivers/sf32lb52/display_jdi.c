@@ -14,6 +14,7 @@
 #include "os/mutex.h"
 #include "system/logging.h"
 #include "system/passert.h"
+#include "system/profiler.h"
 
 #include "FreeRTOS.h"
 #include "semphr.h"
@@ -26,10 +27,23 @@
 #define POWER_SEQ_DELAY_TIME  (11)
 #define POWER_RESET_CYCLE_DELAY_TIME (500)
 
+// Maximum number of separate row ranges sent as part of a single update. If the rows handed to
+// us are split into more ranges than this, the gaps between the last ones are sent as well.
+#define MAX_UPDATE_RANGES (4)
+
+typedef struct {
+  uint16_t y0;
+  uint16_t y1;
+} UpdateRange;
+
 // Pointer to the compositor's framebuffer - we convert in-place to save 44KB RAM
 static uint8_t *s_framebuffer;
+// Rows currently being sent (inclusive)
 static uint16_t s_update_y0;
 static uint16_t s_update_y1;
+static UpdateRange s_update_ranges[MAX_UPDATE_RANGES];
+static uint8_t s_num_update_ranges;
+static uint8_t s_current_update_range;
 static bool s_initialized;
 static bool s_updating;
 static UpdateCompleteCallback s_uccb;
@@ -136,32 +150,70 @@ static void prv_display_update_start(void) {
   HAL_LCDC_SendLayerData_IT(&state->hlcdc);
 }
 
-static void prv_display_update_terminate(void *data) {
-  // Convert the updated region back from 332 to 222 format
-  for (uint16_t y = s_update_y0; y <= s_update_y1; y++) {
-    uint8_t *row = &s_framebuffer[y * PBL_DISPLAY_WIDTH];
+static void prv_hmirror_row(uint8_t *row) {
+  for (uint16_t x = 0; x < PBL_DISPLAY_WIDTH / 2; x++) {
+    uint8_t tmp = row[x];
+    row[x] = row[PBL_DISPLAY_WIDTH - 1 - x];
+    row[PBL_DISPLAY_WIDTH - 1 - x] = tmp;
+  }
+}
+
+static void prv_convert_row_to_332(uint8_t *row) {
+  // Convert this row in-place from 222 to 332 using word-level bit manipulation
+  // 222 format: XX RR GG BB (bits 7-6 unused, 5-4 R, 3-2 G, 1-0 B)
+  // 332 format: RR 0G GG BB (bits 7-6 R, 4-3 G, 1-0 B)
+  uint32_t *row32 = (uint32_t *)row;
+  for (uint16_t x = 0; x < PBL_DISPLAY_WIDTH / 4; x++) {
+    uint32_t p = row32[x];
+    row32[x] = ((p & 0x30303030) << 2) |  // R: bits 4-5 → 6-7
+               ((p & 0x0C0C0C0C) << 1) |  // G: bits 2-3 → 3-4
+               (p & 0x03030303);          // B: bits 0-1 stay
+  }
 
+  if (s_rotated_180) {
+    // HMirror in software (VMirror is done by hardware)
+    prv_hmirror_row(row);
+  }
+}
+
+static void prv_convert_row_to_222(uint8_t *row) {
   if (s_rotated_180) {
     // Undo HMirror before converting back
-    for (uint16_t x = 0; x < PBL_DISPLAY_WIDTH / 2; x++) {
-      uint8_t tmp = row[x];
-      row[x] = row[PBL_DISPLAY_WIDTH - 1 - x];
-      row[PBL_DISPLAY_WIDTH - 1 - x] = tmp;
-    }
+    prv_hmirror_row(row);
   }
 
-    // Convert this row in-place from 332 to 222 using word-level bit manipulation
-    // 332 format: RR 0G GG BB (bits 7-6 R, 4-3 G, 1-0 B)
-    // 222 format: XX RR GG BB (bits 7-6 unused, 5-4 R, 3-2 G, 1-0 B)
-    uint32_t *row32 = (uint32_t *)row;
-    for (uint16_t x = 0; x < PBL_DISPLAY_WIDTH / 4; x++) {
-      uint32_t p = row32[x];
-      row32[x] = ((p >> 2) & 0x30303030) |  // R: bits 6-7 → 4-5
-                 ((p >> 1) & 0x0C0C0C0C) |  // G: bits 3-4 → 2-3
-                 (p & 0x03030303);          // B: bits 0-1 stay
-    }
+  // Convert this row in-place from 332 to 222 using word-level bit manipulation
+  // 332 format: RR 0G GG BB (bits 7-6 R, 4-3 G, 1-0 B)
+  // 222 format: XX RR GG BB (bits 7-6 unused, 5-4 R, 3-2 G, 1-0 B)
+  uint32_t *row32 = (uint32_t *)row;
+  for (uint16_t x = 0; x < PBL_DISPLAY_WIDTH / 4; x++) {
+    uint32_t p = row32[x];
+    row32[x] = ((p >> 2) & 0x30303030) |  // R: bits 6-7 → 4-5
+               ((p >> 1) & 0x0C0C0C0C) |  // G: bits 3-4 → 2-3
+               (p & 0x03030303);          // B: bits 0-1 stay
   }
+}
 
+static void prv_display_update_next_range(void) {
+  const UpdateRange *range = &s_update_ranges[s_current_update_range];
+  s_update_y0 = range->y0;
+  s_update_y1 = range->y1;
+  prv_display_update_start();
+}
+
+static void prv_display_update_terminate(void *data) {
+  // Convert the updated region back from 332 to 222 format
+  for (uint16_t y = s_update_y0; y <= s_update_y1; y++) {
+    prv_convert_row_to_222(&s_framebuffer[y * PBL_DISPLAY_WIDTH]);
+  }
+
+  // Send the next range of rows, if any
+  if (++s_current_update_range < s_num_update_ranges) {
+    prv_display_update_next_range();
+    return;
+  }
+
+  PROFILER_NODE_STOP(display_transfer);
   s_updating = false;
   s_uccb();
   stop_mode_enable(InhibitorDisplay);
@@ -285,71 +337,59 @@ void display_set_rotated(bool rotated) {
 }
 
 void display_update(NextRowCallback nrcb, UpdateCompleteCallback uccb) {
-  DisplayJDIState *state = DISPLAY->state;
   DisplayRow row;
-  bool first_row = true;
 
   PBL_ASSERTN(!s_updating);
 
-  // Convert rows in-place from 222 to 332 format
+  // Convert rows in-place from 222 to 332 format, grouping consecutive rows into ranges which
+  // are each sent with a single transfer. Rows are handed to us in ascending order, but the
+  // caller may skip over rows which haven't changed.
   // We use the compositor's framebuffer directly to save RAM
+  s_num_update_ranges = 0;
   while (nrcb(&row)) {
-    if (first_row) {
-      // Capture pointer to compositor's framebuffer from first row
-      s_framebuffer = row.data;
-      s_update_y0 = row.address;
-      first_row = false;
-    }
-    s_update_y1 = row.address;
-
-    // Convert this row in-place from 222 to 332 using word-level bit manipulation
-    // 222 format: XX RR GG BB (bits 7-6 unused, 5-4 R, 3-2 G, 1-0 B)
-    // 332 format: RR 0G GG BB (bits 7-6 R, 4-3 G, 1-0 B)
-    uint32_t *row32 = (uint32_t *)row.data;
-    for (uint16_t x = 0; x < PBL_DISPLAY_WIDTH / 4; x++) {
-      uint32_t p = row32[x];
-      row32[x] = ((p & 0x30303030) << 2) |  // R: bits 4-5 → 6-7
-                 ((p & 0x0C0C0C0C) << 1) |  // G: bits 2-3 → 3-4
-                 (p & 0x03030303);          // B: bits 0-1 stay
-    }
-
-    if (s_rotated_180) {
-      // HMirror in software (VMirror is done by hardware)
-      uint8_t *row_data = row.data;
-      for (uint16_t x = 0; x < PBL_DISPLAY_WIDTH / 2; x++) {
-        uint8_t tmp = row_data[x];
-        row_data[x] = row_data[PBL_DISPLAY_WIDTH - 1 - x];
-        row_data[PBL_DISPLAY_WIDTH - 1 - x] = tmp;
+    if (s_num_update_ranges == 0) {
+      // Capture pointer to the start of the compositor's framebuffer (row 0) from first row
+      s_framebuffer = (uint8_t *)row.data - (row.address * PBL_DISPLAY_WIDTH);
+      s_update_ranges[s_num_update_ranges++] = (UpdateRange) { row.address, row.address };
+    } else {
+      UpdateRange *range = &s_update_ranges[s_num_update_ranges - 1];
+      if (row.address == range->y1 + 1) {
+        range->y1 = row.address;
+      } else if (s_num_update_ranges < MAX_UPDATE_RANGES) {
+        s_update_ranges[s_num_update_ranges++] = (UpdateRange) { row.address, row.address };
+      } else {
+        // Out of ranges, send the skipped rows along with the last range
+        for (uint16_t y = range->y1 + 1; y < row.address; y++) {
+          prv_convert_row_to_332(&s_framebuffer[y * PBL_DISPLAY_WIDTH]);
+        }
+        range->y1 = row.address;
       }
     }
+
+    prv_convert_row_to_332(row.data);
   }
 
-  if (first_row) {
+  if (s_num_update_ranges == 0) {
     // No rows to update
     uccb();
     return;
   }
 
-  // Adjust framebuffer pointer to start of buffer (row 0)
-  s_framebuffer = s_framebuffer - (s_update_y0 * PBL_DISPLAY_WIDTH);
-
   s_uccb = uccb;
   s_updating = true;
+  s_current_update_range = 0;
+
+  PROFILER_NODE_START(display_transfer);
 
   stop_mode_disable(InhibitorDisplay);
-  prv_display_update_start();
+  prv_display_update_next_range();
 }
 
 void display_update_boot_frame(uint8_t *framebuffer) {
   if (s_rotated_180) {
     // HMirror in software (VMirror is done by hardware)
     for (uint16_t y = 0; y < PBL_DISPLAY_HEIGHT; y++) {
-      uint8_t *row = &framebuffer[y * PBL_DISPLAY_WIDTH];
-      for (uint16_t x = 0; x < PBL_DISPLAY_WIDTH / 2; x++) {
-        uint8_t tmp = row[x];
-        row[x] = row[PBL_DISPLAY_WIDTH - 1 - x];
-        row[PBL_DISPLAY_WIDTH - 1 - x] = tmp;
-      }
+      prv_hmirror_row(&framebuffer[y * PBL_DISPLAY_WIDTH]);
     }
   }
 
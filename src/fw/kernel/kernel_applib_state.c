@@ -150,6 +150,11 @@ Layer** kernel_applib_get_layer_tree_stack(void) {
   return layer_tree_stack;
 }
 
+LayerTreeDrawState *kernel_applib_get_layer_tree_draw_state_stack(void) {
+  static LayerTreeDrawState layer_tree_draw_state_stack[LAYER_TREE_STACK_SIZE];
+  return layer_tree_draw_state_stack;
+}
+
 // -------------------------------------------------------------------------------------------------------------
 void kernel_applib_init(void) {
   s_log_state_mutex = mutex_create_recursive();
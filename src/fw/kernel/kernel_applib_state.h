@@ -35,3 +35,5 @@ struct Layer;
 typedef struct Layer Layer;
 
 Layer** kernel_applib_get_layer_tree_stack(void);
+
+struct LayerTreeDrawState *kernel_applib_get_layer_tree_draw_state_stack(void);
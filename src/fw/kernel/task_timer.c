@@ -4,13 +4,14 @@
 #include "task_timer.h"
 #include "task_timer_manager.h"
 
+#include "drivers/rtc.h"
 #include "kernel/pebble_tasks.h"
 #include "kernel/pbl_malloc.h"
 #include "os/mutex.h"
 #include "os/tick.h"
 #include "system/logging.h"
 #include "system/passert.h"
-#include "util/list.h"
+#include "util/math.h"
 
 #include "FreeRTOS.h"
 #include "queue.h"
@@ -19,9 +20,8 @@
 
 // Structure of a timer
 typedef struct TaskTimer {
-  //! Entry into either the running timers (manager->running_timers) list or the idle timers
-  //! (manager->idle_timers)
-  ListNode list_node;
+  //! Next timer in the same manager->timers_by_id bucket
+  struct TaskTimer *id_next;
 
   //! The tick value when this timer will expire (in ticks). If the timer isn't currently
   //! running (scheduled) this value will be zero.
@@ -31,6 +31,13 @@ typedef struct TaskTimer {
 
   TaskTimerID id;            //<! ID assigned to this timer
 
+  //! Value of manager->next_schedule_seq when this timer was scheduled, breaks ties between
+  //! timers with the same expire_time.
+  uint32_t schedule_seq;
+
+  //! Position of this timer in manager->running_timers. Only valid while expire_time is non-zero.
+  uint16_t heap_index;
+
   //! client provided callback function and argument
   TaskTimerCallback cb;
   void* cb_data;
@@ -46,38 +53,176 @@ typedef struct TaskTimer {
   bool defer_delete:1;
 } TaskTimer;
 
+#define MIN_RUNNING_TIMERS_CAPACITY 8
+#define MIN_ID_BUCKETS 8
+
+
 // ------------------------------------------------------------------------------------
-// Comparator function for list_sorted_add
-// Returns the order in which (a, b) occurs
-// returns negative int for a descending value (a > b), positive for an ascending value (b > a),
-// 0 for equal
-static int prv_timer_expire_compare_func(void* a, void* b) {
-  if (((TaskTimer*)b)->expire_time < ((TaskTimer*)a)->expire_time) {
-    return -1;
-  } else if (((TaskTimer*)b)->expire_time > ((TaskTimer*)a)->expire_time) {
-    return 1;
-  } else {
-    return 0;
+// Running timers min-heap
+
+//! Returns true if a should expire before b. Timers with the same expire time run in the order
+//! they were scheduled.
+static bool prv_timer_expires_before(const TaskTimer *a, const TaskTimer *b) {
+  if (a->expire_time != b->expire_time) {
+    return (a->expire_time < b->expire_time);
+  }
+  return ((int32_t)(a->schedule_seq - b->schedule_seq) < 0);
+}
+
+static void prv_heap_set(TaskTimerManager *manager, uint16_t index, TaskTimer *timer) {
+  manager->running_timers[index] = timer;
+  timer->heap_index = index;
+}
+
+static void prv_heap_sift_up(TaskTimerManager *manager, uint16_t index) {
+  TaskTimer *timer = manager->running_timers[index];
+  while (index > 0) {
+    const uint16_t parent = (index - 1) / 2;
+    if (!prv_timer_expires_before(timer, manager->running_timers[parent])) {
+      break;
+    }
+    prv_heap_set(manager, index, manager->running_timers[parent]);
+    index = parent;
+  }
+  prv_heap_set(manager, index, timer);
+}
+
+static void prv_heap_sift_down(TaskTimerManager *manager, uint16_t index) {
+  TaskTimer *timer = manager->running_timers[index];
+  const uint16_t count = manager->num_running_timers;
+  while (true) {
+    uint16_t child = (2 * index) + 1;
+    if (child >= count) {
+      break;
+    }
+    if ((child + 1 < count) &&
+        prv_timer_expires_before(manager->running_timers[child + 1],
+                                 manager->running_timers[child])) {
+      child++;
+    }
+    if (!prv_timer_expires_before(manager->running_timers[child], timer)) {
+      break;
+    }
+    prv_heap_set(manager, index, manager->running_timers[child]);
+    index = child;
+  }
+  prv_heap_set(manager, index, timer);
+}
+
+static TaskTimer *prv_next_running_timer(TaskTimerManager *manager) {
+  return (manager->num_running_timers) ? manager->running_timers[0] : NULL;
+}
+
+//! Adds a timer whose expire_time has already been set to the running timers
+static void prv_add_running_timer(TaskTimerManager *manager, TaskTimer *timer) {
+  // task_timer_create() makes sure there's a slot for every timer
+  PBL_ASSERTN(manager->num_running_timers < manager->running_timers_capacity);
+  timer->schedule_seq = manager->next_schedule_seq++;
+  const uint16_t index = manager->num_running_timers++;
+  prv_heap_set(manager, index, timer);
+  prv_heap_sift_up(manager, index);
+}
+
+static void prv_remove_running_timer(TaskTimerManager *manager, TaskTimer *timer) {
+  const uint16_t index = timer->heap_index;
+  PBL_ASSERTN(index < manager->num_running_timers && manager->running_timers[index] == timer);
+  const uint16_t last = --manager->num_running_timers;
+  if (index != last) {
+    // Move the last timer into the hole, then restore the heap order in whichever direction the
+    // moved timer needs to go
+    TaskTimer *moved = manager->running_timers[last];
+    prv_heap_set(manager, index, moved);
+    prv_heap_sift_up(manager, index);
+    prv_heap_sift_down(manager, moved->heap_index);
   }
 }
 
 
 // ------------------------------------------------------------------------------------
-// Find timer by id
-static bool prv_id_list_filter(ListNode* node, void* data) {
-  TaskTimer* timer = (TaskTimer*)node;
-  return timer->id == (uint32_t) data;
+// Timer ID index
+
+static TaskTimer **prv_id_bucket(TaskTimerManager *manager, TaskTimerID timer_id) {
+  return &manager->timers_by_id[timer_id & (manager->num_id_buckets - 1)];
+}
+
+//! Grows the ID hash table so chains stay short. Keeps the current table if we're out of memory,
+//! which is only slower, unless there's no table at all yet.
+static bool prv_grow_id_index(TaskTimerManager *manager) {
+  if (manager->num_timers < manager->num_id_buckets) {
+    return true;
+  }
+  const uint16_t num_buckets = MAX(MIN_ID_BUCKETS, 2 * manager->num_id_buckets);
+  TaskTimer **buckets = kernel_zalloc(num_buckets * sizeof(TaskTimer *));
+  if (!buckets) {
+    return (manager->num_id_buckets != 0);
+  }
+  TaskTimer **old_buckets = manager->timers_by_id;
+  const uint16_t old_num_buckets = manager->num_id_buckets;
+  manager->timers_by_id = buckets;
+  manager->num_id_buckets = num_buckets;
+  for (uint16_t i = 0; i < old_num_buckets; i++) {
+    TaskTimer *timer = old_buckets[i];
+    while (timer) {
+      TaskTimer *next = timer->id_next;
+      TaskTimer **bucket = prv_id_bucket(manager, timer->id);
+      timer->id_next = *bucket;
+      *bucket = timer;
+      timer = next;
+    }
+  }
+  kernel_free(old_buckets);
+  return true;
+}
+
+//! Makes sure there's a running_timers slot for one more timer
+static bool prv_grow_running_timers(TaskTimerManager *manager) {
+  if (manager->num_timers < manager->running_timers_capacity) {
+    return true;
+  }
+  const uint32_t capacity = MAX(MIN_RUNNING_TIMERS_CAPACITY,
+                                2 * manager->running_timers_capacity);
+  if (capacity > UINT16_MAX) {
+    return false;
+  }
+  TaskTimer **running_timers = kernel_realloc(manager->running_timers,
+                                              capacity * sizeof(TaskTimer *));
+  if (!running_timers) {
+    return false;
+  }
+  manager->running_timers = running_timers;
+  manager->running_timers_capacity = capacity;
+  return true;
 }
 
+static void prv_add_to_id_index(TaskTimerManager *manager, TaskTimer *timer) {
+  TaskTimer **bucket = prv_id_bucket(manager, timer->id);
+  timer->id_next = *bucket;
+  *bucket = timer;
+  manager->num_timers++;
+}
+
+static void prv_remove_from_id_index(TaskTimerManager *manager, TaskTimer *timer) {
+  TaskTimer **link = prv_id_bucket(manager, timer->id);
+  while (*link != timer) {
+    PBL_ASSERTN(*link);
+    link = &(*link)->id_next;
+  }
+  *link = timer->id_next;
+  manager->num_timers--;
+}
+
+
+// ------------------------------------------------------------------------------------
+// Find timer by id
 static TaskTimer* prv_find_timer(TaskTimerManager *manager, TaskTimerID timer_id) {
   PBL_ASSERTN(timer_id != TASK_TIMER_INVALID_ID);
-  // Look for this timer in either the running or idle list
-  ListNode* node = list_find(manager->running_timers, prv_id_list_filter, (void*)timer_id);
-  if (!node) {
-    node = list_find(manager->idle_timers, prv_id_list_filter, (void*)timer_id);
+  PBL_ASSERTN(manager->num_id_buckets);
+  TaskTimer *timer = *prv_id_bucket(manager, timer_id);
+  while (timer && timer->id != timer_id) {
+    timer = timer->id_next;
   }
-  PBL_ASSERTN(node);
-  return (TaskTimer *)node;
+  PBL_ASSERTN(timer);
+  return timer;
 }
 
 
@@ -92,9 +237,16 @@ TaskTimerID task_timer_create(TaskTimerManager *manager) {
     return TASK_TIMER_INVALID_ID;
   }
 
-  // Grab lock on timer structures, create a unique ID for this timer and put it into our idle
-  // timers list
+  // Grab lock on timer structures, make sure there's room for one more timer in the running
+  // timers heap so that task_timer_start() never has to allocate, then create a unique ID for this
+  // timer and add it to our ID index
   mutex_lock(manager->mutex);
+  if (!prv_grow_running_timers(manager) || !prv_grow_id_index(manager)) {
+    mutex_unlock(manager->mutex);
+    kernel_free(timer);
+    return TASK_TIMER_INVALID_ID;
+  }
+
   *timer = (TaskTimer) {
     .id = manager->next_id++,
   };
@@ -103,7 +255,7 @@ TaskTimerID task_timer_create(TaskTimerManager *manager) {
   // second
   PBL_ASSERTN(timer->id != TASK_TIMER_INVALID_ID);
 
-  manager->idle_timers = list_insert_before(manager->idle_timers, &timer->list_node);
+  prv_add_to_id_index(manager, timer);
   mutex_unlock(manager->mutex);
 
   return timer->id;
@@ -137,13 +289,9 @@ bool task_timer_start(TaskTimerManager *manager, TaskTimerID timer_id,
     return false;
   }
 
-  // Remove it from its current list
+  // Unschedule it if it's currently running
   if (timer->expire_time) {
-    PBL_ASSERTN(list_contains(manager->running_timers, &timer->list_node));
-    list_remove(&timer->list_node, &manager->running_timers /* &head */, NULL /* &tail */);
-  } else {
-    PBL_ASSERTN(list_contains(manager->idle_timers, &timer->list_node));
-    list_remove(&timer->list_node, &manager->idle_timers /* &head */, NULL /* &tail */);
+    prv_remove_running_timer(manager, timer);
   }
 
   // Set timer variables
@@ -153,12 +301,11 @@ bool task_timer_start(TaskTimerManager *manager, TaskTimerID timer_id,
   timer->repeating = flags & TIMER_START_FLAG_REPEATING;
   timer->period_ticks = timeout_ticks;
 
-  // Insert into sorted order in the running list
-  manager->running_timers = list_sorted_add(manager->running_timers, &timer->list_node,
-                                            prv_timer_expire_compare_func, true);
+  // Insert into the running timers heap
+  prv_add_running_timer(manager, timer);
 
   // Wake up our service task if this is the new head so that it can recompute its wait timeout
-  if (manager->running_timers == &timer->list_node) {
+  if (prv_next_running_timer(manager) == timer) {
     xSemaphoreGive(manager->semaphore);
   }
   mutex_unlock(manager->mutex);
@@ -202,11 +349,9 @@ bool task_timer_stop(TaskTimerManager *manager, TaskTimerID timer_id) {
   TaskTimer* timer = prv_find_timer(manager, timer_id);
   PBL_ASSERTN(!timer->defer_delete);
 
-  // Move it to the idle list if it's currently running
+  // Unschedule it if it's currently running
   if (timer->expire_time) {
-    PBL_ASSERTN(list_contains(manager->running_timers, &timer->list_node));
-    list_remove(&timer->list_node, &manager->running_timers /* &head */, NULL /* &tail */);
-    manager->idle_timers = list_insert_before(manager->idle_timers, &timer->list_node);
+    prv_remove_running_timer(manager, timer);
   }
 
   // Clear the repeating flag so that if they call this method from a callback it won't get
@@ -235,10 +380,8 @@ void task_timer_delete(TaskTimerManager *manager, TaskTimerID timer_id) {
 
   // Automatically stop it if it it's not stopped already
   if (timer->expire_time) {
+    prv_remove_running_timer(manager, timer);
     timer->expire_time = 0;
-    PBL_ASSERTN(list_contains(manager->running_timers, &timer->list_node));
-    list_remove(&timer->list_node, &manager->running_timers /* &head */, NULL /* &tail */);
-    manager->idle_timers = list_insert_before(manager->idle_timers, &timer->list_node);
   }
   timer->repeating = false; // In case it's currently executing, make sure we don't reschedule it
 
@@ -248,8 +391,7 @@ void task_timer_delete(TaskTimerManager *manager, TaskTimerID timer_id) {
     timer->defer_delete = true;
     mutex_unlock(manager->mutex);
   } else {
-    PBL_ASSERTN(list_contains(manager->idle_timers, &timer->list_node));
-    list_remove(&timer->list_node, &manager->idle_timers /* &head */, NULL /* &tail */);
+    prv_remove_from_id_index(manager, timer);
     mutex_unlock(manager->mutex);
     kernel_free(timer);
   }
@@ -280,16 +422,15 @@ TickType_t task_timer_manager_execute_expired_timers(TaskTimerManager *manager)
     // If no timer is ready yet, then ticks_to_wait will be > 0.
     mutex_lock(manager->mutex);
 
-    TaskTimer *next_timer = (TaskTimer*) manager->running_timers;
+    TaskTimer *next_timer = prv_next_running_timer(manager);
     if (next_timer != NULL) {
       next_expiry_time = next_timer->expire_time;
       RtcTicks current_time = rtc_get_ticks();
 
       if (next_expiry_time <= current_time) {
-        // Found a timer that has expired! Move it from the running list to the idle talk and
-        // mark it as executing.
-        manager->running_timers = list_pop_head(manager->running_timers);
-        manager->idle_timers = list_insert_before(manager->idle_timers, &next_timer->list_node);
+        // Found a timer that has expired! Take it out of the running timers and mark it as
+        // executing.
+        prv_remove_running_timer(manager, next_timer);
 
         next_timer->executing = true;
         next_timer->expire_time = 0;
@@ -331,15 +472,12 @@ TickType_t task_timer_manager_execute_expired_timers(TaskTimerManager *manager)
     // callback (next_timer->expire_time != 0)
     if (next_timer->repeating && !next_timer->expire_time) {
       next_timer->expire_time = next_expiry_time + next_timer->period_ticks;
-      list_remove(&next_timer->list_node, &manager->idle_timers /* &head */, NULL /* &tail */);
-      manager->running_timers = list_sorted_add(manager->running_timers, &next_timer->list_node,
-                                                prv_timer_expire_compare_func, true);
+      prv_add_running_timer(manager, next_timer);
     }
 
     // If it's been marked for deletion, take care of that now
     if (next_timer->defer_delete) {
-      PBL_ASSERTN(list_contains(manager->idle_timers, &next_timer->list_node));
-      list_remove(&next_timer->list_node, &manager->idle_timers /* &head */, NULL /* &tail */);
+      prv_remove_from_id_index(manager, next_timer);
       mutex_unlock(manager->mutex);
 
       kernel_free(next_timer);
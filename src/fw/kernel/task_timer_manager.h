@@ -10,10 +10,25 @@
 typedef struct TaskTimerManager {
   PebbleMutex *mutex;
 
-  //! List of timers that are currently running
-  ListNode *running_timers;
-  //! List of timers that are allocated but unscheduled
-  ListNode *idle_timers;
+  //! Binary min-heap of the timers that are currently running, ordered by expire time. The next
+  //! timer to expire is always running_timers[0].
+  struct TaskTimer **running_timers;
+  uint16_t num_running_timers;
+  //! Number of slots allocated in running_timers. This is grown as timers are created so that
+  //! scheduling a timer never has to allocate.
+  uint16_t running_timers_capacity;
+
+  //! Hash table of every timer allocated by this manager, running or not, keyed by timer ID.
+  //! Each bucket is a chain of timers linked through TaskTimer::id_next.
+  struct TaskTimer **timers_by_id;
+  //! Number of buckets in timers_by_id, always a power of two (or zero before the first timer).
+  uint16_t num_id_buckets;
+  //! Number of timers in timers_by_id
+  uint16_t num_timers;
+
+  //! Incremented every time a timer is scheduled so that timers that expire on the same tick run
+  //! in the order they were scheduled.
+  uint32_t next_schedule_seq;
 
   //! The next ID to assign to a new timer.
   TaskTimerID next_id;
@@ -397,6 +397,8 @@ static bool prv_render_modal_stack_callback(ModalContext *modal, IterContext *it
     transition_context->implementation->render(transition_context, ctx);
   } else {
     PROFILER_NODE_START(render_modal);
+    // Modal windows share the framebuffer with the modals and app below them
+    window_invalidate(window);
     window_render(window, ctx);
     PROFILER_NODE_STOP(render_modal);
   }
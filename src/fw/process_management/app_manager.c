@@ -347,6 +347,11 @@ static bool prv_app_start(const PebbleProcessMd *app_md, const void *args,
   PBL_LOG_DBG("App heap init %p %p",
           app_segment.start, app_segment.end);
   heap_init(app_heap, app_segment.start, app_segment.end, enable_heap_fuzzing);
+  // The free lists keep their links in free'd memory, so only use them where fuzzing would
+  // have caught accesses to free'd memory.
+  if (enable_heap_fuzzing) {
+    heap_enable_free_lists(app_heap);
+  }
   heap_set_lock_impl(app_heap, (HeapLockImpl) {
       .lock_function = prv_heap_lock,
   });
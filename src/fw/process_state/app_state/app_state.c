@@ -90,6 +90,7 @@ typedef struct {
   UnobstructedAreaState unobstructed_area_service_state;
 
   Layer* layer_tree_stack[LAYER_TREE_STACK_SIZE];
+  LayerTreeDrawState layer_tree_draw_state_stack[LAYER_TREE_STACK_SIZE];
 
   WakeupHandler wakeup_handler;
 
@@ -345,6 +346,10 @@ Layer** app_state_get_layer_tree_stack(void) {
   return s_app_state_ptr->layer_tree_stack;
 }
 
+LayerTreeDrawState *app_state_get_layer_tree_draw_state_stack(void) {
+  return s_app_state_ptr->layer_tree_draw_state_stack;
+}
+
 AppFocusState *app_state_get_app_focus_state(void) {
   return &s_app_state_ptr->app_focus_state;
 }
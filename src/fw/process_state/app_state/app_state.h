@@ -152,6 +152,8 @@ typedef struct Layer Layer;
 
 Layer** app_state_get_layer_tree_stack(void);
 
+struct LayerTreeDrawState *app_state_get_layer_tree_draw_state_stack(void);
+
 WakeupHandler app_state_get_wakeup_handler(void);
 void app_state_set_wakeup_handler(WakeupHandler handler);
 
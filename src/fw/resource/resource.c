@@ -4,6 +4,7 @@
 #include "resource.h"
 #include "resource_storage.h"
 #include "resource_storage_builtin.h"
+#include "resource_storage_file.h"
 #include "resource_storage_flash.h"
 
 #include "process_management/app_manager.h"
@@ -11,12 +12,40 @@
 #include "flash_region/flash_region.h"
 #include "kernel/pbl_malloc.h"
 #include "os/mutex.h"
+#include "services/normal/filesystem/pfs.h"
 #include "services/normal/process_management/app_storage.h"
 #include "system/logging.h"
 #include "system/passert.h"
+#include "util/attributes.h"
+#include "util/list.h"
+#include "util/lru_cache.h"
 
-// TODO: this may be replaced once apps become more dynamic
+extern const FileResourceData g_file_resource_stores[];
+extern const uint32_t g_num_file_resource_stores;
 
+//! Number of resource entries that are kept for the system bank and for the current app bank.
+//! Every entry that is found here saves reading the table of contents of the store again.
+#define SYSTEM_ENTRY_CACHE_SIZE 32
+#define APP_ENTRY_CACHE_SIZE 16
+
+#define ENTRY_CACHE_BUFFER_SIZE(num_entries) \
+    ((num_entries) * (sizeof(CacheEntry) + sizeof(ResourceStoreEntry)))
+
+typedef struct {
+  LRUCache cache;
+  uint8_t *buffer;
+  size_t buffer_size;
+  //! The bank the entries belong to, SYSTEM_APP for the app cache means no app bank is cached
+  ResAppNum app_num;
+  PFSCallbackHandle watch_handle;
+  //! Set by the PFS callbacks when a file the entries were read from changed, the cache is
+  //! flushed before the next lookup
+  volatile bool is_stale;
+  bool is_initialized;
+} ResourceEntryCache;
+
+//! A system resource that was looked up with resource_get_and_cache, like the system fonts.
+//! These are kept apart from the entry cache so that they are never evicted from it.
 typedef struct {
   ListNode list_node;
   uint32_t id;
@@ -27,6 +56,24 @@ PebbleRecursiveMutex *s_resource_mutex = NULL;
 
 static CachedResource *s_resource_list = NULL;
 
+static ALIGN(8) uint8_t s_system_cache_buffer[ENTRY_CACHE_BUFFER_SIZE(SYSTEM_ENTRY_CACHE_SIZE)];
+static ALIGN(8) uint8_t s_app_cache_buffer[ENTRY_CACHE_BUFFER_SIZE(APP_ENTRY_CACHE_SIZE)];
+
+static ResourceEntryCache s_system_cache = {
+  .buffer = s_system_cache_buffer,
+  .buffer_size = sizeof(s_system_cache_buffer),
+  .app_num = SYSTEM_APP,
+};
+
+static ResourceEntryCache s_app_cache = {
+  .buffer = s_app_cache_buffer,
+  .buffer_size = sizeof(s_app_cache_buffer),
+  .app_num = SYSTEM_APP,
+};
+
+static uint32_t s_cache_hits;
+static uint32_t s_cache_misses;
+
 static bool prv_resource_filter(ListNode *found_node, void *data) {
   CachedResource *resource = (CachedResource *)found_node;
   uint32_t resource_id = (uint32_t)data;
@@ -34,6 +81,84 @@ static bool prv_resource_filter(ListNode *found_node, void *data) {
   return (resource->id == resource_id);
 }
 
+static CachedResource *prv_find_cached_resource(uint32_t resource_id) {
+  return (CachedResource *)list_find((ListNode *)s_resource_list, prv_resource_filter,
+                                     (void *)(uintptr_t)resource_id);
+}
+
+static void prv_entry_cache_flush(ResourceEntryCache *cache) {
+  if (!cache->is_initialized) {
+    lru_cache_init(&cache->cache, sizeof(ResourceStoreEntry), cache->buffer, cache->buffer_size);
+    cache->is_initialized = true;
+  }
+  lru_cache_flush(&cache->cache);
+  cache->is_stale = false;
+
+  if (cache == &s_system_cache) {
+    // the system bank changed, read the resources that stay cached from the new one
+    CachedResource *cached_resource = s_resource_list;
+    while (cached_resource) {
+      resource_storage_get_resource(SYSTEM_APP, cached_resource->id,
+                                    &cached_resource->stored_resource);
+      cached_resource = (CachedResource *)cached_resource->list_node.next;
+    }
+  }
+}
+
+//! Called by PFS with its own lock held, so this must not take s_resource_mutex
+static void prv_entry_cache_file_changed(void *data) {
+  ResourceEntryCache *cache = data;
+  cache->is_stale = true;
+}
+
+//! @return the cache for the given bank, NULL if entries of that bank aren't cached
+static ResourceEntryCache *prv_entry_cache_for_bank(ResAppNum app_num) {
+  ResourceEntryCache *cache;
+  if (app_num == SYSTEM_APP) {
+    cache = &s_system_cache;
+  } else if (app_num == s_app_cache.app_num) {
+    cache = &s_app_cache;
+  } else {
+    return NULL;
+  }
+  if (!cache->is_initialized || cache->is_stale) {
+    prv_entry_cache_flush(cache);
+  }
+  return cache;
+}
+
+static void prv_app_cache_set_bank(ResAppNum app_num) {
+#ifndef RECOVERY_FW
+  if (s_app_cache.watch_handle) {
+    pfs_unwatch_file(s_app_cache.watch_handle);
+    s_app_cache.watch_handle = NULL;
+  }
+  if (app_num != SYSTEM_APP) {
+    // app updates and removals rewrite the resource file without a call to resource_init_app
+    char filename[APP_RESOURCE_FILENAME_MAX_LENGTH + 1]; // extra for null terminator
+    resource_storage_get_file_name(filename, sizeof(filename), app_num);
+    s_app_cache.watch_handle = pfs_watch_file(filename, prv_entry_cache_file_changed,
+                                              FILE_CHANGED_EVENT_ALL, &s_app_cache);
+  }
+#endif
+  s_app_cache.app_num = app_num;
+  prv_entry_cache_flush(&s_app_cache);
+}
+
+static void prv_system_cache_watch_files(void) {
+#ifndef RECOVERY_FW
+  static bool s_watching_files = false;
+  if (s_watching_files) {
+    return;
+  }
+  for (unsigned int i = 0; i < g_num_file_resource_stores; ++i) {
+    pfs_watch_file(g_file_resource_stores[i].name, prv_entry_cache_file_changed,
+                   FILE_CHANGED_EVENT_ALL, &s_system_cache);
+  }
+  s_watching_files = true;
+#endif
+}
+
 static void prv_get_resource(ResAppNum app_num, uint32_t id, ResourceStoreEntry *entry) {
   if (id < 1) {
     *entry = (ResourceStoreEntry){0};
@@ -42,15 +167,30 @@ static void prv_get_resource(ResAppNum app_num, uint32_t id, ResourceStoreEntry
 
   mutex_lock_recursive(s_resource_mutex);
 
-  ListNode *node;
-  if (app_num == SYSTEM_APP &&
-     (node = list_find((ListNode *)s_resource_list, prv_resource_filter, (void *)(uintptr_t)id))) {
+  ResourceEntryCache *cache = prv_entry_cache_for_bank(app_num);
+  const ResourceStoreEntry *cached = NULL;
+  if (app_num == SYSTEM_APP) {
+    CachedResource *cached_resource = prv_find_cached_resource(id);
+    if (cached_resource) {
+      cached = &cached_resource->stored_resource;
+    }
+  }
+  if (!cached && cache) {
+    cached = lru_cache_get(&cache->cache, id);
+  }
+  if (cached) {
+    ++s_cache_hits;
+    *entry = *cached;
     mutex_unlock_recursive(s_resource_mutex);
-    *entry = ((CachedResource *)node)->stored_resource;
     return;
   }
 
+  ++s_cache_misses;
   resource_storage_get_resource(app_num, id, entry);
+  // missing resources aren't cached, looking them up again is rare
+  if (cache && entry->id != 0) {
+    lru_cache_put(&cache->cache, id, entry);
+  }
   mutex_unlock_recursive(s_resource_mutex);
 }
 
@@ -58,6 +198,12 @@ static void prv_get_resource(ResAppNum app_num, uint32_t id, ResourceStoreEntry
 bool resource_init_app(ResAppNum app_num, const ResourceVersion *expected_version) {
   // resource_id is ignored in this case, so we set it to 0
   mutex_lock_recursive(s_resource_mutex);
+  // the bank may have been replaced, start over with the entries of this one
+  if (app_num == SYSTEM_APP) {
+    prv_entry_cache_flush(&s_system_cache);
+  } else {
+    prv_app_cache_set_bank(app_num);
+  }
   bool rv = resource_storage_check(app_num, 0, expected_version);
   mutex_unlock_recursive(s_resource_mutex);
   return rv;
@@ -68,35 +214,49 @@ void resource_init(void) {
   resource_storage_init();
 
   s_resource_mutex = mutex_create_recursive();
+
+  while (s_resource_list) {
+    CachedResource *cached_resource = s_resource_list;
+    s_resource_list = (CachedResource *)list_pop_head((ListNode *)cached_resource);
+    kernel_free(cached_resource);
+  }
+  prv_entry_cache_flush(&s_system_cache);
+  prv_app_cache_set_bank(SYSTEM_APP);
+  prv_system_cache_watch_files();
 }
 
 uint32_t resource_get_and_cache(ResAppNum app_num, uint32_t resource_id) {
   PBL_ASSERTN(app_num == SYSTEM_APP);
-  // get from resource store
   mutex_lock_recursive(s_resource_mutex);
   ResourceStoreEntry res;
-  resource_storage_get_resource(app_num, resource_id, &res);
+  prv_get_resource(app_num, resource_id, &res);
   if (res.id < 1) {
     mutex_unlock_recursive(s_resource_mutex);
     return 0;
   }
 
-  // check if we already have something in cache for this resource
-  CachedResource *cached_resource = (CachedResource *)list_find((ListNode *)s_resource_list,
-      prv_resource_filter, (void *)(uintptr_t)resource_id);
-  if (cached_resource == NULL) {
-    cached_resource = kernel_malloc_check(sizeof(CachedResource));
-    *cached_resource = (CachedResource){};
-    cached_resource->id = resource_id;
+  // keep it out of reach of the LRU eviction of the entry cache
+  if (prv_find_cached_resource(resource_id) == NULL) {
+    CachedResource *cached_resource = kernel_malloc_check(sizeof(CachedResource));
+    *cached_resource = (CachedResource){
+      .id = resource_id,
+      .stored_resource = res,
+    };
     s_resource_list = (CachedResource *)list_prepend((ListNode *)s_resource_list,
         (ListNode *)cached_resource);
   }
-  cached_resource->stored_resource = res;
 
   mutex_unlock_recursive(s_resource_mutex);
   return resource_id;
 }
 
+void resource_get_entry_cache_stats(uint32_t *hits, uint32_t *misses) {
+  mutex_lock_recursive(s_resource_mutex);
+  *hits = s_cache_hits;
+  *misses = s_cache_misses;
+  mutex_unlock_recursive(s_resource_mutex);
+}
+
 size_t resource_load_byte_range_system(ResAppNum app_num, uint32_t resource_id,
     uint32_t offset, uint8_t *buffer, size_t num_bytes) {
   PBL_ASSERTN(buffer);
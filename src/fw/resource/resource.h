@@ -50,8 +50,15 @@ size_t resource_size(ResAppNum app_num, uint32_t resource_id);
 bool resource_is_valid(ResAppNum app_num, uint32_t resource_id);
 
 //! @internal
+//! Keeps the entry of a system resource cached for good, for resources like the system fonts
+//! that are read all the time
 uint32_t resource_get_and_cache(ResAppNum app_num, uint32_t resource_id);
 
+//! @internal
+//! Number of resource lookups that were answered by the entry cache of the system and current app
+//! bank, and the number of lookups that had to read the table of contents of the store instead.
+void resource_get_entry_cache_stats(uint32_t *hits, uint32_t *misses);
+
 //! @internal
 //! @param buffer[out] a buffer to load the data into. Must be at least max_length in bytes.
 //! @return Number of bytes actually read. Should be num_bytes for a successful read.
@@ -22,7 +22,7 @@
 // change or a new AnalyticsEvent enum is added.
 // Please do not cherrypick any change here into a release branch without first checking
 // with Katharine, or something is very likely to break.
-#define ANALYTICS_EVENT_BLOB_VERSION 32
+#define ANALYTICS_EVENT_BLOB_VERSION 33
 
 
 //! Types of events that can be logged outside of a heartbeat using analytics_logging_log_event()
@@ -224,6 +224,7 @@ typedef struct PACKED {
   uint16_t sync_errors;
   uint16_t skip_errors;
   uint16_t other_errors;
+  uint32_t commit_time_ms; // time spent checking the CRC and committing the object
 } AnalyticsEvent_PutByteTimeData;
 
 //! Used for both AnalyticsEvent_AppCrash and AnalyticsEvent_RockyAppCrash event types!
@@ -462,10 +463,12 @@ void analytics_event_health_insight_response(time_t timestamp, ActivityInsightTy
 //! @param bytes_transferred the number of bytes transferred
 //! @param elapsed_time_ms the amount of time spent transmitting the bytes
 //! @param conn_events, sync_errors, other_errors LE connection event statistics (if available)
+//! @param commit_time_ms the amount of time spent checking the CRC and committing the bytes
 void analytics_event_put_byte_stats(
     CommSession *session, bool crc_good, uint8_t type,
     uint32_t bytes_transferred, uint32_t elapsed_time_ms,
-    uint32_t conn_events, uint32_t sync_errors, uint32_t skip_errors, uint32_t other_errors);
+    uint32_t conn_events, uint32_t sync_errors, uint32_t skip_errors, uint32_t other_errors,
+    uint32_t commit_time_ms);
 
 //! Log an App Crash event to analytics
 //! @param uuid app's UUID
@@ -9,7 +9,7 @@
 // with Katharine, or something is very likely to break.
 
 #define ANALYTICS_APP_HEARTBEAT_BLOB_VERSION 11
-#define ANALYTICS_DEVICE_HEARTBEAT_BLOB_VERSION 69
+#define ANALYTICS_DEVICE_HEARTBEAT_BLOB_VERSION 71
 
 
 // Note that every analytics blob we send out (device blob, app blob, or event blob) starts out with
@@ -103,6 +103,10 @@
   DEVICE(ANALYTICS_DEVICE_METRIC_BT_DISCONNECT_IAP_WATCHDOG_FAILURE_COUNT, UINT8) \
   DEVICE(ANALYTICS_DEVICE_METRIC_BT_ZERO_ACL_CREDITS_MAX_DURATION_TICKS, UINT16) \
   DEVICE(ANALYTICS_DEVICE_METRIC_BT_COMM_SESSION_SEND_DATA_FAIL_COUNT, UINT16) \
+  DEVICE(ANALYTICS_DEVICE_METRIC_BT_COMM_SESSION_TX_WINDOW, UINT8) \
+  DEVICE(ANALYTICS_DEVICE_METRIC_BT_COMM_SESSION_RTT_MS, UINT16) \
+  DEVICE(ANALYTICS_DEVICE_METRIC_BT_COMM_SESSION_MAX_RTT_MS, UINT16) \
+  DEVICE(ANALYTICS_DEVICE_METRIC_BT_COMM_SESSION_RETRANSMIT_COUNT, UINT16) \
   \
   DEVICE(ANALYTICS_DEVICE_METRIC_BLE_CONNECT_COUNT, UINT16) \
   DEVICE(ANALYTICS_DEVICE_METRIC_BLE_CONNECT_TIME, UINT32) \
@@ -216,6 +220,9 @@
   DEVICE(ANALYTICS_DEVICE_METRIC_FLASH_READ_BYTES_COUNT, UINT32) \
   DEVICE(ANALYTICS_DEVICE_METRIC_FLASH_WRITE_BYTES_COUNT, UINT32) \
   DEVICE(ANALYTICS_DEVICE_METRIC_FLASH_ERASE_COUNT, UINT8)  \
+  DEVICE(ANALYTICS_DEVICE_METRIC_FLASH_READ_CACHE_HIT_COUNT, UINT32) \
+  DEVICE(ANALYTICS_DEVICE_METRIC_FLASH_READ_CACHE_MISS_COUNT, UINT32) \
+  DEVICE(ANALYTICS_DEVICE_METRIC_FLASH_READ_CACHE_SAVED_BYTES_COUNT, UINT32) \
   \
   DEVICE(ANALYTICS_DEVICE_METRIC_KERNEL_HEAP_MIN_HEADROOM_BYTES, UINT16) \
   \
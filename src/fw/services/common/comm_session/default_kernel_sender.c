@@ -156,11 +156,17 @@ static size_t prv_send_job_impl_copy(const SessionSendQueueJob *send_job, int st
   return length_to_copy;
 }
 
+static size_t prv_send_job_impl_get_read_pointer_at(const SessionSendQueueJob *send_job,
+                                                    uint32_t start_offset,
+                                                    const uint8_t **data_out) {
+  SendBuffer *sb = (SendBuffer *)send_job;
+  *data_out = prv_get_read_pointer(sb) + start_offset;
+  return (prv_get_remaining_length(sb) - start_offset);
+}
+
 static size_t prv_send_job_impl_get_read_pointer(const SessionSendQueueJob *send_job,
                                                  const uint8_t **data_out) {
-  SendBuffer *sb = (SendBuffer *)send_job;
-  *data_out = prv_get_read_pointer(sb);
-  return prv_get_remaining_length(sb);
+  return prv_send_job_impl_get_read_pointer_at(send_job, 0, data_out);
 }
 
 static void prv_send_job_impl_consume(const SessionSendQueueJob *send_job, size_t length) {
@@ -176,6 +182,7 @@ T_STATIC const SessionSendJobImpl s_default_kernel_send_job_impl = {
   .get_length = prv_send_job_impl_get_length,
   .copy = prv_send_job_impl_copy,
   .get_read_pointer = prv_send_job_impl_get_read_pointer,
+  .get_read_pointer_at = prv_send_job_impl_get_read_pointer_at,
   .consume = prv_send_job_impl_consume,
   .free = prv_send_job_impl_free,
 };
@@ -11,6 +11,7 @@
 #include "services/common/comm_session/session_internal.h"
 #include "services/common/analytics/analytics.h"
 #include "services/common/ping.h"
+#include "util/math.h"
 #include "util/time/time.h"
 
 //! returns the analytic timer id we want to use
@@ -88,3 +89,21 @@ void comm_session_analytics_inc_bytes_received(CommSession *session, uint16_t le
                                                 ANALYTICS_DEVICE_METRIC_BT_PUBLIC_BYTE_IN_COUNT;
   analytics_add(metric, length, AnalyticsClient_System);
 }
+
+void comm_session_analytics_set_tx_window(CommSession *session, uint8_t num_packets) {
+  analytics_set(ANALYTICS_DEVICE_METRIC_BT_COMM_SESSION_TX_WINDOW, num_packets,
+                AnalyticsClient_System);
+}
+
+void comm_session_analytics_set_rtt(CommSession *session, uint32_t rtt_ms) {
+  const uint16_t capped_rtt_ms = MIN(rtt_ms, UINT16_MAX);
+  analytics_set(ANALYTICS_DEVICE_METRIC_BT_COMM_SESSION_RTT_MS, capped_rtt_ms,
+                AnalyticsClient_System);
+  analytics_max(ANALYTICS_DEVICE_METRIC_BT_COMM_SESSION_MAX_RTT_MS, capped_rtt_ms,
+                AnalyticsClient_System);
+}
+
+void comm_session_analytics_inc_retransmits(CommSession *session, uint16_t num_packets) {
+  analytics_add(ANALYTICS_DEVICE_METRIC_BT_COMM_SESSION_RETRANSMIT_COUNT, num_packets,
+                AnalyticsClient_System);
+}
@@ -33,3 +33,14 @@ void comm_session_analytics_close_session(CommSession *session, CommSessionClose
 void comm_session_analytics_inc_bytes_sent(CommSession *session, uint16_t length);
 
 void comm_session_analytics_inc_bytes_received(CommSession *session, uint16_t length);
+
+//! The following are reported by transports that do their own flow control (i.e. PPoGATT).
+
+//! Records the number of packets the transport currently allows to be in flight.
+void comm_session_analytics_set_tx_window(CommSession *session, uint8_t num_packets);
+
+//! Records the transport's (smoothed) round trip time estimate.
+void comm_session_analytics_set_rtt(CommSession *session, uint32_t rtt_ms);
+
+//! Increment the "retransmitted packets" counter
+void comm_session_analytics_inc_retransmits(CommSession *session, uint16_t num_packets);
@@ -42,6 +42,9 @@ typedef struct CommSession {
   //! The send queue of this session. See session_send_queue.c
   SessionSendQueueJob *send_queue_head;
 
+  //! The total length in bytes of the jobs in the send queue
+  size_t send_queue_length;
+
   ReceiveRouter recv_router;
 
   //! Absolute number of ticks since session opened.
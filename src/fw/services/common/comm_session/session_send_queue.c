@@ -23,6 +23,7 @@ void comm_session_send_queue_cleanup(CommSession *session) {
     job = next;
   }
   session->send_queue_head = NULL;
+  session->send_queue_length = 0;
 }
 
 // -------------------------------------------------------------------------------------------------
@@ -44,6 +45,7 @@ void comm_session_send_queue_add_job(CommSession *session, SessionSendQueueJob *
     } else {
       session->send_queue_head = job;
     }
+    session->send_queue_length += job->impl->get_length(job);
     // Schedule to let the transport to send the enqueued data:
     comm_session_send_next(session);
   }
@@ -56,13 +58,7 @@ unlock:
 // bt_lock is assumed to be taken by the caller of each of the below functions:
 
 size_t comm_session_send_queue_get_length(const CommSession *session) {
-  size_t length = 0;
-  const SessionSendQueueJob *job = session->send_queue_head;
-  while (job) {
-    length += job->impl->get_length(job);
-    job = (const SessionSendQueueJob *)job->node.next;
-  }
-  return length;
+  return session->send_queue_length;
 }
 
 size_t comm_session_send_queue_copy(CommSession *session, uint32_t start_offset,
@@ -84,6 +80,37 @@ size_t comm_session_send_queue_copy(CommSession *session, uint32_t start_offset,
   return (length - remaining_length);
 }
 
+size_t comm_session_send_queue_get_mbufs(CommSession *session, uint32_t start_offset,
+                                         size_t length, MBuf *mbufs, size_t max_mbufs) {
+  size_t remaining_length = length;
+  size_t num_mbufs = 0;
+  const SessionSendQueueJob *job = session->send_queue_head;
+  while (job && remaining_length && num_mbufs < max_mbufs) {
+    const size_t job_length = job->impl->get_length(job);
+    if (job_length <= start_offset) {
+      start_offset -= job_length;
+      job = (SessionSendQueueJob *)job->node.next;
+      continue;
+    }
+    // The job may not store its data contiguously, so it can take several MBufs to describe it
+    const uint8_t *data;
+    size_t data_length = job->impl->get_read_pointer_at(job, start_offset, &data);
+    data_length = MIN(data_length, MIN(job_length - start_offset, remaining_length));
+
+    mbufs[num_mbufs] = (MBuf) {
+      .data = (void *)data,
+      .length = data_length,
+    };
+    if (num_mbufs) {
+      mbufs[num_mbufs - 1].next = &mbufs[num_mbufs];
+    }
+    ++num_mbufs;
+    remaining_length -= data_length;
+    start_offset += data_length;
+  }
+  return (length - remaining_length);
+}
+
 size_t comm_session_send_queue_get_read_pointer(const CommSession *session,
                                                 const uint8_t **data_out) {
   if (!session->send_queue_head) {
@@ -98,6 +125,7 @@ void comm_session_send_queue_consume(CommSession *session, size_t remaining_leng
   comm_session_analytics_inc_bytes_sent(session, remaining_length);
 
   PBL_ASSERTN(session->send_queue_head);
+  const size_t length = remaining_length;
   SessionSendQueueJob *job = session->send_queue_head;
   while (job && remaining_length) {
     const size_t job_length = job->impl->get_length(job);
@@ -112,4 +140,5 @@ void comm_session_send_queue_consume(CommSession *session, size_t remaining_leng
     remaining_length -= consume_length;
     job = next;
   }
+  session->send_queue_length -= (length - remaining_length);
 }
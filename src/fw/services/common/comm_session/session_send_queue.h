@@ -33,6 +33,11 @@ typedef struct {
   size_t (*get_read_pointer)(const SessionSendQueueJob *send_job,
                              const uint8_t **data_out);
 
+  //! Like get_read_pointer(), but for the data `start_offset` bytes after the read pointer.
+  //! @note The caller will ensure start_offset is smaller than the length of the job.
+  size_t (*get_read_pointer_at)(const SessionSendQueueJob *send_job, uint32_t start_offset,
+                                const uint8_t **data_out);
+
   //! Indicates that `length` bytes have been consumed and sent out by the transport.
   void (*consume)(const SessionSendQueueJob *send_job, size_t length);
 
@@ -6,6 +6,7 @@
 #include "services/common/comm_session/session.h"
 #include "services/common/comm_session/session_analytics.h"
 
+#include "util/mbuf.h"
 #include "util/uuid.h"
 
 #include "comm/bt_conn_mgr.h"
@@ -141,6 +142,19 @@ size_t comm_session_send_queue_copy(CommSession *session, uint32_t start_offset,
 size_t comm_session_send_queue_get_read_pointer(const CommSession *session,
                                                 const uint8_t **data_out);
 
+//! Describes bytes in the send buffer as a chain of MBufs that point into the queued messages, so
+//! that they can be sent out without copying them into another buffer first.
+//! @param start_off The offset into the send buffer
+//! @param length The maximum number of bytes to describe
+//! @param[out] mbufs Caller-owned array of MBufs that will be filled in and chained together
+//! @param max_mbufs The number of MBufs in the array
+//! @return The number of bytes described by the chain. This is less than `length` if the data is
+//! spread out over more than `max_mbufs` buffers.
+//! @note The chain is only valid until comm_session_send_queue_consume() is called.
+//! @note bt_lock() is expected to be taken by the caller!
+size_t comm_session_send_queue_get_mbufs(CommSession *session, uint32_t start_offset,
+                                         size_t length, MBuf *mbufs, size_t max_mbufs);
+
 //! @note bt_lock() is expected to be taken by the caller!
 void comm_session_send_queue_consume(CommSession *session, size_t length);
 
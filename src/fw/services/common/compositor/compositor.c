@@ -84,6 +84,11 @@ static CompositorTransitionState s_animation_state;
 
 static bool s_framebuffer_frozen;
 
+//! True if the last frame composited into s_framebuffer (and therefore sent to the display) was
+//! the app framebuffer on its own. In that case only the rows which the app changed since then
+//! need to be sent to the display again.
+static bool s_app_frame_on_display;
+
 //! Animation .update function for the AnimationImplementation we use to drive our transitions.
 //! Wraps the .update function of the current CompositorTransition.
 static void prv_animation_update(Animation *animation, const AnimationProgress distance_normalized);
@@ -100,6 +105,7 @@ void compositor_init(void) {
   const GSize fb_size = GSize(DISP_COLS, DISP_ROWS);
   framebuffer_init(&s_framebuffer, &fb_size);
   framebuffer_clear(&s_framebuffer);
+  s_app_frame_on_display = false;
 
   s_state = CompositorState_App;
 
@@ -148,6 +154,41 @@ void compositor_set_modal_transition_offset(GPoint modal_offset) {
   s_animation_state.modal_offset = modal_offset;
 }
 
+//! Copies the rows of the app framebuffer which differ from s_framebuffer and marks only those
+//! rows as dirty, so that the display update can skip the rows which didn't change.
+static void prv_copy_changed_app_rows(void) {
+  GBitmap src_bitmap = compositor_get_app_framebuffer_as_bitmap();
+  GBitmap dst_bitmap = compositor_get_framebuffer_as_bitmap();
+  const int16_t num_rows = dst_bitmap.bounds.size.h;
+  int16_t changed_start = -1;
+  for (int16_t y = 0; y <= num_rows; y++) {
+    bool changed = false;
+    if (y < num_rows) {
+      const GBitmapDataRowInfo src_row = gbitmap_get_data_row_info(&src_bitmap, y);
+      const GBitmapDataRowInfo dst_row = gbitmap_get_data_row_info(&dst_bitmap, y);
+#if SCREEN_COLOR_DEPTH_BITS == 8
+      const size_t row_offset = dst_row.min_x;
+      const size_t row_size = dst_row.max_x - dst_row.min_x + 1;
+#else
+      const size_t row_offset = 0;
+      const size_t row_size = dst_bitmap.row_size_bytes;
+#endif
+      if (memcmp(dst_row.data + row_offset, src_row.data + row_offset, row_size) != 0) {
+        memcpy(dst_row.data + row_offset, src_row.data + row_offset, row_size);
+        changed = true;
+      }
+    }
+
+    if (changed && changed_start < 0) {
+      changed_start = y;
+    } else if (!changed && changed_start >= 0) {
+      framebuffer_mark_dirty_rect(&s_framebuffer,
+                                  GRect(0, changed_start, s_framebuffer.size.w, y - changed_start));
+      changed_start = -1;
+    }
+  }
+}
+
 void compositor_render_app(void) {
   PBL_ASSERT_TASK(PebbleTask_KernelMain);
 
@@ -157,21 +198,28 @@ void compositor_render_app(void) {
   GSize app_framebuffer_size;
   app_manager_get_framebuffer_size(&app_framebuffer_size);
 
+  const bool is_app_only = (s_state == CompositorState_App) &&
+                           gsize_equal(&app_framebuffer_size, &s_framebuffer.size);
+  bool only_changed_rows_dirty = false;
 
 #if CAPABILITY_COMPOSITOR_USES_DMA && !TARGET_QEMU && !UNITTEST
   if (gsize_equal(&app_framebuffer_size, &s_framebuffer.size)) {
     const FrameBuffer *app_framebuffer = app_state_get_framebuffer();
     compositor_dma_run(s_framebuffer.buffer, app_framebuffer->buffer, FRAMEBUFFER_SIZE_BYTES);
   } else {
+#else
+  if (is_app_only && s_app_frame_on_display) {
+    // s_framebuffer still holds the previous app frame, which is what the display is showing.
+    prv_copy_changed_app_rows();
+    only_changed_rows_dirty = true;
+  } else {
 #endif
     // Fill entire framebuffer with black first to avoid artifacts
     GBitmap dest_bitmap = compositor_get_framebuffer_as_bitmap();
     memset(dest_bitmap.addr, GColorBlack.argb, framebuffer_get_size_bytes(&s_framebuffer));
 
     compositor_scaled_app_fb_copy(GRect(0, 0, DISP_COLS, DISP_ROWS), false /* copy_relative_to_origin */);
-#if CAPABILITY_COMPOSITOR_USES_DMA && !TARGET_QEMU && !UNITTEST
   }
-#endif
 
   if (s_state == CompositorState_AppAndModal) {
     compositor_render_modal();
@@ -179,7 +227,10 @@ void compositor_render_app(void) {
 
   PROFILER_NODE_STOP(compositor);
 
-  framebuffer_dirty_all(&s_framebuffer);
+  if (!only_changed_rows_dirty) {
+    framebuffer_dirty_all(&s_framebuffer);
+  }
+  s_app_frame_on_display = is_app_only;
 }
 
 void compositor_render_modal(void) {
@@ -190,6 +241,8 @@ void compositor_render_modal(void) {
   static GDrawState prev_state;
   prev_state = ctx->draw_state;
 
+  s_app_frame_on_display = false;
+
   gpoint_add_eq(&ctx->draw_state.drawing_box.origin, s_animation_state.modal_offset);
 
   modal_manager_render(ctx);
@@ -337,6 +390,8 @@ void compositor_transition_render(CompositorTransitionUpdateFunc func, Animation
   static GDrawState prev_state;
   prev_state = ctx->draw_state;
 
+  s_app_frame_on_display = false;
+
   func(ctx, animation, distance_normalized);
 
   ctx->draw_state = prev_state;
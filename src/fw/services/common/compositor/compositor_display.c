@@ -32,17 +32,18 @@ static const uint8_t s_corner_shape[] = { 12, 9, 7, 6, 5, 4, 3, 2, 2, 1, 1, 1 };
 // 2 corners per row (left+right), so 12 * 24 * 2 = 576 bytes
 #define CORNER_SAVE_ROWS ARRAY_LENGTH(s_corner_shape)
 static uint8_t s_saved_corners[CORNER_SAVE_ROWS * 2][12 * 2]; // [row][left+right pixels]
-static uint8_t s_dirty_y0;
-static uint8_t s_dirty_y1;
+//! Bitset of the s_saved_corners rows which were saved as part of the current update
+static uint32_t s_saved_corner_rows;
+_Static_assert(CORNER_SAVE_ROWS * 2 <= 32, "s_saved_corner_rows is too small");
 #endif
 
 //! display_update get next line callback
 static bool prv_flush_get_next_line_cb(DisplayRow* row) {
   FrameBuffer *fb = compositor_get_framebuffer();
 
-  s_current_flush_line = MAX(s_current_flush_line, fb->dirty_rect.origin.y);
-  const uint16_t y_end = fb->dirty_rect.origin.y + fb->dirty_rect.size.h;
-  if (s_current_flush_line < y_end) {
+  // Skip over the clean rows between the dirty row spans
+  s_current_flush_line = framebuffer_get_next_dirty_row(fb, s_current_flush_line);
+  if (s_current_flush_line < fb->size.h) {
     row->address = s_current_flush_line;
     void *fb_line = framebuffer_get_line(fb, s_current_flush_line);
 #if PLATFORM_SILK || PLATFORM_ASTERIX
@@ -82,6 +83,7 @@ static bool prv_flush_get_next_line_cb(DisplayRow* row) {
         s_saved_corners[save_idx][pixel] = line[pixel];
         s_saved_corners[save_idx][12 + pixel] = line[DISP_COLS - pixel - 1];
       }
+      s_saved_corner_rows |= (1u << save_idx);
       // Draw black corners
       for (uint8_t pixel = 0; pixel < corner_width; ++pixel) {
         line[pixel] = GColorBlackARGB8;
@@ -106,17 +108,17 @@ static void prv_flush_complete_cb(void) {
   FrameBuffer *fb = compositor_get_framebuffer();
   for (uint8_t i = 0; i < CORNER_SAVE_ROWS; ++i) {
     uint8_t corner_width = s_corner_shape[i];
-    // Top corners (only if row was in dirty region)
-    if (i >= s_dirty_y0 && i <= s_dirty_y1) {
+    // Top corners (only if row was sent)
+    if (s_saved_corner_rows & (1u << i)) {
       uint8_t *top_line = framebuffer_get_line(fb, i);
       for (uint8_t pixel = 0; pixel < corner_width; ++pixel) {
         top_line[pixel] = s_saved_corners[i][pixel];
         top_line[DISP_COLS - pixel - 1] = s_saved_corners[i][12 + pixel];
       }
     }
-    // Bottom corners (only if row was in dirty region)
+    // Bottom corners (only if row was sent)
     uint8_t bottom_row = DISP_ROWS - i - 1;
-    if (bottom_row >= s_dirty_y0 && bottom_row <= s_dirty_y1) {
+    if (s_saved_corner_rows & (1u << (CORNER_SAVE_ROWS + i))) {
       uint8_t *bottom_line = framebuffer_get_line(fb, bottom_row);
       for (uint8_t pixel = 0; pixel < corner_width; ++pixel) {
         bottom_line[pixel] = s_saved_corners[CORNER_SAVE_ROWS + i][pixel];
@@ -124,6 +126,7 @@ static void prv_flush_complete_cb(void) {
       }
     }
   }
+  s_saved_corner_rows = 0;
 #endif
 
   s_current_flush_line = 0;
@@ -141,12 +144,10 @@ void compositor_display_update(void (*handle_update_complete_cb)(void)) {
   }
 #if PLATFORM_GETAFIX
   // Force full screen updates - partial ROI causes animation issues on getafix display
-  fb->dirty_rect = (GRect){ GPointZero, fb->size };
+  framebuffer_dirty_all(fb);
 #endif
 #if PLATFORM_OBELIX
-  // Capture dirty region bounds for corner restoration later
-  s_dirty_y0 = fb->dirty_rect.origin.y;
-  s_dirty_y1 = fb->dirty_rect.origin.y + fb->dirty_rect.size.h - 1;
+  s_saved_corner_rows = 0;
 #endif
   s_update_complete_handler = handle_update_complete_cb;
   s_current_flush_line = 0;
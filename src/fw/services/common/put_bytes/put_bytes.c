@@ -815,6 +815,7 @@ static void prv_do_commit(void) {
 
   const CommitRequest *request = (const CommitRequest *)s_pb_state.receiver.buffer;
 
+  const RtcTicks commit_start_ticks = rtc_get_ticks();
   uint32_t crc = ntohl(request->crc);
   uint32_t calculated_crc = pb_storage_calculate_crc(&s_pb_state.storage, PutBytesCrcType_Legacy);
   bool commit_succeeded = (calculated_crc == crc);
@@ -824,10 +825,6 @@ static void prv_do_commit(void) {
     PBL_LOG_DBG("PutBytes pushed %d bytes/sec", bytes_per_sec);
   }
 
-  bluetooth_analytics_handle_put_bytes_stats(
-      commit_succeeded, s_pb_state.type,
-      s_pb_state.total_size, elapsed_time_ms, &s_pb_state.conn_event_stats);
-
   if (commit_succeeded) {
     s_pb_state.is_success = true;
     PBL_LOG_DBG("PutBytes commit CB. CRC matches! Calculated CRC is 0x%"PRIx32
@@ -838,6 +835,12 @@ static void prv_do_commit(void) {
             calculated_crc, crc);
   }
 
+  const uint32_t commit_time_ms = ticks_to_milliseconds(rtc_get_ticks() - commit_start_ticks);
+  PBL_LOG_DBG("PutBytes commit took %"PRIu32" ms", commit_time_ms);
+  bluetooth_analytics_handle_put_bytes_stats(
+      commit_succeeded, s_pb_state.type, s_pb_state.total_size, elapsed_time_ms, commit_time_ms,
+      &s_pb_state.conn_event_stats);
+
   s_pb_state.is_success &= commit_succeeded;
   prv_mark_pb_jobs_complete(1);
   prv_cleanup_and_send_response((commit_succeeded) ? ResponseAck : ResponseNack);
@@ -6,6 +6,8 @@
 #include "kernel/pbl_malloc.h"
 #include "system/logging.h"
 #include "system/passert.h"
+#include "util/crc32.h"
+#include "util/math.h"
 #include "util/size.h"
 
 
@@ -19,6 +21,7 @@ static const PutBytesStorageImplementation s_raw_implementation = {
   .init = pb_storage_raw_init,
   .get_max_size = pb_storage_raw_get_max_size,
   .write = pb_storage_raw_write,
+  .read = pb_storage_raw_read,
   .calculate_crc = pb_storage_raw_calculate_crc,
   .deinit = pb_storage_raw_deinit
 };
@@ -37,18 +40,78 @@ static const PutBytesStorageImplementation s_file_implementation = {
 #endif  // #ifdef UNITTEST
 
 
+static void prv_checksums_update(PutBytesStorage *storage, const uint8_t *buffer, uint32_t length) {
+  legacy_defective_checksum_update(&storage->checksums.legacy, buffer, length);
+  storage->checksums.crc32 = crc32(storage->checksums.crc32, buffer, length);
+}
+
+static void prv_checksums_init(PutBytesStorage *storage, uint32_t append_offset) {
+  storage->checksums.is_valid = true;
+  storage->checksums.start_offset = storage->current_offset;
+  legacy_defective_checksum_init(&storage->checksums.legacy);
+  storage->checksums.crc32 = CRC32_INIT;
+
+  if (append_offset == 0) {
+    return;
+  }
+  if (!storage->impl->read || append_offset > storage->current_offset) {
+    // We can't tell what's already there, read the whole object back when it's complete
+    storage->checksums.is_valid = false;
+    return;
+  }
+
+  // Continuing a previous transfer, catch up with the data it wrote
+  storage->checksums.start_offset = storage->current_offset - append_offset;
+  uint8_t buffer[128];
+  for (uint32_t offset = storage->checksums.start_offset; offset < storage->current_offset;
+       offset += sizeof(buffer)) {
+    const uint32_t length = MIN(sizeof(buffer), storage->current_offset - offset);
+    storage->impl->read(storage, offset, buffer, length);
+    prv_checksums_update(storage, buffer, length);
+  }
+}
+
 void pb_storage_write(PutBytesStorage *storage, uint32_t offset, const uint8_t *buffer,
                       uint32_t length) {
+  if (offset + length > storage->checksums.start_offset) {
+    // Overwrites or skips past part of the object
+    storage->checksums.is_valid = false;
+  }
   storage->impl->write(storage, offset, buffer, length);
 }
 
 void pb_storage_append(PutBytesStorage *storage, const uint8_t *buffer, uint32_t length) {
-  pb_storage_write(storage, storage->current_offset, buffer, length);
+  if (storage->checksums.is_valid) {
+    prv_checksums_update(storage, buffer, length);
+  }
+  storage->impl->write(storage, storage->current_offset, buffer, length);
   storage->current_offset += length;
 }
 
+static uint32_t prv_get_accumulated_crc(PutBytesStorage *storage, PutBytesCrcType crc_type) {
+  if (crc_type == PutBytesCrcType_Legacy) {
+    // Finishing the checksum consumes its state, work on a copy so that it can be asked for again
+    LegacyChecksum legacy = storage->checksums.legacy;
+    return legacy_defective_checksum_finish(&legacy);
+  }
+  return storage->checksums.crc32;
+}
+
 uint32_t pb_storage_calculate_crc(PutBytesStorage *storage, PutBytesCrcType crc_type) {
-  return storage->impl->calculate_crc(storage, crc_type);
+  if (!storage->checksums.is_valid) {
+    return storage->impl->calculate_crc(storage, crc_type);
+  }
+
+  uint32_t crc = prv_get_accumulated_crc(storage, crc_type);
+#ifdef PUT_BYTES_CRC_READBACK
+  const uint32_t stored_crc = storage->impl->calculate_crc(storage, crc_type);
+  if (stored_crc != crc) {
+    PBL_LOG_ERR("Stored object has CRC 0x%"PRIx32", but 0x%"PRIx32" was written",
+                stored_crc, crc);
+    crc = stored_crc;
+  }
+#endif
+  return crc;
 }
 
 bool pb_storage_init(PutBytesStorage *storage, PutBytesObjectType object_type,
@@ -84,7 +147,11 @@ bool pb_storage_init(PutBytesStorage *storage, PutBytesObjectType object_type,
   }
 
   storage->impl = impl;
-  return storage->impl->init(storage, object_type, total_size, info, append_offset);
+  if (!storage->impl->init(storage, object_type, total_size, info, append_offset)) {
+    return false;
+  }
+  prv_checksums_init(storage, append_offset);
+  return true;
 }
 
 void pb_storage_deinit(PutBytesStorage *storage, bool is_success) {
@@ -7,6 +7,7 @@
 #include <stdbool.h>
 
 #include "services/common/put_bytes/put_bytes.h"
+#include "util/legacy_checksum.h"
 
 struct PutBytesStorageImplementation;
 typedef struct PutBytesStorageImplementation PutBytesStorageImplementation;
@@ -21,6 +22,18 @@ typedef struct {
   //! The offset into the storage we've initialized. Updated by pb_storage_append. pb_storage_init
   //! may set this to a non-zero value.
   uint32_t current_offset;
+
+  //! Checksums of the object, accumulated by pb_storage_append so that they don't have to be
+  //! calculated by reading the whole object back once it's complete.
+  struct {
+    //! False if the object was written in a way the checksums can't follow.
+    //! pb_storage_calculate_crc then reads the object back instead.
+    bool is_valid;
+    //! The offset of the first byte of the object
+    uint32_t start_offset;
+    LegacyChecksum legacy;
+    uint32_t crc32;
+  } checksums;
 } PutBytesStorage;
 
 typedef struct {
@@ -47,7 +60,9 @@ typedef enum {
   PutBytesCrcType_CRC32,
 } PutBytesCrcType;
 
-//! Calculate the CRC of the data in storage
+//! Calculate the CRC of the data in storage. This is the CRC of the data that has been appended
+//! unless the object was written out of order, in which case it's read back from storage. Build
+//! with PUT_BYTES_CRC_READBACK to always read it back and check the two agree.
 //! @param storage A pointer to the storage struct representing the underlying storage
 //! @param crc_type The type of CRC to compute
 //! @return the checksum computed using 'crc_type' specified
@@ -15,6 +15,9 @@ typedef struct PutBytesStorageImplementation {
 
   void (*write)(PutBytesStorage *storage, uint32_t offset, const uint8_t *buffer, uint32_t length);
 
+  //! Optional, used to pick up the checksums of an object where a previous transfer left off
+  void (*read)(PutBytesStorage *storage, uint32_t offset, uint8_t *buffer, uint32_t length);
+
   uint32_t (*calculate_crc)(PutBytesStorage *storage, PutBytesCrcType crc_type);
 
   void (*deinit)(PutBytesStorage *storage, bool is_success);
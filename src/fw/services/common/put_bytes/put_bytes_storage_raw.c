@@ -166,6 +166,13 @@ void pb_storage_raw_write(PutBytesStorage *storage, uint32_t offset, const uint8
   flash_write_bytes(buffer, flash_address, length);
 }
 
+void pb_storage_raw_read(PutBytesStorage *storage, uint32_t offset, uint8_t *buffer,
+                         uint32_t length) {
+  const MemoryLayout *layout = storage->impl_data;
+
+  flash_read_bytes(buffer, layout->start_address + offset, length);
+}
+
 uint32_t pb_storage_raw_calculate_crc(PutBytesStorage *storage, PutBytesCrcType crc_type) {
   const MemoryLayout *layout = storage->impl_data;
 
@@ -15,6 +15,9 @@ uint32_t pb_storage_raw_get_max_size(PutBytesObjectType object_type);
 void pb_storage_raw_write(PutBytesStorage *storage, uint32_t offset, const uint8_t *buffer,
                           uint32_t length);
 
+void pb_storage_raw_read(PutBytesStorage *storage, uint32_t offset, uint8_t *buffer,
+                         uint32_t length);
+
 uint32_t pb_storage_raw_calculate_crc(PutBytesStorage *storage, PutBytesCrcType crc_type);
 
 
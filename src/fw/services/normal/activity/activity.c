@@ -1157,6 +1157,62 @@ DEFINE_SYSCALL(bool, sys_activity_get_minute_history, HealthMinuteData *minute_d
 }
 
 
+// ------------------------------------------------------------------------------------------------
+typedef struct {
+  time_t utc_start;
+  time_t utc_end;
+  ActivityMinuteAggregate *aggregate;
+  bool success;
+  bool completed;
+} ActivityGetMinuteAggregateContext;
+
+static void prv_get_minute_aggregate_system_cb(void *context_param) {
+  ActivityGetMinuteAggregateContext *context = (ActivityGetMinuteAggregateContext *)context_param;
+
+  // Get the aggregate
+  if (s_activity_state.started) {
+    context->success = activity_algorithm_get_minute_aggregate(context->utc_start,
+                                                               context->utc_end,
+                                                               context->aggregate);
+  } else {
+    context->success = false;
+  }
+
+  // Unblock the caller
+  context->completed = true;
+  xSemaphoreGive(s_activity_state.bg_wait_semaphore);
+}
+
+bool activity_get_minute_aggregate(time_t utc_start, time_t utc_end,
+                                   ActivityMinuteAggregate *aggregate) {
+  if (!s_activity_initialized) {
+    return false;
+  }
+  // Fill in the context
+  ActivityGetMinuteAggregateContext context = (ActivityGetMinuteAggregateContext) {
+    .utc_start = utc_start,
+    .utc_end = utc_end,
+    .aggregate = aggregate,
+  };
+
+  // Enqueue it for KernelBG to process
+  bool success = prv_wait_system_task(prv_get_minute_aggregate_system_cb, &context,
+                                      &context.success, &context.completed, 30 /*timeout_sec*/);
+  return success;
+}
+
+
+// ------------------------------------------------------------------------------------------------
+DEFINE_SYSCALL(bool, sys_activity_get_minute_aggregate, time_t utc_start, time_t utc_end,
+               ActivityMinuteAggregate *aggregate) {
+  if (PRIVILEGE_WAS_ELEVATED) {
+    syscall_assert_userspace_buffer(aggregate, sizeof(*aggregate));
+  }
+
+  return activity_get_minute_aggregate(utc_start, utc_end, aggregate);
+}
+
+
 // ------------------------------------------------------------------------------------------------
 bool activity_get_step_averages(DayInWeek day_of_week, ActivityMetricAverages *averages) {
   if (!s_activity_initialized) {
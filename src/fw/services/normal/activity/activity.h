@@ -446,6 +446,35 @@ bool activity_get_sessions(uint32_t *session_entries, ActivitySession *sessions)
 bool activity_get_minute_history(HealthMinuteData *minute_data, uint32_t *num_records,
                                  time_t *utc_start);
 
+// How far back activity_get_minute_aggregate() can answer from its summary index
+#define ACTIVITY_MINUTE_AGGREGATE_MAX_AGE_SEC  (6 * SECONDS_PER_HOUR)
+
+// Totals of the minute data over a range of time, returned by activity_get_minute_aggregate()
+typedef struct {
+  uint32_t steps;
+  uint32_t active_minutes;
+  uint32_t distance_cm;
+  uint32_t resting_calories;
+  uint32_t active_calories;
+  uint32_t heart_rate_samples;       //!< number of minutes that have a heart rate reading
+  uint32_t heart_rate_sum_bpm;       //!< sum of those readings
+  uint8_t heart_rate_min_bpm;        //!< 0 if there were no readings
+  uint8_t heart_rate_max_bpm;        //!< 0 if there were no readings
+} ActivityMinuteAggregate;
+
+//! Return the totals of the minute data from utc_start up to (but not including) utc_end. These
+//! are answered from a summary index of 15 minute and hourly buckets maintained as minutes are
+//! logged, so only the partial buckets at the edges of the range look at individual minutes.
+//! IMPORTANT: This call will block on KernelBG, so it can only be called from the app or
+//! worker task.
+//! @param[in] utc_start UTC time of the start of the range. The minute it falls in is included.
+//! @param[in] utc_end UTC time of the end of the range
+//! @param[out] aggregate filled in with the totals
+//! @return true on success, false if the range reaches further back than the index covers, which
+//!     is at most ACTIVITY_MINUTE_AGGREGATE_MAX_AGE_SEC and less right after a reboot.
+bool activity_get_minute_aggregate(time_t utc_start, time_t utc_end,
+                                   ActivityMinuteAggregate *aggregate);
+
 // Metric averages, returned by activity_get_step_averages()
 #define ACTIVITY_NUM_METRIC_AVERAGES (4 * 24) //!< one average for each 15 minute interval of a day
 #define ACTIVITY_METRIC_AVERAGES_UNKNOWN  0xFFFF //!< indicates the average is unknown
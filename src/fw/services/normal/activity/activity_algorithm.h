@@ -18,8 +18,8 @@
 //   6: Added heart rate bpm
 #define ALG_MINUTE_FILE_RECORD_VERSION  6
 
-// Format of each minute in our minute file. In the minute file, which is stored as a settings file
-// on the watch, we store a subset of what we send to data logging since we only need the
+// Format of each minute in our minute file. In the minute file, which is stored in PFS on the
+// watch, we store a subset of what we send to data logging since we only need the
 // information required by the sleep algorithm and the information that could be returned by
 // the health_service_get_minute_history() API call.
 typedef struct __attribute__((__packed__)) {
@@ -129,9 +129,24 @@ typedef struct __attribute__((__packed__)) {
 // Size quota for the minute file
 #define ALG_MINUTE_DATA_FILE_LEN   0x20000
 
-// Max possible number of entries we can fit in our settings file if there was no overhead to
-// the settings file at all. The actual number we can fit is less than this.
-#define ALG_MINUTE_FILE_MAX_ENTRIES (ALG_MINUTE_DATA_FILE_LEN / sizeof(AlgMinuteFileRecord))
+// The minute file is a ring of fixed size segment files. Each segment holds this many
+// consecutive records (one day's worth) in slots addressed directly by timestamp.
+#define ALG_MINUTE_FILE_RECORDS_PER_SEGMENT  96
+
+// How many segments make up the ring, as many as fit within the size quota
+#define ALG_MINUTE_FILE_NUM_SEGMENTS \
+    (ALG_MINUTE_DATA_FILE_LEN / (ALG_MINUTE_FILE_RECORDS_PER_SEGMENT * sizeof(AlgMinuteFileRecord)))
+
+// Max possible number of entries we can fit in the minute file
+#define ALG_MINUTE_FILE_MAX_ENTRIES \
+    (ALG_MINUTE_FILE_NUM_SEGMENTS * ALG_MINUTE_FILE_RECORDS_PER_SEGMENT)
+
+// The aggregate index keeps totals of the minute data in 15 minute and hourly buckets. It holds
+// one more hour than ACTIVITY_MINUTE_AGGREGATE_MAX_AGE_SEC so that a range of that length
+// which doesn't start on an hour boundary is still covered.
+#define ALG_AGGREGATE_QUARTER_SEC     (15 * SECONDS_PER_MINUTE)
+#define ALG_AGGREGATE_NUM_HOURS       (ACTIVITY_MINUTE_AGGREGATE_MAX_AGE_SEC / SECONDS_PER_HOUR + 1)
+#define ALG_AGGREGATE_NUM_QUARTERS    (ALG_AGGREGATE_NUM_HOURS * 4)
 
 //! Init the algorithm
 //! @param[out] sampling_rate the required sampling rate is returned in this variable
@@ -220,13 +235,21 @@ void activity_algorithm_post_process_sleep_sessions(uint16_t num_sessions,
 bool activity_algorithm_get_minute_history(HealthMinuteData *minute_data, uint32_t *num_records,
                                            time_t *utc_start);
 
+//! Retrieve the totals of the minute data over a range of time
+//! @param[in] utc_start UTC time of the start of the range. The minute it falls in is included.
+//! @param[in] utc_end UTC time of the end of the range
+//! @param[out] aggregate filled in with the totals
+//! @return true if success, false if the range is not covered by the aggregate index
+bool activity_algorithm_get_minute_aggregate(time_t utc_start, time_t utc_end,
+                                             ActivityMinuteAggregate *aggregate);
+
 //! Dump the current sleep file to PBL_LOG. We write out base64 encoded data using PBL_LOG
 //! so that it can be extracted using a support request.
 //! @return true if success
 bool activity_algorithm_dump_minute_data_to_log(void);
 
 //! Get info on the sleep file
-//! @param[in] compact_first if true, compact the file first
+//! @param[in] compact_first if true, first remove segments that no longer hold live data
 //! @param[out] *num_records number of records in file
 //! @param[out] *data_bytes bytes of data it contains
 //! @param[out] *minutes how many minutes of data it contains
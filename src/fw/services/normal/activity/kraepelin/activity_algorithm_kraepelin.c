@@ -20,23 +20,60 @@
 #include "util/math.h"
 #include "util/shared_circular_buffer.h"
 #include "util/size.h"
+#include "util/string.h"
 #include "util/time/time.h"
 #include "util/units.h"
 
 #include "activity_algorithm_kraepelin.h"
 #include "kraepelin_algorithm.h"
 
-// NOTE: This file is called "activity_sleep" for legacy reasons. A better name now would be
-// something like "activity_minute_data", but we want to maintain compatibility with prior
-// releases that only used it for sleep data.
+// NOTE: This file is called "activity_sleep" for legacy reasons. It is the settings file that
+// prior releases kept the minute data in. We no longer write to it: at init, its records are
+// migrated into the minute file ring and the file is removed.
 #define ALG_MINUTE_DATA_FILE_NAME  "activity_sleep"
 
+// The minute file ring is made up of ALG_MINUTE_FILE_NUM_SEGMENTS files named with this prefix
+// followed by the position of the segment in the ring
+#define ALG_MINUTE_SEGMENT_FILE_PREFIX  "activity_min"
+#define ALG_MINUTE_SEGMENT_NAME_BUF_LEN  (sizeof(ALG_MINUTE_SEGMENT_FILE_PREFIX) + 12)
+
+// Version of our minute file segments
+#define ALG_MINUTE_SEGMENT_VERSION  1
+
+// Each segment file starts with this header, followed by ALG_MINUTE_FILE_RECORDS_PER_SEGMENT
+// record slots. The record with key N lives in slot (N % ALG_MINUTE_FILE_RECORDS_PER_SEGMENT) of
+// the segment whose first_key is N rounded down to a multiple of
+// ALG_MINUTE_FILE_RECORDS_PER_SEGMENT. Slots that were never written read back as all 0xFF.
+typedef struct __attribute__((__packed__)) {
+  uint16_t version;                  // ALG_MINUTE_SEGMENT_VERSION
+  uint32_t first_key;                // key of the record in slot 0
+} AlgMinuteSegmentHdr;
+
+#define ALG_MINUTE_SEGMENT_FILE_LEN  (sizeof(AlgMinuteSegmentHdr) \
+                                      + ALG_MINUTE_FILE_RECORDS_PER_SEGMENT \
+                                        * sizeof(AlgMinuteFileRecord))
+
 
 // How many records we need to store in our circular buffer
 // +1 for mgmt overhead
 #define ALG_MINUTE_CBUF_NUM_RECORDS  (MAX(ALG_MINUTES_PER_DLS_RECORD, ALG_MINUTES_PER_FILE_RECORD) \
                                        + KALG_MAX_UNCERTAIN_SLEEP_M + 1)
 
+// Totals of the minute data in one bucket of the aggregate index
+typedef struct {
+  uint32_t key;                      // bucket start time divided by the bucket length
+  uint32_t distance_cm;
+  uint32_t resting_calories;
+  uint32_t active_calories;
+  uint16_t steps;
+  uint16_t heart_rate_sum_bpm;
+  uint8_t num_minutes;
+  uint8_t active_minutes;
+  uint8_t heart_rate_samples;
+  uint8_t heart_rate_min_bpm;
+  uint8_t heart_rate_max_bpm;
+} AlgAggregateBucket;
+
 // ---------------------------------------------------------------------------------------------
 // Globals
 typedef struct {
@@ -60,8 +97,10 @@ typedef struct {
   AlgMinuteDLSRecord dls_record;
   AlgMinuteFileRecord file_record;
 
-  // How many records we have in our minute data settings file
-  uint16_t num_minute_records;
+  // Key of the first slot of the oldest segment and key of the newest record in the minute
+  // file ring. Both are 0 when the ring is empty.
+  uint32_t minute_ring_tail_key;
+  uint32_t minute_ring_head_key;
 
   // Metrics that we compute minute deltas of
   uint32_t prev_distance_mm;
@@ -78,6 +117,16 @@ typedef struct {
   SharedCircularBufferClient file_minute_data_client;
   SharedCircularBufferClient dls_minute_data_client;
   AlgMinuteRecord cbuf_record;  // space for tmp record here to decrease stack requirements
+
+  // Aggregate index of the minutes written to the minute file. A bucket lives in the slot given
+  // by its key modulo the number of slots and is reset when a newer bucket claims that slot.
+  AlgAggregateBucket aggregate_quarters[ALG_AGGREGATE_NUM_QUARTERS];
+  AlgAggregateBucket aggregate_hours[ALG_AGGREGATE_NUM_HOURS];
+
+  // The index covers the minutes logged since aggregate_start_utc. The ones before
+  // aggregate_end_utc are in the buckets, the rest are still in the circular buffer.
+  time_t aggregate_start_utc;
+  time_t aggregate_end_utc;
 } AlgState;
 static AlgState *s_alg_state = NULL;
 
@@ -101,12 +150,12 @@ static void prv_unlock(void) {
 }
 
 // ----------------------------------------------------------------------------------------------
-// Open the minute data settings file and malloc space for the file struct
-// We use NOINLINE to reduce the stack requirements during the minute handler (see PBL-38130)
-static NOINLINE SettingsFile *prv_minute_data_file_open(void) {
+// Open the legacy minute data settings file and malloc space for the file struct
+static SettingsFile *prv_minute_data_file_open(void) {
   SettingsFile *file = kernel_malloc_check(sizeof(SettingsFile));
   if (settings_file_open(file, ALG_MINUTE_DATA_FILE_NAME, ALG_MINUTE_DATA_FILE_LEN) != S_SUCCESS) {
     PBL_LOG_ERR("No minute data file");
+    kernel_free(file);
     return NULL;
   }
   return file;
@@ -122,10 +171,10 @@ static void prv_minute_data_file_close(SettingsFile *file) {
 
 
 // --------------------------------------------------------------------------------------------
-// Return the settings file key associated with a particular UTC timestamp. Each entry
+// Return the minute file key associated with a particular UTC timestamp. Each entry
 // holds ALG_MINUTES_PER_RECORD minutes of data. To get the key index, we divide the UTC
 // time by ALG_MINUTES_PER_RECORD.
-static uint32_t prv_minute_file_get_settings_key(time_t utc) {
+static uint32_t prv_minute_file_get_key(time_t utc) {
   uint32_t seconds_per_key = ALG_MINUTES_PER_FILE_RECORD * SECONDS_PER_MINUTE;
   return utc / seconds_per_key;
 }
@@ -179,8 +228,8 @@ static void prv_create_activity_session_cb(void *context, KAlgActivityType kalg_
 
 
 // ------------------------------------------------------------------------------------------
-// Used from settings_file_each() callback to read in a chunk based on the SettingsRecordInfo
-// given to the callback. Returns true if the chunk is within the designated key range and
+// Used from settings_file_each() callback to read in a chunk of the legacy minute data file based
+// on the SettingsRecordInfo given to the callback. Returns true if the chunk is within the designated key range and
 // should be processed.
 static bool prv_read_minute_file_record(SettingsFile *file, SettingsRecordInfo *info,
                                         uint32_t key_range_start, uint32_t key_range_end,
@@ -208,27 +257,423 @@ static bool prv_read_minute_file_record(SettingsFile *file, SettingsRecordInfo *
 
 
 // ----------------------------------------------------------------------------------------------
-// The callback we give to settings_file_each to send the minute data to the logs
+// Minute file ring
+//
+// The minute file records are kept in a ring of ALG_MINUTE_FILE_NUM_SEGMENTS segment files, each
+// holding ALG_MINUTE_FILE_RECORDS_PER_SEGMENT fixed size slots. The slot for a record is computed
+// directly from its key, so appending a record and seeking to the record for a timestamp are
+// both O(1), and a slot is written exactly once after its segment is created. When the head
+// moves into a new segment, the segment that occupied the same position in the ring
+// ALG_MINUTE_FILE_NUM_SEGMENTS segments earlier is removed, which advances the tail. Nothing is
+// ever compacted or copied on the regular write path.
+
+// Callback used by prv_minute_ring_each(). Return false to stop the iteration.
+typedef bool (*AlgMinuteRingEachCb)(AlgMinuteFileRecord *record, void *context);
+
+static uint32_t prv_minute_ring_segment_first_key(uint32_t key) {
+  return key - (key % ALG_MINUTE_FILE_RECORDS_PER_SEGMENT);
+}
+
+static uint32_t prv_minute_ring_position(uint32_t key) {
+  return (key / ALG_MINUTE_FILE_RECORDS_PER_SEGMENT) % ALG_MINUTE_FILE_NUM_SEGMENTS;
+}
+
+static int prv_minute_ring_slot_offset(uint32_t key) {
+  return sizeof(AlgMinuteSegmentHdr)
+         + (key % ALG_MINUTE_FILE_RECORDS_PER_SEGMENT) * sizeof(AlgMinuteFileRecord);
+}
+
+static void prv_minute_ring_segment_name(uint32_t position, char *name) {
+  concat_str_int(ALG_MINUTE_SEGMENT_FILE_PREFIX, position, name, ALG_MINUTE_SEGMENT_NAME_BUF_LEN);
+}
+
+// Return the first key of the oldest segment that can still be in the ring when the newest
+// record has the key head_key
+static uint32_t prv_minute_ring_oldest_key(uint32_t head_key) {
+  const uint32_t k_span = (ALG_MINUTE_FILE_NUM_SEGMENTS - 1) * ALG_MINUTE_FILE_RECORDS_PER_SEGMENT;
+  const uint32_t head_first_key = prv_minute_ring_segment_first_key(head_key);
+  return (head_first_key > k_span) ? head_first_key - k_span : 0;
+}
+
+static bool prv_minute_ring_is_erased(const void *data, size_t size) {
+  const uint8_t *bytes = data;
+  for (size_t i = 0; i < size; i++) {
+    if (bytes[i] != 0xFF) {
+      return false;
+    }
+  }
+  return true;
+}
+
+
+// ----------------------------------------------------------------------------------------------
+// Open the segment file that holds the slot for 'key' and return its fd, or a negative status if
+// there is no such segment. If 'for_write' is set, the segment is created if needed. Whatever
+// else the file at that position in the ring held before (an older segment that is falling off
+// the tail, or garbage) is removed first.
+static int prv_minute_ring_open_segment(uint32_t key, bool for_write) {
+  char name[ALG_MINUTE_SEGMENT_NAME_BUF_LEN];
+  prv_minute_ring_segment_name(prv_minute_ring_position(key), name);
+  const AlgMinuteSegmentHdr expected_hdr = {
+    .version = ALG_MINUTE_SEGMENT_VERSION,
+    .first_key = prv_minute_ring_segment_first_key(key),
+  };
+
+  const uint8_t op_flags = for_write ? (OP_FLAG_READ | OP_FLAG_WRITE) : OP_FLAG_READ;
+  int fd = pfs_open(name, op_flags, FILE_TYPE_STATIC, ALG_MINUTE_SEGMENT_FILE_LEN);
+  if (fd < 0) {
+    return fd;
+  }
+
+  AlgMinuteSegmentHdr hdr = { };
+  if ((pfs_read(fd, &hdr, sizeof(hdr)) == sizeof(hdr))
+      && (memcmp(&hdr, &expected_hdr, sizeof(hdr)) == 0)) {
+    return fd;
+  }
+  if (!for_write) {
+    pfs_close(fd);
+    return E_DOES_NOT_EXIST;
+  }
+
+  if (!prv_minute_ring_is_erased(&hdr, sizeof(hdr))) {
+    ACTIVITY_LOG_DEBUG("Dropping minute segment %s with first key %"PRIu32, name,
+                       hdr.first_key);
+    pfs_close_and_remove(fd);
+    fd = pfs_open(name, op_flags, FILE_TYPE_STATIC, ALG_MINUTE_SEGMENT_FILE_LEN);
+    if (fd < 0) {
+      return fd;
+    }
+  }
+
+  pfs_seek(fd, 0, FSeekSet);
+  int rv = pfs_write(fd, &expected_hdr, sizeof(expected_hdr));
+  if (rv != sizeof(expected_hdr)) {
+    pfs_close(fd);
+    return (rv < 0) ? rv : E_INTERNAL;
+  }
+  return fd;
+}
+
+
+// ----------------------------------------------------------------------------------------------
+// Replace the record in an already used slot. Rare: this only happens if we rebooted part way
+// through a record or the clock was moved back. The segment open as 'fd' is copied to a new
+// version of the file with 'record' in place of the old one, and 'fd' is closed.
+// 'scratch' is space for one record, to keep this off the stack of the minute handler.
+static bool prv_minute_ring_rewrite_segment(int fd, const AlgMinuteFileRecord *record,
+                                            AlgMinuteFileRecord *scratch) {
+  const uint32_t key = prv_minute_file_get_key(record->hdr.time_utc);
+  const uint32_t first_key = prv_minute_ring_segment_first_key(key);
+  char name[ALG_MINUTE_SEGMENT_NAME_BUF_LEN];
+  prv_minute_ring_segment_name(prv_minute_ring_position(key), name);
+
+  int new_fd = pfs_open(name, OP_FLAG_OVERWRITE, FILE_TYPE_STATIC, ALG_MINUTE_SEGMENT_FILE_LEN);
+  bool success = (new_fd >= 0);
+  if (success) {
+    const AlgMinuteSegmentHdr hdr = {
+      .version = ALG_MINUTE_SEGMENT_VERSION,
+      .first_key = first_key,
+    };
+    success = (pfs_write(new_fd, &hdr, sizeof(hdr)) == sizeof(hdr));
+  }
+
+  for (uint32_t slot_key = first_key;
+       success && slot_key < first_key + ALG_MINUTE_FILE_RECORDS_PER_SEGMENT; slot_key++) {
+    const AlgMinuteFileRecord *slot_record = record;
+    if (slot_key != key) {
+      pfs_seek(fd, prv_minute_ring_slot_offset(slot_key), FSeekSet);
+      success = (pfs_read(fd, scratch, sizeof(*scratch)) == sizeof(*scratch));
+      if (!success || prv_minute_ring_is_erased(scratch, sizeof(*scratch))) {
+        continue;
+      }
+      slot_record = scratch;
+    }
+    pfs_seek(new_fd, prv_minute_ring_slot_offset(slot_key), FSeekSet);
+    success = (pfs_write(new_fd, slot_record, sizeof(*slot_record)) == sizeof(*slot_record));
+  }
+
+  pfs_close(fd);
+  if (new_fd >= 0) {
+    // Closing the new version of the file is what replaces the old one
+    pfs_close(new_fd);
+  }
+  return success;
+}
+
+
+// ----------------------------------------------------------------------------------------------
+// Write a record into its slot in the minute file ring and advance the head (and if we moved
+// into a new segment, the tail) to include it
+// We use NOINLINE to reduce the stack requirements during the minute handler (see PBL-38130)
+static NOINLINE bool prv_minute_ring_write(const AlgMinuteFileRecord *record) {
+  const uint32_t key = prv_minute_file_get_key(record->hdr.time_utc);
+  const uint32_t first_key = prv_minute_ring_segment_first_key(key);
+
+  uint32_t head_key = s_alg_state->minute_ring_head_key;
+  uint32_t tail_key = s_alg_state->minute_ring_tail_key;
+  if (head_key == 0 || first_key < prv_minute_ring_oldest_key(head_key)) {
+    if (head_key != 0) {
+      PBL_LOG_WRN("Minute record is older than the ring, starting it over");
+    }
+    head_key = key;
+    tail_key = first_key;
+  } else {
+    head_key = MAX(head_key, key);
+    tail_key = MAX(tail_key, prv_minute_ring_oldest_key(head_key));
+    tail_key = MIN(tail_key, first_key);
+  }
+
+  int fd = prv_minute_ring_open_segment(key, true /*for_write*/);
+  if (fd < 0) {
+    PBL_LOG_ERR("Error %d opening minute segment for key %"PRIu32, fd, key);
+    return false;
+  }
+
+  const int offset = prv_minute_ring_slot_offset(key);
+  AlgMinuteFileRecord old_record;
+  pfs_seek(fd, offset, FSeekSet);
+  bool success = (pfs_read(fd, &old_record, sizeof(old_record)) == sizeof(old_record));
+  if (success && prv_minute_ring_is_erased(&old_record, sizeof(old_record))) {
+    // Write the version last so that a record cut short by a reset never looks valid
+    const size_t k_version_size = sizeof(record->hdr.version);
+    pfs_seek(fd, offset + k_version_size, FSeekSet);
+    success = (pfs_write(fd, (const uint8_t *)record + k_version_size,
+                         sizeof(*record) - k_version_size) == (int)(sizeof(*record) - k_version_size));
+    if (success) {
+      pfs_seek(fd, offset, FSeekSet);
+      success = (pfs_write(fd, &record->hdr.version, k_version_size) == (int)k_version_size);
+    }
+    pfs_close(fd);
+  } else if (success) {
+    success = prv_minute_ring_rewrite_segment(fd, record, &old_record);
+  } else {
+    pfs_close(fd);
+  }
+
+  if (success) {
+    s_alg_state->minute_ring_head_key = head_key;
+    s_alg_state->minute_ring_tail_key = tail_key;
+  }
+  return success;
+}
+
+
+// ----------------------------------------------------------------------------------------------
+// Call 'cb' on each valid record in the minute file ring with a key from first_key to last_key
+// inclusive, oldest first, until it returns false. Only the segments covering that range are
+// opened and each one is read starting from the slot of the first key we want from it.
+static void prv_minute_ring_each(uint32_t first_key, uint32_t last_key, AlgMinuteRingEachCb cb,
+                                 void *context) {
+  if (s_alg_state->minute_ring_head_key == 0) {
+    return;
+  }
+  first_key = MAX(first_key, s_alg_state->minute_ring_tail_key);
+  last_key = MIN(last_key, s_alg_state->minute_ring_head_key);
+
+  AlgMinuteFileRecord record;
+  uint32_t key = first_key;
+  while (key <= last_key) {
+    const uint32_t next_segment_key = prv_minute_ring_segment_first_key(key)
+                                      + ALG_MINUTE_FILE_RECORDS_PER_SEGMENT;
+    int fd = prv_minute_ring_open_segment(key, false /*for_write*/);
+    if (fd >= 0) {
+      pfs_seek(fd, prv_minute_ring_slot_offset(key), FSeekSet);
+      for (; key < next_segment_key && key <= last_key; key++) {
+        if (pfs_read(fd, &record, sizeof(record)) != sizeof(record)) {
+          break;
+        }
+        if (record.hdr.version != ALG_MINUTE_FILE_RECORD_VERSION
+            || prv_minute_file_get_key(record.hdr.time_utc) != key) {
+          continue;
+        }
+        if (!cb(&record, context)) {
+          pfs_close(fd);
+          return;
+        }
+      }
+      pfs_close(fd);
+    }
+    key = next_segment_key;
+  }
+}
+
+
+// ----------------------------------------------------------------------------------------------
+// Find the head and tail of the minute file ring from the segment headers. Segments that can't
+// be part of the ring anymore (they are older than the tail, from the future because the clock
+// was moved back, or invalid) are removed if 'remove_stale' is set.
+static void prv_minute_ring_load(bool remove_stale) {
+  const uint32_t now_key = prv_minute_file_get_key(rtc_get_time());
+  uint32_t first_keys[ALG_MINUTE_FILE_NUM_SEGMENTS];
+  uint32_t head_first_key = 0;
+  for (uint32_t position = 0; position < ALG_MINUTE_FILE_NUM_SEGMENTS; position++) {
+    first_keys[position] = 0;
+    char name[ALG_MINUTE_SEGMENT_NAME_BUF_LEN];
+    prv_minute_ring_segment_name(position, name);
+    int fd = pfs_open(name, OP_FLAG_READ, 0, 0);
+    if (fd < 0) {
+      continue;
+    }
+    AlgMinuteSegmentHdr hdr = { };
+    pfs_read(fd, &hdr, sizeof(hdr));
+    pfs_close(fd);
+
+    if (hdr.version == ALG_MINUTE_SEGMENT_VERSION
+        && hdr.first_key == prv_minute_ring_segment_first_key(hdr.first_key)
+        && prv_minute_ring_position(hdr.first_key) == position
+        && hdr.first_key <= now_key) {
+      first_keys[position] = hdr.first_key;
+      head_first_key = MAX(head_first_key, hdr.first_key);
+    } else if (remove_stale) {
+      pfs_remove(name);
+    }
+  }
+
+  s_alg_state->minute_ring_head_key = 0;
+  s_alg_state->minute_ring_tail_key = 0;
+  if (head_first_key == 0) {
+    return;
+  }
+
+  const uint32_t oldest_key = prv_minute_ring_oldest_key(head_first_key);
+  uint32_t tail_key = head_first_key;
+  for (uint32_t position = 0; position < ALG_MINUTE_FILE_NUM_SEGMENTS; position++) {
+    if (first_keys[position] >= oldest_key) {
+      tail_key = MIN(tail_key, first_keys[position]);
+    } else if (first_keys[position] != 0 && remove_stale) {
+      char name[ALG_MINUTE_SEGMENT_NAME_BUF_LEN];
+      prv_minute_ring_segment_name(position, name);
+      pfs_remove(name);
+    }
+  }
+
+  // The head is the newest record in the newest segment
+  uint32_t head_key = head_first_key;
+  int fd = prv_minute_ring_open_segment(head_first_key, false /*for_write*/);
+  if (fd >= 0) {
+    for (uint32_t key = head_first_key + ALG_MINUTE_FILE_RECORDS_PER_SEGMENT - 1;
+         key > head_first_key; key--) {
+      uint16_t version;
+      pfs_seek(fd, prv_minute_ring_slot_offset(key), FSeekSet);
+      if (pfs_read(fd, &version, sizeof(version)) == sizeof(version)
+          && version == ALG_MINUTE_FILE_RECORD_VERSION) {
+        head_key = key;
+        break;
+      }
+    }
+    pfs_close(fd);
+  }
+
+  s_alg_state->minute_ring_head_key = head_key;
+  s_alg_state->minute_ring_tail_key = tail_key;
+}
+
+
+// ----------------------------------------------------------------------------------------------
+// Remove all of the segments in the minute file ring
+static void prv_minute_ring_remove_all(void) {
+  for (uint32_t position = 0; position < ALG_MINUTE_FILE_NUM_SEGMENTS; position++) {
+    char name[ALG_MINUTE_SEGMENT_NAME_BUF_LEN];
+    prv_minute_ring_segment_name(position, name);
+    pfs_remove(name);
+  }
+  s_alg_state->minute_ring_head_key = 0;
+  s_alg_state->minute_ring_tail_key = 0;
+}
+
+
+// ----------------------------------------------------------------------------------------------
+// Return true if the slot for 'key' in the minute file ring holds a complete record
+static bool prv_minute_ring_has_record(uint32_t key) {
+  if (s_alg_state->minute_ring_head_key == 0 || key < s_alg_state->minute_ring_tail_key
+      || key > s_alg_state->minute_ring_head_key) {
+    return false;
+  }
+  int fd = prv_minute_ring_open_segment(key, false /*for_write*/);
+  if (fd < 0) {
+    return false;
+  }
+  uint16_t version = 0;
+  pfs_seek(fd, prv_minute_ring_slot_offset(key), FSeekSet);
+  const bool has_record = (pfs_read(fd, &version, sizeof(version)) == sizeof(version))
+                          && (version == ALG_MINUTE_FILE_RECORD_VERSION);
+  pfs_close(fd);
+  return has_record;
+}
+
+
+// ----------------------------------------------------------------------------------------------
+// Settings file callback used by prv_minute_ring_migrate_legacy_file() to copy each record of the
+// legacy minute data file into the ring
 typedef struct {
   uint32_t oldest_key;
   uint32_t newest_key;
+  uint32_t num_migrated;
+} AlgMinuteRingMigrateContext;
 
-  time_t oldest_valid_utc;
-  time_t newest_valid_utc;
-} AlgLogMinuteFileContext;
-
-static bool prv_log_minute_file_minutes_cb(SettingsFile *file, SettingsRecordInfo *info,
-                                            void *context_param) {
-  AlgLogMinuteFileContext *context = (AlgLogMinuteFileContext *)context_param;
+static bool prv_minute_ring_migrate_cb(SettingsFile *file, SettingsRecordInfo *info,
+                                       void *context_arg) {
+  AlgMinuteRingMigrateContext *context = (AlgMinuteRingMigrateContext *)context_arg;
 
   AlgMinuteFileRecord chunk;
   if (!prv_read_minute_file_record(file, info, context->oldest_key, context->newest_key, &chunk)) {
     return true;
   }
+  // If a prior migration was cut short before the legacy file got removed, the records it
+  // already copied are left as they are. Writing them again would rewrite their whole segment.
+  if (prv_minute_ring_has_record(prv_minute_file_get_key(chunk.hdr.time_utc))) {
+    return true;
+  }
+  if (prv_minute_ring_write(&chunk)) {
+    context->num_migrated++;
+  }
+
+  // This can take a while, so periodically tickle the KernelBG watchdog. The number of records
+  // is bounded by the size of the legacy file.
+  system_task_watchdog_feed();
+  return true;
+}
+
+
+// ----------------------------------------------------------------------------------------------
+// If we still have the minute data settings file from a prior release, copy its records into the
+// ring and remove it. Only records recent enough to fit within the ring are kept.
+static void prv_minute_ring_migrate_legacy_file(void) {
+  int fd = pfs_open(ALG_MINUTE_DATA_FILE_NAME, OP_FLAG_READ, 0, 0);
+  if (fd < 0) {
+    return;
+  }
+  pfs_close(fd);
+
+  SettingsFile *file = prv_minute_data_file_open();
+  if (file) {
+    const uint32_t newest_key = prv_minute_file_get_key(rtc_get_time()) + 1;
+    AlgMinuteRingMigrateContext context = (AlgMinuteRingMigrateContext) {
+      .oldest_key = prv_minute_ring_oldest_key(newest_key),
+      .newest_key = newest_key,
+    };
+    settings_file_each(file, prv_minute_ring_migrate_cb, &context);
+    prv_minute_data_file_close(file);
+    PBL_LOG_INFO("Migrated %"PRIu32" records from the legacy minute data file",
+                 context.num_migrated);
+  }
+  pfs_remove(ALG_MINUTE_DATA_FILE_NAME);
+}
+
+
+// ----------------------------------------------------------------------------------------------
+// The callback we give to prv_minute_ring_each to send the minute data to the logs
+typedef struct {
+  time_t oldest_valid_utc;
+  time_t newest_valid_utc;
+} AlgLogMinuteFileContext;
+
+static bool prv_log_minute_file_minutes_cb(AlgMinuteFileRecord *chunk, void *context_param) {
+  AlgLogMinuteFileContext *context = (AlgLogMinuteFileContext *)context_param;
 
   // if in the wrong time range, skip it
-  if (chunk.hdr.time_utc < (uint32_t)context->oldest_valid_utc
-      || chunk.hdr.time_utc > (uint32_t)context->newest_valid_utc) {
+  if (chunk->hdr.time_utc < (uint32_t)context->oldest_valid_utc
+      || chunk->hdr.time_utc > (uint32_t)context->newest_valid_utc) {
     ACTIVITY_LOG_DEBUG("Minute chunk time out of range, skipping it");
     return true;
   }
@@ -237,7 +682,7 @@ static bool prv_log_minute_file_minutes_cb(SettingsFile *file, SettingsRecordInf
   // Enough for half the base64 encoded message
   char base64_buf[sizeof(AlgMinuteFileRecord)];
   uint32_t chunk_size = sizeof(AlgMinuteFileRecord) / 2;
-  uint8_t *binary_data = (uint8_t *)&chunk;
+  uint8_t *binary_data = (uint8_t *)chunk;
 
   int32_t num_chars = base64_encode(base64_buf, sizeof(base64_buf), binary_data, chunk_size);
   PBL_ASSERTN(num_chars + 1 < (int)sizeof(base64_buf));
@@ -262,15 +707,6 @@ bool activity_algorithm_dump_minute_data_to_log(void) {
     return false;
   }
 
-  bool success = false;
-  SettingsFile *file = NULL;
-
-  // Open the minute data file
-  file = prv_minute_data_file_open();
-  if (!file) {
-    goto exit;
-  }
-
   // Figure out the oldest and newest possible time stamp for chunks that go into these buffers
   time_t now = rtc_get_time();
   const time_t k_oldest_valid_utc = now
@@ -278,128 +714,21 @@ bool activity_algorithm_dump_minute_data_to_log(void) {
   const time_t k_newest_valid_utc = now;
 
   AlgLogMinuteFileContext context = (AlgLogMinuteFileContext) {
-    .oldest_key = prv_minute_file_get_settings_key(k_oldest_valid_utc) - 1,
-    .newest_key = prv_minute_file_get_settings_key(k_newest_valid_utc) + 1,
     .oldest_valid_utc = k_oldest_valid_utc,
     .newest_valid_utc = k_newest_valid_utc,
   };
 
   // Feed in the saved data, reading chunks out of the saved minute data and compressing
   // it into algorithm sleep minute structures.
-  status_t status = settings_file_each(file, prv_log_minute_file_minutes_cb, &context);
-  success = (status == S_SUCCESS);
+  prv_minute_ring_each(prv_minute_file_get_key(k_oldest_valid_utc) - 1,
+                       prv_minute_file_get_key(k_newest_valid_utc) + 1,
+                       prv_log_minute_file_minutes_cb, &context);
 
-exit:
-  if (file) {
-    prv_minute_data_file_close(file);
-  }
   prv_unlock();
-  return success;
-}
-
-
-// ----------------------------------------------------------------------------------------------
-// Settings file rewrite callback used by prv_validate_and_trim_minute_file() when trimming off
-// old keys
-typedef struct {
-  uint32_t oldest_valid_key;
-  uint32_t newest_valid_key;
-  uint16_t num_keys_kept;
-  int32_t watchdog_kicks_left;
-} AlgMinuteFileRewriteContext;
-
-static bool prv_minute_file_rewrite_cb(void *key_arg, size_t key_len, void *val_arg,
-                                       size_t value_len, void *context_arg) {
-  AlgMinuteFileRewriteContext *context = (AlgMinuteFileRewriteContext *)context_arg;
-  AlgMinuteFileRecord *val = (AlgMinuteFileRecord *)val_arg;
-  uint32_t key = *(uint32_t *)key_arg;
-
-  if (val->hdr.version != ALG_MINUTE_FILE_RECORD_VERSION) {
-    ACTIVITY_LOG_DEBUG("Dropping key %"PRIu32", invalid version of %"PRIu16"", key,
-                       val->hdr.version);
-    return false;
-  }
-
-  if (key < context->oldest_valid_key || key > context->newest_valid_key) {
-    ACTIVITY_LOG_DEBUG("Dropping key %"PRIu32", record UTC of %"PRIu32"", key,
-                       val->hdr.time_utc);
-    return false;
-  }
-
-  // This can take a while, so periodically tickle the KernelBG watchdog.
-  if (context->watchdog_kicks_left > 0) {
-    // Check counter as insurance against getting into an infinite loop and still tickling the
-    // watchdog.
-    system_task_watchdog_feed();
-    context->watchdog_kicks_left--;
-  }
-
-  context->num_keys_kept++;
   return true;
 }
 
 
-// ----------------------------------------------------------------------------------------------
-// Scan the existing minute file, validate it, keep only the most recent 'max_records' records
-// If the file handle is not NULL, it will be used. Otherwise, the file will be opened and then
-// closed again before we exit.
-static SettingsFile *prv_validate_and_trim_minute_file(SettingsFile *file, uint16_t max_records) {
-  bool need_close = false;
-  bool nuke_file = false;
-
-  // Reset total # of records we have. We will update this after we scan the file
-  s_alg_state->num_minute_records = 0;
-
-  // Open settings file containing our minute data
-  if (file == NULL) {
-    need_close = true;
-    file = prv_minute_data_file_open();
-    if (file == NULL) {
-      goto exit;
-    }
-  }
-
-  // Figure out which keys we want to keep
-  time_t utc = rtc_get_time();
-  uint32_t newest_valid_key = prv_minute_file_get_settings_key(utc) + 1;
-  int32_t oldest_valid_key = (int32_t)newest_valid_key - max_records;
-  oldest_valid_key = MAX(0, oldest_valid_key);
-  AlgMinuteFileRewriteContext context = (AlgMinuteFileRewriteContext) {
-    .oldest_valid_key = oldest_valid_key,
-    .newest_valid_key = newest_valid_key,
-    .watchdog_kicks_left = max_records,
-  };
-
-  // Rewrite the settings file, keeping only the keys we need
-  PBL_LOG_DBG("Compacting minute file down to %"PRIu16" records", max_records);
-  status_t status = settings_file_rewrite_filtered(file, prv_minute_file_rewrite_cb, &context);
-
-  // Error re-writing?
-  if (status != S_SUCCESS) {
-    PBL_LOG_ERR("Encountered error %"PRIi32" rewriting settings file",
-            (int32_t)status);
-    nuke_file = true;
-  } else {
-    s_alg_state->num_minute_records = context.num_keys_kept;
-  }
-
-  PBL_LOG_DBG("Compaction done, ended up with %"PRIu16" records",
-          s_alg_state->num_minute_records);
-
-exit:
-  if (file && (need_close || nuke_file)) {
-    prv_minute_data_file_close(file);
-    file = NULL;
-  }
-
-  if (nuke_file) {
-    PBL_LOG_WRN("Detected invalid minute data file, deleting it");
-    pfs_remove(ALG_MINUTE_DATA_FILE_NAME);
-  }
-  return file;
-}
-
-
 // -------------------------------------------------------------------------------------
 static void prv_init_minute_record(AlgMinuteRecordHdr *hdr, time_t utc_sec, bool for_file) {
   time_t local_time = time_utc_to_local(utc_sec);
@@ -440,43 +769,68 @@ static void NOINLINE prv_set_file_minute_record_entry(AlgMinuteFileRecord *file_
 // ------------------------------------------------------------------------------------
 // Add a record to the minute file
 static bool prv_write_minute_file_record(AlgMinuteFileRecord *file_record) {
-  bool success = false;
+  bool success = prv_minute_ring_write(file_record);
+  if (!success) {
+    PBL_LOG_ERR("Error writing out minute data to minute file");
+  }
+  return success;
+}
 
-  SettingsFile *minute_file = prv_minute_data_file_open();
-  if (!minute_file) {
-    PBL_LOG_ERR("Could not open minute file for saving minute stats");
-    goto exit;
-  }
-
-  uint32_t key = prv_minute_file_get_settings_key(file_record->hdr.time_utc);
-  status_t status = settings_file_set(minute_file, &key, sizeof(key), file_record,
-                                      sizeof(*file_record));
-  if (status == E_OUT_OF_STORAGE) {
-    uint16_t max_records = s_alg_state->num_minute_records / 2;
-    PBL_LOG_INFO("Compacting minute file from %"PRIu16" records to %"PRIu16"",
-            s_alg_state->num_minute_records, max_records);
-    minute_file = prv_validate_and_trim_minute_file(minute_file, max_records);
-    if (!minute_file) {
-      goto exit;
-    }
 
-    status = settings_file_set(minute_file, &key, sizeof(key), file_record, sizeof(*file_record));
+// -------------------------------------------------------------------------------------
+static void prv_aggregate_bucket_add_minute(AlgAggregateBucket *buckets, uint32_t num_buckets,
+                                            uint32_t key, const AlgMinuteDLSSample *data) {
+  AlgAggregateBucket *bucket = &buckets[key % num_buckets];
+  if (bucket->key != key) {
+    *bucket = (AlgAggregateBucket) {
+      .key = key,
+    };
   }
 
-  // Was there an error writing the value out?
-  if (status != S_SUCCESS) {
-    PBL_LOG_ERR("Error %"PRIi32" writing out minute data to minute file",
-            (int32_t)status);
-  } else {
-    s_alg_state->num_minute_records++;
-    success = true;
+  bucket->num_minutes++;
+  bucket->steps += data->base.steps;
+  bucket->active_minutes += data->base.active;
+  bucket->distance_cm += data->distance_cm;
+  bucket->resting_calories += data->resting_calories;
+  bucket->active_calories += data->active_calories;
+  if (data->heart_rate_bpm != 0) {
+    if (bucket->heart_rate_samples == 0) {
+      bucket->heart_rate_min_bpm = data->heart_rate_bpm;
+      bucket->heart_rate_max_bpm = data->heart_rate_bpm;
+    }
+    bucket->heart_rate_samples++;
+    bucket->heart_rate_sum_bpm += data->heart_rate_bpm;
+    bucket->heart_rate_min_bpm = MIN(bucket->heart_rate_min_bpm, data->heart_rate_bpm);
+    bucket->heart_rate_max_bpm = MAX(bucket->heart_rate_max_bpm, data->heart_rate_bpm);
   }
+}
 
-exit:
-  if (minute_file) {
-    prv_minute_data_file_close(minute_file);
+
+// -------------------------------------------------------------------------------------
+// Add a minute that is being written to the minute file to the aggregate index. Minutes we
+// were sleeping in get the same treatment as in the data logging records.
+// We use NOINLINE to reduce the stack requirements during the minute handler (see PBL-38130)
+static void NOINLINE prv_aggregate_add_minute(time_t utc_sec, const AlgMinuteDLSSample *data,
+                                              bool was_sleeping) {
+  if (utc_sec < s_alg_state->aggregate_end_utc) {
+    // The clock was moved back, start over
+    memset(s_alg_state->aggregate_quarters, 0, sizeof(s_alg_state->aggregate_quarters));
+    memset(s_alg_state->aggregate_hours, 0, sizeof(s_alg_state->aggregate_hours));
+    s_alg_state->aggregate_start_utc = utc_sec;
   }
-  return success;
+
+  AlgMinuteDLSSample sample = *data;
+  if (was_sleeping) {
+    sample.base.steps = 0;
+    sample.base.active = false;
+    sample.active_calories = 0;
+    sample.distance_cm = 0;
+  }
+  prv_aggregate_bucket_add_minute(s_alg_state->aggregate_quarters, ALG_AGGREGATE_NUM_QUARTERS,
+                                  utc_sec / ALG_AGGREGATE_QUARTER_SEC, &sample);
+  prv_aggregate_bucket_add_minute(s_alg_state->aggregate_hours, ALG_AGGREGATE_NUM_HOURS,
+                                  utc_sec / SECONDS_PER_HOUR, &sample);
+  s_alg_state->aggregate_end_utc = utc_sec + SECONDS_PER_MINUTE;
 }
 
 
@@ -580,6 +934,7 @@ static bool NOINLINE prv_prepare_minute_data(uint16_t uncertain_m, time_t sleep_
     if (file_record) {
       prv_set_file_minute_record_entry(file_record, &cbuf_record->data, i, cbuf_record->utc_sec,
                                        was_sleeping);
+      prv_aggregate_add_minute(cbuf_record->utc_sec, &cbuf_record->data, was_sleeping);
 
       // Handle writing the record out to data logging
     } else {
@@ -658,6 +1013,9 @@ static void prv_log_minute_data(time_t utc_now, AlgMinuteRecord *minute_rec) {
                                            sizeof(*minute_rec), true /*advance_slackers*/);
   }
   PBL_ASSERTN(success);
+  if (s_alg_state->aggregate_start_utc == 0) {
+    s_alg_state->aggregate_start_utc = minute_rec->utc_sec;
+  }
 
   // Find the number of "certain" minutes we have in the buffer. When we are asleep, the
   // most recent N minutes in the buffer will be uncertain because we don't know that we woke
@@ -828,15 +1186,12 @@ bool activity_algorithm_init(AccelSamplingRate *sampling_rate) {
   // Init the algorithm state
   kalg_init(k_state, NULL);
 
-  // Count # of records in minute file
-  uint32_t num_records;
-  uint32_t data_bytes;
-  uint32_t minutes;
-  activity_algorithm_minute_file_info(false /*compact_first*/, &num_records, &data_bytes, &minutes);
-  s_alg_state->num_minute_records = num_records;
+  // Find the head and tail of the minute file and bring over the data from prior releases
+  prv_minute_ring_load(false /*remove_stale*/);
+  prv_minute_ring_migrate_legacy_file();
 
-  PBL_LOG_DBG("Found %"PRIu16" records in minute file",
-          s_alg_state->num_minute_records);
+  PBL_LOG_DBG("Minute file holds keys %"PRIu32" to %"PRIu32,
+          s_alg_state->minute_ring_tail_key, s_alg_state->minute_ring_head_key);
 
   // Reset all metrics
   activity_algorithm_metrics_changed_notification();
@@ -1122,30 +1477,23 @@ static bool prv_insert_health_minute_record(AlgReadMinutesContext *context, time
 
 
 // ----------------------------------------------------------------------------------------------
-// The callback we give to settings_file_each to read in the minute data for
+// The callback we give to prv_minute_ring_each to read in the minute data for
 // activity_algorithm_get_minute_history()
-static bool prv_read_minute_history_file_cb(SettingsFile *file, SettingsRecordInfo *info,
-                                            void *context_param) {
+static bool prv_read_minute_history_file_cb(AlgMinuteFileRecord *chunk, void *context_param) {
   AlgReadMinutesContext *context = (AlgReadMinutesContext *)context_param;
 
-  AlgMinuteFileRecord chunk;
-  if (!prv_read_minute_file_record(file, info, context->oldest_key, context->newest_key, &chunk)) {
-    // This record key not within the desired time range
-    return true;
-  }
-
   // Check the exact time range using the value
   const uint32_t k_seconds_per_chunk = ALG_MINUTES_PER_FILE_RECORD * SECONDS_PER_MINUTE;
-  if (chunk.hdr.time_utc + k_seconds_per_chunk < (uint32_t)context->oldest_requested_utc) {
+  if (chunk->hdr.time_utc + k_seconds_per_chunk < (uint32_t)context->oldest_requested_utc) {
     ACTIVITY_LOG_DEBUG("Minute chunk time out of range, skipping it");
-    return true;;
+    return true;
   }
 
   // Insert each of the minutes from this chunk into the caller's array
-  time_t minute_utc = chunk.hdr.time_utc;
+  time_t minute_utc = chunk->hdr.time_utc;
   for (uint32_t i = 0; i < ALG_MINUTES_PER_FILE_RECORD; i++, minute_utc += SECONDS_PER_MINUTE) {
-    bool done = prv_insert_health_minute_record(context, minute_utc, &chunk.samples[i].v5_fields,
-                                                chunk.samples[i].heart_rate_bpm);
+    bool done = prv_insert_health_minute_record(context, minute_utc, &chunk->samples[i].v5_fields,
+                                                chunk->samples[i].heart_rate_bpm);
     if (done) {
       // Already newer than we need, return false to stop the search
       return false;
@@ -1213,17 +1561,8 @@ bool activity_algorithm_get_minute_history(HealthMinuteData *minute_data, uint32
     return false;
   }
 
-  bool success = true;
-  SettingsFile *file = NULL;
   uint32_t array_size = *num_records;
 
-  // Open the minute data file
-  file = prv_minute_data_file_open();
-  if (!file) {
-    success = false;
-    goto exit;
-  }
-
   // Init for missing records
   memset(minute_data, 0xFF, array_size * sizeof(HealthMinuteData));
 
@@ -1238,37 +1577,232 @@ bool activity_algorithm_get_minute_history(HealthMinuteData *minute_data, uint32
   AlgReadMinutesContext context = (AlgReadMinutesContext) {
     .minute_data = minute_data,
     .array_size = array_size,
-    .oldest_key = prv_minute_file_get_settings_key(oldest_requested_utc) - 1,
-    .newest_key = prv_minute_file_get_settings_key(utc_now) + 1,
+    .oldest_key = prv_minute_file_get_key(oldest_requested_utc) - 1,
+    .newest_key = prv_minute_file_get_key(utc_now) + 1,
     .utc_start = 0,
     .oldest_requested_utc = oldest_requested_utc,
     .last_record_idx_written = -1,
   };
 
-  // Read the minute data from flash
-  status_t status = settings_file_each(file, prv_read_minute_history_file_cb, &context);
-  if (status != S_SUCCESS) {
-    success = false;
-    goto exit;
-  }
+  // Read the minute data from flash, seeking straight to the oldest chunk we want
+  prv_minute_ring_each(context.oldest_key, context.newest_key, prv_read_minute_history_file_cb,
+                       &context);
 
   // Fill in any data we have in RAM as well
   prv_read_minute_history_buffer(&context);
 
-exit:
-  if (file) {
-    prv_minute_data_file_close(file);
-  }
   prv_unlock();
 
-  if (success) {
-    // Return number of records that were written, including missing records in the middle
-    *num_records = context.last_record_idx_written + 1;
-    *utc_start = context.utc_start;
-  } else {
-    *num_records = 0;
-    *utc_start = 0;
+  // Return number of records that were written, including missing records in the middle
+  *num_records = context.last_record_idx_written + 1;
+  *utc_start = context.utc_start;
+  return true;
+}
+
+
+// ----------------------------------------------------------------------------------------------
+static void prv_aggregate_add_heart_rate(ActivityMinuteAggregate *aggregate, uint32_t samples,
+                                         uint32_t sum_bpm, uint8_t min_bpm, uint8_t max_bpm) {
+  if (samples == 0) {
+    return;
+  }
+  if (aggregate->heart_rate_samples == 0) {
+    aggregate->heart_rate_min_bpm = min_bpm;
+    aggregate->heart_rate_max_bpm = max_bpm;
+  }
+  aggregate->heart_rate_samples += samples;
+  aggregate->heart_rate_sum_bpm += sum_bpm;
+  aggregate->heart_rate_min_bpm = MIN(aggregate->heart_rate_min_bpm, min_bpm);
+  aggregate->heart_rate_max_bpm = MAX(aggregate->heart_rate_max_bpm, max_bpm);
+}
+
+static void prv_aggregate_add_bucket(ActivityMinuteAggregate *aggregate,
+                                     const AlgAggregateBucket *bucket) {
+  if (!bucket) {
+    // No minutes were logged in this bucket
+    return;
   }
+  aggregate->steps += bucket->steps;
+  aggregate->active_minutes += bucket->active_minutes;
+  aggregate->distance_cm += bucket->distance_cm;
+  aggregate->resting_calories += bucket->resting_calories;
+  aggregate->active_calories += bucket->active_calories;
+  prv_aggregate_add_heart_rate(aggregate, bucket->heart_rate_samples, bucket->heart_rate_sum_bpm,
+                               bucket->heart_rate_min_bpm, bucket->heart_rate_max_bpm);
+}
+
+static void prv_aggregate_add_sample(ActivityMinuteAggregate *aggregate,
+                                     const AlgMinuteDLSSample *data) {
+  aggregate->steps += data->base.steps;
+  aggregate->active_minutes += data->base.active;
+  aggregate->distance_cm += data->distance_cm;
+  aggregate->resting_calories += data->resting_calories;
+  aggregate->active_calories += data->active_calories;
+  prv_aggregate_add_heart_rate(aggregate, (data->heart_rate_bpm != 0), data->heart_rate_bpm,
+                               data->heart_rate_bpm, data->heart_rate_bpm);
+}
+
+// Return the bucket with the given key, or NULL if its slot holds a different one
+static const AlgAggregateBucket *prv_aggregate_find_bucket(const AlgAggregateBucket *buckets,
+                                                           uint32_t num_buckets, uint32_t key) {
+  const AlgAggregateBucket *bucket = &buckets[key % num_buckets];
+  return (bucket->key == key) ? bucket : NULL;
+}
+
+// Return true if a range starting at utc and ending at utc_end includes every minute the
+// bucket starting at bucket_start holds, so that the bucket can be used as a whole
+static bool prv_aggregate_covers_bucket(time_t bucket_start, time_t bucket_len, time_t utc,
+                                        time_t utc_end) {
+  return (utc <= MAX(bucket_start, s_alg_state->aggregate_start_utc))
+         && (utc_end >= MIN(bucket_start + bucket_len, s_alg_state->aggregate_end_utc));
+}
+
+
+// ----------------------------------------------------------------------------------------------
+typedef struct {
+  ActivityMinuteAggregate *aggregate;
+  time_t utc_start;
+  time_t utc_end;
+} AlgAggregateEdgeContext;
+
+static bool prv_aggregate_edge_file_cb(AlgMinuteFileRecord *chunk, void *context_param) {
+  AlgAggregateEdgeContext *context = (AlgAggregateEdgeContext *)context_param;
+
+  time_t minute_utc = chunk->hdr.time_utc;
+  for (uint32_t i = 0; i < ALG_MINUTES_PER_FILE_RECORD; i++, minute_utc += SECONDS_PER_MINUTE) {
+    if (minute_utc >= context->utc_end) {
+      return false;
+    }
+    if (minute_utc < context->utc_start) {
+      continue;
+    }
+    const AlgMinuteFileSample *sample = &chunk->samples[i];
+    context->aggregate->steps += sample->v5_fields.steps;
+    context->aggregate->active_minutes += sample->v5_fields.active;
+    prv_aggregate_add_heart_rate(context->aggregate, (sample->heart_rate_bpm != 0),
+                                 sample->heart_rate_bpm, sample->heart_rate_bpm,
+                                 sample->heart_rate_bpm);
+  }
+  return true;
+}
+
+// Add the minutes from utc_start to utc_end, which only cover part of the 15 minute bucket they
+// fall in. Steps, active minutes and heart rate are read from the minute file. It doesn't keep
+// distance or calories, so those are prorated from the bucket.
+static void prv_aggregate_add_edge(ActivityMinuteAggregate *aggregate,
+                                   const AlgAggregateBucket *bucket, time_t utc_start,
+                                   time_t utc_end) {
+  AlgAggregateEdgeContext context = (AlgAggregateEdgeContext) {
+    .aggregate = aggregate,
+    .utc_start = utc_start,
+    .utc_end = utc_end,
+  };
+  // Minute file records don't have to start on a 15 minute boundary, so the record holding the
+  // first minute we want can start up to a record's length before it
+  const time_t k_seconds_per_record = ALG_MINUTES_PER_FILE_RECORD * SECONDS_PER_MINUTE;
+  prv_minute_ring_each(prv_minute_file_get_key(utc_start - k_seconds_per_record
+                                               + SECONDS_PER_MINUTE),
+                       prv_minute_file_get_key(utc_end - 1), prv_aggregate_edge_file_cb,
+                       &context);
+
+  if (!bucket || (bucket->num_minutes == 0)) {
+    return;
+  }
+  const uint32_t num_minutes = MIN((utc_end - utc_start) / SECONDS_PER_MINUTE,
+                                   bucket->num_minutes);
+  aggregate->distance_cm += (uint64_t)bucket->distance_cm * num_minutes / bucket->num_minutes;
+  aggregate->resting_calories +=
+      (uint64_t)bucket->resting_calories * num_minutes / bucket->num_minutes;
+  aggregate->active_calories +=
+      (uint64_t)bucket->active_calories * num_minutes / bucket->num_minutes;
+}
+
+// Add the minutes from utc_start to utc_end that are still in our circular buffer, plus the
+// partial current minute
+static void prv_aggregate_add_buffer(ActivityMinuteAggregate *aggregate, time_t utc_start,
+                                     time_t utc_end) {
+  // Make a copy of the circular buffer client because we don't want to permanently consume data
+  SharedCircularBufferClient *cbuf_client = &s_alg_state->file_minute_data_client;
+  SharedCircularBufferClient cbuf_client_bck = *cbuf_client;
+
+  AlgMinuteRecord *cbuf_record = &s_alg_state->cbuf_record;
+  int16_t avail_minutes = (shared_circular_buffer_get_read_space_remaining(
+      &s_alg_state->minute_data_cbuf, cbuf_client) / sizeof(*cbuf_record));
+  while (avail_minutes--) {
+    uint16_t length_out;
+    bool success = shared_circular_buffer_read_consume(
+        &s_alg_state->minute_data_cbuf, cbuf_client, sizeof(*cbuf_record), (uint8_t *)cbuf_record,
+        &length_out);
+    PBL_ASSERTN(success);
+    if (WITHIN(cbuf_record->utc_sec, utc_start, utc_end - 1)) {
+      prv_aggregate_add_sample(aggregate, &cbuf_record->data);
+    }
+  }
+  *cbuf_client = cbuf_client_bck;
+
+  time_t minute_utc = rtc_get_time();
+  uint32_t seconds_into_minute = minute_utc % SECONDS_PER_MINUTE;
+  minute_utc -= seconds_into_minute;
+  if ((seconds_into_minute > 0) && WITHIN(minute_utc, utc_start, utc_end - 1)) {
+    AlgMinuteDLSSample current_minute;
+    prv_fill_minute_record(minute_utc, &current_minute);
+    prv_aggregate_add_sample(aggregate, &current_minute);
+  }
+}
+
+
+// -------------------------------------------------------------------------------
+bool activity_algorithm_get_minute_aggregate(time_t utc_start, time_t utc_end,
+                                             ActivityMinuteAggregate *aggregate) {
+  if (!prv_lock()) {
+    return false;
+  }
+
+  *aggregate = (ActivityMinuteAggregate) {};
+  utc_start -= utc_start % SECONDS_PER_MINUTE;
+
+  // We can't answer for anything older than the oldest hour still in the index
+  const time_t utc_now = rtc_get_time();
+  const time_t oldest_indexed = (utc_now / SECONDS_PER_HOUR - ALG_AGGREGATE_NUM_HOURS + 1)
+                                * SECONDS_PER_HOUR;
+  const bool success = (s_alg_state->aggregate_start_utc != 0)
+                       && (utc_start >= MAX(s_alg_state->aggregate_start_utc, oldest_indexed));
+  if (!success) {
+    goto unlock;
+  }
+
+  // Use the largest buckets the range covers completely. Only the first and last 15 minute
+  // bucket can be partially covered.
+  const time_t index_end = MIN(utc_end, s_alg_state->aggregate_end_utc);
+  time_t utc = utc_start;
+  while (utc < index_end) {
+    const time_t hour_start = utc - (utc % SECONDS_PER_HOUR);
+    if (prv_aggregate_covers_bucket(hour_start, SECONDS_PER_HOUR, utc, index_end)) {
+      prv_aggregate_add_bucket(aggregate, prv_aggregate_find_bucket(
+          s_alg_state->aggregate_hours, ALG_AGGREGATE_NUM_HOURS, hour_start / SECONDS_PER_HOUR));
+      utc = hour_start + SECONDS_PER_HOUR;
+      continue;
+    }
+
+    const time_t quarter_start = utc - (utc % ALG_AGGREGATE_QUARTER_SEC);
+    const AlgAggregateBucket *quarter = prv_aggregate_find_bucket(
+        s_alg_state->aggregate_quarters, ALG_AGGREGATE_NUM_QUARTERS,
+        quarter_start / ALG_AGGREGATE_QUARTER_SEC);
+    if (prv_aggregate_covers_bucket(quarter_start, ALG_AGGREGATE_QUARTER_SEC, utc, index_end)) {
+      prv_aggregate_add_bucket(aggregate, quarter);
+      utc = quarter_start + ALG_AGGREGATE_QUARTER_SEC;
+    } else {
+      const time_t edge_end = MIN(quarter_start + ALG_AGGREGATE_QUARTER_SEC, index_end);
+      prv_aggregate_add_edge(aggregate, quarter, utc, edge_end);
+      utc = edge_end;
+    }
+  }
+
+  // The most recent minutes haven't been added to the index yet
+  prv_aggregate_add_buffer(aggregate, MAX(utc_start, s_alg_state->aggregate_end_utc), utc_end);
+
+unlock:
+  prv_unlock();
   return success;
 }
 
@@ -1279,8 +1813,7 @@ typedef struct {
   uint32_t num_records;
 } AlgMinuteFileInfoContext;
 
-static bool prv_read_minute_file_info_cb(SettingsFile *file, SettingsRecordInfo *info,
-                                         void *context_arg) {
+static bool prv_read_minute_file_info_cb(AlgMinuteFileRecord *record, void *context_arg) {
   AlgMinuteFileInfoContext *context = (AlgMinuteFileInfoContext *)context_arg;
   context->num_records++;
   return true;
@@ -1291,42 +1824,22 @@ bool activity_algorithm_minute_file_info(bool compact_first, uint32_t *num_recor
   if (!prv_lock()) {
     return false;
   }
-  bool success = false;
-  SettingsFile *file = NULL;
 
-  file = prv_minute_data_file_open();
-  if (file && compact_first) {
-    file = prv_validate_and_trim_minute_file(file, ALG_MINUTE_FILE_MAX_ENTRIES);
-  }
-  if (!file) {
-    goto exit;
+  if (compact_first) {
+    prv_minute_ring_load(true /*remove_stale*/);
   }
 
   // Count # of records in minute file
   AlgMinuteFileInfoContext context = (AlgMinuteFileInfoContext) {};
+  prv_minute_ring_each(s_alg_state->minute_ring_tail_key, s_alg_state->minute_ring_head_key,
+                       prv_read_minute_file_info_cb, &context);
 
-  status_t status = settings_file_each(file, prv_read_minute_file_info_cb, &context);
-  if (status != S_SUCCESS) {
-    goto exit;
-  }
-  success = true;
-
-exit:
-  if (file) {
-    prv_minute_data_file_close(file);
-  }
   prv_unlock();
 
-  if (success) {
-    *num_records = context.num_records;
-    *minutes = context.num_records * ALG_MINUTES_PER_FILE_RECORD;
-    *data_bytes = *minutes * sizeof(AlgMinuteFileSample);
-  } else {
-    *num_records = 0;
-    *minutes = 0;
-    *data_bytes = 0;
-  }
-  return success;
+  *num_records = context.num_records;
+  *minutes = context.num_records * ALG_MINUTES_PER_FILE_RECORD;
+  *data_bytes = *minutes * sizeof(AlgMinuteFileSample);
+  return true;
 }
 
 
@@ -1338,9 +1851,8 @@ bool activity_algorithm_test_fill_minute_file(void) {
   AlgMinuteFileRecord record = { };
   prv_init_minute_record(&record.hdr, utc_sec, true /*for_file*/);
 
-  // Delete old file so this doesn't take forver, in case it's already got a lot of data in it
-  pfs_remove(ALG_MINUTE_DATA_FILE_NAME);
-  s_alg_state->num_minute_records = 0;
+  // Start from an empty ring, in case it's already got a lot of data in it
+  prv_minute_ring_remove_all();
 
   uint32_t secs_per_record = ALG_MINUTES_PER_FILE_RECORD * SECONDS_PER_MINUTE;
   time_t start_utc = utc_sec - ALG_MINUTE_FILE_MAX_ENTRIES * secs_per_record;
@@ -1376,7 +1888,8 @@ bool activity_algorithm_test_fill_minute_file(void) {
     }
   }
 
-  PBL_LOG_DBG("Done. End # of records: %"PRIu16, s_alg_state->num_minute_records);
+  PBL_LOG_DBG("Done. Minute file holds keys %"PRIu32" to %"PRIu32,
+          s_alg_state->minute_ring_tail_key, s_alg_state->minute_ring_head_key);
   return success;
 }
 
@@ -529,6 +529,27 @@ static uint32_t prv_real_counts_from_raw(uint32_t raw) {
 }
 
 
+// -----------------------------------------------------------------------------------------
+// sin_lookup() of the angles i * TRIG_MAX_ANGLE / KALG_FFT_WIDTH in the first quadrant. These are
+// the only twiddle factors an FFT of up to KALG_FFT_WIDTH elements needs, and
+// cos_lookup(angle) == sin_lookup(TRIG_MAX_ANGLE / 4 - angle) covers the cosines. The unit tests
+// compare the FFT against the reference implementation, which calls sin_lookup()/cos_lookup().
+static const uint16_t s_fft_sin_table[KALG_FFT_WIDTH / 4 + 1] = {
+  0, 3215, 6423, 9616, 12785, 15923, 19024, 22078,
+  25079, 28020, 30893, 33692, 36409, 39039, 41575, 44010,
+  46340, 48558, 50659, 52638, 54490, 56211, 57797, 59243,
+  60546, 61704, 62713, 63571, 64276, 64825, 65219, 65456,
+  65535,
+};
+
+
+// -----------------------------------------------------------------------------------------
+// Divide by TRIG_MAX_ANGLE, rounding towards 0 like the integer division does
+static int16_t prv_fft_unscale(int32_t value) {
+  return (int16_t)((value + ((value >> 31) & (TRIG_MAX_ANGLE - 1))) >> 16);
+}
+
+
 // -----------------------------------------------------------------------------------------
 // Real-valued, in-place, 2-radix Fourier transform
 //
@@ -541,9 +562,13 @@ static uint32_t prv_real_counts_from_raw(uint32_t raw) {
 //   function and the floating point equivalents that are not important for its
 //   use here, but nonetheless documented in the accompaning Julia test code.
 //
+//   The twiddle factors come from s_fft_sin_table instead of sin_lookup()/cos_lookup() and the
+//   products are scaled back with a shift, the output is bit for bit the same as that of the
+//   reference implementation (fft_2radix_real() in the unit tests).
+//
 //   INPUT
 //     d = input signal array pointer
-//     width the width of d (must be a power of 2)
+//     width the width of d (must be a power of 2, at most KALG_FFT_WIDTH)
 //     width_log_2 the log base 2 of width: 2^width_log_2 = width
 //
 //   OUTPUT
@@ -551,6 +576,7 @@ static uint32_t prv_real_counts_from_raw(uint32_t raw) {
 //       [Re(0), Re(1),..., Re(N/2-1), Re(N/2), Im(N/2-1),..., Im(1)]
 //
 static void prv_fft_2radix_real(int16_t *d, int16_t width, int16_t width_log_2) {
+  PBL_ASSERTN(width <= KALG_FFT_WIDTH);
   int16_t n = width;
   int16_t j = 1;
   int16_t n1 = n -1;
@@ -570,46 +596,48 @@ static void prv_fft_2radix_real(int16_t *d, int16_t width, int16_t width_log_2)
     j = j + k;
   }
 
-  for (int16_t i = 1; i <= n; i += 2) {
-    dt = d[i-1];
-    d[i-1] = dt + d[i];
-    d[i] = dt - d[i];
+  for (int16_t i = 0; i < n; i += 2) {
+    dt = d[i];
+    d[i] = dt + d[i+1];
+    d[i+1] = dt - d[i+1];
   }
 
   int16_t n2 = 1;
-  int16_t n4, i1, i2, i3, i4, t1, t2;
-  int32_t E, A, ss, cc;
+  int16_t n4, t1, t2;
 
   for (int16_t k = 2; k <= width_log_2 ; k++) {
     n4 = n2;
     n2 = 2 * n4;
     n1 = 2 * n2;
-    E = TRIG_MAX_ANGLE / n1;
-
-    for (int16_t i = 1; i<= n; i+=n1) {
-      dt = d[i-1];
-      d[i-1] = dt + d[i+n2-1];
-      d[i+n2-1] = dt - d[i+n2-1];
-      d[i+n4+n2-1] = -1 * d[i+n4+n2-1];
-      A = E;
+    // The angle of twiddle factor j in this pass is j * TRIG_MAX_ANGLE / n1
+    const int16_t table_stride = KALG_FFT_WIDTH / n1;
+
+    for (int16_t i = 0; i < n; i += n1) {
+      int16_t *const block = &d[i];
+      dt = block[0];
+      block[0] = dt + block[n2];
+      block[n2] = dt - block[n2];
+      block[n4+n2] = -1 * block[n4+n2];
+      const uint16_t *sin_entry = &s_fft_sin_table[table_stride];
+      const uint16_t *cos_entry = &s_fft_sin_table[(n4 - 1) * table_stride];
       for (int16_t j = 1; j <= (n4-1); j++) {
-        i1 = i + j;
-        i2 = i - j + n2;
-        i3 = i + j + n2;
-        i4 = i - j + n1;
-
-        ss = sin_lookup(A);
-        cc = cos_lookup(A);
-
-        A = A + E;
-
-        t1 = (int16_t) ((d[i3-1] * cc + d[i4-1] * ss) / TRIG_MAX_ANGLE);
-        t2 = (int16_t) ((d[i3-1] * ss - d[i4-1] * cc) / TRIG_MAX_ANGLE);
-
-        d[i4-1] = d[i2-1] - t2;
-        d[i3-1] = -d[i2-1] - t2;
-        d[i2-1] = d[i1-1] - t1;
-        d[i1-1] = d[i1-1] + t1;
+        int16_t *const d1 = &block[j];
+        int16_t *const d2 = &block[n2 - j];
+        int16_t *const d3 = &block[n2 + j];
+        int16_t *const d4 = &block[n1 - j];
+
+        const int32_t ss = *sin_entry;
+        const int32_t cc = *cos_entry;
+        sin_entry += table_stride;
+        cos_entry -= table_stride;
+
+        t1 = prv_fft_unscale(*d3 * cc + *d4 * ss);
+        t2 = prv_fft_unscale(*d3 * ss - *d4 * cc);
+
+        *d4 = *d2 - t2;
+        *d3 = -*d2 - t2;
+        *d2 = *d1 - t1;
+        *d1 = *d1 + t1;
       }
     }
   }
@@ -1371,6 +1399,12 @@ uint32_t kalg_analyze_finish_epoch(KAlgState *state) {
 }
 
 
+// ------------------------------------------------------------------------------------
+void kalg_fft_real(int16_t *d, int16_t width, int16_t width_log_2) {
+  prv_fft_2radix_real(d, width, width_log_2);
+}
+
+
 
 
 // ------------------------------------------------------------------------------------------
@@ -118,6 +118,13 @@ void kalg_minute_stats(KAlgState *state, uint16_t *vmc, uint8_t *orientation, bo
 // @return number of steps counted
 uint32_t kalg_analyze_finish_epoch(KAlgState *state);
 
+// Used by unit tests - compute the real-valued FFT that the step counting runs on each axis of
+// every epoch, in place
+// @param[in,out] d the input signal, replaced by [Re(0), ..., Re(N/2), Im(N/2-1), ..., Im(1)]
+// @param[in] width the number of elements in d, a power of 2 no larger than 128
+// @param[in] width_log_2 the log base 2 of width
+void kalg_fft_real(int16_t *d, int16_t width, int16_t width_log_2);
+
 // Feed new minute data into the activity detection state machine. This logic looks for non-sleep
 // activities, like walks, runs, etc.
 // @param[in] state the state structure passed into kalg_init
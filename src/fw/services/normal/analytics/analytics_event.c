@@ -558,7 +558,8 @@ static bool prv_get_connection_details(CommSession *session, bool *is_ppogatt,
 void analytics_event_put_byte_stats(
     CommSession *session, bool crc_good, uint8_t type,
     uint32_t bytes_transferred, uint32_t elapsed_time_ms,
-    uint32_t conn_events, uint32_t sync_errors, uint32_t skip_errors, uint32_t other_errors) {
+    uint32_t conn_events, uint32_t sync_errors, uint32_t skip_errors, uint32_t other_errors,
+    uint32_t commit_time_ms) {
 
   bool is_ppogatt = false;
   uint16_t conn_interval = 0;
@@ -579,13 +580,15 @@ void analytics_event_put_byte_stats(
       .sync_errors = MIN(sync_errors, UINT16_MAX),
       .skip_errors = MIN(skip_errors, UINT16_MAX),
       .other_errors = MIN(other_errors, UINT16_MAX),
+      .commit_time_ms = commit_time_ms,
     },
   };
 
-  ANALYTICS_LOG_DEBUG("PutBytes event: is_ppogatt: %d, bytes: %d, time ms: %d",
+  ANALYTICS_LOG_DEBUG("PutBytes event: is_ppogatt: %d, bytes: %d, time ms: %d, commit ms: %d",
                       (int)event_blob.pb_time.ppogatt,
                       (int)event_blob.pb_time.bytes_transferred,
-                      (int)event_blob.pb_time.elapsed_time_ms);
+                      (int)event_blob.pb_time.elapsed_time_ms,
+                      (int)event_blob.pb_time.commit_time_ms);
 
   analytics_logging_log_event(&event_blob);
 }
@@ -109,13 +109,19 @@ static size_t prv_send_job_impl_copy(const SessionSendQueueJob *send_job, int st
   return length_to_copy;
 }
 
-static size_t prv_send_job_impl_get_read_pointer(const SessionSendQueueJob *send_job,
-                                                 const uint8_t **data_out) {
+static size_t prv_send_job_impl_get_read_pointer_at(const SessionSendQueueJob *send_job,
+                                                    uint32_t start_offset,
+                                                    const uint8_t **data_out) {
   AppMessageSendJob *app_message_send_job = (AppMessageSendJob *)send_job;
   prv_request_fast_connection(app_message_send_job->session);
 
   return prv_get_read_pointer(app_message_send_job,
-                              app_message_send_job->consumed_length, data_out);
+                              app_message_send_job->consumed_length + start_offset, data_out);
+}
+
+static size_t prv_send_job_impl_get_read_pointer(const SessionSendQueueJob *send_job,
+                                                 const uint8_t **data_out) {
+  return prv_send_job_impl_get_read_pointer_at(send_job, 0, data_out);
 }
 
 static void prv_send_job_impl_consume(const SessionSendQueueJob *send_job, size_t length) {
@@ -146,6 +152,7 @@ T_STATIC const SessionSendJobImpl s_app_message_send_job_impl = {
   .get_length = prv_send_job_impl_get_length,
   .copy = prv_send_job_impl_copy,
   .get_read_pointer = prv_send_job_impl_get_read_pointer,
+  .get_read_pointer_at = prv_send_job_impl_get_read_pointer_at,
   .consume = prv_send_job_impl_consume,
   .free = prv_send_job_impl_free,
 };
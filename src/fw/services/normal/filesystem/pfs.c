@@ -25,6 +25,7 @@
 #include "system/passert.h"
 #include "util/attributes.h"
 #include "util/crc8.h"
+#include "util/hash.h"
 #include "util/legacy_checksum.h"
 #include "util/math.h"
 
@@ -192,9 +193,17 @@ typedef struct GCBlock {
 
 static GCBlock s_gc_block;
 
+// Background garbage collection, see pfs_background_gc_enable()
+static uint16_t s_bg_gc_free_sector_reserve = 0;
+static PFSBackgroundGCRequest s_bg_gc_request = NULL;
+static bool s_bg_gc_requested = false;
+
 // This is used by unit tests to clear out static state and simulate a reboot.
 void pfs_reset_all_state(void) {
   s_gc_block = (GCBlock){};
+  s_bg_gc_free_sector_reserve = 0;
+  s_bg_gc_request = NULL;
+  s_bg_gc_requested = false;
   memset(s_pfs_avail_fd, 0, sizeof(s_pfs_avail_fd));
   time_closed_counter = 0;
 }
@@ -218,8 +227,16 @@ typedef struct {
 } PFSFileChangedCallbackNode;
 
 static uint8_t *s_pfs_page_flags_cache = NULL;
+#if CAPABILITY_HAS_PFS_NAME_INDEX
+// One byte hash of the file name stored on each page. Only meaningful for start pages, it lets
+// locate_flash_file() skip the flash reads for every file whose name can't possibly match.
+static uint8_t *s_pfs_name_index = NULL;
+#endif
 static uint16_t s_pfs_page_count = 0;
 static uint32_t s_pfs_size = 0;
+// Number of pages whose flags say they are erased and ready to be handed out, kept up to date by
+// prv_flash_write() and prv_flash_erase_sector() so background GC doesn't have to scan for it
+static uint16_t s_pfs_erased_page_count = 0;
 static ListNode *s_head_callback_node_list = NULL;
 
 // In the interest of being able to leverage sector erases / minimize seek time
@@ -259,10 +276,128 @@ static void prv_invalidate_page_flags_cache_all(void) {
   prv_invalidate_page_flags_cache(0, s_pfs_page_count * PFS_PAGE_SIZE);
 }
 
+#if CAPABILITY_HAS_PFS_NAME_INDEX
+static uint8_t prv_get_page_flags(uint16_t pg);
+
+// Name index entries are never 0 so that 0 can mean "not known yet, go look at flash"
+#define NAME_INDEX_UNKNOWN (0)
+
+static uint8_t prv_name_index_hash(const char *name, uint8_t namelen) {
+  return (hash((const uint8_t *)name, namelen) % UINT8_MAX) + 1;
+}
+
+// Forgets the name hash of every page whose page or file header falls within the range of bytes
+// being changed. The name of a file is only ever written right after its headers so this is
+// enough to catch pages which get reused for a different file. Entries are lazily re-populated
+// the next time locate_flash_file() walks past them.
+static void prv_invalidate_name_index(uint32_t offset, uint32_t size) {
+  if (!s_pfs_name_index || (size == 0)) {
+    return;
+  }
+
+  const uint16_t start_page = offset / PFS_PAGE_SIZE;
+  const uint16_t end_page = MIN((offset + size - 1) / PFS_PAGE_SIZE, s_pfs_page_count - 1);
+  for (uint16_t pg = start_page; pg <= end_page; pg++) {
+    const uint32_t hdr_start = prv_page_to_flash_offset(pg);
+    const uint32_t hdr_end = hdr_start + METADATA_OFFSET;
+    if ((offset < hdr_end) && ((offset + size) > hdr_start)) {
+      s_pfs_name_index[pg] = NAME_INDEX_UNKNOWN;
+    }
+  }
+}
+
+static void prv_set_name_index(uint16_t page, const char *name) {
+  if (s_pfs_name_index) {
+    s_pfs_name_index[page] = prv_name_index_hash(name, strlen(name));
+  }
+}
+
+//! @return The name hash of the file starting at 'page', reading the name from flash if the
+//!   index doesn't know it yet.
+static uint8_t prv_get_name_index(uint16_t page) {
+  if (s_pfs_name_index[page] != NAME_INDEX_UNKNOWN) {
+    return s_pfs_name_index[page];
+  }
+
+  uint8_t namelen;
+  prv_flash_read(&namelen, sizeof(namelen), prv_page_to_flash_offset(page) +
+                 FILEHEADER_OFFSET + offsetof(FileHeader, file_namelen));
+
+  char name[namelen + 1];
+  prv_flash_read((uint8_t *)name, namelen, prv_page_to_flash_offset(page) + FILE_NAME_OFFSET);
+
+  s_pfs_name_index[page] = prv_name_index_hash(name, namelen);
+  return s_pfs_name_index[page];
+}
+
+static void prv_build_name_index(void) {
+  if (s_pfs_name_index) {
+    kernel_free(s_pfs_name_index);
+    s_pfs_name_index = NULL;
+  }
+
+  if (s_pfs_page_count == 0) {
+    return;
+  }
+
+  // The index is purely an optimization, if we can't afford it we just scan the flash
+  s_pfs_name_index = kernel_malloc(s_pfs_page_count * sizeof(*s_pfs_name_index));
+  if (!s_pfs_name_index) {
+    PBL_LOG_WRN("Not enough memory for the filename index");
+    return;
+  }
+  memset(s_pfs_name_index, NAME_INDEX_UNKNOWN, s_pfs_page_count * sizeof(*s_pfs_name_index));
+
+  for (uint16_t pg = 0; pg < s_pfs_page_count; pg++) {
+    if (IS_PAGE_TYPE(prv_get_page_flags(pg), PAGE_FLAG_START_PAGE)) {
+      prv_get_name_index(pg);
+    }
+  }
+}
+#else
+static void prv_invalidate_name_index(uint32_t offset, uint32_t size) { }
+static void prv_set_name_index(uint16_t page, const char *name) { }
+static void prv_build_name_index(void) { }
+#endif
+
+static uint8_t prv_get_page_flags(uint16_t pg);
+static bool page_is_erased(uint8_t page_flags);
+
+//! @return the number of erased pages among those whose page flags lie within the range of bytes
+static uint16_t prv_count_erased_pages_in_range(uint32_t offset, uint32_t size) {
+  if ((size == 0) || (s_pfs_page_count == 0)) {
+    return 0;
+  }
+#if !UNITTEST
+  if (!s_pfs_page_flags_cache) {
+    return 0;
+  }
+#endif
+  const uint32_t page_flags_offset = offsetof(PageHeader, page_flags);
+  const uint16_t start_page = offset / PFS_PAGE_SIZE;
+  const uint16_t end_page = MIN((offset + size - 1) / PFS_PAGE_SIZE, s_pfs_page_count - 1);
+  uint16_t num_erased = 0;
+  for (uint32_t pg = start_page; pg <= end_page; pg++) {
+    const uint32_t flags_addr = prv_page_to_flash_offset(pg) + page_flags_offset;
+    if ((flags_addr >= offset) && (flags_addr < (offset + size)) &&
+        page_is_erased(prv_get_page_flags(pg))) {
+      num_erased++;
+    }
+  }
+  return num_erased;
+}
+
+static void prv_recount_erased_pages(void) {
+  s_pfs_erased_page_count = prv_count_erased_pages_in_range(0, s_pfs_page_count * PFS_PAGE_SIZE);
+}
+
 static void prv_flash_write(const void *buffer, uint32_t size, uint32_t offset) {
   if ((offset + size) <= s_pfs_size) {
+    const uint16_t erased_before = prv_count_erased_pages_in_range(offset, size);
     ftl_write(buffer, size, offset);
     prv_invalidate_page_flags_cache(offset, size);
+    prv_invalidate_name_index(offset, size);
+    s_pfs_erased_page_count += prv_count_erased_pages_in_range(offset, size) - erased_before;
   } else {
     PBL_LOG_ERR("FS write out of bounds 0x%x", (int)offset);
   }
@@ -272,8 +407,12 @@ static void prv_flash_write(const void *buffer, uint32_t size, uint32_t offset)
 static void prv_flash_erase_sector(uint16_t start_page) {
   uint32_t offset = PFS_PAGE_SIZE * start_page;
   if (offset < s_pfs_size) {
-    ftl_erase_sector(PFS_PAGE_SIZE * PFS_PAGES_PER_ERASE_SECTOR, offset);
-    prv_invalidate_page_flags_cache(offset, PFS_PAGE_SIZE * PFS_PAGES_PER_ERASE_SECTOR);
+    const uint32_t size = PFS_PAGE_SIZE * PFS_PAGES_PER_ERASE_SECTOR;
+    const uint16_t erased_before = prv_count_erased_pages_in_range(offset, size);
+    ftl_erase_sector(size, offset);
+    prv_invalidate_page_flags_cache(offset, size);
+    prv_invalidate_name_index(offset, size);
+    s_pfs_erased_page_count += prv_count_erased_pages_in_range(offset, size) - erased_before;
   } else {
     PBL_LOG_ERR("Erase out of bounds, 0x%x", (int)start_page);
   }
@@ -456,6 +595,9 @@ static status_t locate_flash_file(const char *name, uint16_t *page) {
   const int file_namelen_offset = FILEHEADER_OFFSET +
       offsetof(FileHeader, file_namelen);
   uint8_t namelen = strlen(name);
+#if CAPABILITY_HAS_PFS_NAME_INDEX
+  const uint8_t name_hash = prv_name_index_hash(name, namelen);
+#endif
 
   for (uint16_t pg = 0; pg < s_pfs_page_count; pg++) {
     PageHeader pg_hdr;
@@ -466,6 +608,12 @@ static status_t locate_flash_file(const char *name, uint16_t *page) {
       continue; // only start pages contain file name info
     }
 
+#if CAPABILITY_HAS_PFS_NAME_INDEX
+    if (s_pfs_name_index && (prv_get_name_index(pg) != name_hash)) {
+      continue; // the name can't match, no need to read it from flash
+    }
+#endif
+
     prv_flash_read((uint8_t *)&file_hdr.file_namelen, sizeof(file_hdr.file_namelen),
         prv_page_to_flash_offset(pg) + file_namelen_offset);
 
@@ -587,8 +735,27 @@ static uint32_t prv_get_sector_page_status(uint16_t region,
   return (sectors_active);
 }
 
+//! @return the number of times the erase sector has been erased. Each page in
+//!     the sector tracks its own count and pages which were carried over by a
+//!     garbage collection keep their old one, so the largest count wins
+static uint32_t prv_get_region_erase_count(uint16_t region) {
+  uint16_t start_pg = region * PFS_PAGES_PER_ERASE_SECTOR;
+  uint32_t max_erase = 0;
+  for (uint16_t pg = start_pg; pg < start_pg + PFS_PAGES_PER_ERASE_SECTOR; pg++) {
+    uint32_t erase_count;
+    prv_flash_read((uint8_t *)&erase_count, sizeof(erase_count),
+        prv_page_to_flash_offset(pg) + offsetof(PageHeader, erase_count));
+    if (erase_count == 0xffffffff) {
+      continue; // never had an erase header written
+    }
+    max_erase = MAX(max_erase, erase_count);
+  }
+  return (max_erase);
+}
+
 //! Scans through the filesystem and finds a sector with no pages that
-//! are active
+//! are active. If there are several, the one which has been erased the least
+//! is picked so that the garbage collection block moves to cold sectors.
 //!
 //! @param skip_gc_region - will skip checking the region that is
 //!     used for garbage collection
@@ -600,6 +767,8 @@ static int prv_find_free_erase_region(bool skip_gc_region) {
 
   uint16_t gc_erase_block = s_gc_block.gc_start_page / PFS_PAGES_PER_ERASE_SECTOR;
 
+  int best_region = -1;
+  uint32_t best_erase_count = 0;
   for (int region = start_region; region < end_region; region++) {
     int erase_region = region % num_erase_regions;
 
@@ -610,11 +779,90 @@ static int prv_find_free_erase_region(bool skip_gc_region) {
     uint16_t free_pg;
     uint32_t sectors_active = prv_get_sector_page_status(erase_region, &free_pg);
     if ((__builtin_popcount(sectors_active) == 0)) {
-      return (erase_region * PFS_PAGES_PER_ERASE_SECTOR);
+      uint32_t erase_count = prv_get_region_erase_count(erase_region);
+      if ((best_region < 0) || (erase_count < best_erase_count)) {
+        best_region = erase_region;
+        best_erase_count = erase_count;
+      }
     }
   }
 
-  return (-1);
+  return (best_region < 0) ? -1 : (best_region * PFS_PAGES_PER_ERASE_SECTOR);
+}
+
+//! @return the number of pages which are erased and ready to be handed out,
+//!     not counting the garbage collection block
+static uint32_t prv_count_erased_pages(void) {
+  if (!s_gc_block.block_valid) {
+    return (s_pfs_erased_page_count);
+  }
+  const uint32_t gc_offset = prv_page_to_flash_offset(s_gc_block.gc_start_page);
+  return (s_pfs_erased_page_count -
+      prv_count_erased_pages_in_range(gc_offset, PFS_PAGE_SIZE * PFS_PAGES_PER_ERASE_SECTOR));
+}
+
+//! Picks the erase sector which is the cheapest to garbage collect: the one
+//! with the most pages which are no longer in use but haven't been erased yet,
+//! since those are the pages we win back while every active page has to be
+//! copied. Ties go to the sector which has been erased the least.
+//!
+//! @param start_region - the region to start the search from, ties that are
+//!     not broken by the erase count go to the first region after it
+//! @param sectors_active - populated with the active page bitmask of the region
+//! @return the first page of the sector to collect or INVALID_PAGE if there is
+//!     nothing to win back
+static uint16_t prv_find_gc_victim_region(uint16_t start_region, uint32_t *sectors_active) {
+  int num_erase_regions = s_pfs_page_count / PFS_PAGES_PER_ERASE_SECTOR;
+  uint16_t gc_erase_region = s_gc_block.gc_start_page / PFS_PAGES_PER_ERASE_SECTOR;
+
+  uint16_t best_region = INVALID_PAGE;
+  int best_reclaimable = 0;
+  uint32_t best_erase_count = 0;
+  for (int region = 0; region < num_erase_regions; region++) {
+    uint16_t curr_region = (region + start_region) % num_erase_regions;
+    if (s_gc_block.block_valid && (curr_region == gc_erase_region)) {
+      continue;
+    }
+
+    int reclaimable = 0;
+    uint32_t active = 0;
+    uint16_t start_pg = curr_region * PFS_PAGES_PER_ERASE_SECTOR;
+    for (uint16_t pg = 0; pg < PFS_PAGES_PER_ERASE_SECTOR; pg++) {
+      uint8_t page_flags = prv_get_page_flags(start_pg + pg);
+      if (!page_is_unallocated(page_flags)) {
+        active |= (0x1 << pg);
+      } else if (!page_is_erased(page_flags)) {
+        reclaimable++;
+      }
+    }
+
+    if ((reclaimable == 0) || (reclaimable < best_reclaimable)) {
+      continue;
+    }
+
+    uint32_t erase_count = prv_get_region_erase_count(curr_region);
+    if ((reclaimable > best_reclaimable) || (erase_count < best_erase_count)) {
+      best_region = curr_region;
+      best_reclaimable = reclaimable;
+      best_erase_count = erase_count;
+      *sectors_active = active;
+    }
+  }
+
+  return (best_region == INVALID_PAGE) ? INVALID_PAGE :
+      (best_region * PFS_PAGES_PER_ERASE_SECTOR);
+}
+
+//! Asks for a background garbage collection pass if fewer pre-erased pages than
+//! the configured reserve are left
+static void prv_request_background_gc_if_needed(void) {
+  if ((s_bg_gc_free_sector_reserve == 0) || !s_bg_gc_request || s_bg_gc_requested) {
+    return;
+  }
+
+  if (prv_count_erased_pages() < (s_bg_gc_free_sector_reserve * PFS_PAGES_PER_ERASE_SECTOR)) {
+    s_bg_gc_requested = s_bg_gc_request();
+  }
 }
 
 static status_t garbage_collect_sector(uint16_t *free_page,
@@ -717,17 +965,24 @@ static status_t find_free_page(uint16_t *free_page, bool use_gc_allocator,
         continue;
       }
 
-      uint32_t sectors_active = prv_get_sector_page_status(curr_region, &next_page);
+      prv_get_sector_page_status(curr_region, &next_page);
       if (next_page != INVALID_PAGE) {
         // we have found a page which is already erased
         break;
-      } else if (__builtin_popcount(sectors_active) < PFS_PAGES_PER_ERASE_SECTOR) {
-        // we can erase this region and have at least 1 free page after
-        uint16_t sector_start_pg = curr_region * PFS_PAGES_PER_ERASE_SECTOR;
-        garbage_collect_sector(&next_page, sector_start_pg, sectors_active);
-        break;
       }
     }
+
+    // only erase while the caller waits if there is no pre-erased page left
+    // anywhere on the filesystem
+    uint32_t sectors_active = 0;
+    uint16_t sector_start_pg;
+    if ((next_page == INVALID_PAGE) &&
+        ((sector_start_pg = prv_find_gc_victim_region(start_region, &sectors_active)) !=
+         INVALID_PAGE)) {
+      garbage_collect_sector(&next_page, sector_start_pg, sectors_active);
+    }
+
+    prv_request_background_gc_if_needed();
   }
 
   if (next_page != INVALID_PAGE) { // a free page was found
@@ -898,6 +1153,7 @@ static status_t create_flash_file(File *f) {
 
   prv_flash_write((uint8_t *)f->name, strlen(f->name),
       prv_page_to_flash_offset(start_page) + FILE_NAME_OFFSET);
+  prv_set_name_index(start_page, f->name);
 
   if (!f->is_tmp) {
     update_curr_state(f->start_page, TMP_STATE_OFFSET, TMP_STATE_DONE);
@@ -1203,8 +1459,10 @@ void pfs_set_size(uint32_t new_size, bool new_region_erased) {
   s_pfs_size = new_size;
   s_pfs_page_count = new_size / PFS_PAGE_SIZE;
 
-  // re-build the flags cache
+  // re-build the flags cache and filename index
   prv_build_page_flags_cache();
+  prv_build_name_index();
+  prv_recount_erased_pages();
 
   if (new_region_erased) {
     prv_write_erased_header_on_page_range((prev_size/PFS_PAGE_SIZE),
@@ -1491,6 +1749,7 @@ status_t pfs_remove(const char *name) {
   rv = unlink_flash_file(page);
   // IMPORTANT: prv_invoke_watch_file_callbacks assumes that we already have s_pfs_mutex
   prv_invoke_watch_file_callbacks(name, FILE_CHANGED_EVENT_REMOVED);
+  prv_request_background_gc_if_needed();
 cleanup:
   mutex_unlock_recursive(s_pfs_mutex);
   return (rv);
@@ -1903,7 +2162,8 @@ static int pfs_open_gc_file(uint32_t space_needed, bool create) {
   file->is_tmp = false;
 
   if (s_gc_block.block_valid && create) {
-    prv_flash_erase_sector(s_gc_block.gc_start_page);
+    // keep track of the erase count so that wear on the gc block is accounted for
+    prv_handle_sector_erase(s_gc_block.gc_start_page, true);
   }
 
   int res = file_found_or_added_to_pfs(fd, GC_FILE_NAME, file->op_flags,
@@ -2062,6 +2322,40 @@ done:
   return (E_INTERNAL);
 }
 
+void pfs_background_gc_enable(uint16_t free_sector_reserve, PFSBackgroundGCRequest request) {
+  mutex_lock_recursive(s_pfs_mutex);
+  s_bg_gc_free_sector_reserve = request ? free_sector_reserve : 0;
+  s_bg_gc_request = request;
+  s_bg_gc_requested = false;
+  prv_request_background_gc_if_needed();
+  mutex_unlock_recursive(s_pfs_mutex);
+}
+
+bool pfs_background_gc_step(void) {
+  mutex_lock_recursive(s_pfs_mutex);
+
+  const uint32_t pages_to_reserve = s_bg_gc_free_sector_reserve * PFS_PAGES_PER_ERASE_SECTOR;
+  bool more_work = false;
+  if (prv_count_erased_pages() < pages_to_reserve) {
+    uint32_t sectors_active = 0;
+    uint16_t start_region = s_last_page_written / PFS_PAGES_PER_ERASE_SECTOR;
+    uint16_t sector_start_pg = prv_find_gc_victim_region(start_region, &sectors_active);
+    if (sector_start_pg != INVALID_PAGE) {
+      PBL_LOG_DBG("Background GC of sector at page %d", (int)sector_start_pg);
+      uint16_t free_page;
+      garbage_collect_sector(&free_page, sector_start_pg, sectors_active);
+      prv_update_gc_reserved_region();
+      more_work = (prv_count_erased_pages() < pages_to_reserve);
+    }
+  }
+
+  // let the next allocation or removal ask again once we have caught up
+  s_bg_gc_requested = more_work;
+
+  mutex_unlock_recursive(s_pfs_mutex);
+  return (more_work);
+}
+
 status_t pfs_init(bool run_filesystem_check) {
   if (s_pfs_mutex == NULL) {
     s_pfs_mutex = mutex_create_recursive();
@@ -2072,6 +2366,7 @@ status_t pfs_init(bool run_filesystem_check) {
   }
 
   ftl_populate_region_list();
+  prv_recount_erased_pages();
 
   if (run_filesystem_check) {
     if (!pfs_active()) {
@@ -2124,6 +2419,8 @@ void pfs_format(bool write_erase_headers) {
   // clear out all pages
   filesystem_regions_erase_all();
   prv_invalidate_page_flags_cache_all();
+  prv_invalidate_name_index(0, s_pfs_page_count * PFS_PAGE_SIZE);
+  prv_recount_erased_pages();
 
   if (write_erase_headers) {
     prv_write_erased_header_on_page_range(0, s_pfs_page_count, 1);
@@ -2382,4 +2679,21 @@ void test_force_reboot_during_garbage_collection(uint16_t start_page) {
 void test_override_last_written_page(uint16_t start_page) {
   s_test_last_page_written_override = s_last_page_written;
 }
+
+uint32_t test_get_region_erase_count(uint16_t region) {
+  return (prv_get_region_erase_count(region));
+}
+
+uint16_t test_get_num_erase_regions(void) {
+  return (s_pfs_page_count / PFS_PAGES_PER_ERASE_SECTOR);
+}
+
+uint16_t test_get_erased_page_count(void) {
+  return (s_pfs_erased_page_count);
+}
+
+uint16_t test_recount_erased_page_count(void) {
+  prv_recount_erased_pages();
+  return (s_pfs_erased_page_count);
+}
 #endif
@@ -153,6 +153,27 @@ extern void pfs_reboot_cleanup(void);
 //! Note: assumes that pfs_init was called before this
 extern void pfs_format(bool write_erase_headers);
 
+//! Called by the filesystem when it wants pfs_background_gc_step() to be run from a low priority
+//! context. The filesystem mutex is held while this is called so it must not block, which rules
+//! out adding to the system task queue directly.
+//! @return true if the step was scheduled, false to be asked again on the next removal or
+//!     allocation
+typedef bool (*PFSBackgroundGCRequest)(void);
+
+//! Enables background garbage collection. Whenever a removal or an allocation leaves fewer
+//! pre-erased pages than free_sector_reserve erase sectors' worth, request is invoked so that
+//! deleted pages can be reclaimed before a writer has to wait for the erase.
+//! @param free_sector_reserve - number of erase sectors to keep erased, 0 disables background GC
+//! @param request - callback which schedules a call to pfs_background_gc_step()
+extern void pfs_background_gc_enable(uint16_t free_sector_reserve,
+                                     PFSBackgroundGCRequest request);
+
+//! Garbage collects at most one erase sector, preferring the one with the most deleted pages and
+//! then the one with the lowest erase count.
+//! @return true if the reserve has not been reached yet and the step should be scheduled again.
+//!     The request callback won't be called again until a step returns false.
+extern bool pfs_background_gc_step(void);
+
 //! Returns the size of the pfs filesystem.
 extern uint32_t pfs_get_size(void);
 
@@ -12,6 +12,7 @@
 #include "system/logging.h"
 #include "os/mutex.h"
 #include "system/passert.h"
+#include "util/hash.h"
 #include "util/iterator.h"
 
 #include <inttypes.h>
@@ -24,17 +25,81 @@ typedef struct NotificationIterState {
   TimelineItem notification;
 } NotificationIterState;
 
+//! Where to find a notification in the storage file, along with the fields we look it up by
+typedef struct NotificationIndexEntry {
+  uint32_t id_hash;
+  uint32_t ancs_uid;
+  time_t timestamp;
+  uint16_t offset;
+} NotificationIndexEntry;
+
+_Static_assert(NOTIFICATION_STORAGE_FILE_SIZE <= UINT16_MAX,
+               "Notification storage offsets don't fit the index");
+
+#define NOTIFICATION_INDEX_GROW_ENTRIES (16)
+
+//! In RAM index of the notifications in the storage file, in file order, so that lookups only need
+//! to read the headers of the candidates instead of scanning the whole file.
+//! Entries are not removed when a notification gets marked as deleted, the header status is
+//! checked when reading them. They go away when the file gets compressed.
+//! If the index can't be grown we fall back to scanning the file until it is rebuilt.
+typedef struct NotificationIndex {
+  NotificationIndexEntry *entries;
+  uint16_t num_entries;
+  uint16_t capacity;
+  bool valid;
+} NotificationIndex;
+
 static const char *FILENAME = "notifstr";     //The filename should not be changed
 
 static PebbleRecursiveMutex *s_notif_storage_mutex = NULL;
 
 static uint32_t s_write_offset;
 
+static NotificationIndex s_index;
+
 static bool prv_iter_next(NotificationIterState *iter_state);
 static bool prv_get_notification(TimelineItem *notification,
     SerializedTimelineItemHeader *header, int fd);
 static void prv_set_header_status(SerializedTimelineItemHeader *header, uint8_t status, int fd);
 
+static uint32_t prv_hash_id(const Uuid *id) {
+  return hash((const uint8_t *)id, sizeof(*id));
+}
+
+//! Empties the index, the file has to be empty too or about to be rewritten from the start
+static void prv_index_reset(void) {
+  kernel_free(s_index.entries);
+  s_index = (NotificationIndex) {
+    .valid = true,
+  };
+}
+
+static void prv_index_add(const SerializedTimelineItemHeader *header, uint32_t offset) {
+  if (!s_index.valid) {
+    return;
+  }
+  if (s_index.num_entries == s_index.capacity) {
+    const uint16_t capacity = s_index.capacity + NOTIFICATION_INDEX_GROW_ENTRIES;
+    NotificationIndexEntry *entries =
+        kernel_realloc(s_index.entries, capacity * sizeof(NotificationIndexEntry));
+    if (!entries) {
+      PBL_LOG_WRN("Not enough memory for the notification index, falling back to scanning");
+      kernel_free(s_index.entries);
+      s_index = (NotificationIndex) {};
+      return;
+    }
+    s_index.entries = entries;
+    s_index.capacity = capacity;
+  }
+  s_index.entries[s_index.num_entries++] = (NotificationIndexEntry) {
+    .id_hash = prv_hash_id(&header->common.id),
+    .ancs_uid = header->common.ancs_uid,
+    .timestamp = header->common.timestamp,
+    .offset = offset,
+  };
+}
+
 void notification_storage_init(void) {
   PBL_ASSERTN(s_notif_storage_mutex == NULL);
 
@@ -48,6 +113,7 @@ void notification_storage_init(void) {
     pfs_close(fd);
   }
   s_write_offset = 0;
+  prv_index_reset();
   s_notif_storage_mutex = mutex_create_recursive();
 }
 
@@ -199,6 +265,7 @@ static bool prv_compress(size_t size_needed, int *fd) {
   pfs_seek(*fd, 0, FSeekSet);
 
   int write_offset = 0;
+  prv_index_reset();
 
   // Iterate over notifications stored and write to new file
   NotificationIterState iter_state = {
@@ -232,6 +299,7 @@ static bool prv_compress(size_t size_needed, int *fd) {
       kernel_free(notification.allocated_buffer);
       goto cleanup;
     }
+    prv_index_add(&iter_state.header, write_offset);
     write_offset += result;
     kernel_free(notification.allocated_buffer);
   }
@@ -278,6 +346,7 @@ void notification_storage_store(TimelineItem* notification) {
 
   pfs_seek(fd, s_write_offset, FSeekSet);
 
+  const uint32_t offset = s_write_offset;
   int result = prv_write_notification(notification, &header, fd);
   if (result < 0) {
     // [AS] TODO: Write failure: reset storage, compression or reset watch?
@@ -288,6 +357,7 @@ void notification_storage_store(TimelineItem* notification) {
   }
 
   s_write_offset += result;
+  prv_index_add(&header, offset);
 
   prv_file_close(fd);
   return;
@@ -297,6 +367,41 @@ reset_storage:
   notification_storage_reset_and_init();
 }
 
+//! Resets the storage if the header doesn't look like a notification
+//! @return false if the storage was corrupt
+static bool prv_check_header(SerializedTimelineItemHeader *header, int fd) {
+  uint8_t status = header->common.status;
+  if ((status & TimelineItemStatusUnused) ||
+      (header->common.type >= TimelineItemTypeOutOfRange) ||
+      (header->common.layout >= NumLayoutIds)) {
+    pfs_close(fd);
+    notification_storage_reset_and_init();
+    PBL_LOG_ERR("Notification storage corrupt. Resetting...");
+    return false;
+  }
+  return true;
+}
+
+//! Reads the header of the notification at the given index entry
+//! Position in file will be at the start of notification payload if return value is true
+//! @return false if it couldn't be read or the storage was corrupt
+static bool prv_read_indexed_header(const NotificationIndexEntry *entry,
+                                    SerializedTimelineItemHeader *header, int fd) {
+  if (pfs_seek(fd, entry->offset, FSeekSet) < 0) {
+    return false;
+  }
+  int result = pfs_read(fd, (uint8_t *)header, sizeof(*header));
+  if (result != sizeof(*header)) {
+    return false;
+  }
+
+  // Restore flags & status
+  header->common.flags = ~header->common.flags;
+  header->common.status = ~header->common.status;
+
+  return prv_check_header(header, fd);
+}
+
 // Finds the next match in the notification storage file from the current position
 // Position in file will be at the start of notification payload if return value is true
 static bool prv_find_next_notification(SerializedTimelineItemHeader* header,
@@ -312,16 +417,11 @@ static bool prv_find_next_notification(SerializedTimelineItemHeader* header,
       break;
     }
 
-    uint8_t status = header->common.status;
-    if ((status & TimelineItemStatusUnused) ||
-        (header->common.type >= TimelineItemTypeOutOfRange) ||
-        (header->common.layout >= NumLayoutIds)) {
-      pfs_close(fd);
-      notification_storage_reset_and_init();
-      PBL_LOG_ERR("Notification storage corrupt. Resetting...");
+    if (!prv_check_header(header, fd)) {
       break;
     }
 
+    uint8_t status = header->common.status;
     if (!(status & TimelineItemStatusDeleted)) {
       // Only check compare notifications if it is not deleted, otherwise skip it and look for
       // the next match
@@ -348,6 +448,29 @@ static bool prv_ancs_id_compare_func(SerializedTimelineItemHeader* header, void*
   return header->common.ancs_uid == ancs_uid;
 }
 
+//! Finds the first notification with the given id, through the index if we have one
+//! Position in file will be at the start of notification payload if return value is true
+static bool prv_find_notification(SerializedTimelineItemHeader *header, const Uuid *id, int fd) {
+  if (!s_index.valid) {
+    return prv_find_next_notification(header, prv_uuid_equal_func, (void *)id, fd);
+  }
+
+  const uint32_t id_hash = prv_hash_id(id);
+  for (int i = 0; i < s_index.num_entries; i++) {
+    if (s_index.entries[i].id_hash != id_hash) {
+      continue;
+    }
+    if (!prv_read_indexed_header(&s_index.entries[i], header, fd)) {
+      return false;
+    }
+    if (!(header->common.status & TimelineItemStatusDeleted) &&
+        uuid_equal(&header->common.id, id)) {
+      return true;
+    }
+  }
+  return false;
+}
+
 bool notification_storage_notification_exists(const Uuid *id) {
   int fd = prv_file_open(OP_FLAG_READ);
   if (fd < 0) {
@@ -355,7 +478,7 @@ bool notification_storage_notification_exists(const Uuid *id) {
   }
 
   SerializedTimelineItemHeader header = { .common.id = UUID_INVALID };
-  bool found = prv_find_next_notification(&header, prv_uuid_equal_func, (void *)id, fd);
+  bool found = prv_find_notification(&header, id, fd);
 
   prv_file_close(fd);
 
@@ -394,7 +517,7 @@ size_t notification_storage_get_len(const Uuid *uuid) {
 
   size_t size = 0;
   SerializedTimelineItemHeader header = { .common.id = UUID_INVALID };
-  if (prv_find_next_notification(&header, prv_uuid_equal_func, (void *) uuid, fd)) {
+  if (prv_find_notification(&header, uuid, fd)) {
     size = header.payload_length + sizeof(SerializedTimelineItemHeader);
   } else {
     PBL_LOG_DBG("notification not found");
@@ -417,7 +540,7 @@ bool notification_storage_get(const Uuid *id, TimelineItem *item_out) {
   SerializedTimelineItemHeader header = { .common.id = UUID_INVALID };
   char uuid_string[UUID_STRING_BUFFER_LENGTH];
   uuid_to_string(id, uuid_string);
-  if (!prv_find_next_notification(&header, prv_uuid_equal_func, (void *) id, fd)) {
+  if (!prv_find_notification(&header, id, fd)) {
     PBL_LOG_DBG("notification not found, %s", uuid_string);
     rv = false;
   } else {
@@ -503,7 +626,7 @@ bool notification_storage_get_status(const Uuid *id, uint8_t *status) {
   }
 
   SerializedTimelineItemHeader header = { .common.id = UUID_INVALID };
-  if (prv_find_next_notification(&header, prv_uuid_equal_func, (void *) id, fd)) {
+  if (prv_find_notification(&header, id, fd)) {
     *status = header.common.status;
     rv = true;
   }
@@ -522,7 +645,7 @@ void notification_storage_set_status(const Uuid *id, uint8_t status) {
     return;
   }
 
-  if (prv_find_next_notification(&header, prv_uuid_equal_func, (void *) id, fd)) {
+  if (prv_find_notification(&header, id, fd)) {
     prv_set_header_status(&header, status, fd);
   }
 
@@ -546,6 +669,24 @@ bool notification_storage_find_ancs_notification_id(uint32_t ancs_uid, Uuid *uui
   // Find the most recent notification which matches this ANCS UID - this will be the last entry in
   // the db. iOS can reset ANCS UIDs on reconnect, so we want to avoid finding an old notification
   bool found = false;
+  if (s_index.valid) {
+    for (int i = s_index.num_entries - 1; i >= 0; i--) {
+      if (s_index.entries[i].ancs_uid != ancs_uid) {
+        continue;
+      }
+      if (!prv_read_indexed_header(&s_index.entries[i], &header, fd)) {
+        break;
+      }
+      if (!(header.common.status & TimelineItemStatusDeleted) &&
+          (header.common.ancs_uid == ancs_uid)) {
+        found = true;
+        *uuid_out = header.common.id;
+        break;
+      }
+    }
+    goto done;
+  }
+
   while (prv_find_next_notification(&header, prv_ancs_id_compare_func,
                                     (void *)(uintptr_t) ancs_uid, fd)) {
     found = true;
@@ -557,6 +698,7 @@ bool notification_storage_find_ancs_notification_id(uint32_t ancs_uid, Uuid *uui
     }
   }
 
+done:
   prv_file_close(fd);
 
   return found;
@@ -605,8 +747,28 @@ bool notification_storage_find_ancs_notification_by_timestamp(
   uint8_t *payload = kernel_malloc_check(payload_size);
   timeline_item_serialize_payload(notification, payload, payload_size);
 
-  //Iterate over all records until a match is found
   bool rv = false;
+  if (s_index.valid) {
+    // Only read the records with a matching timestamp
+    for (int i = 0; i < s_index.num_entries; i++) {
+      if (s_index.entries[i].timestamp != notification->header.timestamp) {
+        continue;
+      }
+      SerializedTimelineItemHeader header;
+      if (!prv_read_indexed_header(&s_index.entries[i], &header, fd)) {
+        break;
+      }
+      if (!(header.common.status & TimelineItemStatusDeleted) &&
+          prv_compare_ancs_notifications(notification, payload, payload_size, &header, fd)) {
+        *header_out = header.common;
+        rv = true;
+        break;
+      }
+    }
+    goto done;
+  }
+
+  //Iterate over all records until a match is found
   NotificationIterState iter_state = {
       .fd = fd,
   };
@@ -629,6 +791,7 @@ bool notification_storage_find_ancs_notification_by_timestamp(
     }
   }
 
+done:
   kernel_free(payload);
 
   prv_file_close(fd);
@@ -663,12 +826,21 @@ void notification_storage_rewrite(void (*iter_callback)(TimelineItem *notificati
   };
   iter_init(&iter, (IteratorCallback)prv_rewrite_iter_next, NULL, &iter_state);
 
+  // The callback can change the notifications, so the index is rebuilt along with the file
+  prv_index_reset();
+  uint32_t write_offset = 0;
   while (iter_next(&iter)) {
     uint8_t status = iter_state.header.common.status;
     if (!(status & TimelineItemStatusDeleted)) {
       iter_callback(&iter_state.notification, &iter_state.header, data);
     }
-    prv_write_notification(&iter_state.notification, &iter_state.header, new_fd);
+    int result = prv_write_notification(&iter_state.notification, &iter_state.header, new_fd);
+    if (result > 0) {
+      if (!(iter_state.header.common.status & TimelineItemStatusDeleted)) {
+        prv_index_add(&iter_state.header, write_offset);
+      }
+      write_offset += result;
+    }
   }
 
   // Close the old file
@@ -723,6 +895,7 @@ void notification_storage_reset_and_init(void) {
   notification_storage_lock();
   pfs_remove(FILENAME);
   s_write_offset = 0;
+  prv_index_reset();
   notification_storage_unlock();
 }
 
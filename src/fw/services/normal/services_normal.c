@@ -32,6 +32,8 @@
 #include "services/normal/timeline/event.h"
 #include "services/normal/wakeup.h"
 #include "services/normal/weather/weather_service.h"
+#include "services/common/new_timer/new_timer.h"
+#include "services/common/system_task.h"
 #include "services/runlevel_impl.h"
 
 #if CAPABILITY_HAS_ORIENTATION_MANAGER
@@ -77,6 +79,40 @@ static bool prv_is_time_valid_for_activity_init(void) {
   return rtc_get_time() >= MIN_VALID_TIME_TIMESTAMP;
 }
 
+// Number of erase sectors the filesystem tries to keep pre-erased so that writers rarely have to
+// wait for a garbage collection
+#define PFS_BACKGROUND_GC_FREE_SECTOR_RESERVE 2
+// How long to wait before trying again when the system task queue is full
+#define PFS_BACKGROUND_GC_RETRY_MS 1000
+
+static TimerID s_pfs_background_gc_timer = TIMER_INVALID_ID;
+
+static void prv_pfs_background_gc_timer_callback(void *data);
+
+static void prv_pfs_background_gc_callback(void *data) {
+  // one sector at a time so that other system task work can run in between
+  if (pfs_background_gc_step()) {
+    new_timer_start(s_pfs_background_gc_timer, 0, prv_pfs_background_gc_timer_callback, NULL, 0);
+  }
+}
+
+static void prv_pfs_background_gc_timer_callback(void *data) {
+  // Don't wait for room on the system task queue, it's fine for the collection to run later
+  if (system_task_get_available_space() == 0) {
+    new_timer_start(s_pfs_background_gc_timer, PFS_BACKGROUND_GC_RETRY_MS,
+                    prv_pfs_background_gc_timer_callback, NULL, 0);
+    return;
+  }
+  system_task_add_callback(prv_pfs_background_gc_callback, NULL);
+}
+
+static bool prv_pfs_background_gc_request(void) {
+  // The filesystem mutex is held here. Adding to the system task queue could block on a full
+  // queue or on callbacks waiting for the filesystem, so only kick off a timer.
+  return new_timer_start(s_pfs_background_gc_timer, 0, prv_pfs_background_gc_timer_callback,
+                         NULL, 0);
+}
+
 void services_normal_early_init(void) {
   pfs_init(true);
 }
@@ -131,6 +167,9 @@ void services_normal_init(void) {
 #if CAPABILITY_HAS_APP_GLANCES
   app_glance_service_init();
 #endif
+
+  s_pfs_background_gc_timer = new_timer_create();
+  pfs_background_gc_enable(PFS_BACKGROUND_GC_FREE_SECTOR_RESERVE, prv_pfs_background_gc_request);
 }
 
 static struct ServiceRunLevelSetting s_runlevel_settings[] = {
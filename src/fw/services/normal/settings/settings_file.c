@@ -19,6 +19,7 @@ static SettingsFileChangeCallback s_change_callback = NULL;
 
 static status_t bootup_check(SettingsFile *file);
 static void compute_stats(SettingsFile *file);
+static void prv_index_free(SettingsFile *file);
 
 static bool file_hdr_is_uninitialized(SettingsFileHeader *file_hdr) {
   return (file_hdr->magic == 0xffffffff) && (file_hdr->version == 0xffff)
@@ -113,6 +114,7 @@ status_t settings_file_open(SettingsFile *file, const char *name,
 }
 
 void settings_file_close(SettingsFile *file) {
+  prv_index_free(file);
   settings_raw_iter_deinit(&file->iter);
   kernel_free(file->name);
   file->name = NULL;
@@ -169,7 +171,137 @@ static bool deleted_and_expired(SettingsRecordHeader *hdr) {
       && (hdr->last_modified <= (utc_time() - DELETED_LIFETIME));
 }
 
+  //////////////////////////////////////////////////////////////////////////////
+ // Key Index                                                                  //
+//////////////////////////////////////////////////////////////////////////////
+
+// Without an index, every lookup walks the record headers from the last position we were at,
+// which costs a flash read per record. The index is an open-addressed hash table which maps
+// the crc8 key hash already stored in each record header to the position of the live record
+// (i.e. not overwritten) for that key, so a lookup only has to look at the handful of records
+// which share its key hash. It is rebuilt from scratch whenever the file is (re)opened and kept
+// up to date by prv_settings_file_set_internal(). If we ever fail to allocate memory for it,
+// we drop it and go back to scanning the file.
+
+#define INDEX_INITIAL_NUM_SLOTS (16)
+#define INDEX_EMPTY_SLOT (0)
+#define INDEX_POS_BITS (24)
+#define INDEX_POS_MASK ((1 << INDEX_POS_BITS) - 1)
+
+typedef struct SettingsFileIndex {
+  //! Number of slots in use
+  uint32_t num_entries;
+  //! Number of slots, always a power of two
+  uint32_t num_slots;
+  //! Position of the EOF marker, which is where the next record will be written
+  int eof_pos;
+  //! Each slot holds (key_hash << INDEX_POS_BITS) | record_pos, or INDEX_EMPTY_SLOT. A record
+  //! can never start at position 0 since that is where the file header lives.
+  uint32_t slots[];
+} SettingsFileIndex;
+
+static void prv_index_free(SettingsFile *file) {
+  kernel_free(file->index);
+  file->index = NULL;
+}
+
+static uint32_t prv_index_home_slot(const SettingsFileIndex *index, uint8_t key_hash) {
+  // Spread the 256 possible key hashes evenly over the table
+  return ((uint32_t)key_hash * index->num_slots) >> 8;
+}
+
+static uint8_t prv_index_slot_key_hash(uint32_t slot) {
+  return slot >> INDEX_POS_BITS;
+}
+
+static int prv_index_slot_pos(uint32_t slot) {
+  return slot & INDEX_POS_MASK;
+}
+
+static void prv_index_insert_slot(SettingsFileIndex *index, uint32_t slot) {
+  const uint32_t mask = index->num_slots - 1;
+  uint32_t i = prv_index_home_slot(index, prv_index_slot_key_hash(slot));
+  while (index->slots[i] != INDEX_EMPTY_SLOT) {
+    i = (i + 1) & mask;
+  }
+  index->slots[i] = slot;
+  index->num_entries++;
+}
+
+static SettingsFileIndex *prv_index_create(uint32_t num_slots) {
+  SettingsFileIndex *index = kernel_zalloc(sizeof(SettingsFileIndex) +
+                                           num_slots * sizeof(index->slots[0]));
+  if (index) {
+    index->num_slots = num_slots;
+  }
+  return index;
+}
+
+//! Makes sure there is room for one more entry, keeping the load factor at or below 3/4 so
+//! that probe sequences stay short and always terminate on an empty slot.
+static bool prv_index_reserve(SettingsFile *file) {
+  SettingsFileIndex *index = file->index;
+  if ((index->num_entries + 1) * 4 <= index->num_slots * 3) {
+    return true;
+  }
+  SettingsFileIndex *new_index = prv_index_create(index->num_slots * 2);
+  if (!new_index) {
+    PBL_LOG_WRN("Not enough memory to grow index for %s, falling back to scanning",
+                file->name);
+    prv_index_free(file);
+    return false;
+  }
+  new_index->eof_pos = index->eof_pos;
+  for (uint32_t i = 0; i < index->num_slots; i++) {
+    if (index->slots[i] != INDEX_EMPTY_SLOT) {
+      prv_index_insert_slot(new_index, index->slots[i]);
+    }
+  }
+  kernel_free(index);
+  file->index = new_index;
+  return true;
+}
+
+static void prv_index_add(SettingsFile *file, uint8_t key_hash, int record_pos) {
+  if (record_pos > INDEX_POS_MASK) {
+    // Can't represent this record, only happens for absurdly large files.
+    prv_index_free(file);
+    return;
+  }
+  if (!prv_index_reserve(file)) {
+    return;
+  }
+  prv_index_insert_slot(file->index, ((uint32_t)key_hash << INDEX_POS_BITS) | record_pos);
+}
+
+//! Points the entry for the record at old_pos to the record at new_pos, which superseded it.
+static void prv_index_replace(SettingsFile *file, uint8_t key_hash, int old_pos, int new_pos) {
+  SettingsFileIndex *index = file->index;
+  const uint32_t old_slot = ((uint32_t)key_hash << INDEX_POS_BITS) | old_pos;
+  const uint32_t mask = index->num_slots - 1;
+  for (uint32_t i = prv_index_home_slot(index, key_hash); index->slots[i] != INDEX_EMPTY_SLOT;
+       i = (i + 1) & mask) {
+    if (index->slots[i] == old_slot) {
+      if (new_pos > INDEX_POS_MASK) {
+        prv_index_free(file);
+      } else {
+        index->slots[i] = ((uint32_t)key_hash << INDEX_POS_BITS) | new_pos;
+      }
+      return;
+    }
+  }
+  // Every live record is indexed, so we should never get here, but adding the record is
+  // always correct.
+  prv_index_add(file, key_hash, new_pos);
+}
+
 static void compute_stats(SettingsFile *file) {
+  prv_index_free(file);
+  file->index = prv_index_create(INDEX_INITIAL_NUM_SLOTS);
+  if (!file->index) {
+    PBL_LOG_WRN("Not enough memory to index %s, falling back to scanning", file->name);
+  }
+
   file->dead_space = 0;
   file->used_space = 0;
   file->last_modified = 0;
@@ -185,6 +317,13 @@ static void compute_stats(SettingsFile *file) {
     if (file->iter.hdr.last_modified > file->last_modified) {
       file->last_modified = file->iter.hdr.last_modified;
     }
+    if (file->index && !overwritten(&file->iter.hdr) && !partially_written(&file->iter.hdr)) {
+      prv_index_add(file, file->iter.hdr.key_hash,
+                    settings_raw_iter_get_current_record_pos(&file->iter));
+    }
+  }
+  if (file->index) {
+    file->index->eof_pos = settings_raw_iter_get_current_record_pos(&file->iter);
   }
 }
 
@@ -308,6 +447,32 @@ static bool search_forward(SettingsRawIter *iter, const uint8_t *key, int key_le
   return false;
 }
 
+static bool prv_index_search(SettingsFile *file, const uint8_t *key, int key_len) {
+  const SettingsFileIndex *index = file->index;
+  const uint8_t key_hash = crc8_calculate_bytes(key, key_len, true /* big_endian */);
+  const uint32_t mask = index->num_slots - 1;
+  for (uint32_t i = prv_index_home_slot(index, key_hash); index->slots[i] != INDEX_EMPTY_SLOT;
+       i = (i + 1) & mask) {
+    if (prv_index_slot_key_hash(index->slots[i]) != key_hash) {
+      continue;
+    }
+    settings_raw_iter_set_current_record_pos(&file->iter, prv_index_slot_pos(index->slots[i]));
+    if (prv_is_desired_hdr(&file->iter, key, key_len)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+//! Positions the iterator on the live record for the given key, if there is one.
+static bool prv_search(SettingsFile *file, const uint8_t *key, int key_len) {
+  if (file->index) {
+    return prv_index_search(file, key, key_len);
+  }
+  settings_raw_iter_resume(&file->iter);
+  return search_forward(&file->iter, key, key_len);
+}
+
 static status_t cleanup_partial_transactions(SettingsFile *file) {
   for (settings_raw_iter_begin(&file->iter); !settings_raw_iter_end(&file->iter);
       settings_raw_iter_next(&file->iter)) {
@@ -354,8 +519,7 @@ static status_t bootup_check(SettingsFile* file) {
 }
 
 int settings_file_get_len(SettingsFile *file, const void *key, size_t key_len) {
-  settings_raw_iter_resume(&file->iter);
-  if (search_forward(&file->iter, key, key_len)) {
+  if (prv_search(file, key, key_len)) {
     return file->iter.hdr.val_len;
   } else {
     return 0;
@@ -368,8 +532,7 @@ bool settings_file_exists(SettingsFile *file, const void *key, size_t key_len) {
 
 status_t settings_file_get(SettingsFile *file, const void *key, size_t key_len,
                            void *val_out, size_t val_out_len) {
-  settings_raw_iter_resume(&file->iter);
-  if (!search_forward(&file->iter, key, key_len)) {
+  if (!prv_search(file, key, key_len)) {
     memset(val_out, 0, val_out_len);
     return E_DOES_NOT_EXIST;
   }
@@ -393,8 +556,7 @@ status_t settings_file_set_byte(SettingsFile *file, const void *key,
   }
 
   // Find the record
-  settings_raw_iter_resume(&file->iter);
-  if (!search_forward(&file->iter, key, key_len) ||
+  if (!prv_search(file, key, key_len) ||
       file->iter.hdr.val_len == 0) {
     return E_DOES_NOT_EXIST;
   }
@@ -436,16 +598,19 @@ static status_t prv_settings_file_set_internal(SettingsFile *file, const void *k
 
   int overwritten_record = -1;
   // Find an existing record, if any, and mark it as overwrite-in-progress.
-  settings_raw_iter_resume(&file->iter);
-  if (search_forward(&file->iter, key, key_len)) {
+  if (prv_search(file, key, key_len)) {
     set_flag(&file->iter.hdr, SETTINGS_FLAG_OVERWRITE_STARTED);
     settings_raw_iter_write_header(&file->iter, &file->iter.hdr);
     overwritten_record = settings_raw_iter_get_current_record_pos(&file->iter);
   }
 
+  if (file->index) {
+    settings_raw_iter_set_current_record_pos(&file->iter, file->index->eof_pos);
+  }
   while (!settings_raw_iter_end(&file->iter)) {
     settings_raw_iter_next(&file->iter);
   }
+  const int new_record = settings_raw_iter_get_current_record_pos(&file->iter);
 
   // Create and write out a new record. Writing the header transitions us into
   // the write-in-progress state, since at least once of the bits must be
@@ -476,6 +641,15 @@ static status_t prv_settings_file_set_internal(SettingsFile *file, const void *k
     file->used_space -= record_size(&file->iter.hdr);
   }
 
+  if (file->index) {
+    file->index->eof_pos = new_record + rec_size;
+    if (overwritten_record >= 0) {
+      prv_index_replace(file, new_hdr.key_hash, overwritten_record, new_record);
+    } else {
+      prv_index_add(file, new_hdr.key_hash, new_record);
+    }
+  }
+
   // Notify change callback if registered (for settings sync)
   if (s_change_callback) {
     s_change_callback(file, key, key_len, new_hdr.last_modified);
@@ -502,8 +676,7 @@ status_t settings_file_mark_synced(SettingsFile *file, const void *key, size_t k
   }
 
   // Find an existing record, if any, and mark it as synced
-  settings_raw_iter_resume(&file->iter);
-  if (search_forward(&file->iter, key, key_len)) {
+  if (prv_search(file, key, key_len)) {
     set_flag(&file->iter.hdr, SETTINGS_FLAG_SYNCED);
     settings_raw_iter_write_header(&file->iter, &file->iter.hdr);
     return S_SUCCESS;
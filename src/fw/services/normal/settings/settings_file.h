@@ -59,6 +59,11 @@ typedef struct SettingsFile {
   //! settings_file_each()/settings_file_rewrite()),  without messing up the
   //! state of the iteration. Set to 0 if not in use.
   int cur_record_pos;
+
+  //! Optional in-RAM index from key hash to record position, built when the
+  //! file is opened. NULL if there wasn't enough memory for it, in which case
+  //! lookups fall back to scanning the file.
+  struct SettingsFileIndex *index;
 } SettingsFile;
 
 
@@ -31,8 +31,11 @@
 #include "util/math.h"
 #include "util/order.h"
 #include "util/size.h"
+#include "util/sort.h"
 #include "util/time/time.h"
 
+#include <string.h>
+
 struct TimelineNode {
   ListNode node;
   int index;
@@ -42,6 +45,22 @@ struct TimelineNode {
   bool all_day;
 };
 
+//! Time ordered array of the nodes in the list built by timeline_init, which lets us binary
+//! search for the first node to show instead of walking the list from one end
+typedef struct TimelineIndex {
+  TimelineNode **nodes;
+  int num_nodes;
+  int capacity;
+  //! The longest duration of any node, bounds how far before a timestamp a shown node can start
+  uint16_t max_duration;
+} TimelineIndex;
+
+static TimelineIndex s_index;
+
+#if UNITTEST
+static uint32_t s_num_index_nodes_moved;
+#endif
+
 static uint32_t i18n_key;
 
 #define TIMELINE_FUTURE_WINDOW (3 * SECONDS_PER_DAY)
@@ -114,15 +133,47 @@ static bool prv_show_event(TimelineNode *node, time_t timestamp, time_t midnight
   }
 }
 
+//! Returns the position in the index of the first node that starts at or after timestamp
+static int prv_index_lower_bound(time_t timestamp) {
+  int low = 0;
+  int high = s_index.num_nodes;
+  while (low < high) {
+    const int mid = low + (high - low) / 2;
+    if (s_index.nodes[mid]->timestamp < timestamp) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
 // All day events show up in future if no timed events have passed today,
 // i.e. no events exist between midnight today and now
 // iterate and figure out if we had a timed event pass today
-static bool prv_should_show_all_day_events(TimelineNode *head, time_t now, time_t today_midnight,
+static bool prv_should_show_all_day_events(time_t now, time_t today_midnight,
   TimelineIterDirection direction) {
-  TimelineNode *current = head;
   // show in future / hide in past all day events unless we find a timed event
   // between midnight and now
   bool show = direction == TimelineIterDirectionFuture;
+  for (int i = prv_index_lower_bound(today_midnight); i < s_index.num_nodes; i++) {
+    TimelineNode *current = s_index.nodes[i];
+    if (current->timestamp > now) {
+      break;
+    }
+    if (!current->all_day) {
+      show = !show;
+      break;
+    }
+  }
+  return show;
+}
+
+//! Same as prv_should_show_all_day_events, for a list that the index may not have been built for
+static bool prv_list_should_show_all_day_events(TimelineNode *head, time_t now,
+  time_t today_midnight, TimelineIterDirection direction) {
+  TimelineNode *current = head;
+  bool show = direction == TimelineIterDirectionFuture;
   while (current) {
     if (current->timestamp > now) {
       break;
@@ -136,42 +187,83 @@ static bool prv_should_show_all_day_events(TimelineNode *head, time_t now, time_
   return show;
 }
 
-static TimelineNode *prv_find_first_past(TimelineNode *head, time_t timestamp,
-  time_t today_midnight, bool show_all_day_events) {
-  TimelineNode *current = (TimelineNode *)list_get_tail((ListNode *)head);
-  while (current) {
+static TimelineNode *prv_find_first_past(time_t timestamp, time_t today_midnight,
+  bool show_all_day_events) {
+  // Past events start before the timestamp, all day events at midnight, nothing after that
+  const time_t last_start = MAX(timestamp, today_midnight);
+  for (int i = prv_index_lower_bound(last_start + 1) - 1; i >= 0; i--) {
+    TimelineNode *current = s_index.nodes[i];
     if (prv_show_event(current, timestamp, today_midnight, TimelineIterDirectionPast,
-     show_all_day_events)) {
-      break;
+      show_all_day_events)) {
+      return current;
     }
-    current = (TimelineNode *)current->node.prev;
   }
-  return current;
+  return NULL;
 }
 
-static TimelineNode *prv_find_first_future(TimelineNode *head, time_t timestamp,
-  time_t today_midnight, bool show_all_day_events) {
-  TimelineNode *current = head;
-  while (current) {
+static TimelineNode *prv_find_first_future(time_t timestamp, time_t today_midnight,
+  bool show_all_day_events) {
+  // Future events are still going on at the timestamp, or are all day events at midnight
+  const time_t first_start = MIN(timestamp - s_index.max_duration * SECONDS_PER_MINUTE,
+                                 today_midnight);
+  for (int i = prv_index_lower_bound(first_start); i < s_index.num_nodes; i++) {
+    TimelineNode *current = s_index.nodes[i];
     if (prv_show_event(current, timestamp, today_midnight, TimelineIterDirectionFuture,
       show_all_day_events)) {
-      break;
+      return current;
     }
-    current = (TimelineNode *)current->node.next;
   }
-  return current;
+  return NULL;
 }
 
-static TimelineNode *prv_find_first(TimelineNode *head, TimelineIterDirection direction,
-  time_t timestamp, time_t today_midnight, bool show_all_day_events) {
+static TimelineNode *prv_find_first(TimelineIterDirection direction, time_t timestamp,
+  time_t today_midnight, bool show_all_day_events) {
   if (direction == TimelineIterDirectionPast) {
-    return prv_find_first_past(head, timestamp, today_midnight, show_all_day_events);
+    return prv_find_first_past(timestamp, today_midnight, show_all_day_events);
   } else {
-    return prv_find_first_future(head, timestamp, today_midnight, show_all_day_events);
+    return prv_find_first_future(timestamp, today_midnight, show_all_day_events);
+  }
+}
+
+static void prv_index_deinit(void) {
+  task_free(s_index.nodes);
+  s_index = (TimelineIndex){};
+}
+
+static void prv_index_append(TimelineNode *node) {
+  if (s_index.num_nodes == s_index.capacity) {
+    s_index.capacity = MAX(2 * s_index.capacity, 16);
+    s_index.nodes = task_realloc(s_index.nodes, s_index.capacity * sizeof(TimelineNode *));
+    PBL_ASSERTN(s_index.nodes);
+  }
+  s_index.nodes[s_index.num_nodes++] = node;
+  s_index.max_duration = MAX(s_index.max_duration, node->duration);
+}
+
+//! The node indices are assigned in index order once it is sorted, so they can be searched for
+static void prv_index_remove(TimelineNode *node) {
+  int low = 0;
+  int high = s_index.num_nodes;
+  while (low < high) {
+    const int mid = low + (high - low) / 2;
+    if (s_index.nodes[mid]->index < node->index) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  if (low < s_index.num_nodes && s_index.nodes[low] == node) {
+    s_index.num_nodes--;
+#if UNITTEST
+    s_num_index_nodes_moved += s_index.num_nodes - low;
+#endif
+    memmove(&s_index.nodes[low], &s_index.nodes[low + 1],
+            (s_index.num_nodes - low) * sizeof(TimelineNode *));
   }
 }
 
 static void prv_remove_node(TimelineNode **head, TimelineNode *node) {
+  prv_index_remove(node);
   list_remove((ListNode *)node, (ListNode **)head, NULL);
   task_free(node);
 }
@@ -249,8 +341,7 @@ static void prv_set_nodes_all_day(TimelineNode *nodes[], CommonTimelineItemHeade
   }
 }
 
-static void prv_add_nodes_for_serialized_item(TimelineNode **list_head,
-  CommonTimelineItemHeader *header) {
+static void prv_add_nodes_for_serialized_item(CommonTimelineItemHeader *header) {
   int num_nodes = prv_num_nodes_for_serialized_item(header);
   TimelineNode *nodes[num_nodes];
 
@@ -269,8 +360,9 @@ static void prv_add_nodes_for_serialized_item(TimelineNode **list_head,
   }
 
   for (int i = 0; i < num_nodes; i++) {
-    *list_head = (TimelineNode *)list_sorted_add((ListNode *)*list_head, (ListNode *)nodes[i],
-      prv_time_comparator, true);
+    // remember the order the nodes were read in for prv_index_comparator
+    nodes[i]->index = s_index.num_nodes;
+    prv_index_append(nodes[i]);
   }
 }
 
@@ -280,8 +372,6 @@ static bool prv_each(SettingsFile *file, SettingsRecordInfo *info, void *context
     return true; // continue iteration
   }
 
-  TimelineNode **list_head = context;
-
   CommonTimelineItemHeader header;
   // we don't care about the attributes here, so we don't allocate space for them
   info->get_val(file, (uint8_t *)&header, sizeof(CommonTimelineItemHeader));
@@ -289,18 +379,48 @@ static bool prv_each(SettingsFile *file, SettingsRecordInfo *info, void *context
   header.flags = ~header.flags;
   header.status = ~header.status;
 
-  prv_add_nodes_for_serialized_item(list_head, &header);
+  prv_add_nodes_for_serialized_item(&header);
 
   return true; // continue iteration
 }
-static void prv_set_indices(TimelineNode *timeline) {
-  TimelineNode *node = timeline;
-  int index = 0;
-  while (node) {
-    node->index = index;
-    index++;
-    node = (TimelineNode *)list_get_next((ListNode *)node);
+
+// Orders the nodes exactly like adding them one by one with list_sorted_add and
+// prv_time_comparator would: all day events go in front of the nodes at the same time that were
+// read before them, all other nodes go behind the nodes at the same time and duration.
+// prv_time_comparator can't be used for this directly, it doesn't order two all day events.
+static int prv_index_comparator(const void *a, const void *b) {
+  TimelineNode *node_a = *(TimelineNode **)a;
+  TimelineNode *node_b = *(TimelineNode **)b;
+  if (node_a->timestamp != node_b->timestamp) {
+    return (node_a->timestamp < node_b->timestamp) ? -1 : 1;
+  } else if (node_a->all_day != node_b->all_day) {
+    return node_a->all_day ? -1 : 1;
+  } else if (node_a->all_day) {
+    return node_b->index - node_a->index;
+  } else if (node_a->duration != node_b->duration) {
+    return node_a->duration - node_b->duration;
+  } else {
+    return node_a->index - node_b->index;
+  }
+}
+
+//! Sorts the index and links the list up in the same order. This is O(n log n), where inserting
+//! every node into a sorted list is O(n^2) and was the bulk of the time spent opening the timeline
+//! with a lot of pins.
+static TimelineNode *prv_build_list_from_index(void) {
+  sort_heap(s_index.nodes, s_index.num_nodes, sizeof(TimelineNode *), prv_index_comparator);
+  TimelineNode *prev = NULL;
+  for (int i = 0; i < s_index.num_nodes; i++) {
+    TimelineNode *node = s_index.nodes[i];
+    node->index = i;
+    node->node.prev = (ListNode *)prev;
+    node->node.next = NULL;
+    if (prev) {
+      prev->node.next = (ListNode *)node;
+    }
+    prev = node;
   }
+  return s_index.num_nodes ? s_index.nodes[0] : NULL;
 }
 
 static int prv_first_event_comparator(TimelineNode *new_node, TimelineNode *old_node,
@@ -464,9 +584,16 @@ static void prv_put_outgoing_call_event(uint32_t call_identifier, const char *ca
 
 status_t timeline_init(TimelineNode **timeline) {
   PBL_LOG_DBG("Starting to build list.");
-  status_t rv = pin_db_each(prv_each, timeline);
+  // The index lives on the heap of the task that built the previous timeline, which may be gone
+  // by now, so don't try to free it
+  s_index = (TimelineIndex){};
+  status_t rv = pin_db_each(prv_each, NULL);
+  *timeline = prv_build_list_from_index();
   prv_prune_ordered_timeline_list(timeline);
-  prv_set_indices(*timeline);
+  if (s_index.num_nodes == 0) {
+    // everything was pruned, don't hold on to the index
+    prv_index_deinit();
+  }
   PBL_LOG_DBG("Finished building list.");
 #ifdef TIMELINE_SERVICE_DEBUG
   prv_debug_print_pins(*timeline);
@@ -492,7 +619,8 @@ TimelineIterDirection timeline_direction_for_item(TimelineItem *item,
   if (item->header.all_day) {
     time_t today_midnight = time_util_get_midnight_of(now);
     if (today_midnight > item->header.timestamp ||
-        prv_should_show_all_day_events(timeline, now, today_midnight, TimelineIterDirectionPast)) {
+        prv_list_should_show_all_day_events(timeline, now, today_midnight,
+                                            TimelineIterDirectionPast)) {
       return TimelineIterDirectionPast;
     } else {
       return TimelineIterDirectionFuture;
@@ -569,15 +697,15 @@ bool timeline_iter_remove_node_with_id(TimelineNode **head, Uuid *key) {
   }
 }
 
-status_t timeline_iter_init(Iterator *iter, TimelineIterState *iter_state, TimelineNode **head,
+status_t timeline_iter_init(Iterator *iter, TimelineIterState *iter_state,
     TimelineIterDirection direction, time_t timestamp) {
   iter_state->direction = direction;
   iter_state->start_time = timestamp;
   iter_state->midnight = time_util_get_midnight_of(timestamp);
   iter_state->current_day = iter_state->midnight;
-  iter_state->show_all_day_events = prv_should_show_all_day_events(*head, timestamp,
+  iter_state->show_all_day_events = prv_should_show_all_day_events(timestamp,
     iter_state->midnight, direction);
-  TimelineNode *node = prv_find_first(*head, direction, timestamp, iter_state->midnight,
+  TimelineNode *node = prv_find_first(direction, timestamp, iter_state->midnight,
     iter_state->show_all_day_events);
   if (node == NULL) {
     iter_init(iter, prv_iter_dummy, prv_iter_dummy, iter_state);
@@ -617,11 +745,13 @@ void timeline_iter_copy_state(TimelineIterState *dst_state, TimelineIterState *s
 }
 
 void timeline_iter_deinit(Iterator *iter, TimelineIterState *iter_state, TimelineNode **head) {
+  // the whole list goes away, so free the nodes without taking each one out of the index
+  prv_index_deinit();
   TimelineNode *node = *head;
   while (node) {
     TimelineNode *old = node;
     node = (TimelineNode *)node->node.next;
-    prv_remove_node(head, old);
+    task_free(old);
   }
   *head = NULL;
 
@@ -1038,3 +1168,9 @@ void analytics_external_collect_timeline_pin_stats(void) {
   analytics_set(ANALYTICS_DEVICE_METRIC_TIMELINE_PINS_HOURLY_OTHER_COUNT,
                 analytics_info.hourly_count.other, AnalyticsClient_System);
 }
+
+#if UNITTEST
+uint32_t timeline_get_num_index_nodes_moved(void) {
+  return s_num_index_nodes_moved;
+}
+#endif
@@ -53,8 +53,9 @@ bool timeline_is_bulk_ancs_action_mode_enabled(void);
 void timeline_invoke_action(const TimelineItem *item, const TimelineItemAction *action,
                             const AttributeList *attributes);
 
+//! Walks the given list, which may be NULL, to check for timed events earlier today
 TimelineIterDirection timeline_direction_for_item(TimelineItem *item,
-    TimelineNode *timeline, time_t now);
+     TimelineNode *timeline, time_t now);
 
 bool timeline_nodes_equal(TimelineNode *a, TimelineNode *b);
 
@@ -89,7 +90,9 @@ bool timeline_item_should_show(CommonTimelineItemHeader *header, TimelineIterDir
 //! Timeline Iterator functions
 ///////////////////////////////////
 
-status_t timeline_iter_init(Iterator *iter, TimelineIterState *iter_state, TimelineNode **timeline,
+//! Starts iterating the list built by the last timeline_init at the first node to show from
+//! timestamp in the given direction
+status_t timeline_iter_init(Iterator *iter, TimelineIterState *iter_state,
     TimelineIterDirection direction, time_t timestamp);
 
 // Copy an iterator's contents into another one
@@ -109,6 +112,11 @@ void timeline_iter_remove_node(TimelineNode **timeline, TimelineNode *node);
 //! @return true if a node exists and was removed, false otherwise
 bool timeline_iter_remove_node_with_id(TimelineNode **timeline, Uuid *key);
 
+#if UNITTEST
+//! The number of node pointers shifted down the index by node removals so far
+uint32_t timeline_get_num_index_nodes_moved(void);
+#endif
+
 ///////////////////////////////////
 //! Timeline datasource functions
 ///////////////////////////////////
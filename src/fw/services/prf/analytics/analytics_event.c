@@ -17,7 +17,8 @@ typedef struct CommSession CommSession;
 void analytics_event_put_byte_stats(
     CommSession *session, bool crc_good, uint8_t type,
     uint32_t bytes_transferred, uint32_t elapsed_time_ms,
-    uint32_t conn_events, uint32_t sync_errors, uint32_t skip_errors, uint32_t other_errors) {
+    uint32_t conn_events, uint32_t sync_errors, uint32_t skip_errors, uint32_t other_errors,
+    uint32_t commit_time_ms) {
 }
 
 void analytics_event_PPoGATT_disconnect(time_t timestamp, bool successful_reconnect) {
@@ -183,6 +183,8 @@ BatteryChargeState sys_battery_get_charge_state(void);
 bool sys_activity_get_metric(ActivityMetric metric, uint32_t history_len, int32_t *history);
 bool sys_activity_get_minute_history(HealthMinuteData *minute_data, uint32_t *num_records,
                                      time_t *utc_start);
+bool sys_activity_get_minute_aggregate(time_t utc_start, time_t utc_end,
+                                       ActivityMinuteAggregate *aggregate);
 bool sys_activity_get_step_averages(DayInWeek day_of_week, ActivityMetricAverages *averages);
 bool sys_activity_get_sessions(uint32_t *session_entries, ActivitySession *sessions);
 bool sys_activity_sessions_is_session_type_ongoing(ActivitySessionType type);
@@ -15,3 +15,5 @@ PROFILER_NODE(hrm_handling)
 PROFILER_NODE(display_transfer)
 PROFILER_NODE(text_render_flash)
 PROFILER_NODE(text_render_compress)
+PROFILER_NODE(text_render_glyph_cache_hit)
+PROFILER_NODE(text_render_glyph_cache_miss)
@@ -5,23 +5,54 @@
 
 from __future__ import print_function
 
+import sys
+
 CRC_POLY = 0xEDB88320
 
 
 def crc_table(bits):
     lookup_table = []
-    for i in xrange(2**bits):
+    for i in range(2**bits):
         rr = i * 16
-        for x in xrange(8):
+        for x in range(8):
             rr = (rr >> 1) ^ (-(rr & 1) & CRC_POLY)
         lookup_table.append(rr & 0xFFFFFFFF)
     return lookup_table
 
 
-table = ["0x{:08x},".format(entry) for entry in crc_table(4)]
-chunks = zip(*[iter(table)] * 4)
+def byte_table():
+    lookup_table = []
+    for i in range(256):
+        rr = i
+        for x in range(8):
+            rr = (rr >> 1) ^ (-(rr & 1) & CRC_POLY)
+        lookup_table.append(rr & 0xFFFFFFFF)
+    return lookup_table
+
 
-print("static const uint32_t s_lookup_table[] = {")
-for chunk in chunks:
-    print("  " + " ".join(chunk))
-print("};")
+def slice_tables(num_slices):
+    # Table n advances the CRC of a byte by n further zero bytes
+    tables = [byte_table()]
+    for n in range(1, num_slices):
+        prev = tables[n - 1]
+        tables.append([(prev[i] >> 8) ^ tables[0][prev[i] & 0xFF] for i in range(256)])
+    return tables
+
+
+def print_table(entries, indent):
+    table = ["0x{:08x},".format(entry) for entry in entries]
+    for chunk in zip(*[iter(table)] * 4):
+        print(indent + " ".join(chunk))
+
+
+if len(sys.argv) > 1 and sys.argv[1] == '--slice-by-4':
+    print("static const uint32_t s_slice_by_4_table[4][256] = {")
+    for table in slice_tables(4):
+        print("  {")
+        print_table(table, "    ")
+        print("  },")
+    print("};")
+else:
+    print("static const uint32_t s_lookup_table[] = {")
+    print_table(crc_table(4), "  ")
+    print("};")
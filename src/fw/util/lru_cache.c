@@ -4,94 +4,134 @@
 #include "lru_cache.h"
 
 #include "system/passert.h"
+#include "util/math.h"
 
 #include <string.h>
 
+#define NO_ENTRY (UINT8_MAX)
+
+_Static_assert(LRU_CACHE_MAX_ITEMS <= NO_ENTRY, "Entry indices must not collide with NO_ENTRY");
+
 void lru_cache_init(LRUCache* c, size_t item_size, uint8_t *buffer, size_t buffer_size) {
   *c = (LRUCache) {
     .buffer = buffer,
     .item_size = item_size,
-    .max_items = buffer_size / (item_size + sizeof(CacheEntry)),
-    .least_recent = NULL
+    .max_items = MIN(buffer_size / (item_size + sizeof(CacheEntry)), LRU_CACHE_MAX_ITEMS),
   };
+  lru_cache_flush(c);
 }
 
 static CacheEntry *entry_for_index(LRUCache *c, int index) {
   return ((CacheEntry *)(c->buffer + index * (sizeof(CacheEntry) + c->item_size)));
 }
 
-void lru_cache_flush(LRUCache *c) {
-  c->least_recent = NULL;
+//! Fibonacci hashing, the high bits of the product are scaled down to the number of buckets
+static int prv_bucket_for_key(LRUCache *c, uint32_t key) {
+  const uint32_t hash = key * 2654435761u;
+  return ((uint64_t)hash * c->max_items) >> 32;
 }
 
-void *lru_cache_get(LRUCache* c, uint32_t key) {
-  // cur_ptr is a pointer-to-pointer to the more_recent
-  // field in the parent of the current entry
-  CacheEntry **cur_ptr = &c->least_recent;
-  CacheEntry *found = NULL;
-
+void lru_cache_flush(LRUCache *c) {
+  c->num_items = 0;
+  c->least_recent = NO_ENTRY;
+  c->most_recent = NO_ENTRY;
   for (int i = 0; i < c->max_items; ++i) {
-    CacheEntry *cur_entry = *cur_ptr;
-    if (cur_entry == NULL) {
-      break;
-    }
-    if (cur_entry->key == key) {
-      *cur_ptr = cur_entry->more_recent;
-      found = cur_entry;
-    }
-    if (*cur_ptr == NULL) {
+    entry_for_index(c, i)->bucket_head = NO_ENTRY;
+  }
+}
+
+static int prv_find(LRUCache *c, uint32_t key) {
+  if (c->max_items == 0) {
+    return NO_ENTRY;
+  }
+  int index = entry_for_index(c, prv_bucket_for_key(c, key))->bucket_head;
+  while (index != NO_ENTRY) {
+    CacheEntry *entry = entry_for_index(c, index);
+    if (entry->key == key) {
       break;
     }
-    cur_ptr = &cur_entry->more_recent;
+    index = entry->hash_next;
   }
+  return index;
+}
 
-  // cur_ptr should point to the last pointer in the list
-  PBL_ASSERTN(*cur_ptr == NULL);
+static void prv_unlink_recency(LRUCache *c, int index) {
+  CacheEntry *entry = entry_for_index(c, index);
+  if (entry->less_recent == NO_ENTRY) {
+    c->least_recent = entry->more_recent;
+  } else {
+    entry_for_index(c, entry->less_recent)->more_recent = entry->more_recent;
+  }
+  if (entry->more_recent == NO_ENTRY) {
+    c->most_recent = entry->less_recent;
+  } else {
+    entry_for_index(c, entry->more_recent)->less_recent = entry->less_recent;
+  }
+}
 
-  if (found) {
-    found->more_recent = NULL;
-    *cur_ptr = found;
-    return (found->data);
+static void prv_link_most_recent(LRUCache *c, int index) {
+  CacheEntry *entry = entry_for_index(c, index);
+  entry->less_recent = c->most_recent;
+  entry->more_recent = NO_ENTRY;
+  if (c->most_recent == NO_ENTRY) {
+    c->least_recent = index;
   } else {
+    entry_for_index(c, c->most_recent)->more_recent = index;
+  }
+  c->most_recent = index;
+}
+
+static void prv_unlink_bucket(LRUCache *c, int index) {
+  CacheEntry *entry = entry_for_index(c, index);
+  // cur_ptr is a pointer to the index field that refers to the current entry
+  uint8_t *cur_ptr = &entry_for_index(c, prv_bucket_for_key(c, entry->key))->bucket_head;
+  while (*cur_ptr != index) {
+    PBL_ASSERTN(*cur_ptr != NO_ENTRY);
+    cur_ptr = &entry_for_index(c, *cur_ptr)->hash_next;
+  }
+  *cur_ptr = entry->hash_next;
+}
+
+void *lru_cache_get(LRUCache* c, uint32_t key) {
+  const int index = prv_find(c, key);
+  if (index == NO_ENTRY) {
+    ++c->misses;
     return (NULL);
   }
+  ++c->hits;
+  if (index != c->most_recent) {
+    prv_unlink_recency(c, index);
+    prv_link_most_recent(c, index);
+  }
+  return (entry_for_index(c, index)->data);
 }
 
 void lru_cache_put(LRUCache* c, uint32_t key, void* item) {
-  // cur_ptr is a pointer-to-pointer to the more_recent
-  // field in the parent of the current entry
-  CacheEntry **cur_ptr = &c->least_recent;
-  CacheEntry *new = NULL;
+  if (c->max_items == 0) {
+    return;
+  }
 
-  for (int i = 0; i < c->max_items; ++i) {
-    CacheEntry *cur_entry = *cur_ptr;
-    if (cur_entry == NULL) {
+  int index = prv_find(c, key);
+  if (index != NO_ENTRY) {
+    // key already in cache, update
+    prv_unlink_recency(c, index);
+  } else {
+    if (c->num_items < c->max_items) {
       // cache is not full
-      new = entry_for_index(c, i);
-      break;
-    } else if (cur_entry->key == key) {
-      // key already in cache, update
-      *cur_ptr = cur_entry->more_recent;
-      new = cur_entry;
-    }
-    if (*cur_ptr == NULL) {
-      break;
+      index = c->num_items++;
+    } else {
+      // cache full, evict LRU
+      index = c->least_recent;
+      prv_unlink_recency(c, index);
+      prv_unlink_bucket(c, index);
     }
-    cur_ptr = &cur_entry->more_recent;
+    CacheEntry *new = entry_for_index(c, index);
+    CacheEntry *bucket = entry_for_index(c, prv_bucket_for_key(c, key));
+    new->key = key;
+    new->hash_next = bucket->bucket_head;
+    bucket->bucket_head = index;
   }
 
-  // cur_ptr should point to the last pointer in the list
-  PBL_ASSERTN(*cur_ptr == NULL);
-
-  if (new == NULL) {
-    // cache full, evict LRU
-    new = c->least_recent;
-    c->least_recent = new->more_recent;
-  }
-
-  new->more_recent = NULL;
-  new->key = key;
-  memcpy(new->data, item, c->item_size);
-  *cur_ptr = new;
+  prv_link_most_recent(c, index);
+  memcpy(entry_for_index(c, index)->data, item, c->item_size);
 }
-
@@ -8,15 +8,21 @@
 #include <stdint.h>
 
 //! This is a pretty simple & lean LRU cache
-//! It works with a pre-allocated buffer in which it stores a singly linked list
-//! of the items in LRU order (head of the list is the LRU item)
-//! put and get are both O[N]
-//! Note: we could save 2 bytes per entry by using array indices rather than pointer
-//! but this would complicate the code quite a bit
+//! It works with a pre-allocated buffer in which it stores the items in a doubly linked list in
+//! LRU order, along with a hash table to look them up by key. Entries refer to each other by array
+//! index to keep the per-entry overhead down, and every entry doubles as the head of one hash
+//! bucket so that the table doesn't need any extra space.
+//! put and get are both O(1)
+
+//! The largest number of items a cache can hold, regardless of the size of its buffer
+#define LRU_CACHE_MAX_ITEMS (UINT8_MAX)
 
 typedef struct CacheEntry {
-  struct CacheEntry *more_recent; ///< The next entry in the linked list
   uint32_t key; ///< The key that identifies this entry
+  uint8_t more_recent; ///< Index of the next more recently used entry
+  uint8_t less_recent; ///< Index of the next less recently used entry
+  uint8_t hash_next; ///< Index of the next entry in the same hash bucket
+  uint8_t bucket_head; ///< Index of the first entry in the hash bucket of this index
   uint8_t data[]; ///< the data associated with this entry
 } CacheEntry;
 
@@ -24,7 +30,11 @@ typedef struct {
   uint8_t *buffer; ///< A pointer to the buffer allocated for storing cache data
   size_t item_size; ///< The size in bytes of items in the cache
   int max_items; ///< The max number of items that can fit in the cache
-  CacheEntry *least_recent; ///< The head of the singly linked list of cache entries
+  int num_items; ///< The number of entries of the buffer that are in use
+  uint8_t least_recent; ///< Index of the head of the LRU list, the next entry to be evicted
+  uint8_t most_recent; ///< Index of the tail of the LRU list
+  uint32_t hits; ///< Number of calls to lru_cache_get that found their key
+  uint32_t misses; ///< Number of calls to lru_cache_get that didn't find their key
 } LRUCache;
 
 //! Initialize an LRU cache
@@ -32,7 +42,7 @@ typedef struct {
 //! @param item_size the size in bytes of items to be stored in the cache
 //! @param buffer a buffer to store cache items into
 //! @param buffer_size the size of the buffer
-//! @note each entry is 8 bytes larger than item_size, allocate accordingly!
+//! @note each entry is sizeof(CacheEntry) (8 bytes) larger than item_size, allocate accordingly!
 void lru_cache_init(LRUCache* c, size_t item_size, uint8_t *buffer, size_t buffer_size);
 
 //! Retrieve an item from the cache and mark the item as most recently used
@@ -50,6 +60,6 @@ void *lru_cache_get(LRUCache* c, uint32_t key);
 void lru_cache_put(LRUCache* c, uint32_t key, void* item);
 
 //! Flush the cache. This removes all data from the cache.
+//! @note The hit and miss counters are left untouched
 //! @param c the cache to flush
 void lru_cache_flush(LRUCache *c);
-
@@ -80,6 +80,27 @@ _Static_assert((offsetof(HeapInfo_t, Data) % ALIGNMENT_SIZE) == 0, "Heap not pro
 #define HEAP_ASSERT_SANE(heap, expr, log_addr) \
             if (!(expr)) { prv_handle_corruption(heap, log_addr); }
 
+//! Blocks smaller than this many alignment units each have a free list of their exact size.
+//! Larger blocks are binned by powers of two.
+#define FREE_LIST_EXACT_SIZES   (16)
+#define FREE_LIST_EXACT_SIZES_LOG2 (4)
+
+//! Marks the end of a free list
+#define FREE_LIST_NIL           (0xFFFF)
+
+_Static_assert(FREE_LIST_EXACT_SIZES + (15 - FREE_LIST_EXACT_SIZES_LOG2) == HEAP_NUM_FREE_LISTS,
+               "HEAP_NUM_FREE_LISTS doesn't cover SEGMENT_SIZE_MAX");
+
+//! The links of a free block, stored in place of its data. Offsets are from heap->begin in
+//! alignment units, which always fit in 16 bits since blocks are at most SEGMENT_SIZE_MAX units.
+typedef struct HeapFreeListNode {
+  uint16_t next;
+  uint16_t prev;
+} HeapFreeListNode;
+
+_Static_assert(sizeof(HeapFreeListNode) <= ALIGNMENT_SIZE * MINIMUM_MEMORY_SIZE,
+               "Free list links don't fit in the smallest block");
+
 //! Lock the heap, using whatever behaviour the heap has configured using heap_set_lock_impl
 static void heap_lock(Heap* heap) {
   if (heap->lock_impl.lock_function) {
@@ -109,6 +130,7 @@ static void prv_handle_corruption(Heap * const heap, void *ptr) {
 }
 
 static HeapInfo_t *find_segment(Heap* const heap, unsigned long n_units);
+static void prv_sanity_check_block(Heap * const heap, HeapInfo_t *block);
 static HeapInfo_t *allocate_block(Heap* const heap, unsigned long n_units, HeapInfo_t* heap_info_ptr);
 
 //! Advance the block pointer to the next block.
@@ -123,6 +145,133 @@ static HeapInfo_t* get_previous_block(Heap * const heap, HeapInfo_t* block) {
   return (HeapInfo_t *)(((Alignment_t *)block) - block->PrevSize);
 }
 
+// Free lists
+///////////////////////////////////////////////////////////
+
+static HeapFreeListNode *prv_free_list_node(HeapInfo_t *block) {
+  return (HeapFreeListNode *)&block->Data;
+}
+
+static uint16_t prv_block_offset(Heap * const heap, HeapInfo_t *block) {
+  return ((Alignment_t *)block) - ((Alignment_t *)heap->begin);
+}
+
+static HeapInfo_t *prv_block_at_offset(Heap * const heap, uint16_t offset) {
+  return (HeapInfo_t *)(((Alignment_t *)heap->begin) + offset);
+}
+
+static unsigned int prv_free_list_index(unsigned long n_units) {
+  if (n_units < FREE_LIST_EXACT_SIZES) {
+    return n_units;
+  }
+  const unsigned int log2_units = 31 - __builtin_clz(n_units);
+  return FREE_LIST_EXACT_SIZES + log2_units - FREE_LIST_EXACT_SIZES_LOG2;
+}
+
+//! A free list link is sane if it is the end of the list or points at a free block in the heap.
+//! Links live in freed memory, so a write after free shows up here.
+static bool prv_free_list_link_is_sane(Heap * const heap, uint16_t offset) {
+  if (offset == FREE_LIST_NIL) {
+    return true;
+  }
+  HeapInfo_t *block = prv_block_at_offset(heap, offset);
+  return (block < heap->end) && !block->is_allocated;
+}
+
+//! The free lists can't be trusted anymore. Report it and go back to searching the heap.
+static void prv_free_lists_corrupt(Heap * const heap, HeapInfo_t *block) {
+  heap->use_free_lists = false;
+  prv_handle_corruption(heap, block);
+}
+
+static void prv_free_list_insert(Heap * const heap, HeapInfo_t *block) {
+  if (!heap->use_free_lists) {
+    return;
+  }
+  const unsigned int index = prv_free_list_index(block->Size);
+  const uint16_t offset = prv_block_offset(heap, block);
+  const uint16_t head = heap->free_lists[index];
+
+  *prv_free_list_node(block) = (HeapFreeListNode) {
+    .next = head,
+    .prev = FREE_LIST_NIL,
+  };
+  if (head != FREE_LIST_NIL) {
+    prv_free_list_node(prv_block_at_offset(heap, head))->prev = offset;
+  }
+  heap->free_lists[index] = offset;
+  heap->free_list_bitmap |= (1u << index);
+}
+
+//! Must be called before the size of the block changes, as that determines its free list.
+static void prv_free_list_remove(Heap * const heap, HeapInfo_t *block) {
+  if (!heap->use_free_lists) {
+    return;
+  }
+  const unsigned int index = prv_free_list_index(block->Size);
+  const uint16_t offset = prv_block_offset(heap, block);
+  const HeapFreeListNode node = *prv_free_list_node(block);
+
+  if (!prv_free_list_link_is_sane(heap, node.next) ||
+      !prv_free_list_link_is_sane(heap, node.prev)) {
+    prv_free_lists_corrupt(heap, block);
+    return;
+  }
+
+  if (node.prev == FREE_LIST_NIL) {
+    if (heap->free_lists[index] != offset) {
+      prv_free_lists_corrupt(heap, block);
+      return;
+    }
+    heap->free_lists[index] = node.next;
+    if (node.next == FREE_LIST_NIL) {
+      heap->free_list_bitmap &= ~(1u << index);
+    }
+  } else {
+    prv_free_list_node(prv_block_at_offset(heap, node.prev))->next = node.next;
+  }
+  if (node.next != FREE_LIST_NIL) {
+    prv_free_list_node(prv_block_at_offset(heap, node.next))->prev = node.prev;
+  }
+}
+
+//! Finds a free block that fits n_units using the free lists.
+//! @return The block, or heap->end if there is none.
+static HeapInfo_t *prv_free_list_find(Heap * const heap, unsigned long n_units) {
+  unsigned int index = prv_free_list_index(n_units);
+
+  if (index >= FREE_LIST_EXACT_SIZES) {
+    // Blocks in this list may be smaller than requested, take the first one that fits
+    uint16_t offset = heap->free_lists[index];
+    while (offset != FREE_LIST_NIL) {
+      if (!prv_free_list_link_is_sane(heap, offset)) {
+        prv_free_lists_corrupt(heap, prv_block_at_offset(heap, offset));
+        return heap->end;
+      }
+      HeapInfo_t *block = prv_block_at_offset(heap, offset);
+      if (block->Size >= n_units) {
+        return block;
+      }
+      offset = prv_free_list_node(block)->next;
+    }
+    index++;
+  }
+
+  // Any block in this or a larger size class fits
+  const uint32_t candidates = heap->free_list_bitmap & ~((1u << index) - 1);
+  if (candidates == 0) {
+    return heap->end;
+  }
+  const uint16_t offset = heap->free_lists[__builtin_ctz(candidates)];
+  if ((offset == FREE_LIST_NIL) || !prv_free_list_link_is_sane(heap, offset)) {
+    prv_free_lists_corrupt(heap, heap->begin);
+    return heap->end;
+  }
+  HeapInfo_t *block = prv_block_at_offset(heap, offset);
+  prv_sanity_check_block(heap, block);
+  return block;
+}
+
 static void prv_calc_totals(Heap* const heap, unsigned int *used, unsigned int *free, unsigned int *max_free) {
   HeapInfo_t    *heap_info_ptr;
   uint16_t      free_segments;
@@ -220,6 +369,24 @@ void heap_set_corruption_handler(Heap *heap, CorruptionHandler corruption_handle
   heap->corruption_handler = corruption_handler;
 }
 
+void heap_enable_free_lists(Heap *heap) {
+  UTIL_ASSERT(heap->begin);
+
+  heap_lock(heap);
+  heap->use_free_lists = true;
+  heap->free_list_bitmap = 0;
+  memset(heap->free_lists, 0xFF, sizeof(heap->free_lists));
+
+  HeapInfo_t *block = heap->begin;
+  while (block < heap->end) {
+    if (!block->is_allocated) {
+      prv_free_list_insert(heap, block);
+    }
+    block = get_next_block(heap, block);
+  }
+  heap_unlock(heap);
+}
+
 void *heap_malloc(Heap* const heap, unsigned long nbytes, uintptr_t client_pc) {
   // Check to make sure the heap we have is initialized.
   UTIL_ASSERT(heap->begin);
@@ -323,6 +490,8 @@ void heap_free(Heap* const heap, void *ptr, uintptr_t client_pc) {
 
       /* Check to see if the previous segment can be combined. */
       if(!previous_block->is_allocated) {
+        prv_free_list_remove(heap, previous_block);
+
         /* Add the segment to be freed to the new beginer.     */
         previous_block->Size += heap_info_ptr->Size;
 
@@ -353,6 +522,7 @@ void heap_free(Heap* const heap, void *ptr, uintptr_t client_pc) {
       } else {
         /* The next segment is free, so merge it with the     */
         /* current segment.                                   */
+        prv_free_list_remove(heap, next_block);
         heap_info_ptr->Size += next_block->Size;
 
         /* Since we merged the next segment, we have to update*/
@@ -369,6 +539,8 @@ void heap_free(Heap* const heap, void *ptr, uintptr_t client_pc) {
         }
       }
     }
+
+    prv_free_list_insert(heap, heap_info_ptr);
   }
   heap_unlock(heap);
 }
@@ -414,6 +586,10 @@ static void prv_sanity_check_block(Heap * const heap, HeapInfo_t *block) {
 //! Finds a segment where data of the size n_units  will fit.
 //!     @param n_units number of ALIGNMENT_SIZE units this segment requires.
 static HeapInfo_t *find_segment(Heap* const heap, unsigned long n_units) {
+  if (heap->use_free_lists) {
+    return prv_free_list_find(heap, n_units);
+  }
+
   HeapInfo_t *heap_info_ptr = NULL;
   /* If we are allocating a large segment, then start at the  */
   /* end of the heap.  Otherwise, start at the beginning of   */
@@ -490,6 +666,8 @@ static HeapInfo_t *allocate_block(Heap* const heap, unsigned long n_units, HeapI
     return NULL;
   }
 
+  prv_free_list_remove(heap, heap_info_ptr);
+
   /* Check to see if we need to split this into two        */
   /* entries.                                              */
   /* * NOTE * If there is not enough room to make another  */
@@ -507,11 +685,13 @@ static HeapInfo_t *allocate_block(Heap* const heap, unsigned long n_units, HeapI
   if (n_units >= LARGE_SIZE) {
     HeapInfo_t *second_block = split_block(heap, heap_info_ptr, heap_info_ptr->Size - n_units);
     second_block->is_allocated = true;
+    prv_free_list_insert(heap, heap_info_ptr);
     return second_block;
   }
 
-  split_block(heap, heap_info_ptr, n_units);
+  HeapInfo_t *second_block = split_block(heap, heap_info_ptr, n_units);
   heap_info_ptr->is_allocated = true;
+  prv_free_list_insert(heap, second_block);
   return heap_info_ptr;
 }
 
@@ -36,6 +36,16 @@
 //! \endcode
 uint32_t crc32(uint32_t crc, const void * restrict data, size_t length);
 
+//! Nybble-wide table implementation of \ref crc32, using a 64 byte table.
+//!
+//! This is the reference implementation; it is what \ref crc32 uses on platforms without the
+//! HAS_FAST_CRC32 capability.
+uint32_t crc32_nibble(uint32_t crc, const void * restrict data, size_t length);
+
+//! Slice-by-4 implementation of \ref crc32, using a 4 KiB table and processing a word at a
+//! time. This is what \ref crc32 uses on platforms with the HAS_FAST_CRC32 capability.
+uint32_t crc32_slice_by_4(uint32_t crc, const void * restrict data, size_t length);
+
 //! The initial CRC register value for a standard CRC-32 checksum.
 //!
 //! It is the same value as is returned by the `crc32` function when data is
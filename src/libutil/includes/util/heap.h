@@ -22,6 +22,9 @@ typedef struct HeapLockImpl {
 typedef void (*DoubleFreeHandler)(void*);
 typedef void (*CorruptionHandler)(void*);
 
+//! Number of size classes used by the free lists, see heap_enable_free_lists()
+#define HEAP_NUM_FREE_LISTS (27)
+
 typedef struct Heap {
   // These HeapInfo_t structure pointers are initialized to the start and the end of the heap area.
   // The begin will point to the first block that's in the heap area, where the end is actually a
@@ -42,6 +45,13 @@ typedef struct Heap {
 
   void *corrupt_block;
   CorruptionHandler corruption_handler;
+
+  //! Whether free blocks are tracked in per-size-class free lists, see heap_enable_free_lists()
+  bool use_free_lists;
+  //! Bit n is set if free_lists[n] is non-empty
+  uint32_t free_list_bitmap;
+  //! Heads of the free lists, as offsets from begin in alignment units
+  uint16_t free_lists[HEAP_NUM_FREE_LISTS];
 } Heap;
 
 //! Initialize the heap inside the specified boundaries, zero-ing out the free
@@ -61,6 +71,14 @@ void heap_set_lock_impl(Heap *heap, HeapLockImpl lock_impl);
 //! If this isn't configured on a heap, the default behaviour is to trigger a PBL_CROAK.
 void heap_set_double_free_handler(Heap *heap, DoubleFreeHandler double_free_handler);
 
+//! Track the free blocks of this heap in free lists binned by size class, instead of searching
+//! the whole heap for a fitting block on every allocation. Small allocations are served from
+//! their exact size class in constant time and larger ones from a power of two size class.
+//! Must be called after heap_init().
+//!     @note The free list links are stored in the first bytes of each free block, so a heap
+//!           whose users may access memory after freeing it should not enable this.
+void heap_enable_free_lists(Heap *heap);
+
 //! Configure the heap with a pointer that gets called when (and if) corruption is detected.
 //! If this isn't configured on a heap, the default behaviour is to trigger a PBL_CROAK.
 void heap_set_corruption_handler(Heap *heap, CorruptionHandler corruption_handler);
@@ -15,3 +15,11 @@ typedef int (*SortComparator)(const void *, const void *);
 //! @param[in] elem_size Size of each element in the array
 //! @param[in] comp SortComparator comparator function
 void sort_bubble(void *array, size_t num_elem, size_t elem_size, SortComparator comp);
+
+//! Heap sorts an array in place, O(n log n) without any extra memory
+//! @note The sort is not stable, elements that compare equal can end up in any order
+//! @param[in] array The array that should be sorted
+//! @param[in] num_elem Number of elements in the array
+//! @param[in] elem_size Size of each element in the array
+//! @param[in] comp SortComparator comparator function
+void sort_heap(void *array, size_t num_elem, size_t elem_size, SortComparator comp);
@@ -29,3 +29,34 @@ void sort_bubble(void *array, size_t num_elem, size_t elem_size, SortComparator
     }
   }
 }
+
+static void prv_sift_down(uint8_t *array, size_t root, size_t num_elem, size_t elem_size,
+                          SortComparator comp) {
+  for (;;) {
+    size_t largest = root;
+    const size_t left = 2 * root + 1;
+    const size_t right = left + 1;
+    if (left < num_elem && comp(array + left * elem_size, array + largest * elem_size) > 0) {
+      largest = left;
+    }
+    if (right < num_elem && comp(array + right * elem_size, array + largest * elem_size) > 0) {
+      largest = right;
+    }
+    if (largest == root) {
+      return;
+    }
+    prv_swap(array + root * elem_size, array + largest * elem_size, elem_size);
+    root = largest;
+  }
+}
+
+void sort_heap(void *array, size_t num_elem, size_t elem_size, SortComparator comp) {
+  uint8_t *bytes = (uint8_t *)array;
+  for (size_t i = num_elem / 2; i > 0; i--) {
+    prv_sift_down(bytes, i - 1, num_elem, elem_size, comp);
+  }
+  for (size_t end = num_elem; end > 1; end--) {
+    prv_swap(bytes, bytes + (end - 1) * elem_size, elem_size);
+    prv_sift_down(bytes, 0, end - 1, elem_size, comp);
+  }
+}
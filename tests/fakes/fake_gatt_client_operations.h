@@ -18,6 +18,13 @@ void fake_gatt_client_op_assert_read(BLECharacteristic characteristic,
 
 void fake_gatt_client_op_set_write_return_value(BTErrno e);
 
+typedef BTErrno (*FakeGATTClientOpWriteCallback)(BLECharacteristic characteristic,
+                                                 const uint8_t *value, size_t value_length);
+
+//! Hands writes to the callback instead of recording them for fake_gatt_client_op_assert_write().
+//! Pass NULL to go back to recording.
+void fake_gatt_client_op_set_write_callback(FakeGATTClientOpWriteCallback cb);
+
 void fake_gatt_client_op_clear_write_list(void);
 
 void fake_gatt_client_op_assert_no_write(void);
@@ -8,13 +8,15 @@
 #include "kernel/pbl_malloc.h"
 #include "services/common/put_bytes/put_bytes_storage_internal.h"
 #include "system/passert.h"
+#include "util/crc32.h"
+#include "util/legacy_checksum.h"
 
 #define FAKE_STORAGE_MAX_SIZE (512 * 1024)
 
 typedef struct FakePutBytesStorageData {
   PutBytesStorageInfo *info;
   bool last_is_success;
-  uint32_t crc;
+  int calculate_crc_count;
   uint32_t total_size;
   uint8_t buffer[FAKE_STORAGE_MAX_SIZE];
 } FakePutBytesStorageData;
@@ -30,8 +32,10 @@ static bool fake_pb_storage_mem_init(PutBytesStorage *storage, PutBytesObjectTyp
                                      uint32_t append_offset) {
   // This fake only supports one put bytes storage to be init'd at a time.
   PBL_ASSERTN(!s_storage_data.total_size);
-  size_t buffer_size = total_size + sizeof(FirmwareDescription);
-  memset(s_storage_data.buffer, 0, sizeof(s_storage_data.buffer));
+  size_t buffer_size = total_size + sizeof(FirmwareDescription) + append_offset;
+  if (append_offset == 0) {
+    memset(s_storage_data.buffer, 0, sizeof(s_storage_data.buffer));
+  }
   s_storage_data.total_size = buffer_size;
   PutBytesStorageInfo *info_copy = NULL;
   if (info) {
@@ -42,7 +46,7 @@ static bool fake_pb_storage_mem_init(PutBytesStorage *storage, PutBytesObjectTyp
   storage->impl_data = &s_storage_data;
 
   // put_bytes_storage_raw.c is weird, it reserves space at the beginning for FirmwareDescription:
-  storage->current_offset = sizeof(FirmwareDescription);
+  storage->current_offset = sizeof(FirmwareDescription) + append_offset;
   return true;
 }
 
@@ -64,9 +68,22 @@ static void fake_pb_storage_mem_write(PutBytesStorage *storage, uint32_t offset,
   memcpy(s_storage_data.buffer + offset, buffer, length);
 }
 
+static void fake_pb_storage_mem_read(PutBytesStorage *storage, uint32_t offset, uint8_t *buffer,
+                                     uint32_t length) {
+  PBL_ASSERTN(offset + length <= s_storage_data.total_size);
+  memcpy(buffer, s_storage_data.buffer + offset, length);
+}
+
 static uint32_t fake_pb_storage_mem_calculate_crc(PutBytesStorage *storage, PutBytesCrcType crc_type) {
   PBL_ASSERTN(storage->impl_data == &s_storage_data);
-  return s_storage_data.crc;
+  ++s_storage_data.calculate_crc_count;
+
+  const uint8_t *data = s_storage_data.buffer + sizeof(FirmwareDescription);
+  const size_t length = storage->current_offset - sizeof(FirmwareDescription);
+  if (crc_type == PutBytesCrcType_Legacy) {
+    return legacy_defective_checksum_memory(data, length);
+  }
+  return crc32(CRC32_INIT, data, length);
 }
 
 static void prv_cleanup(void) {
@@ -85,6 +102,7 @@ const PutBytesStorageImplementation s_raw_implementation = {
   .init = fake_pb_storage_mem_init,
   .get_max_size = fake_pb_storage_mem_get_max_size,
   .write = fake_pb_storage_mem_write,
+  .read = fake_pb_storage_mem_read,
   .calculate_crc = fake_pb_storage_mem_calculate_crc,
   .deinit = fake_pb_storage_mem_deinit,
 };
@@ -109,8 +127,8 @@ void fake_pb_storage_mem_reset(void) {
   s_storage_data = (FakePutBytesStorageData) {};
 }
 
-void fake_pb_storage_mem_set_crc(uint32_t crc) {
-  s_storage_data.crc = crc;
+int fake_pb_storage_mem_get_calculate_crc_count(void) {
+  return s_storage_data.calculate_crc_count;
 }
 
 bool fake_pb_storage_mem_get_last_success(void) {
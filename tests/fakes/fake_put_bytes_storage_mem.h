@@ -13,7 +13,8 @@ uint32_t fake_pb_storage_mem_get_max_size(PutBytesObjectType object_type);
 
 void fake_pb_storage_mem_reset(void);
 
-void fake_pb_storage_mem_set_crc(uint32_t crc);
+//! The number of times the object was read back to calculate its CRC
+int fake_pb_storage_mem_get_calculate_crc_count(void);
 
 bool fake_pb_storage_mem_get_last_success(void);
 
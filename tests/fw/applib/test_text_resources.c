@@ -13,6 +13,7 @@
 
 // Fakes
 #include "fake_app_manager.h"
+#include "fake_spi_flash.h"
 
 // Stubs
 #include "stubs_analytics.h"
@@ -57,12 +58,6 @@ void test_text_resources__initialize(void) {
   memset(&s_font_info, 0, sizeof(s_font_info));
   memset(&s_font_cache, 0, sizeof(s_font_cache));
 
-  FontCache *font_cache = &s_font_cache;
-  memset(font_cache->cache_keys, 0, sizeof(font_cache->cache_keys));
-  memset(font_cache->cache_data, 0, sizeof(font_cache->cache_data));
-  keyed_circular_cache_init(&font_cache->line_cache, font_cache->cache_keys,
-                            font_cache->cache_data, sizeof(LineCacheData), LINE_CACHE_SIZE);
-
   resource_init();
 }
 
@@ -313,3 +308,68 @@ void test_text_resources__test_glyph_decompression(void) {
     }
   }
 }
+
+//! Looks up the horizontal advance of every character of text, like text layout does
+static void prv_measure_text(FontCache *font_cache, const char *text) {
+  for (const char *c = text; *c; c++) {
+    text_resources_get_glyph_horiz_advance(font_cache, *c, &s_font_info);
+  }
+}
+
+void test_text_resources__recently_used_glyphs_stay_cached(void) {
+  cl_assert(text_resources_init_font(0, RESOURCE_ID_GOTHIC_18, 0, &s_font_info));
+  prv_measure_text(&s_font_cache, "a");
+
+  // Cycle through more glyphs than the cache holds, using 'a' in between
+  for (char c = 'A'; c < 'A' + LINE_CACHE_SIZE * 2; c++) {
+    prv_measure_text(&s_font_cache, (char[]) { c, 'a', '\0' });
+  }
+
+  const uint32_t reads = fake_flash_read_count();
+  prv_measure_text(&s_font_cache, "a");
+  cl_assert_equal_i(fake_flash_read_count(), reads);
+}
+
+// The text of the test_text_layout tests, each one makes up a screen
+static const char *s_layout_screens[] = {
+  "Twitter\n@pebble is talking about a lot of really really cool important stuff.\n",
+  "Twitter\n\n\n\n\n\n\n\n",
+  "Twitter    \n   \n \n\n   \n \n \n\n     ",
+  "JR Whopper",
+  "JR Whopper 123",
+};
+
+//! Lays out and renders every screen num_passes times, returns the number of glyph flash reads
+static uint32_t prv_render_screens(int num_passes, bool keep_cache) {
+  const uint32_t start_reads = fake_flash_read_count();
+  for (int pass = 0; pass < num_passes; pass++) {
+    for (unsigned int i = 0; i < ARRAY_LENGTH(s_layout_screens); i++) {
+      if (!keep_cache) {
+        memset(&s_font_cache, 0, sizeof(s_font_cache));
+      }
+      // Lay the text out, then render it
+      prv_measure_text(&s_font_cache, s_layout_screens[i]);
+      for (const char *c = s_layout_screens[i]; *c; c++) {
+        cl_assert(text_resources_get_glyph(&s_font_cache, *c, &s_font_info));
+      }
+    }
+  }
+  return fake_flash_read_count() - start_reads;
+}
+
+void test_text_resources__flash_reads_per_screen(void) {
+  cl_assert(text_resources_init_font(0, RESOURCE_ID_GOTHIC_18, 0, &s_font_info));
+  const int num_passes = 10;
+
+  // Every screen starts with an empty glyph cache
+  const uint32_t uncached_reads = prv_render_screens(num_passes, false /* keep_cache */);
+
+  // Glyphs stay cached from one screen to the next, which saves at least a third of the reads
+  memset(&s_font_cache, 0, sizeof(s_font_cache));
+  const uint32_t cached_reads = prv_render_screens(num_passes, true /* keep_cache */);
+  cl_assert(cached_reads * 3 < uncached_reads * 2);
+
+  // Most lookups are served by the cache
+  const LRUCache *cache = &s_font_cache.line_cache;
+  cl_assert(cache->hits >= 4 * cache->misses);
+}
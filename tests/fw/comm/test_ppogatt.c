@@ -6,6 +6,7 @@
 #include "services/common/comm_session/session_transport.h"
 #include "services/common/regular_timer.h"
 
+#include <util/math.h>
 #include <util/size.h>
 
 #include "clar.h"
@@ -32,6 +33,7 @@
 #include "fake_gatt_client_subscriptions.h"
 #include "fake_new_timer.h"
 #include "fake_pbl_malloc.h"
+#include "fake_rtc.h"
 #include "fake_session.h"
 #include "fake_system_task.h"
 
@@ -66,6 +68,34 @@ void launcher_task_add_callback(void (*callback)(void *data), void *data) {
   callback(data);
 }
 
+uint16_t gatt_client_characteristic_get_handle_and_connection(BLECharacteristic characteristic_ref,
+                                                              GAPLEConnection **connection_out) {
+  return 0;
+}
+
+BTErrno bt_driver_gatt_write_without_response(GAPLEConnection *connection, const uint8_t *value,
+                                              size_t value_length, uint16_t att_handle) {
+  return BTErrnoOK;
+}
+
+static uint8_t s_analytics_tx_window;
+static uint8_t s_analytics_max_tx_window;
+static uint32_t s_analytics_rtt_ms;
+static uint32_t s_analytics_retransmits;
+
+void comm_session_analytics_set_tx_window(CommSession *session, uint8_t num_packets) {
+  s_analytics_tx_window = num_packets;
+  s_analytics_max_tx_window = MAX(s_analytics_max_tx_window, num_packets);
+}
+
+void comm_session_analytics_set_rtt(CommSession *session, uint32_t rtt_ms) {
+  s_analytics_rtt_ms = rtt_ms;
+}
+
+void comm_session_analytics_inc_retransmits(CommSession *session, uint16_t num_packets) {
+  s_analytics_retransmits += num_packets;
+}
+
 // Helpers
 ///////////////////////////////////////////////////////////
 
@@ -285,6 +315,11 @@ void test_ppogatt__initialize(void) {
   fake_gatt_client_subscriptions_init();
   regular_timer_init();
   fake_comm_session_init();
+  fake_rtc_init(0, 0);
+  s_analytics_tx_window = 0;
+  s_analytics_max_tx_window = 0;
+  s_analytics_rtt_ms = 0;
+  s_analytics_retransmits = 0;
   ppogatt_create();
 }
 
@@ -1091,3 +1126,364 @@ void test_ppogatt__mtu_zero_due_to_service_rediscovery_while_resetting(void) {
 void test_ppogatt__unsubcribe_when_no_memory_for_comm_session(void) {
   // TODO
 }
+
+// Congestion window & Ack coalescing
+///////////////////////////////////////////////////////////
+
+//! Smallest GATT MTU, with which a V1 client negotiates its largest TX window
+#define SMALL_MTU_SIZE (23)
+#define SMALL_MTU_MAX_PAYLOAD_SIZE (SMALL_MTU_SIZE - 3 /* ATT Header */ - 1 /* PPoGATT Header */)
+
+static void prv_open_session_with_mtu(uint16_t mtu_size) {
+  s_mtu_size = mtu_size;
+  prv_discover_and_read_meta_and_reset();
+  prv_receive_reset_complete(s_characteristics[0][PPoGATTCharacteristicData]);
+  fake_gatt_client_op_clear_write_list();
+  cl_assert_equal_i(fake_comm_session_open_call_count(), 1);
+}
+
+static uint8_t prv_expected_max_tx_window(void) {
+  if (s_ppogatt_version == 0) {
+    return PPOGATT_V0_WINDOW_SIZE;
+  }
+  return MIN(PPOGATT_SN_MOD_DIV - 1, s_tx_window_size);
+}
+
+static uint8_t prv_expected_rx_window(void) {
+  if (s_ppogatt_version == 0) {
+    return PPOGATT_V0_WINDOW_SIZE;
+  }
+  return MIN(MIN(PPOGATT_V1_DESIRED_RX_WINDOW_SIZE, PPOGATT_SN_MOD_DIV - 1), s_rx_window_size);
+}
+
+static uint32_t s_num_data_writes;
+static uint8_t s_last_data_sn;
+
+static BTErrno prv_count_data_write_cb(BLECharacteristic characteristic,
+                                       const uint8_t *value, size_t value_length) {
+  const PPoGATTPacket *packet = (const PPoGATTPacket *)value;
+  if (packet->type == PPoGATTPacketTypeData) {
+    ++s_num_data_writes;
+    s_last_data_sn = packet->sn;
+  }
+  return BTErrnoOK;
+}
+
+//! Keeps plenty of data queued up, so the window is the only thing that limits sending
+static void prv_fill_send_buffer_and_send(Transport *transport) {
+  while (fake_comm_session_send_buffer_write_raw_by_transport(transport, s_short_data_fragment,
+                                                              sizeof(s_short_data_fragment))) {
+  }
+  ppogatt_send_next(transport);
+  fake_comm_session_process_send_next();
+}
+
+void test_ppogatt__congestion_window_grows_on_acks_and_shrinks_on_roll_back(void) {
+  prv_open_session_with_mtu(SMALL_MTU_SIZE);
+  Transport *transport = ppogatt_client_for_uuid(&s_meta_v0_system.app_uuid);
+  fake_gatt_client_op_set_write_callback(prv_count_data_write_cb);
+
+  // Starts out with the window that every server can handle:
+  cl_assert_equal_i(s_analytics_tx_window, PPOGATT_V0_WINDOW_SIZE);
+  prv_fill_send_buffer_and_send(transport);
+  cl_assert_equal_i(s_num_data_writes, PPOGATT_V0_WINDOW_SIZE);
+
+  // Ack'd packets open up the window, until the negotiated size is reached:
+  do {
+    fake_rtc_increment_ticks(RTC_TICKS_HZ / 10);
+    s_num_data_writes = 0;
+    prv_receive_ack(s_characteristics[0][PPoGATTCharacteristicData], s_last_data_sn);
+    prv_fill_send_buffer_and_send(transport);
+    cl_assert_equal_i(s_num_data_writes, s_analytics_tx_window);
+  } while (s_analytics_tx_window < prv_expected_max_tx_window());
+  cl_assert_equal_i(s_analytics_tx_window, prv_expected_max_tx_window());
+  cl_assert_equal_i(s_analytics_retransmits, 0);
+  // ~100ms between sending the packets and receiving the Acks:
+  cl_assert(s_analytics_rtt_ms >= 90 && s_analytics_rtt_ms <= 110);
+
+  // Time-out all packets in flight, the window is halved (but never below the V0 window size):
+  const uint32_t num_in_flight = s_num_data_writes;
+  for (int i = 0; i < PPOGATT_TIMEOUT_TICKS; ++i) {
+    regular_timer_fire_seconds(PPOGATT_TIMEOUT_TICK_INTERVAL_SECS);
+  }
+  cl_assert_equal_i(s_analytics_retransmits, num_in_flight);
+  cl_assert_equal_i(s_analytics_tx_window,
+                    MAX(prv_expected_max_tx_window() / 2, PPOGATT_V0_WINDOW_SIZE));
+}
+
+void test_ppogatt__fast_retransmit_after_repeated_acks(void) {
+  test_ppogatt__open_session_when_found_pebble_app();
+  Transport *transport = ppogatt_client_for_uuid(&s_meta_v0_system.app_uuid);
+
+  // Get s_tx_window_size packets in flight, with one more queued up:
+  for (uint8_t sn = 0; sn <= s_tx_window_size; ++sn) {
+    cl_assert_equal_b(fake_comm_session_send_buffer_write_raw_by_transport(
+        transport, s_short_data_fragment, sizeof(s_short_data_fragment) - sn), true);
+    ppogatt_send_next(transport);
+  }
+  prv_receive_ack(s_characteristics[0][PPoGATTCharacteristicData], 0 /* sn */);
+  for (uint8_t sn = 0; sn <= s_tx_window_size; ++sn) {
+    prv_assert_sent_data(s_characteristics[0][PPoGATTCharacteristicData], sn,
+                         s_short_data_fragment, sizeof(s_short_data_fragment) - sn);
+  }
+
+  // sn=1 got lost, the server re-Acks sn=0 for every packet that arrives after it:
+  for (uint8_t i = 0; i < PPOGATT_FAST_RETRANSMIT_DUP_ACK_COUNT; ++i) {
+    prv_receive_ack(s_characteristics[0][PPoGATTCharacteristicData], 0 /* sn */);
+  }
+  fake_comm_session_process_send_next();
+
+  if (s_ppogatt_version == 0) {
+    // Relies on the Ack timeout
+    fake_gatt_client_op_assert_no_write();
+    cl_assert_equal_i(s_analytics_retransmits, 0);
+    return;
+  }
+  for (uint8_t sn = 1; sn <= s_tx_window_size; ++sn) {
+    prv_assert_sent_data(s_characteristics[0][PPoGATTCharacteristicData], sn,
+                         s_short_data_fragment, sizeof(s_short_data_fragment) - sn);
+  }
+  cl_assert_equal_i(s_analytics_retransmits, s_tx_window_size);
+
+  // Only once, until something new gets Ack'd:
+  prv_receive_ack(s_characteristics[0][PPoGATTCharacteristicData], 0 /* sn */);
+  fake_comm_session_process_send_next();
+  fake_gatt_client_op_assert_no_write();
+  cl_assert_equal_i(fake_comm_session_close_call_count(), 0);
+}
+
+void test_ppogatt__coalesce_acks_for_received_data(void) {
+  test_ppogatt__open_session_when_found_pebble_app();
+  const uint8_t ack_interval =
+      (s_ppogatt_version == 0) ? 1 : MAX(prv_expected_rx_window() / 2, 1);
+
+  for (uint8_t sn = 0; sn < 4 * ack_interval; ++sn) {
+    prv_receive_short_data_fragment(s_characteristics[0][PPoGATTCharacteristicData], sn);
+    if ((sn + 1) % ack_interval == 0) {
+      // One Ack for the last packet covers all the packets before it:
+      prv_assert_sent_ack(s_characteristics[0][PPoGATTCharacteristicData], sn);
+    }
+    fake_gatt_client_op_assert_no_write();
+  }
+}
+
+void test_ppogatt__flush_coalesced_ack_on_missing_inbound_packet(void) {
+  test_ppogatt__open_session_when_found_pebble_app();
+  if (s_ppogatt_version == 0 || prv_expected_rx_window() / 2 <= 1) {
+    // Every packet is Ack'd right away, nothing to coalesce
+    return;
+  }
+
+  prv_receive_short_data_fragment(s_characteristics[0][PPoGATTCharacteristicData], 0 /* sn */);
+  fake_gatt_client_op_assert_no_write();
+
+  // sn=1 went missing, let the server know sn=0 made it without waiting for the Ack timer:
+  prv_receive_short_data_fragment(s_characteristics[0][PPoGATTCharacteristicData], 2 /* sn */);
+  prv_assert_sent_ack(s_characteristics[0][PPoGATTCharacteristicData], 0 /* sn */);
+  fake_gatt_client_op_assert_no_write();
+}
+
+// Fake GATT link
+///////////////////////////////////////////////////////////
+// Simulates the link to the phone, with a one-way latency, a fixed time on air per packet and
+// every Nth packet in either direction (data or Ack) getting lost. The losses are spread out
+// evenly to keep the results reproducible; bursts that hit a retransmission too would only
+// measure how long it takes to reset the session. Like the PPoGATT server, the phone Acks
+// every in-order data packet and re-Acks the last in-order one when something else arrives.
+
+#define SIM_LINK_MAX_PACKETS (64)
+#define SIM_TRANSFER_SIZE (16 * 1024)
+#define SIM_TIME_LIMIT_MS (10 * 60 * 1000)
+
+typedef struct {
+  uint32_t latency_ms;
+  uint32_t airtime_ms;
+  //! Every Nth packet gets lost, 0 for none
+  uint32_t loss_interval;
+} SimLinkParams;
+
+typedef struct {
+  uint32_t deliver_at_ms;
+  uint16_t length;
+  uint8_t data[MTU_SIZE];
+} SimPacket;
+
+typedef struct {
+  SimPacket packets[SIM_LINK_MAX_PACKETS];
+  uint32_t head;
+  uint32_t count;
+  uint32_t num_sent;
+  uint32_t busy_until_ms;
+} SimLink;
+
+static struct {
+  SimLinkParams params;
+  uint32_t now_ms;
+  SimLink to_phone;
+  SimLink to_watch;
+  uint8_t phone_next_expected_sn;
+  uint32_t phone_bytes_received;
+} s_sim;
+
+static uint8_t prv_sim_data_byte(uint32_t offset) {
+  return (offset * 7) & 0xff;
+}
+
+static bool prv_sim_link_send(SimLink *link, const uint8_t *value, size_t length) {
+  if (link->count == SIM_LINK_MAX_PACKETS) {
+    return false;
+  }
+  link->busy_until_ms = MAX(link->busy_until_ms, s_sim.now_ms) + s_sim.params.airtime_ms;
+  ++link->num_sent;
+  if (s_sim.params.loss_interval && (link->num_sent % s_sim.params.loss_interval) == 0) {
+    return true;
+  }
+  SimPacket *packet = &link->packets[(link->head + link->count++) % SIM_LINK_MAX_PACKETS];
+  cl_assert(length <= sizeof(packet->data));
+  packet->deliver_at_ms = link->busy_until_ms + s_sim.params.latency_ms;
+  packet->length = length;
+  memcpy(packet->data, value, length);
+  return true;
+}
+
+static SimPacket *prv_sim_link_receive(SimLink *link) {
+  if (link->count == 0) {
+    return NULL;
+  }
+  SimPacket *packet = &link->packets[link->head];
+  if (packet->deliver_at_ms > s_sim.now_ms) {
+    return NULL;
+  }
+  link->head = (link->head + 1) % SIM_LINK_MAX_PACKETS;
+  --link->count;
+  return packet;
+}
+
+static BTErrno prv_sim_write_cb(BLECharacteristic characteristic,
+                                const uint8_t *value, size_t value_length) {
+  cl_assert_equal_i(characteristic, s_characteristics[0][PPoGATTCharacteristicData]);
+  return prv_sim_link_send(&s_sim.to_phone, value, value_length) ? BTErrnoOK :
+                                                                   BTErrnoNotEnoughResources;
+}
+
+static void prv_sim_phone_receive(const SimPacket *sim_packet) {
+  const PPoGATTPacket *packet = (const PPoGATTPacket *)sim_packet->data;
+  cl_assert_equal_i(packet->type, PPoGATTPacketTypeData);
+  PPoGATTPacket ack = (const PPoGATTPacket) {
+    .type = PPoGATTPacketTypeAck,
+  };
+  if (packet->sn != s_sim.phone_next_expected_sn) {
+    // Re-Ack the last packet that was received in order:
+    if (s_sim.phone_bytes_received) {
+      ack.sn = (s_sim.phone_next_expected_sn + PPOGATT_SN_MOD_DIV - 1) % PPOGATT_SN_MOD_DIV;
+      prv_sim_link_send(&s_sim.to_watch, (const uint8_t *)&ack, sizeof(ack));
+    }
+    return;
+  }
+  const uint16_t payload_length = sim_packet->length - sizeof(PPoGATTPacket);
+  for (uint16_t i = 0; i < payload_length; ++i) {
+    cl_assert_equal_i(packet->payload[i], prv_sim_data_byte(s_sim.phone_bytes_received + i));
+  }
+  s_sim.phone_bytes_received += payload_length;
+  s_sim.phone_next_expected_sn = (packet->sn + 1) % PPOGATT_SN_MOD_DIV;
+
+  ack.sn = packet->sn;
+  prv_sim_link_send(&s_sim.to_watch, (const uint8_t *)&ack, sizeof(ack));
+}
+
+//! @return The time it took to transfer SIM_TRANSFER_SIZE bytes to the phone, in ms
+static uint32_t prv_sim_transfer(const SimLinkParams *params) {
+  // Time and sequence numbers carry on from the previous transfer:
+  s_sim = (__typeof__(s_sim)) {
+    .params = *params,
+    .now_ms = s_sim.now_ms,
+    .phone_next_expected_sn = s_sim.phone_next_expected_sn,
+  };
+  const uint32_t start_ms = s_sim.now_ms;
+  Transport *transport = ppogatt_client_for_uuid(&s_meta_v0_system.app_uuid);
+  fake_gatt_client_op_set_write_callback(prv_sim_write_cb);
+
+  CommSession *session = comm_session_get_system_session();
+  uint32_t bytes_enqueued = 0;
+  // Done when the phone got everything and the watch got all the Acks for it:
+  while (s_sim.phone_bytes_received < SIM_TRANSFER_SIZE ||
+         comm_session_send_queue_get_length(session) != 0) {
+    cl_assert(s_sim.now_ms - start_ms < SIM_TIME_LIMIT_MS);
+    // Keep the send buffer topped up:
+    uint8_t chunk[32];
+    while (bytes_enqueued < SIM_TRANSFER_SIZE) {
+      const uint32_t chunk_size = MIN(sizeof(chunk), SIM_TRANSFER_SIZE - bytes_enqueued);
+      for (uint32_t i = 0; i < chunk_size; ++i) {
+        chunk[i] = prv_sim_data_byte(bytes_enqueued + i);
+      }
+      if (!fake_comm_session_send_buffer_write_raw_by_transport(transport, chunk, chunk_size)) {
+        break;
+      }
+      bytes_enqueued += chunk_size;
+    }
+    ppogatt_send_next(transport);
+    fake_comm_session_process_send_next();
+
+    SimPacket *packet;
+    while ((packet = prv_sim_link_receive(&s_sim.to_phone))) {
+      prv_sim_phone_receive(packet);
+    }
+    while ((packet = prv_sim_link_receive(&s_sim.to_watch))) {
+      ppogatt_handle_read_or_notification(s_characteristics[0][PPoGATTCharacteristicData],
+                                          packet->data, packet->length, BLEGATTErrorSuccess);
+    }
+    if (s_sim.to_phone.count < SIM_LINK_MAX_PACKETS) {
+      ppogatt_handle_buffer_empty();
+    }
+
+    ++s_sim.now_ms;
+    fake_rtc_set_ticks(((RtcTicks)s_sim.now_ms * RTC_TICKS_HZ) / MS_PER_SECOND);
+    if (s_sim.now_ms % (PPOGATT_TIMEOUT_TICK_INTERVAL_SECS * MS_PER_SECOND) == 0) {
+      regular_timer_fire_seconds(PPOGATT_TIMEOUT_TICK_INTERVAL_SECS);
+    }
+  }
+  // No resets, which would have dropped the session along with any data in it:
+  cl_assert_equal_i(fake_comm_session_open_call_count(), 1);
+  cl_assert_equal_i(fake_comm_session_close_call_count(), 0);
+
+  fake_gatt_client_op_set_write_callback(NULL);
+  return s_sim.now_ms - start_ms;
+}
+
+void test_ppogatt__simulated_link_throughput(void) {
+  prv_open_session_with_mtu(SMALL_MTU_SIZE);
+  s_sim.now_ms = 0;
+  s_sim.phone_next_expected_sn = 0;
+
+  const uint32_t latencies_ms[] = { 15, 50, 100 };
+  const uint32_t loss_intervals[] = { 0, 100, 30 };
+
+  printf("\nPPoGATT v%d throughput, %d byte payloads, %d byte transfers:\n",
+         s_ppogatt_version, SMALL_MTU_MAX_PAYLOAD_SIZE, SIM_TRANSFER_SIZE);
+  printf("latency (ms) | loss (%%) | bytes/s | window (max) | srtt (ms) | retransmits\n");
+  for (uint32_t i = 0; i < ARRAY_LENGTH(latencies_ms); ++i) {
+    for (uint32_t j = 0; j < ARRAY_LENGTH(loss_intervals); ++j) {
+      const SimLinkParams params = {
+        .latency_ms = latencies_ms[i],
+        .airtime_ms = 2,
+        .loss_interval = loss_intervals[j],
+      };
+      s_analytics_max_tx_window = s_analytics_tx_window;
+      const uint32_t retransmits_before = s_analytics_retransmits;
+      const uint32_t elapsed_ms = prv_sim_transfer(&params);
+      const uint32_t retransmits = s_analytics_retransmits - retransmits_before;
+      printf("%12"PRIu32" | %8"PRIu32" | %7"PRIu32" | %6u (%3u) | %9"PRIu32" | %11"PRIu32"\n",
+             params.latency_ms, params.loss_interval ? 100 / params.loss_interval : 0,
+             (SIM_TRANSFER_SIZE * MS_PER_SECOND) / elapsed_ms, s_analytics_tx_window,
+             s_analytics_max_tx_window, s_analytics_rtt_ms, retransmits);
+
+      if (params.loss_interval == 0) {
+        cl_assert_equal_i(retransmits, 0);
+        cl_assert_equal_i(s_analytics_tx_window, prv_expected_max_tx_window());
+      } else {
+        cl_assert(retransmits > 0);
+      }
+      cl_assert(s_analytics_rtt_ms >= params.latency_ms);
+    }
+  }
+}
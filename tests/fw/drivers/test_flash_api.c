@@ -18,10 +18,23 @@
 
 #include "drivers/flash.h"
 #include "drivers/flash/flash_impl.h"
+#include "flash_region/flash_region.h"
+#include "util/math.h"
+
+#include <stdlib.h>
+#include <string.h>
 
 void flash_api_reset_for_test(void);
 TimerID flash_api_get_erase_poll_timer_for_test(void);
 
+// Fake flash contents, the erases only take effect once they're reported as complete so that
+// reads made while an erase is in progress see the old data
+#define FAKE_FLASH_SIZE (4 * SECTOR_SIZE_BYTES)
+#define FAKE_FLASH_PAGE_SIZE (256)
+static uint8_t s_fake_flash[FAKE_FLASH_SIZE];
+static uint32_t s_fake_erase_addr;
+static uint32_t s_fake_erase_size;
+
 
 status_t return_success(void) {
   return S_SUCCESS;
@@ -55,6 +68,8 @@ int erase_subsector_begin_calls = 0;
 status_t erase_subsector_begin_return = S_SUCCESS;
 status_t flash_impl_erase_subsector_begin(FlashAddress addr) {
   erase_subsector_begin_calls++;
+  s_fake_erase_addr = addr & ~(SUBSECTOR_SIZE_BYTES - 1);
+  s_fake_erase_size = SUBSECTOR_SIZE_BYTES;
   return erase_subsector_begin_return;
 }
 
@@ -62,6 +77,8 @@ int erase_sector_begin_calls = 0;
 status_t erase_sector_begin_return = S_SUCCESS;
 status_t flash_impl_erase_sector_begin(FlashAddress addr) {
   erase_sector_begin_calls++;
+  s_fake_erase_addr = addr & ~(SECTOR_SIZE_BYTES - 1);
+  s_fake_erase_size = SECTOR_SIZE_BYTES;
   return erase_sector_begin_return;
 }
 
@@ -69,7 +86,13 @@ int get_erase_status_calls = 0;
 status_t (*get_erase_status_fn)(void) = return_success;
 status_t flash_impl_get_erase_status(void) {
   get_erase_status_calls++;
-  return get_erase_status_fn();
+  status_t status = get_erase_status_fn();
+  if (status == S_SUCCESS && s_fake_erase_size &&
+      s_fake_erase_addr + s_fake_erase_size <= FAKE_FLASH_SIZE) {
+    memset(&s_fake_flash[s_fake_erase_addr], 0xff, s_fake_erase_size);
+    s_fake_erase_size = 0;
+  }
+  return status;
 }
 
 int blank_check_subsector_calls = 0;
@@ -111,11 +134,15 @@ uint32_t flash_impl_get_typical_sector_erase_duration_ms(void) {
 }
 
 status_t flash_impl_get_write_status(void) {
-  return E_UNKNOWN;
+  return S_SUCCESS;
 }
 
+int read_sync_calls = 0;
 status_t flash_impl_read_sync(void *buffer, FlashAddress addr, size_t len) {
-  return E_UNKNOWN;
+  read_sync_calls++;
+  cl_assert(addr + len <= FAKE_FLASH_SIZE);
+  memcpy(buffer, &s_fake_flash[addr], len);
+  return S_SUCCESS;
 }
 
 status_t flash_impl_set_burst_mode(bool enable) {
@@ -128,7 +155,14 @@ status_t flash_impl_unprotect(void) {
 
 int flash_impl_write_page_begin(const void *buffer, FlashAddress addr,
                                 size_t len) {
-  return E_UNKNOWN;
+  const size_t written = MIN(len, FAKE_FLASH_PAGE_SIZE - (addr % FAKE_FLASH_PAGE_SIZE));
+  cl_assert(addr + written <= FAKE_FLASH_SIZE);
+  const uint8_t *data = buffer;
+  for (size_t i = 0; i < written; i++) {
+    // Programming can only clear bits
+    s_fake_flash[addr + i] &= data[i];
+  }
+  return written;
 }
 
 void flash_impl_enable_write_protection(void) {
@@ -197,6 +231,10 @@ void test_flash_api__initialize(void) {
   get_erase_status_fn = return_success;
   blank_check_subsector_calls = 0;
   blank_check_sector_calls = 0;
+  read_sync_calls = 0;
+
+  memset(s_fake_flash, 0xff, sizeof(s_fake_flash));
+  s_fake_erase_size = 0;
 
   flash_api_reset_for_test();
   flash_init();
@@ -251,3 +289,104 @@ void test_flash_api__handle_uncorrectable_erase_error(void) {
   cl_assert(i > 1 && i < 20);
   cl_assert_equal_i(uncorrectable_erase_error_cb_called, true);
 }
+
+///////////////////////////////////////////////////////////////////////
+
+void test_flash_api__small_reads_hit_cache(void) {
+  const uint8_t header[] = { 0x50, 0x46, 0x53, 0x01, 0x02, 0x03 };
+  flash_write_bytes(header, 0x1000, sizeof(header));
+
+  uint8_t buffer[sizeof(header)];
+  flash_read_bytes(buffer, 0x1000, sizeof(buffer));
+  cl_assert_equal_m(buffer, header, sizeof(header));
+  const int first_read_calls = read_sync_calls;
+  cl_assert(first_read_calls > 0);
+
+  for (int i = 0; i < 10; i++) {
+    flash_read_bytes(buffer, 0x1000, sizeof(buffer));
+    cl_assert_equal_m(buffer, header, sizeof(header));
+  }
+#if CAPABILITY_HAS_FLASH_READ_CACHE
+  cl_assert_equal_i(read_sync_calls, first_read_calls);
+#endif
+
+  // Large reads go straight to the flash
+  uint8_t large_buffer[1024];
+  const int large_read_calls = read_sync_calls + 1;
+  flash_read_bytes(large_buffer, 0x1000, sizeof(large_buffer));
+  cl_assert_equal_m(large_buffer, header, sizeof(header));
+  cl_assert_equal_i(read_sync_calls, large_read_calls);
+}
+
+void test_flash_api__read_during_erase_is_not_cached(void) {
+  const uint8_t data[] = { 0x12, 0x34, 0x56, 0x78 };
+  const uint32_t addr = SUBSECTOR_SIZE_BYTES;
+  flash_write_bytes(data, addr, sizeof(data));
+
+  TimerID erase_timer = flash_api_get_erase_poll_timer_for_test();
+  flash_erase_subsector(addr, callback, NULL);
+
+  // The erase hasn't completed yet, so the old data is still there
+  uint8_t buffer[sizeof(data)];
+  flash_read_bytes(buffer, addr, sizeof(buffer));
+  cl_assert_equal_m(buffer, data, sizeof(data));
+
+  for (int i = 0; i < 20 && callback_status != S_SUCCESS; ++i) {
+    cl_assert(stub_new_timer_is_scheduled(erase_timer));
+    stub_new_timer_fire(erase_timer);
+  }
+  cl_assert_equal_i(callback_status, S_SUCCESS);
+
+  const uint8_t erased[sizeof(data)] = { 0xff, 0xff, 0xff, 0xff };
+  flash_read_bytes(buffer, addr, sizeof(buffer));
+  cl_assert_equal_m(buffer, erased, sizeof(erased));
+}
+
+void test_flash_api__cache_coherency(void) {
+  // Shadow copy of what the flash should contain, every read is checked against it
+  static uint8_t s_expected[FAKE_FLASH_SIZE];
+  memset(s_expected, 0xff, sizeof(s_expected));
+
+  // Keep the accesses within a few hundred bytes at the start of two subsectors so that reads,
+  // writes and erases keep hitting the same cache lines
+  const uint32_t window_size = 512;
+  srand(42);
+  int reads = 0;
+  int hits = 0;
+  for (int i = 0; i < 20000; i++) {
+    const int op = rand() % 32;
+    const uint32_t window_addr = (rand() % 2) * SUBSECTOR_SIZE_BYTES;
+    if (op == 0) {
+      if (rand() % 4) {
+        flash_erase_subsector_blocking(window_addr);
+        memset(&s_expected[window_addr], 0xff, SUBSECTOR_SIZE_BYTES);
+      } else {
+        const uint32_t sector_addr = window_addr & ~(SECTOR_SIZE_BYTES - 1);
+        flash_erase_sector_blocking(sector_addr);
+        memset(&s_expected[sector_addr], 0xff, SECTOR_SIZE_BYTES);
+      }
+    } else if (op < 8) {
+      uint8_t data[64];
+      const uint32_t len = 1 + rand() % sizeof(data);
+      const uint32_t addr = window_addr + rand() % (window_size - len);
+      for (uint32_t j = 0; j < len; j++) {
+        data[j] = rand();
+        s_expected[addr + j] &= data[j];
+      }
+      flash_write_bytes(data, addr, len);
+    } else {
+      uint8_t buffer[48];
+      const uint32_t len = 1 + rand() % sizeof(buffer);
+      const uint32_t addr = window_addr + rand() % (window_size - len);
+      const int prev_read_sync_calls = read_sync_calls;
+      flash_read_bytes(buffer, addr, len);
+      cl_assert_equal_m(buffer, &s_expected[addr], len);
+      reads++;
+      hits += (read_sync_calls == prev_read_sync_calls);
+    }
+  }
+#if CAPABILITY_HAS_FLASH_READ_CACHE
+  // Writes invalidate lines all the time here, but a good share of the reads should still hit
+  cl_assert(hits > reads / 4);
+#endif
+}
@@ -0,0 +1,151 @@
+/* SPDX-FileCopyrightText: 2024 Google LLC */
+/* SPDX-License-Identifier: Apache-2.0 */
+
+#include "applib/graphics/graphics.h"
+#include "applib/graphics/bitblt.h"
+#include "applib/graphics/bitblt_private.h"
+#include "applib/graphics/8_bit/framebuffer.h"
+#include "util/size.h"
+
+#include "clar.h"
+#include "util.h"
+
+#include <string.h>
+
+// Stubs
+////////////////////////////////////
+#include "graphics_common_stubs.h"
+#include "stubs_applib_resource.h"
+#include "test_graphics.h"
+
+#define DEST_W 144
+#define DEST_H 168
+
+static uint8_t s_dest_data[DEST_W * DEST_H];
+static uint8_t s_expect_data[DEST_W * DEST_H];
+static uint8_t s_src_data[DEST_W * DEST_H];
+static uint32_t s_rand_state;
+
+// Helpers
+////////////////////////////////////
+
+static uint8_t prv_rand_byte(void) {
+  s_rand_state = s_rand_state * 1103515245 + 12345;
+  return (s_rand_state >> 16) & 0xff;
+}
+
+typedef enum {
+  AlphaMixed,
+  AlphaOpaque,
+  AlphaTransparent,
+  AlphaOpaqueOrTransparent,
+} AlphaPattern;
+
+static void prv_fill(uint8_t *data, size_t size, AlphaPattern pattern) {
+  for (size_t i = 0; i < size; i++) {
+    GColor8 color = { .argb = prv_rand_byte() };
+    switch (pattern) {
+      case AlphaMixed:
+        break;
+      case AlphaOpaque:
+        color.a = 3;
+        break;
+      case AlphaTransparent:
+        color.a = 0;
+        break;
+      case AlphaOpaqueOrTransparent:
+        color.a = (color.a & 1) ? 3 : 0;
+        break;
+    }
+    data[i] = color.argb;
+  }
+}
+
+static GBitmap prv_bitmap(uint8_t *data, int16_t w, int16_t h) {
+  return (GBitmap) {
+    .addr = data,
+    .row_size_bytes = w,
+    .info.format = GBitmapFormat8Bit,
+    .info.version = GBITMAP_VERSION_CURRENT,
+    .bounds = GRect(0, 0, w, h),
+  };
+}
+
+// Straightforward per-pixel version of the 8-bit to 8-bit tiled blit, used as the reference
+// that the fast paths must match exactly.
+static void prv_reference_blit(uint8_t *dest, const uint8_t *src, int16_t src_w, int16_t src_h,
+                               GRect dest_rect, GPoint src_origin_offset, GCompOp op) {
+  for (int16_t y = 0; y < dest_rect.size.h; y++) {
+    const int16_t dest_y = dest_rect.origin.y + y;
+    if (!WITHIN(dest_y, 0, DEST_H - 1)) {
+      continue;
+    }
+    const int16_t src_y = (src_origin_offset.y + y) % src_h;
+    for (int16_t x = 0; x < dest_rect.size.w; x++) {
+      const int16_t dest_x = dest_rect.origin.x + x;
+      if (!WITHIN(dest_x, 0, DEST_W - 1)) {
+        continue;
+      }
+      const int16_t src_x = (src_origin_offset.x + x) % src_w;
+      const GColor8 src_color = { .argb = src[src_y * src_w + src_x] };
+      uint8_t *d = &dest[dest_y * DEST_W + dest_x];
+      if (op == GCompOpSet) {
+        *d = gcolor_alpha_blend(src_color, (GColor8) { .argb = *d }).argb;
+      } else {
+        *d = src_color.argb;
+      }
+    }
+  }
+}
+
+static void prv_check(int16_t src_w, int16_t src_h, GRect dest_rect, GPoint offset,
+                      GCompOp op, AlphaPattern pattern) {
+  prv_fill(s_src_data, src_w * src_h, pattern);
+  prv_fill(s_dest_data, sizeof(s_dest_data), AlphaMixed);
+  memcpy(s_expect_data, s_dest_data, sizeof(s_dest_data));
+
+  GBitmap dest_bitmap = prv_bitmap(s_dest_data, DEST_W, DEST_H);
+  GBitmap src_bitmap = prv_bitmap(s_src_data, src_w, src_h);
+  bitblt_bitmap_into_bitmap_tiled_8bit_to_8bit(&dest_bitmap, &src_bitmap, dest_rect, offset,
+                                               op, GColorWhite);
+  prv_reference_blit(s_expect_data, s_src_data, src_w, src_h, dest_rect, offset, op);
+
+  cl_assert_equal_m(s_expect_data, s_dest_data, sizeof(s_dest_data));
+}
+
+// Tests
+////////////////////////////////////
+
+void test_bitblt_tiled__initialize(void) {
+  s_rand_state = 1;
+}
+
+void test_bitblt_tiled__cleanup(void) {
+}
+
+void test_bitblt_tiled__assign_matches_reference(void) {
+  // Untiled, full width
+  prv_check(DEST_W, DEST_H, GRect(0, 0, DEST_W, DEST_H), GPointZero,
+            GCompOpAssign, AlphaMixed);
+  // Tiled with an odd source width, offsets and clipping on both sides
+  prv_check(37, 23, GRect(-5, 0, DEST_W + 10, DEST_H), GPoint(11, 7),
+            GCompOpAssign, AlphaMixed);
+  prv_check(1, 1, GRect(3, 3, 50, 50), GPointZero, GCompOpAssign, AlphaMixed);
+  // Source offset beyond the source width, which falls back to the per-pixel loop
+  prv_check(37, 23, GRect(0, 0, 100, 40), GPoint(40, 2), GCompOpAssign, AlphaMixed);
+  prv_check(13, 9, GRect(1, 2, 3, 4), GPoint(12, 8), GCompOpAssign, AlphaMixed);
+}
+
+void test_bitblt_tiled__set_matches_reference(void) {
+  const AlphaPattern patterns[] = {
+    AlphaMixed, AlphaOpaque, AlphaTransparent, AlphaOpaqueOrTransparent,
+  };
+  for (unsigned int i = 0; i < ARRAY_LENGTH(patterns); i++) {
+    prv_check(DEST_W, DEST_H, GRect(0, 0, DEST_W, DEST_H), GPointZero,
+              GCompOpSet, patterns[i]);
+    prv_check(37, 23, GRect(-5, 0, DEST_W + 10, DEST_H), GPoint(11, 7),
+              GCompOpSet, patterns[i]);
+    prv_check(7, 5, GRect(1, 1, 61, 17), GPoint(3, 1), GCompOpSet, patterns[i]);
+    prv_check(2, 2, GRect(0, 0, 3, 3), GPoint(1, 1), GCompOpSet, patterns[i]);
+  }
+}
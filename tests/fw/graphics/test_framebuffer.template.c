@@ -44,3 +44,63 @@ void test_framebuffer_${BIT_DEPTH_NAME}__framebuffer_clear(void) {
 
   cl_assert(framebuffer.is_dirty == true);
 }
+
+void test_framebuffer_${BIT_DEPTH_NAME}__dirty_row_spans(void) {
+  framebuffer_init(&framebuffer, &(GSize) { DISP_COLS, DISP_ROWS });
+  cl_assert(!framebuffer_is_dirty(&framebuffer));
+  cl_assert_equal_i(framebuffer_get_next_dirty_row(&framebuffer, 0), DISP_ROWS);
+
+  // Updates at the top and the bottom of the screen shouldn't dirty the rows in between
+  framebuffer_mark_dirty_rect(&framebuffer, GRect(10, 2, 20, 8));
+  framebuffer_mark_dirty_rect(&framebuffer, GRect(0, DISP_ROWS - 10, 5, 20));
+  cl_assert(framebuffer_is_dirty(&framebuffer));
+  cl_assert_equal_i(framebuffer.num_dirty_row_spans, 2);
+  cl_assert(!framebuffer_is_row_dirty(&framebuffer, 1));
+  cl_assert(framebuffer_is_row_dirty(&framebuffer, 2));
+  cl_assert(framebuffer_is_row_dirty(&framebuffer, 9));
+  cl_assert(!framebuffer_is_row_dirty(&framebuffer, 10));
+  cl_assert_equal_i(framebuffer_get_next_dirty_row(&framebuffer, 10), DISP_ROWS - 10);
+  cl_assert(framebuffer_is_row_dirty(&framebuffer, DISP_ROWS - 1));
+  // The bounding box is still maintained
+  cl_assert(grect_equal(&framebuffer.dirty_rect, &GRect(0, 2, 30, DISP_ROWS - 2)));
+
+  // Overlapping and touching spans get merged
+  framebuffer_mark_dirty_rect(&framebuffer, GRect(0, 10, 1, 5));
+  framebuffer_mark_dirty_rect(&framebuffer, GRect(0, 0, 1, 3));
+  cl_assert_equal_i(framebuffer.num_dirty_row_spans, 2);
+  cl_assert(grect_equal(&(GRect) { .origin.y = framebuffer.dirty_rows[0].origin_y,
+                                   .size.h = framebuffer.dirty_rows[0].size_h },
+                        &(GRect) { .origin.y = 0, .size.h = 15 }));
+
+  // Empty and off-screen rects don't dirty any rows
+  framebuffer_mark_dirty_rect(&framebuffer, GRect(0, 50, 0, 10));
+  framebuffer_mark_dirty_rect(&framebuffer, GRect(0, -20, 10, 10));
+  cl_assert_equal_i(framebuffer.num_dirty_row_spans, 2);
+
+  // Fill up the span list, then overflow it. The two spans closest to each other get merged.
+  framebuffer_mark_dirty_rect(&framebuffer, GRect(0, 40, 10, 2));
+  framebuffer_mark_dirty_rect(&framebuffer, GRect(0, 80, 10, 2));
+  cl_assert_equal_i(framebuffer.num_dirty_row_spans, 4);
+  framebuffer_mark_dirty_rect(&framebuffer, GRect(0, 44, 10, 2));
+  cl_assert_equal_i(framebuffer.num_dirty_row_spans, FRAMEBUFFER_MAX_DIRTY_ROW_SPANS);
+  cl_assert(framebuffer_is_row_dirty(&framebuffer, 43));
+  cl_assert(!framebuffer_is_row_dirty(&framebuffer, 46));
+  cl_assert(!framebuffer_is_row_dirty(&framebuffer, 20));
+  cl_assert(!framebuffer_is_row_dirty(&framebuffer, 79));
+
+  // Make sure we visit exactly the dirty rows when walking the framebuffer
+  int num_dirty_rows = 0;
+  for (int16_t y = framebuffer_get_next_dirty_row(&framebuffer, 0); y < DISP_ROWS;
+       y = framebuffer_get_next_dirty_row(&framebuffer, y + 1)) {
+    num_dirty_rows++;
+  }
+  cl_assert_equal_i(num_dirty_rows, 15 + 6 + 2 + 10);
+
+  framebuffer_dirty_all(&framebuffer);
+  cl_assert_equal_i(framebuffer.num_dirty_row_spans, 1);
+  cl_assert(framebuffer_is_row_dirty(&framebuffer, DISP_ROWS / 2));
+
+  framebuffer_reset_dirty(&framebuffer);
+  cl_assert(!framebuffer_is_dirty(&framebuffer));
+  cl_assert_equal_i(framebuffer_get_next_dirty_row(&framebuffer, 0), DISP_ROWS);
+}
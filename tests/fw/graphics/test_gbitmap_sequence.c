@@ -330,3 +330,187 @@ void test_gbitmap_sequence__1bit_to_1bit_notification(void) {
     cl_check(gbitmap_pbi_eq(bitmap, filename_buffer));
   }
 }
+
+#define DATA_TEST_APNG_FILE "test_gbitmap_sequence__1bit_to_1bit_notification.apng"
+
+static uint32_t prv_load_data_as_resource(const char *filename, const uint8_t *data, size_t size) {
+  char full_path[PATH_STRING_LENGTH];
+  snprintf(full_path, sizeof(full_path), "%s/%s", TEST_OUTPUT_PATH, filename);
+  FILE *file = fopen(full_path, "wb");
+  cl_assert(file);
+  cl_assert_equal_i(fwrite(data, 1, size, file), size);
+  fclose(file);
+  return sys_resource_load_file_as_resource(TEST_OUTPUT_PATH, filename);
+}
+
+// Declares a sliding window of 1 << (cinfo + 8) bytes in the zlib header of every frame
+static void prv_set_zlib_window(uint8_t *png, size_t png_size, uint8_t cinfo) {
+  uint32_t previous_type = 0;
+  for (size_t offset = 8; offset + 12 <= png_size; offset += png_read_be32(png + offset) + 12) {
+    const uint32_t type = png_read_be32(png + offset + 4);
+    // only the first data chunk of a frame starts with the zlib header
+    if (type != previous_type) {
+      uint8_t *zlib_header = NULL;
+      if (type == PNG_CHUNK_IDAT) {
+        zlib_header = png + offset + 8;
+      } else if (type == PNG_CHUNK_FDAT) {
+        zlib_header = png + offset + 8 + 4; // after the sequence number
+      }
+      if (zlib_header) {
+        zlib_header[0] = (cinfo << 4) | 8;
+        // FCHECK makes the header a multiple of 31
+        zlib_header[1] &= ~0x1f;
+        zlib_header[1] += 31 - (((zlib_header[0] << 8) | zlib_header[1]) % 31);
+      }
+    }
+    previous_type = type;
+  }
+}
+
+// Decodes every frame of both sequences and checks that they match
+static void prv_check_sequences_eq(uint32_t expected_resource_id, uint32_t resource_id) {
+  GBitmapSequence *expected_sequence = gbitmap_sequence_create_with_resource(expected_resource_id);
+  GBitmapSequence *bitmap_sequence = gbitmap_sequence_create_with_resource(resource_id);
+  cl_assert(expected_sequence && bitmap_sequence);
+
+  const uint32_t num_frames = gbitmap_sequence_get_total_num_frames(expected_sequence);
+  cl_assert_equal_i(gbitmap_sequence_get_total_num_frames(bitmap_sequence), num_frames);
+
+  const GSize size = gbitmap_sequence_get_bitmap_size(expected_sequence);
+  GBitmap *expected = gbitmap_create_blank(size, GBitmapFormat1Bit);
+  GBitmap *bitmap = gbitmap_create_blank(size, GBitmapFormat1Bit);
+  for (uint32_t i = 0; i < num_frames; i++) {
+    uint32_t expected_delay_ms, delay_ms;
+    cl_assert(gbitmap_sequence_update_bitmap_next_frame(expected_sequence, expected,
+                                                        &expected_delay_ms));
+    cl_assert(gbitmap_sequence_update_bitmap_next_frame(bitmap_sequence, bitmap, &delay_ms));
+    cl_assert_equal_i(delay_ms, expected_delay_ms);
+    cl_assert(memcmp(bitmap->addr, expected->addr, bitmap->row_size_bytes * size.h) == 0);
+  }
+
+  gbitmap_destroy(expected);
+  gbitmap_destroy(bitmap);
+  gbitmap_sequence_destroy(expected_sequence);
+  gbitmap_sequence_destroy(bitmap_sequence);
+}
+
+// Tests an APNG with the data of every frame split across many small IDAT/fdAT chunks
+// Result:
+//   - every frame matches the unsplit APNG
+void test_gbitmap_sequence__split_frame_data(void) {
+  uint8_t *apng_data = NULL;
+  const size_t apng_size = load_file(DATA_TEST_APNG_FILE, &apng_data);
+  uint8_t *split_apng_data = NULL;
+  const size_t split_apng_size = png_split_data_chunks(apng_data, apng_size, 5, &split_apng_data);
+
+  const uint32_t resource_id = sys_resource_load_file_as_resource(TEST_IMAGES_PATH,
+                                                                  DATA_TEST_APNG_FILE);
+  const uint32_t split_resource_id = prv_load_data_as_resource(
+      "test_gbitmap_sequence__split_frame_data.apng", split_apng_data, split_apng_size);
+  cl_assert(resource_id != UINT32_MAX && split_resource_id != UINT32_MAX);
+
+  prv_check_sequences_eq(resource_id, split_resource_id);
+}
+
+// An 80x80 1-bit greyscale APNG compressed with a 512 byte window. The first frame inflates to
+// 880 bytes so it is decoded through the window, the second is a 48x48 frame at (16, 16) which
+// fits in the window and is inflated whole.
+static const uint8_t s_windowed_apng[] = {
+  0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a, 0x00, 0x00, 0x00, 0x0d,
+  0x49, 0x48, 0x44, 0x52, 0x00, 0x00, 0x00, 0x50, 0x00, 0x00, 0x00, 0x50,
+  0x01, 0x00, 0x00, 0x00, 0x00, 0xa6, 0x6a, 0xcf, 0x00, 0x00, 0x00, 0x00,
+  0x08, 0x61, 0x63, 0x54, 0x4c, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00,
+  0x00, 0xf3, 0x8d, 0x93, 0x70, 0x00, 0x00, 0x00, 0x1a, 0x66, 0x63, 0x54,
+  0x4c, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x50, 0x00, 0x00, 0x00,
+  0x50, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00,
+  0x0a, 0x00, 0x00, 0xe4, 0xb5, 0x58, 0x70, 0x00, 0x00, 0x00, 0xb6, 0x49,
+  0x44, 0x41, 0x54, 0x18, 0xd3, 0x85, 0x8f, 0xc1, 0x09, 0xc4, 0x20, 0x14,
+  0x05, 0x27, 0xec, 0x21, 0xb7, 0xad, 0x20, 0x90, 0x36, 0xbc, 0xa5, 0x25,
+  0x3b, 0x30, 0x1d, 0x6c, 0x4b, 0xb9, 0xa5, 0x0d, 0x21, 0x15, 0xe4, 0x96,
+  0x83, 0xe8, 0x22, 0xc2, 0xf3, 0x12, 0xf9, 0x47, 0x61, 0xfe, 0x8c, 0x8f,
+  0x75, 0x49, 0xfb, 0xef, 0x9b, 0x8f, 0x73, 0x26, 0xf8, 0x7b, 0xda, 0xdc,
+  0xc3, 0xba, 0x50, 0xdf, 0x25, 0x5e, 0x9f, 0xe0, 0xa9, 0xef, 0x86, 0x50,
+  0xdf, 0x0d, 0xa1, 0x9d, 0x54, 0x84, 0x76, 0x52, 0x11, 0xda, 0x49, 0x45,
+  0x10, 0xba, 0x22, 0x34, 0x20, 0x34, 0x13, 0xbb, 0x6d, 0x97, 0x8d, 0x49,
+  0x36, 0x66, 0xd9, 0xd0, 0x1f, 0x8b, 0x1d, 0x16, 0x1a, 0xb9, 0x65, 0xe3,
+  0x94, 0x8d, 0xf7, 0xc5, 0x66, 0x58, 0x68, 0xe2, 0x90, 0x8d, 0x6e, 0x1b,
+  0x2c, 0x36, 0xc3, 0x42, 0x3d, 0x8f, 0x10, 0x2e, 0xd9, 0x06, 0x8b, 0xcd,
+  0xb0, 0xd0, 0x4c, 0xec, 0xb6, 0x5d, 0xb6, 0xc1, 0x62, 0x33, 0x2c, 0xd4,
+  0x91, 0x64, 0xe3, 0x96, 0x6d, 0xb0, 0xd8, 0x0c, 0x0b, 0x2d, 0x78, 0xd9,
+  0x38, 0x64, 0x1b, 0x2c, 0x36, 0xc3, 0x42, 0x17, 0xb2, 0x6c, 0x3c, 0x42,
+  0x06, 0x8b, 0xcd, 0xb0, 0xd0, 0x80, 0x93, 0x8d, 0xd8, 0x6d, 0xaf, 0x8b,
+  0xff, 0x78, 0x9f, 0x89, 0x2c, 0xb1, 0x1a, 0x5f, 0x95, 0x00, 0x00, 0x00,
+  0x1a, 0x66, 0x63, 0x54, 0x4c, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,
+  0x30, 0x00, 0x00, 0x00, 0x30, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00,
+  0x10, 0x00, 0x01, 0x00, 0x0a, 0x00, 0x00, 0x9f, 0x5c, 0x35, 0x7e, 0x00,
+  0x00, 0x00, 0x62, 0x66, 0x64, 0x41, 0x54, 0x00, 0x00, 0x00, 0x02, 0x18,
+  0xd3, 0xb5, 0x8f, 0xb1, 0x0d, 0x80, 0x30, 0x0c, 0x04, 0x8d, 0x52, 0x64,
+  0x0c, 0x46, 0x61, 0x34, 0x18, 0x8d, 0x51, 0x32, 0x42, 0x06, 0x40, 0x1c,
+  0xfe, 0xc8, 0x11, 0x0a, 0x05, 0xa2, 0xc1, 0x85, 0xaf, 0x39, 0xcb, 0xff,
+  0x66, 0x5f, 0x66, 0x39, 0x1b, 0x60, 0xf3, 0x9d, 0xa0, 0x38, 0x32, 0x54,
+  0xc7, 0x0c, 0x87, 0x0c, 0x90, 0xb3, 0x02, 0x37, 0x7c, 0xfb, 0xc5, 0x24,
+  0xec, 0x1d, 0x49, 0x28, 0x1d, 0x59, 0xa8, 0xbf, 0x60, 0x7c, 0x34, 0x86,
+  0x88, 0x64, 0x8f, 0xb8, 0xd1, 0x21, 0x1a, 0x45, 0xbf, 0x68, 0x6b, 0xcd,
+  0x77, 0x47, 0xc6, 0xcb, 0x5c, 0xf7, 0xdb, 0x9d, 0x7a, 0xcc, 0x81, 0x2e,
+  0xcf, 0x00, 0x00, 0x00, 0x00, 0x49, 0x45, 0x4e, 0x44, 0xae, 0x42, 0x60,
+  0x82,
+};
+
+// Tests an APNG with a frame larger than its sliding window
+// Result:
+//   - every frame matches the same APNG decoded with a 32k window, which inflates them whole
+void test_gbitmap_sequence__windowed_frame_data(void) {
+  const uint32_t windowed_resource_id = prv_load_data_as_resource(
+      "test_gbitmap_sequence__windowed_frame_data.apng", s_windowed_apng,
+      sizeof(s_windowed_apng));
+
+  uint8_t whole_apng[sizeof(s_windowed_apng)];
+  memcpy(whole_apng, s_windowed_apng, sizeof(whole_apng));
+  prv_set_zlib_window(whole_apng, sizeof(whole_apng), 7 /* cinfo */);
+  const uint32_t whole_resource_id = prv_load_data_as_resource(
+      "test_gbitmap_sequence__windowed_frame_data_whole.apng", whole_apng, sizeof(whole_apng));
+  cl_assert(windowed_resource_id != UINT32_MAX && whole_resource_id != UINT32_MAX);
+
+  prv_check_sequences_eq(whole_resource_id, windowed_resource_id);
+}
+
+// Tests an APNG whose second frame starts with a deflate block of the reserved type
+// Result:
+//   - the first frame decodes, the second one fails and so does every update after it
+//   - the failed frame doesn't advance the sequence
+void test_gbitmap_sequence__corrupt_frame_data(void) {
+  uint8_t *apng_data = NULL;
+  const size_t apng_size = load_file(DATA_TEST_APNG_FILE, &apng_data);
+  // The first frame is in IDAT, the second one in the first fdAT
+  const size_t fdat_offset = png_find_chunk(apng_data, apng_size, PNG_CHUNK_FDAT);
+  cl_assert(fdat_offset);
+  // skip the chunk header, the sequence number and the zlib header
+  apng_data[fdat_offset + 8 + 4 + 2] |= 0x06;
+
+  const uint32_t resource_id = prv_load_data_as_resource(
+      "test_gbitmap_sequence__corrupt_frame_data.apng", apng_data, apng_size);
+  cl_assert(resource_id != UINT32_MAX);
+  GBitmapSequence *bitmap_sequence = gbitmap_sequence_create_with_resource(resource_id);
+  cl_assert(bitmap_sequence);
+  GBitmap *bitmap = gbitmap_create_blank(gbitmap_sequence_get_bitmap_size(bitmap_sequence),
+                                         GBitmapFormat1Bit);
+
+  uint32_t delay_ms = 0;
+  cl_assert(gbitmap_sequence_update_bitmap_next_frame(bitmap_sequence, bitmap, &delay_ms));
+  cl_assert(gbitmap_pbi_eq(bitmap, "test_gbitmap_sequence__1bit_to_1bit_notification_1.pbi"));
+  const int32_t frame_idx = gbitmap_sequence_get_current_frame_idx(bitmap_sequence);
+  cl_assert_equal_i(gbitmap_sequence_get_current_frame_delay_ms(bitmap_sequence), delay_ms);
+
+  uint32_t failed_delay_ms = UINT32_MAX;
+  cl_assert(!gbitmap_sequence_update_bitmap_next_frame(bitmap_sequence, bitmap,
+                                                       &failed_delay_ms));
+  cl_assert_equal_i(failed_delay_ms, UINT32_MAX);
+  cl_assert_equal_i(gbitmap_sequence_get_current_frame_idx(bitmap_sequence), frame_idx);
+  cl_assert_equal_i(gbitmap_sequence_get_current_frame_delay_ms(bitmap_sequence), delay_ms);
+
+  cl_assert(!gbitmap_sequence_update_bitmap_next_frame(bitmap_sequence, bitmap, NULL));
+  cl_assert_equal_i(gbitmap_sequence_get_current_frame_idx(bitmap_sequence), frame_idx);
+
+  gbitmap_destroy(bitmap);
+  gbitmap_sequence_destroy(bitmap_sequence);
+}
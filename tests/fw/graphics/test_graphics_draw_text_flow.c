@@ -9,12 +9,17 @@
 #include "applib/graphics/graphics.h"
 #include "applib/graphics/gtypes.h"
 #include "applib/graphics/text.h"
+#include "applib/graphics/text_layout_private.h"
 #include "applib/graphics/text_resources.h"
 #include "applib/ui/layer.h"
 #include "applib/ui/window_private.h"
 #include "resource/resource_ids.auto.h"
+#include "util/hash.h"
 #include "util/size.h"
 
+#include <limits.h>
+#include <stdio.h>
+
 
 // Helper Functions
 ////////////////////////////////////
@@ -469,3 +474,141 @@ void test_graphics_draw_text_flow__no_infinite_loop2(void) {
 
   cl_check(gbitmap_pbi_eq(s_dest_bitmap, TEST_PBI_FILE));
 }
+
+////////////////////////////////////////////////////////////
+// Line cache
+
+#define LONG_BODY_BYTES (4 * 1024)
+#define SCROLL_STEP_PX (4)
+
+//! Fills text with something that looks like the body of a long notification
+static void prv_fill_long_body(char *text, size_t size, unsigned int seed) {
+  static const char *s_words[] = {
+    "the", "meeting", "has", "been", "moved", "to", "Thursday", "afternoon", "because", "half",
+    "of", "the", "team", "is", "travelling,", "please", "bring", "your", "notes", "and",
+    "a", "laptop.", "Supercalifragilisticexpialidocious", "ok!", "I'll", "call", "you", "later",
+  };
+  size_t len = 0;
+  while (true) {
+    seed = seed * 1103515245 + 12345;
+    const char *word = s_words[(seed >> 16) % ARRAY_LENGTH(s_words)];
+    const char *separator = ((seed >> 8) % 23 == 0) ? "\n\n" : " ";
+    if (len + strlen(word) + strlen(separator) >= size) {
+      break;
+    }
+    len += sprintf(&text[len], "%s%s", word, separator);
+  }
+  text[len] = '\0';
+}
+
+//! Scrolls text through the screen from top to bottom the way a ScrollLayer would
+//! @param frame_hashes the hash of the framebuffer after each scroll step
+//! @return number of frames rendered
+static int prv_render_scrolled(const char *text, GFont font, TextLayoutLineCache *line_cache,
+                               uint32_t *frame_hashes, int max_frames) {
+  const GRect bounds = GRect(0, 0, DISP_COLS, SHRT_MAX);
+  const int16_t content_height =
+      graphics_text_layout_get_max_used_size(&ctx, text, font, bounds, GTextOverflowModeWordWrap,
+                                             GTextAlignmentLeft, NULL).h;
+  cl_assert(content_height > 10 * DISP_ROWS);
+
+  const size_t fb_bytes = s_dest_bitmap->row_size_bytes * s_dest_bitmap->bounds.size.h;
+  int num_frames = 0;
+  for (int offset = 0; offset <= content_height - DISP_ROWS && num_frames < max_frames;
+       offset += SCROLL_STEP_PX) {
+    memset(s_dest_bitmap->addr, 0xff, fb_bytes);
+    const GRect box = GRect(0, -offset, DISP_COLS, content_height);
+    graphics_draw_text_with_line_cache(&ctx, text, font, box, GTextOverflowModeWordWrap,
+                                       GTextAlignmentLeft, NULL, line_cache);
+    frame_hashes[num_frames++] = hash(s_dest_bitmap->addr, fb_bytes);
+  }
+  return num_frames;
+}
+
+#define MAX_FRAMES (2000)
+
+void test_graphics_draw_text_flow__line_cache_scroll(void) {
+  static char s_body[LONG_BODY_BYTES];
+  static uint32_t s_uncached_hashes[MAX_FRAMES];
+  static uint32_t s_cached_hashes[MAX_FRAMES];
+  prv_fill_long_body(s_body, sizeof(s_body), 1);
+  prv_prepare_fb_steps_xy(GSize(DISP_COLS, DISP_ROWS), 1, 1);
+
+  const int num_frames = prv_render_scrolled(s_body, &s_font_info, NULL, s_uncached_hashes,
+                                             MAX_FRAMES);
+
+  TextLayoutLineCache line_cache = {};
+  cl_assert_equal_i(prv_render_scrolled(s_body, &s_font_info, &line_cache, s_cached_hashes,
+                                        MAX_FRAMES), num_frames);
+
+  // Every frame must look exactly the same with and without the cache
+  cl_assert_equal_m(s_cached_hashes, s_uncached_hashes, num_frames * sizeof(uint32_t));
+  // The cache doubled its stride as the text got longer
+  cl_assert(line_cache.lines_per_entry > 1);
+
+  // Scrolling back up reuses the lines found on the way down
+  for (int i = 0; i < num_frames; i++) {
+    s_cached_hashes[i] = 0;
+  }
+  prv_render_scrolled(s_body, &s_font_info, &line_cache, s_cached_hashes, MAX_FRAMES);
+  cl_assert_equal_m(s_cached_hashes, s_uncached_hashes, num_frames * sizeof(uint32_t));
+}
+
+void test_graphics_draw_text_flow__line_cache_invalidation(void) {
+  static char s_body[LONG_BODY_BYTES];
+  static uint32_t s_uncached_hashes[MAX_FRAMES];
+  static uint32_t s_cached_hashes[MAX_FRAMES];
+  const int max_frames = 200;
+  prv_prepare_fb_steps_xy(GSize(DISP_COLS, DISP_ROWS), 1, 1);
+
+  TextLayoutLineCache line_cache = {};
+  prv_fill_long_body(s_body, sizeof(s_body), 1);
+  prv_render_scrolled(s_body, &s_font_info, &line_cache, s_cached_hashes, max_frames);
+
+  // Change the text in place, the cache has to notice even though the pointer stays the same
+  prv_fill_long_body(s_body, sizeof(s_body), 2);
+  int num_frames = prv_render_scrolled(s_body, &s_font_info, NULL, s_uncached_hashes,
+                                       max_frames);
+  cl_assert_equal_i(prv_render_scrolled(s_body, &s_font_info, &line_cache, s_cached_hashes,
+                                        max_frames), num_frames);
+  cl_assert_equal_m(s_cached_hashes, s_uncached_hashes, num_frames * sizeof(uint32_t));
+
+  // Change the font
+  FontInfo font_info = {};
+  cl_assert(text_resources_init_font(0, RESOURCE_ID_GOTHIC_14, 0, &font_info));
+  num_frames = prv_render_scrolled(s_body, &font_info, NULL, s_uncached_hashes, max_frames);
+  cl_assert_equal_i(prv_render_scrolled(s_body, &font_info, &line_cache, s_cached_hashes,
+                                        max_frames), num_frames);
+  cl_assert_equal_m(s_cached_hashes, s_uncached_hashes, num_frames * sizeof(uint32_t));
+
+  // Text flow moves lines around depending on their position on the screen, so the cache is
+  // left alone
+  TextLayoutExtended layout = {
+    .flow_data.perimeter.impl = &(GPerimeter){.callback = perimeter_for_display_rect},
+    .flow_data.perimeter.inset = 8,
+  };
+  const TextLayoutLineCache line_cache_before = line_cache;
+  graphics_draw_text_with_line_cache(&ctx, s_body, &font_info, GRect(0, -500, DISP_COLS, 2000),
+                                     GTextOverflowModeWordWrap, GTextAlignmentLeft,
+                                     (GTextAttributes *)&layout, &line_cache);
+  cl_assert_equal_m(&line_cache, &line_cache_before, sizeof(line_cache));
+}
+
+void test_graphics_draw_text_flow__layout_with_line_cache(void) {
+  GTextLayoutCacheRef layout = NULL;
+  graphics_text_layout_cache_init_with_line_cache(&layout);
+  cl_assert(layout);
+
+  // The line cache is allocated on first use and then stays the same
+  TextLayoutLineCache *line_cache = graphics_text_layout_get_line_cache(layout);
+  cl_assert(line_cache);
+  cl_assert_equal_p(graphics_text_layout_get_line_cache(layout), line_cache);
+
+  // It can still be used as a regular layout
+  graphics_text_layout_set_line_spacing_delta(layout, 3);
+  cl_assert_equal_i(graphics_text_layout_get_line_spacing_delta(layout), 3);
+  cl_assert_equal_p(graphics_text_layout_get_line_cache(layout), line_cache);
+
+  graphics_text_layout_cache_deinit_with_line_cache(&layout);
+  cl_assert_equal_p(layout, NULL);
+}
@@ -9,6 +9,7 @@
 #include "util/trig.h"
 #include "applib/ui/ui.h"
 
+#include <limits.h>
 #include <string.h>
 
 // Helper Functions
@@ -444,3 +445,245 @@ void test_graphics_gpath_8bit__clipping_aa(void) {
   // Safety
   s_path_angle = 0;
 }
+
+// Reference fill
+////////////////////////////////////
+// Intersects every segment of the path with every scanline and sorts the intersections of each
+// scanline, like gpath did before it kept a table of the edges. Both have to come up with exactly
+// the same spans.
+
+#define MAX_FILL_SPANS (4096)
+
+typedef struct FillSpan {
+  int16_t y;
+  Fixed_S16_3 x_begin;
+  Fixed_S16_3 x_end;
+  Fixed_S16_3 delta_begin;
+  Fixed_S16_3 delta_end;
+} FillSpan;
+
+typedef struct FillSpans {
+  FillSpan spans[MAX_FILL_SPANS];
+  int num_spans;
+} FillSpans;
+
+static void prv_record_span_cb(GContext *ctx, int16_t y, Fixed_S16_3 x_begin, Fixed_S16_3 x_end,
+                               Fixed_S16_3 delta_begin, Fixed_S16_3 delta_end, void *user_data) {
+  FillSpans *spans = user_data;
+  cl_assert(spans->num_spans < MAX_FILL_SPANS);
+  spans->spans[spans->num_spans++] = (FillSpan) {
+    .y = y,
+    .x_begin = x_begin,
+    .x_end = x_end,
+    .delta_begin = delta_begin,
+    .delta_end = delta_end,
+  };
+}
+
+typedef struct ReferenceIntersection {
+  //! Precise x in raw units for the antialiased fill, x in pixels otherwise
+  int32_t x;
+  Fixed_S16_3 delta;
+} ReferenceIntersection;
+
+static void prv_reference_sort(ReferenceIntersection *values, int length) {
+  for (int i = 0; i < length; i++) {
+    for (int j = i + 1; j < length; j++) {
+      if (values[i].x > values[j].x) {
+        const ReferenceIntersection tmp = values[i];
+        values[i] = values[j];
+        values[j] = tmp;
+      }
+    }
+  }
+}
+
+static GPoint prv_reference_rotate(GPoint point, int32_t rotation, GPoint offset) {
+  const int32_t cosine = cos_lookup(rotation);
+  const int32_t sine = sin_lookup(rotation);
+  return GPoint(
+      (int32_t)point.x * cosine / TRIG_MAX_RATIO - (int32_t)point.y * sine / TRIG_MAX_RATIO +
+          offset.x,
+      (int32_t)point.y * cosine / TRIG_MAX_RATIO + (int32_t)point.x * sine / TRIG_MAX_RATIO +
+          offset.y);
+}
+
+static void prv_reference_fill(GContext *ctx, GPath *path, bool antialiased, FillSpans *spans) {
+  const int num_points = path->num_points;
+  GPoint points[num_points];
+  int16_t rows[num_points];
+  int min_x = INT_MAX, max_x = INT_MIN, min_y = INT_MAX, max_y = INT_MIN;
+  for (int i = 0; i < num_points; i++) {
+    const GPoint point = prv_reference_rotate(path->points[i], path->rotation, path->offset);
+    if (antialiased) {
+      const GPointPrecise precise = GPointPreciseFromGPoint(point);
+      points[i] = GPoint(precise.x.raw_value, precise.y.raw_value);
+      rows[i] = precise.y.integer;
+      min_x = MIN(min_x, precise.x.integer);
+      max_x = MAX(max_x, precise.x.integer);
+    } else {
+      points[i] = point;
+      rows[i] = point.y;
+      min_x = MIN(min_x, point.x);
+      max_x = MAX(max_x, point.x);
+    }
+    min_y = MIN(min_y, rows[i]);
+    max_y = MAX(max_y, rows[i]);
+  }
+
+  // the direction of the last non-horizontal segment
+  bool start_is_down = false;
+  for (int i = num_points - 1; i >= 0; i--) {
+    const int next = (i + 1) % num_points;
+    if (rows[i] != rows[next]) {
+      start_is_down = rows[next] > rows[i];
+      break;
+    }
+  }
+
+  const int16_t clip_min_x = ctx->draw_state.clip_box.origin.x -
+                             ctx->draw_state.drawing_box.origin.x;
+  const int16_t clip_max_x = ctx->draw_state.clip_box.size.w + clip_min_x;
+  if (max_x < clip_min_x || min_x > clip_max_x) {
+    return;
+  }
+  const int16_t clip_min_y = ctx->draw_state.clip_box.origin.y -
+                             ctx->draw_state.drawing_box.origin.y;
+  const int16_t clip_max_y = ctx->draw_state.clip_box.size.h + clip_min_y;
+  min_y = MAX(min_y, clip_min_y);
+  max_y = MIN(max_y, clip_max_y);
+
+  ReferenceIntersection intersections_up[num_points];
+  ReferenceIntersection intersections_down[num_points];
+  for (int16_t y = min_y; y <= max_y; y++) {
+    int up_count = 0;
+    int down_count = 0;
+    bool last_is_down = start_is_down;
+    for (int i = 0; i < num_points; i++) {
+      const int next = (i + 1) % num_points;
+      if ((rows[i] - y) * (rows[next] - y) > 0) {
+        continue;
+      }
+      const bool is_down = (rows[i] != rows[next]) ? (rows[next] > rows[i]) : last_is_down;
+      if (!(rows[i] == y && last_is_down == is_down)) {
+        ReferenceIntersection intersection;
+        if (antialiased) {
+          const int16_t delta_x = points[next].x - points[i].x;
+          const int16_t delta_y = points[next].y - points[i].y;
+          const int16_t x = points[i].x + delta_x *
+                            (y * FIXED_S16_3_ONE.raw_value - points[i].y) / delta_y;
+          Fixed_S16_3 delta = {.raw_value = ABS(delta_x / delta_y) * FIXED_S16_3_ONE.raw_value};
+          if (delta.integer > 1) {
+            const int16_t x_lo = MIN(points[i].x, points[next].x);
+            const int16_t x_hi = MAX(points[i].x, points[next].x);
+            if (x - (delta.raw_value / 2) < x_lo) {
+              delta.raw_value = (x - x_lo) * 2;
+            }
+            if (x + (delta.raw_value / 2) > x_hi) {
+              delta.raw_value = (x_hi - x) * 2;
+            }
+          }
+          intersection = (ReferenceIntersection) { .x = x, .delta = delta };
+        } else {
+          const int16_t x = points[i].x + (points[next].x - points[i].x) * (y - points[i].y) /
+                            (points[next].y - points[i].y);
+          intersection = (ReferenceIntersection) { .x = x, .delta = {.integer = -1} };
+        }
+        if (is_down) {
+          intersections_down[down_count++] = intersection;
+        } else {
+          intersections_up[up_count++] = intersection;
+        }
+      }
+      last_is_down = is_down;
+    }
+
+    prv_reference_sort(intersections_up, up_count);
+    prv_reference_sort(intersections_down, down_count);
+    for (int i = 0; i < MIN(up_count, down_count); i++) {
+      ReferenceIntersection a = intersections_up[i];
+      ReferenceIntersection b = intersections_down[i];
+      if (antialiased) {
+        const Fixed_S16_3 x_a = {.raw_value = a.x};
+        const Fixed_S16_3 x_b = {.raw_value = b.x};
+        if (x_a.integer == x_b.integer) {
+          continue;
+        }
+        if (x_a.integer > x_b.integer) {
+          prv_record_span_cb(ctx, y, x_b, x_a, b.delta, a.delta, spans);
+        } else {
+          prv_record_span_cb(ctx, y, x_a, x_b, a.delta, b.delta, spans);
+        }
+      } else if (a.x != b.x) {
+        prv_record_span_cb(ctx, y, (Fixed_S16_3){.integer = MIN(a.x, b.x)},
+                           (Fixed_S16_3){.integer = MAX(a.x, b.x)}, a.delta, b.delta, spans);
+      }
+    }
+  }
+}
+
+static void prv_check_spans_eq(const FillSpans *a, const FillSpans *b) {
+  cl_assert_equal_i(a->num_spans, b->num_spans);
+  for (int i = 0; i < a->num_spans; i++) {
+    cl_assert_equal_i(a->spans[i].y, b->spans[i].y);
+    cl_assert_equal_i(a->spans[i].x_begin.raw_value, b->spans[i].x_begin.raw_value);
+    cl_assert_equal_i(a->spans[i].x_end.raw_value, b->spans[i].x_end.raw_value);
+    cl_assert_equal_i(a->spans[i].delta_begin.raw_value, b->spans[i].delta_begin.raw_value);
+    cl_assert_equal_i(a->spans[i].delta_end.raw_value, b->spans[i].delta_end.raw_value);
+  }
+}
+
+static uint32_t prv_rand(uint32_t *seed) {
+  *seed = *seed * 1103515245 + 12345;
+  return *seed >> 8;
+}
+
+#define NUM_RANDOM_PATHS (20000)
+#define MAX_RANDOM_PATH_POINTS (16)
+
+#if PBL_COLOR
+void prv_fill_path_with_cb_aa(GContext *ctx, GPath *path, GPathDrawFilledCallback cb,
+                              void *user_data);
+#endif
+
+void test_graphics_gpath_${BIT_DEPTH_NAME}__filled_matches_reference(void) {
+  static FillSpans s_spans;
+  static FillSpans s_reference_spans;
+  GContext ctx;
+  test_graphics_context_init(&ctx, fb);
+
+  uint32_t seed = 1;
+  for (int n = 0; n < NUM_RANDOM_PATHS; n++) {
+    // mostly small paths on screen, some with coordinates far outside of it
+    const int num_points = 2 + prv_rand(&seed) % (MAX_RANDOM_PATH_POINTS - 1);
+    const int range = (n % 4 == 0) ? 2000 : 100;
+    GPoint points[MAX_RANDOM_PATH_POINTS];
+    for (int i = 0; i < num_points; i++) {
+      points[i] = GPoint(prv_rand(&seed) % (2 * range + 1) - range,
+                         prv_rand(&seed) % (2 * range + 1) - range);
+    }
+    GPath path = {
+      .num_points = num_points,
+      .points = points,
+      .rotation = (n % 2) ? prv_rand(&seed) % TRIG_MAX_ANGLE : 0,
+      .offset = GPoint(prv_rand(&seed) % 200 - 30, prv_rand(&seed) % 200 - 30),
+    };
+    ctx.draw_state.clip_box = GRect(prv_rand(&seed) % 100 - 20, prv_rand(&seed) % 100 - 20,
+                                    prv_rand(&seed) % 200, prv_rand(&seed) % 200);
+    ctx.draw_state.drawing_box.origin = GPoint(prv_rand(&seed) % 20, prv_rand(&seed) % 20);
+
+    s_spans.num_spans = 0;
+    s_reference_spans.num_spans = 0;
+    gpath_draw_filled_with_cb(&ctx, &path, prv_record_span_cb, &s_spans);
+    prv_reference_fill(&ctx, &path, false, &s_reference_spans);
+    prv_check_spans_eq(&s_spans, &s_reference_spans);
+
+#if PBL_COLOR
+    s_spans.num_spans = 0;
+    s_reference_spans.num_spans = 0;
+    prv_fill_path_with_cb_aa(&ctx, &path, prv_record_span_cb, &s_spans);
+    prv_reference_fill(&ctx, &path, true, &s_reference_spans);
+    prv_check_spans_eq(&s_spans, &s_reference_spans);
+#endif
+  }
+}
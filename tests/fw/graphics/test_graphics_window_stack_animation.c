@@ -32,6 +32,8 @@ void window_transition_context_appearance_call_all(WindowTransitioningContext *c
 
 void window_render(Window *window, GContext *ctx) {}
 
+void window_invalidate(Window *window) {}
+
 bool compositor_transition_app_to_app_should_be_skipped(void) {
   return false;
 }
@@ -194,3 +194,65 @@ void test_png__color_256_colors_check(void) {
   cl_assert(gbitmap_pbi_eq(bitmap, TEST_PBI_FILE_FMT(raw)));
   cl_assert_equal_i(gbitmap_get_format(bitmap), GBitmapFormat8Bit);
 }
+
+#define SPLIT_TEST_PNG_FILE "test_png__color_8_bit.8bit.png"
+
+// Tests a PNG with its image data split across many small IDAT chunks, including one that only
+// holds part of the zlib header
+// Result:
+//   - gbitmap matches the one loaded from the unsplit PNG
+void test_png__split_image_data(void) {
+  uint8_t *png_data = NULL;
+  const size_t png_size = load_file(SPLIT_TEST_PNG_FILE, &png_data);
+  uint8_t *split_png_data = NULL;
+  const size_t split_png_size = png_split_data_chunks(png_data, png_size, 1, &split_png_data);
+  cl_assert(split_png_size > png_size);
+
+  GBitmap *expected = gbitmap_create_from_png_data(png_data, png_size);
+  GBitmap *bitmap = gbitmap_create_from_png_data(split_png_data, split_png_size);
+  cl_assert(gbitmap_eq(bitmap, expected, SPLIT_TEST_PNG_FILE));
+  cl_assert(gbitmap_pbi_eq(bitmap, "test_png__color_8_bit.8bit.pbi"));
+}
+
+// Tests a PNG whose image data ends before the end of the deflate stream
+// Result:
+//   - loading fails
+void test_png__truncated_image_data(void) {
+  uint8_t *png_data = NULL;
+  const size_t png_size = load_file(SPLIT_TEST_PNG_FILE, &png_data);
+
+  // Cut the IDAT chunk in half and follow it with IEND
+  const size_t idat_offset = png_find_chunk(png_data, png_size, PNG_CHUNK_IDAT);
+  const size_t iend_offset = png_find_chunk(png_data, png_size, PNG_CHUNK_IEND);
+  cl_assert(idat_offset && iend_offset);
+  const uint32_t idat_length = png_read_be32(png_data + idat_offset) / 2;
+  png_write_be32(png_data + idat_offset, idat_length);
+  const size_t iend_size = png_size - iend_offset;
+  memmove(png_data + idat_offset + 12 + idat_length, png_data + iend_offset, iend_size);
+  const size_t truncated_size = idat_offset + 12 + idat_length + iend_size;
+
+  GBitmap bitmap = {};
+  cl_assert(!gbitmap_init_with_png_data(&bitmap, png_data, truncated_size));
+
+  // Same again with the truncated data split across chunks
+  uint8_t *split_png_data = NULL;
+  const size_t split_png_size = png_split_data_chunks(png_data, truncated_size, 3,
+                                                      &split_png_data);
+  cl_assert(!gbitmap_init_with_png_data(&bitmap, split_png_data, split_png_size));
+}
+
+// Tests a PNG whose deflate stream starts with a block of the reserved type
+// Result:
+//   - loading fails
+void test_png__corrupt_image_data(void) {
+  uint8_t *png_data = NULL;
+  const size_t png_size = load_file(SPLIT_TEST_PNG_FILE, &png_data);
+
+  const size_t idat_offset = png_find_chunk(png_data, png_size, PNG_CHUNK_IDAT);
+  cl_assert(idat_offset);
+  // The first deflate block header follows the 2 byte zlib header, BTYPE 3 is reserved
+  png_data[idat_offset + 8 + 2] |= 0x06;
+
+  GBitmap bitmap = {};
+  cl_assert(!gbitmap_init_with_png_data(&bitmap, png_data, png_size));
+}
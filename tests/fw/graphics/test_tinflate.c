@@ -0,0 +1,165 @@
+/* SPDX-FileCopyrightText: 2024 Google LLC */
+/* SPDX-License-Identifier: Apache-2.0 */
+
+#include "applib/vendor/tinflate/tinflate.h"
+#include "util/math.h"
+#include "util/size.h"
+
+#include "clar.h"
+
+#include <string.h>
+
+// Stubs
+////////////////////////////////////
+#include "stubs_pbl_malloc.h"
+
+// Raw deflate stream of TEST_DATA_SIZE bytes of prv_test_data_byte(), compressed with a 1k window
+// so that it refers back TEST_DATA_PERIOD bytes
+static const uint8_t s_compressed[] = {
+  0x63, 0x60, 0x62, 0x60, 0x66, 0x64, 0x60, 0x62, 0x64, 0x46, 0xd0, 0x28,
+  0x1c, 0x10, 0x8d, 0xa1, 0x82, 0x19, 0x5d, 0x05, 0x23, 0xa6, 0x0a, 0x06,
+  0x22, 0x0c, 0x66, 0x24, 0xc2, 0xe0, 0xa1, 0xe8, 0x1e, 0x4a, 0x0c, 0x1e,
+  0x8d, 0x8f, 0xd1, 0xf8, 0x18, 0x8d, 0x0f, 0x9c, 0x06, 0x03, 0x00,
+};
+
+#define TEST_DATA_SIZE 1200
+#define TEST_DATA_PERIOD 400
+
+static uint8_t prv_test_data_byte(unsigned int i) {
+  return ((i % TEST_DATA_PERIOD) * 2654435761u) >> 30;
+}
+
+typedef struct {
+  const uint8_t *data;
+  unsigned int size;
+  unsigned int pos;
+  //! The most bytes handed out per read, to check that input can arrive in pieces of any size
+  unsigned int max_read;
+} TestInput;
+
+static unsigned int prv_read(void *context, unsigned char *buf, unsigned int len) {
+  TestInput *input = context;
+  len = MIN(len, MIN(input->max_read, input->size - input->pos));
+  memcpy(buf, input->data + input->pos, len);
+  input->pos += len;
+  return len;
+}
+
+//! Inflates TEST_DATA_SIZE bytes in reads of read_size bytes
+//! @return the status of the first read that failed, TINF_OK if none did
+static int prv_inflate(TestInput *input, unsigned int window_size, unsigned int read_size,
+                       uint8_t *out) {
+  TINF_STREAM *stream = tinflate_stream_create(window_size, prv_read, input);
+  cl_assert(stream);
+  int status = TINF_OK;
+  for (unsigned int pos = 0; (pos < TEST_DATA_SIZE) && (status == TINF_OK); pos += read_size) {
+    status = tinflate_stream_read(stream, out + pos, MIN(read_size, TEST_DATA_SIZE - pos));
+  }
+  tinflate_stream_destroy(stream);
+  return status;
+}
+
+static void prv_check_test_data(const uint8_t *out) {
+  for (unsigned int i = 0; i < TEST_DATA_SIZE; i++) {
+    cl_assert_equal_i(out[i], prv_test_data_byte(i));
+  }
+}
+
+void test_tinflate__whole_stream_without_window(void) {
+  TestInput input = { .data = s_compressed, .size = sizeof(s_compressed), .max_read = 64 };
+  uint8_t out[TEST_DATA_SIZE];
+  cl_assert_equal_i(prv_inflate(&input, 0, TEST_DATA_SIZE, out), TINF_OK);
+  prv_check_test_data(out);
+}
+
+void test_tinflate__pieces_through_window(void) {
+  const unsigned int window_sizes[] = { TEST_DATA_PERIOD, 512, 1024 };
+  const unsigned int read_sizes[] = { 1, 7, 401 };
+  for (unsigned int w = 0; w < ARRAY_LENGTH(window_sizes); w++) {
+    for (unsigned int r = 0; r < ARRAY_LENGTH(read_sizes); r++) {
+      // input arriving one byte at a time is like a stream split across many chunks
+      TestInput input = { .data = s_compressed, .size = sizeof(s_compressed), .max_read = 1 };
+      uint8_t out[TEST_DATA_SIZE] = {};
+      cl_assert_equal_i(prv_inflate(&input, window_sizes[w], read_sizes[r], out), TINF_OK);
+      prv_check_test_data(out);
+    }
+  }
+}
+
+void test_tinflate__window_too_small(void) {
+  TestInput input = { .data = s_compressed, .size = sizeof(s_compressed), .max_read = 64 };
+  uint8_t out[TEST_DATA_SIZE];
+  cl_assert_equal_i(prv_inflate(&input, TEST_DATA_PERIOD - 1, 100, out), TINF_DATA_ERROR);
+}
+
+void test_tinflate__truncated(void) {
+  // The last byte only holds the end of block code, which isn't needed to produce the data
+  for (unsigned int size = 0; size < sizeof(s_compressed) - 1; size++) {
+    TestInput input = { .data = s_compressed, .size = size, .max_read = 64 };
+    uint8_t out[TEST_DATA_SIZE];
+    cl_assert_equal_i(prv_inflate(&input, 512, 100, out), TINF_DATA_ERROR);
+  }
+}
+
+void test_tinflate__reading_past_the_end(void) {
+  TestInput input = { .data = s_compressed, .size = sizeof(s_compressed), .max_read = 64 };
+  TINF_STREAM *stream = tinflate_stream_create(512, prv_read, &input);
+  uint8_t out[TEST_DATA_SIZE + 1];
+  cl_assert_equal_i(tinflate_stream_read(stream, out, sizeof(out)), TINF_DATA_ERROR);
+  tinflate_stream_destroy(stream);
+}
+
+void test_tinflate__corrupt(void) {
+  uint8_t corrupt[sizeof(s_compressed)];
+  uint8_t out[TEST_DATA_SIZE];
+
+  // BTYPE 3 is reserved
+  memcpy(corrupt, s_compressed, sizeof(corrupt));
+  corrupt[0] |= 0x06;
+  TestInput input = { .data = corrupt, .size = sizeof(corrupt), .max_read = 64 };
+  cl_assert_equal_i(prv_inflate(&input, 512, 100, out), TINF_DATA_ERROR);
+
+  // Garbage must never make the decoder read or write out of bounds, whatever it returns
+  for (unsigned int i = 0; i < sizeof(corrupt); i++) {
+    memcpy(corrupt, s_compressed, sizeof(corrupt));
+    corrupt[i] ^= 0xa5;
+    input = (TestInput) { .data = corrupt, .size = sizeof(corrupt), .max_read = 64 };
+    prv_inflate(&input, 512, 100, out);
+    input = (TestInput) { .data = corrupt, .size = sizeof(corrupt), .max_read = 64 };
+    prv_inflate(&input, 0, TEST_DATA_SIZE, out);
+  }
+}
+
+void test_tinflate__stored_blocks(void) {
+  // Two stored blocks, the second one final, with the test data split between them
+  const unsigned int first_size = 700;
+  const unsigned int second_size = TEST_DATA_SIZE - first_size;
+  uint8_t stored[TEST_DATA_SIZE + 10];
+  unsigned int pos = 0;
+  stored[pos++] = 0x00;
+  stored[pos++] = first_size & 0xff;
+  stored[pos++] = first_size >> 8;
+  stored[pos++] = ~first_size & 0xff;
+  stored[pos++] = (~first_size >> 8) & 0xff;
+  for (unsigned int i = 0; i < first_size; i++) {
+    stored[pos++] = prv_test_data_byte(i);
+  }
+  stored[pos++] = 0x01;
+  stored[pos++] = second_size & 0xff;
+  stored[pos++] = second_size >> 8;
+  stored[pos++] = ~second_size & 0xff;
+  stored[pos++] = (~second_size >> 8) & 0xff;
+  for (unsigned int i = first_size; i < TEST_DATA_SIZE; i++) {
+    stored[pos++] = prv_test_data_byte(i);
+  }
+
+  TestInput input = { .data = stored, .size = pos, .max_read = 3 };
+  uint8_t out[TEST_DATA_SIZE] = {};
+  cl_assert_equal_i(prv_inflate(&input, 256, 33, out), TINF_OK);
+  prv_check_test_data(out);
+
+  // LEN and NLEN have to match
+  stored[3] ^= 0x01;
+  input = (TestInput) { .data = stored, .size = pos, .max_read = 3 };
+  cl_assert_equal_i(prv_inflate(&input, 256, 33, out), TINF_DATA_ERROR);
+}
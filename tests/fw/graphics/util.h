@@ -453,6 +453,80 @@ static GBitmap* setup_png_test(const char *filename) {
   return gbitmap_create_from_png_data(png_data, png_size);
 }
 
+#define PNG_CHUNK_IDAT 0x49444154
+#define PNG_CHUNK_FDAT 0x66644154
+#define PNG_CHUNK_IEND 0x49454e44
+
+static uint32_t png_read_be32(const uint8_t *data) {
+  return ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) | ((uint32_t)data[2] << 8) | data[3];
+}
+
+static void png_write_be32(uint8_t *data, uint32_t value) {
+  data[0] = value >> 24;
+  data[1] = value >> 16;
+  data[2] = value >> 8;
+  data[3] = value;
+}
+
+// Rewrites a PNG or APNG with the data of every IDAT and fdAT chunk split across consecutive
+// chunks of the same type holding at most max_data_bytes each. The CRCs are left as 0 since upng
+// doesn't check them.
+static size_t png_split_data_chunks(const uint8_t *png, size_t png_size, size_t max_data_bytes,
+                                    uint8_t **split_png) {
+  const size_t signature_size = 8;
+  // every extra piece costs a chunk header, a sequence number and a CRC
+  size_t max_out_size = png_size;
+  for (size_t offset = signature_size; offset + 12 <= png_size;
+       offset += png_read_be32(png + offset) + 12) {
+    max_out_size += (png_read_be32(png + offset) / max_data_bytes + 1) * 16;
+  }
+  uint8_t *out = malloc(max_out_size);
+  cl_assert(out);
+  memcpy(out, png, signature_size);
+  size_t out_size = signature_size;
+
+  size_t offset = signature_size;
+  while (offset + 12 <= png_size) {
+    const uint32_t length = png_read_be32(png + offset);
+    const uint32_t type = png_read_be32(png + offset + 4);
+    const uint8_t *data = png + offset + 8;
+    cl_assert(offset + length + 12 <= png_size);
+
+    if ((type == PNG_CHUNK_IDAT) || (type == PNG_CHUNK_FDAT)) {
+      // each fdAT chunk starts with a sequence number, which upng doesn't check either
+      const size_t header_size = (type == PNG_CHUNK_FDAT) ? 4 : 0;
+      for (size_t pos = header_size; pos < length; pos += max_data_bytes) {
+        const size_t piece = MIN(max_data_bytes, length - pos);
+        png_write_be32(out + out_size, header_size + piece);
+        png_write_be32(out + out_size + 4, type);
+        memcpy(out + out_size + 8, data, header_size);
+        memcpy(out + out_size + 8 + header_size, data + pos, piece);
+        png_write_be32(out + out_size + 8 + header_size + piece, 0);
+        out_size += 12 + header_size + piece;
+      }
+    } else {
+      memcpy(out + out_size, png + offset, length + 12);
+      out_size += length + 12;
+    }
+    offset += length + 12;
+  }
+
+  *split_png = out;
+  return out_size;
+}
+
+//! @return the offset of the first chunk of the given type, or 0 if there is none
+static size_t png_find_chunk(const uint8_t *png, size_t png_size, uint32_t chunk_type) {
+  size_t offset = 8;
+  while (offset + 12 <= png_size) {
+    if (png_read_be32(png + offset + 4) == chunk_type) {
+      return offset;
+    }
+    offset += png_read_be32(png + offset) + 12;
+  }
+  return 0;
+}
+
 void setup_test_aa_sw(GContext *ctx, FrameBuffer *fb, GRect clip_box, GRect drawing_box,
                              bool antialiased, uint8_t stroke_width) {
   test_graphics_context_reset(ctx, fb);
@@ -0,0 +1,265 @@
+/* SPDX-FileCopyrightText: 2024 Google LLC */
+/* SPDX-License-Identifier: Apache-2.0 */
+
+#include "kernel/task_timer.h"
+#include "kernel/task_timer_manager.h"
+
+#include "fakes/fake_rtc.h"
+
+#include "clar.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Stubs
+///////////////////////////////////////////////////////////
+
+#include "fake_pebble_tasks.h"
+#include "stubs_logging.h"
+#include "stubs_mutex.h"
+#include "stubs_passert.h"
+#include "stubs_pbl_malloc.h"
+#include "stubs_tick.h"
+
+static int s_semaphore_gives;
+
+signed portBASE_TYPE xQueueGenericSend(QueueHandle_t xQueue, const void * const pvItemToQueue,
+                                       TickType_t xTicksToWait, portBASE_TYPE xCopyPosition) {
+  s_semaphore_gives++;
+  return pdTRUE;
+}
+
+// Helpers
+///////////////////////////////////////////////////////////
+
+#define NUM_TIMERS 500
+#define MAX_TIMEOUT_MS 10000
+
+//! Shadow copy of what each timer should be doing
+typedef struct {
+  TaskTimerID id;
+  bool scheduled;
+  RtcTicks expire_ticks;
+  //! Order in which the timer was last scheduled, to order timers that expire on the same tick
+  uint32_t seq;
+} TimerModel;
+
+static TaskTimerManager s_manager;
+static TimerModel s_model[NUM_TIMERS];
+static uint32_t s_next_seq;
+static uint32_t s_rand_state;
+
+static int s_fired[NUM_TIMERS * 4];
+static int s_num_fired;
+
+static uint32_t prv_rand(void) {
+  s_rand_state = s_rand_state * 1103515245 + 12345;
+  return s_rand_state >> 16;
+}
+
+static void prv_record_cb(void *data) {
+  s_fired[s_num_fired++] = (int)(uintptr_t)data;
+}
+
+static void prv_start(int index, uint32_t timeout_ms) {
+  TimerModel *model = &s_model[index];
+  cl_assert(task_timer_start(&s_manager, model->id, timeout_ms, prv_record_cb,
+                             (void *)(uintptr_t)index, 0));
+  model->scheduled = true;
+  model->expire_ticks = rtc_get_ticks() + milliseconds_to_ticks(timeout_ms);
+  model->seq = s_next_seq++;
+}
+
+static void prv_stop(int index) {
+  cl_assert(task_timer_stop(&s_manager, s_model[index].id));
+  s_model[index].scheduled = false;
+}
+
+static int prv_model_compare(const void *a, const void *b) {
+  const TimerModel *ma = &s_model[*(const int *)a];
+  const TimerModel *mb = &s_model[*(const int *)b];
+  if (ma->expire_ticks != mb->expire_ticks) {
+    return (ma->expire_ticks < mb->expire_ticks) ? -1 : 1;
+  }
+  return (ma->seq < mb->seq) ? -1 : 1;
+}
+
+//! Runs the expired timers and checks that exactly the timers the model expects fired, in order
+static void prv_execute_and_check(void) {
+  const RtcTicks now = rtc_get_ticks();
+  int expected[NUM_TIMERS];
+  int num_expected = 0;
+  for (int i = 0; i < NUM_TIMERS; i++) {
+    if (s_model[i].scheduled && s_model[i].expire_ticks <= now) {
+      expected[num_expected++] = i;
+    }
+  }
+  qsort(expected, num_expected, sizeof(int), prv_model_compare);
+
+  s_num_fired = 0;
+  const TickType_t ticks_to_wait = task_timer_manager_execute_expired_timers(&s_manager);
+
+  cl_assert_equal_i(s_num_fired, num_expected);
+  for (int i = 0; i < num_expected; i++) {
+    cl_assert_equal_i(s_fired[i], expected[i]);
+    s_model[expected[i]].scheduled = false;
+  }
+
+  // The returned wait is the time until the earliest timer that's still scheduled
+  RtcTicks next_expire = 0;
+  for (int i = 0; i < NUM_TIMERS; i++) {
+    if (s_model[i].scheduled && (!next_expire || s_model[i].expire_ticks < next_expire)) {
+      next_expire = s_model[i].expire_ticks;
+    }
+  }
+  if (next_expire) {
+    cl_assert_equal_i(ticks_to_wait, next_expire - now);
+  } else {
+    cl_assert_equal_i(ticks_to_wait, portMAX_DELAY);
+  }
+}
+
+static void prv_create_timers(void) {
+  for (int i = 0; i < NUM_TIMERS; i++) {
+    s_model[i] = (TimerModel) { .id = task_timer_create(&s_manager) };
+    cl_assert(s_model[i].id != TASK_TIMER_INVALID_ID);
+  }
+}
+
+static void prv_delete_timers(void) {
+  for (int i = 0; i < NUM_TIMERS; i++) {
+    task_timer_delete(&s_manager, s_model[i].id);
+  }
+  cl_assert_equal_i(s_manager.num_timers, 0);
+  cl_assert_equal_i(s_manager.num_running_timers, 0);
+}
+
+// Tests
+///////////////////////////////////////////////////////////
+
+void test_task_timer__initialize(void) {
+  fake_rtc_init(100, 0);
+  task_timer_manager_init(&s_manager, NULL);
+  memset(s_model, 0, sizeof(s_model));
+  s_next_seq = 0;
+  s_rand_state = 1;
+  s_num_fired = 0;
+  s_semaphore_gives = 0;
+}
+
+void test_task_timer__cleanup(void) {
+  kernel_free(s_manager.running_timers);
+  kernel_free(s_manager.timers_by_id);
+}
+
+void test_task_timer__expire_in_order(void) {
+  prv_create_timers();
+  for (int i = 0; i < NUM_TIMERS; i++) {
+    // Coarse timeouts so that lots of timers expire on the same tick
+    prv_start(i, (prv_rand() % 50) * 100);
+  }
+  fake_rtc_increment_ticks(milliseconds_to_ticks(MAX_TIMEOUT_MS));
+  prv_execute_and_check();
+  cl_assert_equal_i(s_num_fired, NUM_TIMERS);
+  prv_delete_timers();
+}
+
+void test_task_timer__stress_500_timers(void) {
+  prv_create_timers();
+  for (int round = 0; round < 200; round++) {
+    for (int op = 0; op < 50; op++) {
+      const int index = prv_rand() % NUM_TIMERS;
+      switch (prv_rand() % 4) {
+        case 0:
+          prv_stop(index);
+          break;
+        case 1: {
+          // Reschedules the timer if it's already scheduled
+          prv_start(index, prv_rand() % MAX_TIMEOUT_MS);
+          break;
+        }
+        case 2: {
+          uint32_t expire_ms;
+          const bool scheduled = task_timer_scheduled(&s_manager, s_model[index].id, &expire_ms);
+          cl_assert_equal_b(scheduled, s_model[index].scheduled);
+          break;
+        }
+        case 3: {
+          // Replace the timer entirely
+          task_timer_delete(&s_manager, s_model[index].id);
+          s_model[index] = (TimerModel) { .id = task_timer_create(&s_manager) };
+          prv_start(index, prv_rand() % MAX_TIMEOUT_MS);
+          break;
+        }
+      }
+    }
+    fake_rtc_increment_ticks(prv_rand() % milliseconds_to_ticks(MAX_TIMEOUT_MS / 10));
+    prv_execute_and_check();
+  }
+  fake_rtc_increment_ticks(milliseconds_to_ticks(MAX_TIMEOUT_MS));
+  prv_execute_and_check();
+  cl_assert_equal_i(s_manager.num_running_timers, 0);
+  cl_assert_equal_i(s_manager.num_timers, NUM_TIMERS);
+  prv_delete_timers();
+}
+
+void test_task_timer__semaphore_given_for_new_head(void) {
+  TaskTimerID a = task_timer_create(&s_manager);
+  TaskTimerID b = task_timer_create(&s_manager);
+  TaskTimerID c = task_timer_create(&s_manager);
+
+  task_timer_start(&s_manager, a, 1000, prv_record_cb, NULL, 0);
+  cl_assert_equal_i(s_semaphore_gives, 1);
+  // Not the earliest timer, the task doesn't need to recompute its timeout
+  task_timer_start(&s_manager, b, 2000, prv_record_cb, NULL, 0);
+  cl_assert_equal_i(s_semaphore_gives, 1);
+  task_timer_start(&s_manager, c, 500, prv_record_cb, NULL, 0);
+  cl_assert_equal_i(s_semaphore_gives, 2);
+
+  cl_assert(!task_timer_start(&s_manager, c, 100, prv_record_cb, NULL,
+                              TIMER_START_FLAG_FAIL_IF_SCHEDULED));
+  cl_assert_equal_i(s_semaphore_gives, 2);
+
+  task_timer_delete(&s_manager, a);
+  task_timer_delete(&s_manager, b);
+  task_timer_delete(&s_manager, c);
+}
+
+static TaskTimerID s_repeating_timer;
+static int s_repeating_count;
+
+static void prv_repeating_cb(void *data) {
+  s_repeating_count++;
+  // Can't reschedule ourselves while we're executing if asked not to
+  cl_assert(!task_timer_start(&s_manager, s_repeating_timer, 10, prv_repeating_cb, NULL,
+                              TIMER_START_FLAG_FAIL_IF_EXECUTING));
+  if (s_repeating_count == 5) {
+    // Deleting from our own callback is deferred until the callback returns
+    task_timer_delete(&s_manager, s_repeating_timer);
+  }
+}
+
+void test_task_timer__repeating_and_deferred_delete(void) {
+  s_repeating_count = 0;
+  s_repeating_timer = task_timer_create(&s_manager);
+  TaskTimerID other = task_timer_create(&s_manager);
+  task_timer_start(&s_manager, s_repeating_timer, 100, prv_repeating_cb, NULL,
+                   TIMER_START_FLAG_REPEATING);
+  task_timer_start(&s_manager, other, 250, prv_record_cb, (void *)7, 0);
+
+  // Catches up on every period that has elapsed
+  fake_rtc_increment_ticks(milliseconds_to_ticks(350));
+  task_timer_manager_execute_expired_timers(&s_manager);
+  cl_assert_equal_i(s_repeating_count, 3);
+  cl_assert_equal_i(s_num_fired, 1);
+  cl_assert_equal_i(s_fired[0], 7);
+
+  fake_rtc_increment_ticks(milliseconds_to_ticks(1000));
+  const TickType_t ticks_to_wait = task_timer_manager_execute_expired_timers(&s_manager);
+  cl_assert_equal_i(s_repeating_count, 5);
+  cl_assert_equal_i(ticks_to_wait, portMAX_DELAY);
+  cl_assert_equal_i(s_manager.num_timers, 1);
+
+  task_timer_delete(&s_manager, other);
+  cl_assert_equal_i(s_manager.num_timers, 0);
+}
@@ -717,6 +717,11 @@ bool activity_algorithm_get_minute_history(HealthMinuteData *minute_data, uint32
   return true;
 }
 
+bool activity_algorithm_get_minute_aggregate(time_t utc_start, time_t utc_end,
+                                             ActivityMinuteAggregate *aggregate) {
+  return false;
+}
+
 time_t activity_algorithm_get_last_sleep_utc(void) {
   return s_test_alg_state.last_sleep_utc;
 }
@@ -19,6 +19,7 @@
 #include "util/math.h"
 #include "util/size.h"
 
+#include <inttypes.h>
 #include <stdint.h>
 #include <string.h>
 #include <applib/health_service.h>
@@ -682,6 +683,370 @@ void test_activity_algorithm_kraepelin__get_ram_minute_history(void) {
 }
 
 
+// ---------------------------------------------------------------------------------------
+// Fill in a minute file record whose minutes have steps step_base, step_base + 1, ...
+static void prv_init_test_file_record(AlgMinuteFileRecord *record, time_t utc,
+                                      uint8_t step_base) {
+  *record = (AlgMinuteFileRecord) {
+    .hdr = {
+      .version = ALG_MINUTE_FILE_RECORD_VERSION,
+      .time_utc = utc,
+      .sample_size = sizeof(AlgMinuteFileSample),
+      .num_samples = ALG_MINUTES_PER_FILE_RECORD,
+    },
+  };
+  for (int i = 0; i < ALG_MINUTES_PER_FILE_RECORD; i++) {
+    record->samples[i].v5_fields.steps = step_base + i;
+    record->samples[i].v5_fields.vmc = 100 + i;
+    record->samples[i].heart_rate_bpm = 60 + i;
+  }
+}
+
+// Write records into a settings file the way prior releases stored the minute data
+static void prv_write_legacy_minute_file(const char *name, time_t first_utc, int num_records) {
+  SettingsFile file;
+  cl_assert_equal_i(settings_file_open(&file, name, ALG_MINUTE_DATA_FILE_LEN), S_SUCCESS);
+  const int k_seconds_per_record = ALG_MINUTES_PER_FILE_RECORD * SECONDS_PER_MINUTE;
+  for (int i = 0; i < num_records; i++) {
+    AlgMinuteFileRecord record;
+    time_t utc = first_utc + i * k_seconds_per_record;
+    prv_init_test_file_record(&record, utc, i);
+    uint32_t key = utc / k_seconds_per_record;
+    cl_assert_equal_i(settings_file_set(&file, &key, sizeof(key), &record, sizeof(record)),
+                      S_SUCCESS);
+  }
+  settings_file_close(&file);
+}
+
+
+// ---------------------------------------------------------------------------------------
+// Test that the minute data saved in the settings file by prior releases gets moved into the
+// minute file ring at init
+void test_activity_algorithm_kraepelin__minute_file_migration(void) {
+  const int k_num_records = 16;
+  const int k_seconds_per_record = ALG_MINUTES_PER_FILE_RECORD * SECONDS_PER_MINUTE;
+  const int num_minutes = k_num_records * ALG_MINUTES_PER_FILE_RECORD;
+  time_t now = rtc_get_time();
+  time_t start_utc = now - k_num_records * k_seconds_per_record;
+
+  activity_algorithm_deinit();
+  prv_write_legacy_minute_file("activity_sleep", start_utc, k_num_records);
+  {
+    // Add a record too old to fit in the ring and one with an unknown version
+    SettingsFile file;
+    settings_file_open(&file, "activity_sleep", ALG_MINUTE_DATA_FILE_LEN);
+    AlgMinuteFileRecord record;
+    time_t old_utc = now - (ALG_MINUTE_FILE_MAX_ENTRIES + 10) * k_seconds_per_record;
+    prv_init_test_file_record(&record, old_utc, 0);
+    uint32_t key = old_utc / k_seconds_per_record;
+    settings_file_set(&file, &key, sizeof(key), &record, sizeof(record));
+    prv_init_test_file_record(&record, now, 0);
+    record.hdr.version = ALG_MINUTE_FILE_RECORD_VERSION + 1;
+    key = now / k_seconds_per_record;
+    settings_file_set(&file, &key, sizeof(key), &record, sizeof(record));
+    settings_file_close(&file);
+  }
+  activity_algorithm_init(&s_sample_rate);
+
+  // The legacy file is gone
+  cl_assert(pfs_open("activity_sleep", OP_FLAG_READ, 0, 0) < 0);
+
+  // And all of its valid records are in the ring, even after another reboot
+  for (int boot = 0; boot < 2; boot++) {
+    uint32_t num_records;
+    uint32_t data_bytes;
+    uint32_t minutes;
+    cl_assert(activity_algorithm_minute_file_info(false /*compact_first*/, &num_records,
+                                                  &data_bytes, &minutes));
+    cl_assert_equal_i(num_records, k_num_records);
+
+    HealthMinuteData retrieve[num_minutes];
+    num_records = num_minutes;
+    time_t start = start_utc;
+    activity_algorithm_get_minute_history(retrieve, &num_records, &start);
+    cl_assert_equal_i(num_records, num_minutes);
+    cl_assert_equal_i(start, start_utc);
+    for (int i = 0; i < num_minutes; i++) {
+      int record_idx = i / ALG_MINUTES_PER_FILE_RECORD;
+      int sample_idx = i % ALG_MINUTES_PER_FILE_RECORD;
+      cl_assert_equal_i(retrieve[i].steps, (uint8_t)(record_idx + sample_idx));
+      cl_assert_equal_i(retrieve[i].vmc, 100 + sample_idx);
+      cl_assert_equal_i(retrieve[i].heart_rate_bpm, 60 + sample_idx);
+    }
+
+    activity_algorithm_deinit();
+    activity_algorithm_init(&s_sample_rate);
+  }
+}
+
+
+// ---------------------------------------------------------------------------------------
+// Test that if we reboot after the records of the legacy file were copied but before the file
+// got removed, copying them again leaves the ring as it is
+void test_activity_algorithm_kraepelin__minute_file_migration_retried(void) {
+  const int k_num_records = 16;
+  const int k_seconds_per_record = ALG_MINUTES_PER_FILE_RECORD * SECONDS_PER_MINUTE;
+  time_t start_utc = rtc_get_time() - k_num_records * k_seconds_per_record;
+
+  activity_algorithm_deinit();
+  prv_write_legacy_minute_file("activity_sleep", start_utc, k_num_records);
+  uint32_t start_writes = fake_flash_write_count();
+  activity_algorithm_init(&s_sample_rate);
+  const uint32_t first_writes = fake_flash_write_count() - start_writes;
+
+  activity_algorithm_deinit();
+  prv_write_legacy_minute_file("activity_sleep", start_utc, k_num_records);
+  start_writes = fake_flash_write_count();
+  activity_algorithm_init(&s_sample_rate);
+  const uint32_t retry_writes = fake_flash_write_count() - start_writes;
+
+  // None of the records are written again, which takes at least one write each
+  cl_assert(retry_writes + k_num_records <= first_writes);
+  cl_assert(pfs_open("activity_sleep", OP_FLAG_READ, 0, 0) < 0);
+
+  uint32_t num_records;
+  uint32_t data_bytes;
+  uint32_t minutes;
+  cl_assert(activity_algorithm_minute_file_info(false /*compact_first*/, &num_records,
+                                                &data_bytes, &minutes));
+  cl_assert_equal_i(num_records, k_num_records);
+}
+
+
+// ---------------------------------------------------------------------------------------
+// Test that if the clock gets moved back, the minutes we record again replace the ones that
+// were already in the minute file
+void test_activity_algorithm_kraepelin__minute_file_clock_moved_back(void) {
+  const int num_minutes = 2 * MINUTES_PER_HOUR;
+  time_t start_utc = rtc_get_time();
+
+  AlgMinuteDLSSample minute_data[num_minutes];
+  prv_create_test_data(num_minutes, minute_data);
+  prv_feed_minute_data(num_minutes, minute_data, false /*simulate_bg_delays*/);
+
+  // Go back an hour and record that hour again, with different data
+  const int num_redone_minutes = MINUTES_PER_HOUR;
+  AlgMinuteDLSSample redone_data[num_redone_minutes];
+  prv_create_test_data(num_redone_minutes, redone_data);
+  for (int i = 0; i < num_redone_minutes; i++) {
+    redone_data[i].base.steps += 100;
+    redone_data[i].base.vmc += 100;
+  }
+  rtc_set_time(start_utc + MINUTES_PER_HOUR * SECONDS_PER_MINUTE);
+  prv_feed_minute_data(num_redone_minutes, redone_data, false /*simulate_bg_delays*/);
+
+  // Reboot so that we only see what made it to flash
+  activity_algorithm_deinit();
+  activity_algorithm_init(&s_sample_rate);
+
+  HealthMinuteData retrieve[num_minutes];
+  uint32_t num_records = num_minutes;
+  time_t start = start_utc;
+  activity_algorithm_get_minute_history(retrieve, &num_records, &start);
+  cl_assert_equal_i(num_records, num_minutes);
+  cl_assert_equal_i(start, start_utc);
+  for (int i = 0; i < num_minutes - num_redone_minutes; i++) {
+    prv_assert_minute_data(&retrieve[i], &minute_data[i]);
+  }
+  for (int i = 0; i < num_redone_minutes; i++) {
+    prv_assert_minute_data(&retrieve[num_minutes - num_redone_minutes + i], &redone_data[i]);
+  }
+}
+
+
+// ---------------------------------------------------------------------------------------
+// Test that reading back an hour of a week of minute data only touches the flash of that hour,
+// where the settings file used by prior releases had to be scanned in full each time
+typedef struct {
+  uint32_t oldest_key;
+  uint32_t newest_key;
+  uint32_t num_found;
+} LegacyReadContext;
+
+static bool prv_legacy_read_cb(SettingsFile *file, SettingsRecordInfo *info, void *context_arg) {
+  LegacyReadContext *context = context_arg;
+  uint32_t key;
+  info->get_key(file, &key, sizeof(key));
+  if (key < context->oldest_key || key > context->newest_key) {
+    return true;
+  }
+  AlgMinuteFileRecord record;
+  info->get_val(file, &record, sizeof(record));
+  context->num_found++;
+  return true;
+}
+
+void test_activity_algorithm_kraepelin__minute_file_flash_reads(void) {
+  const int k_records_per_hour = MINUTES_PER_HOUR / ALG_MINUTES_PER_FILE_RECORD;
+  const int k_num_hours = DAYS_PER_WEEK * HOURS_PER_DAY;
+  const int k_num_records = k_num_hours * k_records_per_hour;
+  const int k_seconds_per_record = ALG_MINUTES_PER_FILE_RECORD * SECONDS_PER_MINUTE;
+  time_t now = rtc_get_time();
+
+  // Settings file, as used by prior releases
+  time_t week_start_utc = now - k_num_records * k_seconds_per_record;
+  prv_write_legacy_minute_file("legacy_minutes", week_start_utc, k_num_records);
+
+  SettingsFile file;
+  settings_file_open(&file, "legacy_minutes", ALG_MINUTE_DATA_FILE_LEN);
+  uint32_t start_reads = fake_flash_read_count();
+  for (int hour = 0; hour < k_num_hours; hour++) {
+    uint32_t first_key = week_start_utc / k_seconds_per_record + hour * k_records_per_hour;
+    LegacyReadContext context = {
+      .oldest_key = first_key,
+      .newest_key = first_key + k_records_per_hour - 1,
+    };
+    settings_file_each(&file, prv_legacy_read_cb, &context);
+    cl_assert_equal_i(context.num_found, k_records_per_hour);
+  }
+  const uint32_t legacy_reads = fake_flash_read_count() - start_reads;
+  settings_file_close(&file);
+
+  // Minute file ring. The test fill writes records up to the current minute, more than a week.
+  cl_assert(activity_algorithm_test_fill_minute_file());
+
+  // The test fill stops a minute short of now, so read the week that ends an hour ago
+  start_reads = fake_flash_read_count();
+  for (int hour = 0; hour < k_num_hours; hour++) {
+    HealthMinuteData retrieve[MINUTES_PER_HOUR];
+    uint32_t num_records = MINUTES_PER_HOUR;
+    time_t start_utc = week_start_utc + (hour - 1) * SECONDS_PER_HOUR;
+    activity_algorithm_get_minute_history(retrieve, &num_records, &start_utc);
+    cl_assert_equal_i(num_records, MINUTES_PER_HOUR);
+  }
+  const uint32_t ring_reads = fake_flash_read_count() - start_reads;
+
+  // Reading an hour should only touch the slots of that hour, not the whole week
+  cl_assert(ring_reads * 10 < legacy_reads);
+}
+
+
+// ---------------------------------------------------------------------------------------
+// Compute the aggregate of a range the slow way, by going through each minute of its history
+static void prv_aggregate_from_minute_history(time_t utc_start, time_t utc_end,
+                                              ActivityMinuteAggregate *expected) {
+  *expected = (ActivityMinuteAggregate) { };
+  HealthMinuteData minutes[MINUTES_PER_DAY];
+  uint32_t num_records = ARRAY_LENGTH(minutes);
+  activity_algorithm_get_minute_history(minutes, &num_records, &utc_start);
+  for (uint32_t i = 0; (i < num_records) && (utc_start < utc_end);
+       i++, utc_start += SECONDS_PER_MINUTE) {
+    expected->steps += minutes[i].steps;
+    expected->active_minutes += (minutes[i].steps >= ACTIVITY_ACTIVE_MINUTE_MIN_STEPS);
+    const uint8_t bpm = minutes[i].heart_rate_bpm;
+    if (bpm == 0) {
+      continue;
+    }
+    if (expected->heart_rate_samples == 0) {
+      expected->heart_rate_min_bpm = bpm;
+      expected->heart_rate_max_bpm = bpm;
+    }
+    expected->heart_rate_samples++;
+    expected->heart_rate_sum_bpm += bpm;
+    expected->heart_rate_min_bpm = MIN(expected->heart_rate_min_bpm, bpm);
+    expected->heart_rate_max_bpm = MAX(expected->heart_rate_max_bpm, bpm);
+  }
+}
+
+// Add up the distance and calories of the minutes fed in from utc_start to utc_end. The minute
+// history doesn't have these.
+static void prv_aggregate_from_test_data(const AlgMinuteDLSSample *minute_data, time_t first_utc,
+                                         time_t utc_start, time_t utc_end,
+                                         ActivityMinuteAggregate *expected) {
+  for (time_t utc = utc_start; utc < utc_end; utc += SECONDS_PER_MINUTE) {
+    const AlgMinuteDLSSample *sample = &minute_data[(utc - first_utc) / SECONDS_PER_MINUTE];
+    expected->distance_cm += sample->distance_cm;
+    expected->resting_calories += sample->resting_calories;
+    expected->active_calories += sample->active_calories;
+  }
+}
+
+static void prv_assert_aggregate_equal(const ActivityMinuteAggregate *actual,
+                                       const ActivityMinuteAggregate *expected,
+                                       bool check_distance_and_calories) {
+  cl_assert_equal_i(actual->steps, expected->steps);
+  cl_assert_equal_i(actual->active_minutes, expected->active_minutes);
+  cl_assert_equal_i(actual->heart_rate_samples, expected->heart_rate_samples);
+  cl_assert_equal_i(actual->heart_rate_sum_bpm, expected->heart_rate_sum_bpm);
+  cl_assert_equal_i(actual->heart_rate_min_bpm, expected->heart_rate_min_bpm);
+  cl_assert_equal_i(actual->heart_rate_max_bpm, expected->heart_rate_max_bpm);
+  if (check_distance_and_calories) {
+    cl_assert_equal_i(actual->distance_cm, expected->distance_cm);
+    cl_assert_equal_i(actual->resting_calories, expected->resting_calories);
+    cl_assert_equal_i(actual->active_calories, expected->active_calories);
+  }
+}
+
+// Range queries answered from the aggregate index should match what we get by going through the
+// minute history of the range
+void test_activity_algorithm_kraepelin__minute_aggregate(void) {
+  const int num_minutes = 5 * MINUTES_PER_HOUR;
+
+  // Don't start on a 15 minute boundary so that the first bucket is only partially filled
+  const time_t first_utc = rtc_get_time() + 7 * SECONDS_PER_MINUTE;
+  rtc_set_time(first_utc);
+
+  AlgMinuteDLSSample minute_data[num_minutes];
+  prv_create_test_data(num_minutes, minute_data);
+  for (int i = 0; i < num_minutes; i++) {
+    // Leave some of the minutes without a heart rate reading
+    minute_data[i].heart_rate_bpm = (i % 7) ? (50 + (i * 37) % 120) : 0;
+  }
+  prv_feed_minute_data(num_minutes, minute_data, false /*simulate_bg_delays*/);
+  const time_t now = rtc_get_time();
+
+  // Nothing from before the first minute we logged
+  ActivityMinuteAggregate actual;
+  cl_assert(!activity_algorithm_get_minute_aggregate(first_utc - SECONDS_PER_MINUTE, now,
+                                                     &actual));
+
+  const int k_num_ranges = 500;
+  uint32_t history_reads = 0;
+  uint32_t aggregate_reads = 0;
+  srand(25);
+  for (int i = 0; i < k_num_ranges; i++) {
+    time_t utc_start = first_utc + rand() % (now - first_utc);
+    time_t utc_end = utc_start + rand() % (now - utc_start + 1);
+
+    // The minute file doesn't keep distance and calories, so they are prorated in partially
+    // covered buckets. Every other range lines up with the buckets so those can be checked too.
+    const bool aligned = (i % 2) == 0;
+    if (aligned) {
+      utc_start = ROUND_TO_MOD_CEIL(utc_start, ALG_AGGREGATE_QUARTER_SEC);
+      utc_end = MAX(utc_start, utc_end - (utc_end % ALG_AGGREGATE_QUARTER_SEC));
+    }
+
+    ActivityMinuteAggregate expected;
+    uint32_t reads = fake_flash_read_count();
+    prv_aggregate_from_minute_history(utc_start, utc_end, &expected);
+    history_reads += fake_flash_read_count() - reads;
+    prv_aggregate_from_test_data(minute_data, first_utc,
+                                 utc_start - (utc_start % SECONDS_PER_MINUTE), utc_end, &expected);
+
+    reads = fake_flash_read_count();
+    cl_assert(activity_algorithm_get_minute_aggregate(utc_start, utc_end, &actual));
+    aggregate_reads += fake_flash_read_count() - reads;
+    prv_assert_aggregate_equal(&actual, &expected, aligned);
+  }
+
+  printf("\nAverage flash reads per range: %"PRIu32" from minute history, %"PRIu32" from the "
+         "aggregate index\n", history_reads / k_num_ranges, aggregate_reads / k_num_ranges);
+  cl_assert(aggregate_reads * 2 < history_reads);
+
+  // The partial current minute is included, as it is in the minute history
+  fake_rtc_increment_time(30);
+  s_alg_next_steps = 23;
+  AccelRawData samples[100] = { };
+  activity_algorithm_handle_accel(samples, s_sample_rate, 0 /*timestamp*/);
+  ActivityMinuteAggregate expected;
+  prv_aggregate_from_minute_history(now - SECONDS_PER_HOUR, rtc_get_time(), &expected);
+  cl_assert(activity_algorithm_get_minute_aggregate(now - SECONDS_PER_HOUR, rtc_get_time(),
+                                                    &actual));
+  prv_assert_aggregate_equal(&actual, &expected, false /*check_distance_and_calories*/);
+  cl_assert_equal_i(actual.steps, expected.steps);
+}
+
+
 // ---------------------------------------------------------------------------------------
 // Test the logic that detects naps. This logic is performed by the
 // prv_sleep_sessions_post_process() method.
@@ -15,6 +15,7 @@
 #include "util/math.h"
 #include "util/size.h"
 #include "util/time/time.h"
+#include "util/trig.h"
 
 #include "clar.h"
 
@@ -1334,6 +1335,55 @@ void test_kraepelin_algorithm__step_tests(void) {
 }
 
 
+// ---------------------------------------------------------------------------------------
+// The FFT has to produce exactly the same coefficients as the reference implementation, which
+// computes its twiddle factors with sin_lookup()/cos_lookup()
+#define FFT_TEST_NUM_INPUTS 4096
+static int16_t s_fft_inputs[FFT_TEST_NUM_INPUTS][128];
+static int16_t s_fft_outputs[FFT_TEST_NUM_INPUTS][128];
+static int16_t s_fft_ref_outputs[FFT_TEST_NUM_INPUTS][128];
+
+static int16_t prv_fft_test_width_log_2(int input) {
+  // Mostly the width the step counting uses, but cover the smaller ones as well
+  return (input % 8 == 0) ? 1 + (input / 8) % 7 : 7;
+}
+
+void test_kraepelin_algorithm__fft_matches_reference(void) {
+  extern void fft_2radix_real(int16_t *d, int16_t dlenpwr);
+
+  const int16_t k_amplitudes[] = { 250, 1000, 4000, INT16_MAX };
+  const int k_num_epoch_samples = 125;
+  uint32_t seed = 1;
+  for (int input = 0; input < FFT_TEST_NUM_INPUTS; input++) {
+    const int16_t width = 1 << prv_fft_test_width_log_2(input);
+    const int16_t amplitude = k_amplitudes[input % ARRAY_LENGTH(k_amplitudes)];
+    const int num_samples = (width == 128) ? k_num_epoch_samples : width;
+    int16_t *d = s_fft_inputs[input];
+    memset(d, 0, sizeof(s_fft_inputs[input]));
+    for (int i = 0; i < num_samples; i++) {
+      seed = seed * 1103515245 + 12345;
+      if (input % 2) {
+        // a noisy stepping frequency, like a walk
+        d[i] = (amplitude / 2) * sin_lookup(i * TRIG_MAX_ANGLE * 9 / num_samples) / TRIG_MAX_RATIO
+               + (int16_t)((seed >> 16) % (amplitude / 2 + 1)) - amplitude / 4;
+      } else {
+        d[i] = (int16_t)((seed >> 8) % (2 * amplitude + 1)) - amplitude;
+      }
+    }
+  }
+  memcpy(s_fft_outputs, s_fft_inputs, sizeof(s_fft_inputs));
+  memcpy(s_fft_ref_outputs, s_fft_inputs, sizeof(s_fft_inputs));
+
+  for (int input = 0; input < FFT_TEST_NUM_INPUTS; input++) {
+    const int16_t width_log_2 = prv_fft_test_width_log_2(input);
+    kalg_fft_real(s_fft_outputs[input], 1 << width_log_2, width_log_2);
+    fft_2radix_real(s_fft_ref_outputs[input], width_log_2);
+    cl_assert_equal_m(s_fft_outputs[input], s_fft_ref_outputs[input],
+                      (1 << width_log_2) * sizeof(int16_t));
+  }
+}
+
+
 // ---------------------------------------------------------------------------------------
 static const char *prv_status_str(bool passed) {
     if (!passed) {
@@ -11,6 +11,7 @@
 #include "services/normal/app_outbox_service.h"
 #include "util/math.h"
 #include "util/net.h"
+#include "util/size.h"
 
 extern const SessionSendJobImpl s_app_message_send_job_impl;
 extern void comm_session_send_queue_cleanup(CommSession *session);
@@ -358,6 +359,36 @@ void test_app_message_sender__byte_by_byte_copy_with_offset(void) {
   app_free(outbox_data);
 }
 
+void test_app_message_sender__get_mbufs_with_offset(void) {
+  AppMessageAppOutboxData *outbox_data =
+      prv_create_and_send_outbox_message(NULL /* auto-select */, ALLOWED_ENDPOINT_ID,
+                                         TEST_PAYLOAD, sizeof(TEST_PAYLOAD));
+  size_t length = comm_session_send_queue_get_length(s_app_session_ptr);
+
+  for (int o = 0; o < length; ++o) {
+    MBuf mbufs[2];
+    cl_assert_equal_i(length - o, comm_session_send_queue_get_mbufs(s_app_session_ptr, o, length,
+                                                                    mbufs, ARRAY_LENGTH(mbufs)));
+    // Expect the header and payload to be non-contiguous:
+    MBuf *payload_mbuf = &mbufs[0];
+    if (o < sizeof(PebbleProtocolHeader)) {
+      cl_assert_equal_i(mbufs[0].length, sizeof(PebbleProtocolHeader) - o);
+      cl_assert_equal_m(mbufs[0].data, TEST_EXPECTED_PP_MSG + o, mbufs[0].length);
+      cl_assert_equal_p(mbufs[0].next, &mbufs[1]);
+      payload_mbuf = &mbufs[1];
+    }
+    const size_t payload_offset = MAX(o, sizeof(PebbleProtocolHeader));
+    cl_assert_equal_i(payload_mbuf->length, length - payload_offset);
+    cl_assert_equal_m(payload_mbuf->data, TEST_EXPECTED_PP_MSG + payload_offset,
+                      payload_mbuf->length);
+    cl_assert_equal_p(payload_mbuf->next, NULL);
+  }
+
+  comm_session_send_queue_consume(s_app_session_ptr, length);
+  assert_consumed(AppMessageSenderErrorSuccess, 1);
+  app_free(outbox_data);
+}
+
 // Tests that deal with the edge case of app outbox messages getting cancelled,
 // because the app that provides the buffer for the payload is quit while they are in the
 // process of being sent out.
@@ -9,6 +9,7 @@
 #include "services/normal/blob_db/pin_db.h"
 #include "services/normal/timeline/timeline.h"
 
+#include "util/crc8.h"
 #include "util/list.h"
 #include "util/size.h"
 
@@ -417,7 +418,7 @@ void test_timeline__all_forwards(void) {
   // Note: 1421178000 = Tue Jan 13 11:40:00 PST 2015
   // check first
   timeline_init(&head);
-  cl_assert_equal_i(timeline_iter_init(&iterator, &state, &head, TimelineIterDirectionFuture,
+  cl_assert_equal_i(timeline_iter_init(&iterator, &state, TimelineIterDirectionFuture,
    1421178000), 0);
   cl_assert(uuid_equal(&state.pin.header.id, &s_items[0].header.id));
   // check second
@@ -456,7 +457,7 @@ void test_timeline__forward_and_back(void) {
   // Note: 1421178000 = Tue Jan 13 11:40:00 PST 2015
   // check first
   timeline_init(&head);
-  cl_assert_equal_i(timeline_iter_init(&iterator, &state, &head, TimelineIterDirectionFuture,
+  cl_assert_equal_i(timeline_iter_init(&iterator, &state, TimelineIterDirectionFuture,
    1421178000), 0);
   cl_assert(uuid_equal(&state.pin.header.id, &s_items[0].header.id));
   // check second
@@ -476,7 +477,7 @@ void test_timeline__none_forwards(void) {
   TimelineIterState state = {0};
   TimelineNode *head = NULL;
   timeline_init(&head);
-  cl_assert_equal_i(timeline_iter_init(&iterator, &state, &head, TimelineIterDirectionFuture,
+  cl_assert_equal_i(timeline_iter_init(&iterator, &state, TimelineIterDirectionFuture,
     1421188000), 2);
 }
 
@@ -487,7 +488,7 @@ void test_timeline__all_backwards(void) {
   // Note: 1421188000 == Tue Jan 13 14:26:40 PST 2015
   // check first
   timeline_init(&head);
-  cl_assert_equal_i(timeline_iter_init(&iterator, &state, &head, TimelineIterDirectionPast,
+  cl_assert_equal_i(timeline_iter_init(&iterator, &state, TimelineIterDirectionPast,
     1421188000), 0);
   cl_assert(uuid_equal(&state.pin.header.id, &s_items[3].header.id));
   // check second
@@ -516,7 +517,7 @@ void test_timeline__none_backwards(void) {
   TimelineIterState state = {0};
   TimelineNode *head = NULL;
   timeline_init(&head);
-  cl_assert_equal_i(timeline_iter_init(&iterator, &state, &head, TimelineIterDirectionPast,
+  cl_assert_equal_i(timeline_iter_init(&iterator, &state, TimelineIterDirectionPast,
     1421178000), 2);
 }
 
@@ -526,7 +527,7 @@ void test_timeline__middle_forwards(void) {
   TimelineNode *head = NULL;
   // check first
   timeline_init(&head);
-  cl_assert_equal_i(timeline_iter_init(&iterator, &state, &head, TimelineIterDirectionFuture,
+  cl_assert_equal_i(timeline_iter_init(&iterator, &state, TimelineIterDirectionFuture,
     1421183640), 0);
   cl_assert(uuid_equal(&state.pin.header.id, &s_items[5].header.id));
   cl_assert(iter_next(&iterator));
@@ -552,7 +553,7 @@ void test_timeline__middle_backwards(void) {
   TimelineNode *head = NULL;
   // check first
   timeline_init(&head);
-  cl_assert_equal_i(timeline_iter_init(&iterator, &state, &head, TimelineIterDirectionPast,
+  cl_assert_equal_i(timeline_iter_init(&iterator, &state, TimelineIterDirectionPast,
     1421183640), 0);
   cl_assert(uuid_equal(&state.pin.header.id, &s_items[4].header.id));
   // check second
@@ -577,7 +578,7 @@ void test_timeline__long_middle_past(void) {
   TimelineNode *head = NULL;
   // initialize it to be 11 min after item cc has started
   timeline_init(&head);
-  cl_assert_equal_i(timeline_iter_init(&iterator, &state, &head, TimelineIterDirectionPast,
+  cl_assert_equal_i(timeline_iter_init(&iterator, &state, TimelineIterDirectionPast,
     14700), 0);
  
   cl_assert(uuid_equal(&state.pin.header.id, &s_long_items[1].header.id));
@@ -599,7 +600,7 @@ void test_timeline__long_middle_future(void) {
   TimelineNode *head = NULL;
   // initialize it to be 11 min after item cc has started
   timeline_init(&head);
-  cl_assert_equal_i(timeline_iter_init(&iterator, &state, &head, TimelineIterDirectionFuture,
+  cl_assert_equal_i(timeline_iter_init(&iterator, &state, TimelineIterDirectionFuture,
     14700), 0);
 
   cl_assert(uuid_equal(&state.pin.header.id, &s_long_items[2].header.id));
@@ -639,7 +640,7 @@ void test_timeline__gc_past(void) {
   fake_pbl_malloc_clear_tracking();
   cl_assert_equal_i(fake_pbl_malloc_num_net_allocs(), 0);
   timeline_init(&head);
-  cl_assert_equal_i(timeline_iter_init(&iterator, &state, &head, TimelineIterDirectionFuture,
+  cl_assert_equal_i(timeline_iter_init(&iterator, &state, TimelineIterDirectionFuture,
     1421178000), 0);
   cl_assert_equal_i(prv_num_items(iterator), 6);
 
@@ -648,7 +649,7 @@ void test_timeline__gc_past(void) {
   rtc_set_time(1421395200);
   head = NULL;
   timeline_init(&head);
-  cl_assert_equal_i(timeline_iter_init(&iterator, &state, &head, TimelineIterDirectionPast,
+  cl_assert_equal_i(timeline_iter_init(&iterator, &state, TimelineIterDirectionPast,
                                        1421395200),
                     S_NO_MORE_ITEMS);
 
@@ -658,7 +659,7 @@ void test_timeline__gc_past(void) {
   rtc_set_time(1421445600);
   head = NULL;
   timeline_init(&head);
-  cl_assert_equal_i(timeline_iter_init(&iterator, &state, &head, TimelineIterDirectionPast,
+  cl_assert_equal_i(timeline_iter_init(&iterator, &state, TimelineIterDirectionPast,
                                        1421445600),
                     S_NO_MORE_ITEMS);
 
@@ -681,7 +682,7 @@ void test_timeline__all_day_future(void) {
 
   // start 11:40 AM, earlier than all timed events for that day
   timeline_init(&head);
-  cl_assert_equal_i(timeline_iter_init(&iterator, &state, &head, TimelineIterDirectionFuture,
+  cl_assert_equal_i(timeline_iter_init(&iterator, &state, TimelineIterDirectionFuture,
     1421178000), 0);
   Uuid first_all_day_event = state.pin.header.id;
   cl_assert(uuid_equal(&state.pin.header.id, &s_all_day_items[1].header.id) ||
@@ -708,6 +709,85 @@ void test_timeline__all_day_future(void) {
   cl_assert(!iter_prev(&iterator));
 }
 
+void test_timeline__many_all_day_same_day(void) {
+  // The fake settings file reads records back in the order of the crc8 of their keys, which for
+  // these ids is the order of the ids
+  const int num_all_day = 5;
+  for (int i = 0; i < num_all_day; i++) {
+    TimelineItem item = s_all_day_items[1];
+    item.header.id = (Uuid) {0x20 + i};
+    cl_assert_equal_i(pin_db_insert_item(&item), 0);
+  }
+
+  Iterator iterator = {0};
+  TimelineIterState state = {0};
+  TimelineNode *head = NULL;
+
+  // start 11:40 AM, earlier than all timed events for that day
+  timeline_init(&head);
+  cl_assert_equal_i(timeline_iter_init(&iterator, &state, TimelineIterDirectionFuture,
+    1421178000), 0);
+
+  // Like inserting them one by one in front of the nodes at the same time, the all day events
+  // come out in the reverse of the order they were read in
+  for (int i = num_all_day - 1; i >= 0; i--) {
+    cl_assert(state.node->all_day);
+    cl_assert(uuid_equal(&state.pin.header.id, &(Uuid) {0x20 + i}));
+    cl_assert_equal_i(state.pin.header.timestamp, 1421136000);
+    cl_assert(iter_next(&iterator));
+  }
+  cl_assert(!state.node->all_day);
+
+  for (int i = 0; i < num_all_day; i++) {
+    cl_assert(iter_prev(&iterator));
+    cl_assert(uuid_equal(&state.pin.header.id, &(Uuid) {0x20 + i}));
+  }
+  cl_assert(!iter_prev(&iterator));
+
+  timeline_iter_deinit(&iterator, &state, &head);
+}
+
+void test_timeline__deinit_many_pins(void) {
+  // The fake settings file has a slot for each crc8 of the key but the last, so pick ids that
+  // don't share one
+  fake_settings_file_reset();
+  bool crc8_used[UINT8_MAX + 1] = { [UINT8_MAX] = true };
+  const int num_pins = 200;
+  const time_t now = 1421178000;
+  int num_inserted = 0;
+  for (int i = 0; num_inserted < num_pins; i++) {
+    TimelineItem item = s_items[0];
+    item.header.id = (Uuid) {0x40, i & 0xff, i >> 8};
+    const uint8_t crc = crc8_calculate_bytes((uint8_t *)&item.header.id, sizeof(Uuid), false);
+    if (crc8_used[crc]) {
+      continue;
+    }
+    crc8_used[crc] = true;
+    // each pin spans a few days, so there are more nodes than pins
+    item.header.timestamp = now + num_inserted * SECONDS_PER_MINUTE;
+    item.header.duration = 2 * MINUTES_PER_DAY;
+    cl_assert_equal_i(pin_db_insert_item(&item), 0);
+    num_inserted++;
+  }
+
+  Iterator iterator = {0};
+  TimelineIterState state = {0};
+  TimelineNode *head = NULL;
+  rtc_set_time(now);
+  fake_pbl_malloc_clear_tracking();
+  timeline_init(&head);
+  cl_assert_equal_i(timeline_iter_init(&iterator, &state, TimelineIterDirectionFuture, now), 0);
+  const int num_nodes = list_count((ListNode *)head);
+  cl_assert(num_nodes > num_pins);
+
+  // Tearing the whole list down doesn't take the nodes out of the index one at a time
+  const uint32_t num_moved = timeline_get_num_index_nodes_moved();
+  timeline_iter_deinit(&iterator, &state, &head);
+  cl_assert_equal_i(timeline_get_num_index_nodes_moved(), num_moved);
+  cl_assert(head == NULL);
+  cl_assert_equal_i(fake_pbl_malloc_num_net_allocs(), 0);
+}
+
 void test_timeline__all_day_future_with_others(void) {
   prv_insert_all_day_items();
 
@@ -717,7 +797,7 @@ void test_timeline__all_day_future_with_others(void) {
 
   // start 11:40 AM, earlier than all timed events for that day
   timeline_init(&head);
-  cl_assert_equal_i(timeline_iter_init(&iterator, &state, &head, TimelineIterDirectionFuture,
+  cl_assert_equal_i(timeline_iter_init(&iterator, &state, TimelineIterDirectionFuture,
     1421178000), 0);
   Uuid first_all_day_event = state.pin.header.id;
   cl_assert(uuid_equal(&state.pin.header.id, &s_all_day_items[1].header.id) ||
@@ -786,7 +866,7 @@ void test_timeline__all_day_past(void) {
 
   // start 11:40 AM, earlier than all timed events for that day
   timeline_init(&head);
-  cl_assert_equal_i(timeline_iter_init(&iterator, &state, &head, TimelineIterDirectionPast,
+  cl_assert_equal_i(timeline_iter_init(&iterator, &state, TimelineIterDirectionPast,
     1421178000), 0);
   cl_assert(uuid_equal(&state.pin.header.id, &earlier_item.header.id));
   cl_assert(!state.node->all_day);
@@ -800,6 +880,32 @@ void test_timeline__all_day_past(void) {
   cl_assert(!iter_prev(&iterator));
 }
 
+void test_timeline__direction_for_all_day_item(void) {
+  prv_insert_all_day_items();
+  TimelineItem item = s_all_day_items[1];
+  // 1421136000 is midnight Jan 13, PST
+  item.header.timestamp = 1421136000;
+
+  // 11:40 AM, no timed events yet today
+  TimelineNode *head = NULL;
+  rtc_set_time(1421178000);
+  timeline_init(&head);
+  cl_assert_equal_i(timeline_direction_for_item(&item, head, 1421178000),
+                    TimelineIterDirectionFuture);
+
+  // 13:14, after the first timed event of the day
+  cl_assert_equal_i(timeline_direction_for_item(&item, head, 1421183640),
+                    TimelineIterDirectionPast);
+
+  // Without a list there are no timed events to look at
+  cl_assert_equal_i(timeline_direction_for_item(&item, NULL, 1421183640),
+                    TimelineIterDirectionFuture);
+
+  Iterator iterator = {0};
+  TimelineIterState state = {0};
+  timeline_iter_deinit(&iterator, &state, &head);
+}
+
 void test_timeline__all_day_middle_past(void) {
   prv_insert_all_day_items();
 
@@ -810,7 +916,7 @@ void test_timeline__all_day_middle_past(void) {
   TimelineNode *head = NULL;
 
   timeline_init(&head);
-  cl_assert_equal_i(timeline_iter_init(&iterator, &state, &head, TimelineIterDirectionPast,
+  cl_assert_equal_i(timeline_iter_init(&iterator, &state, TimelineIterDirectionPast,
     1421183640), 0);
   cl_assert(uuid_equal(&state.pin.header.id, &s_items[4].header.id));
   cl_assert(iter_next(&iterator));
@@ -851,7 +957,7 @@ void test_timeline__extra_case_forwards(void) {
   TimelineNode *head = NULL;
 
   timeline_init(&head);
-  cl_assert_equal_i(timeline_iter_init(&iterator, &state, &head, TimelineIterDirectionFuture,
+  cl_assert_equal_i(timeline_iter_init(&iterator, &state, TimelineIterDirectionFuture,
     s_feb_5_midnight + 5 * 60 * 60), 0);
   cl_assert(uuid_equal(&state.pin.header.id, &s_extra_case_items[0].header.id));
 
@@ -874,7 +980,7 @@ void test_timeline__extra_case_none_backwards(void) {
   TimelineNode *head = NULL;
 
   timeline_init(&head);
-  cl_assert_equal_i(timeline_iter_init(&iterator, &state, &head, TimelineIterDirectionPast,
+  cl_assert_equal_i(timeline_iter_init(&iterator, &state, TimelineIterDirectionPast,
     s_feb_5_midnight + 5 * 60 * 60), 2);
 }
 
@@ -887,7 +993,7 @@ void test_timeline__extra_case_middle_future(void) {
   TimelineNode *head = NULL;
 
   timeline_init(&head);
-  cl_assert_equal_i(timeline_iter_init(&iterator, &state, &head, TimelineIterDirectionFuture,
+  cl_assert_equal_i(timeline_iter_init(&iterator, &state, TimelineIterDirectionFuture,
     s_feb_5_midnight + 8 * SECONDS_PER_HOUR + 16 * SECONDS_PER_MINUTE), 0);
 
   cl_assert(uuid_equal(&state.pin.header.id, &s_extra_case_items[1].header.id));
@@ -908,7 +1014,7 @@ void test_timeline__extra_case_middle_past(void) {
   TimelineNode *head = NULL;
 
   timeline_init(&head);
-  cl_assert_equal_i(timeline_iter_init(&iterator, &state, &head, TimelineIterDirectionPast,
+  cl_assert_equal_i(timeline_iter_init(&iterator, &state, TimelineIterDirectionPast,
     s_feb_5_midnight + 8 * 60 * 60 + 16 * 60), 0);
 
   cl_assert(uuid_equal(&state.pin.header.id, &s_extra_case_items[0].header.id));
@@ -925,7 +1031,7 @@ void test_timeline__extra_case_backwards(void) {
   TimelineNode *head = NULL;
 
   timeline_init(&head);
-  cl_assert_equal_i(timeline_iter_init(&iterator, &state, &head, TimelineIterDirectionPast,
+  cl_assert_equal_i(timeline_iter_init(&iterator, &state, TimelineIterDirectionPast,
     s_feb_5_midnight + 11 * 60 * 60), 0);
   cl_assert(uuid_equal(&state.pin.header.id, &s_extra_case_items[2].header.id));
 
@@ -947,7 +1053,7 @@ void test_timeline__extra_case_none_forwards(void) {
   TimelineNode *head = NULL;
 
   timeline_init(&head);
-  cl_assert_equal_i(timeline_iter_init(&iterator, &state, &head, TimelineIterDirectionFuture,
+  cl_assert_equal_i(timeline_iter_init(&iterator, &state, TimelineIterDirectionFuture,
     s_feb_5_midnight + 11 * 60 * 60), 2);
 }
 
@@ -961,18 +1067,20 @@ void test_timeline__two_iterators(void) {
 
   // first iterator should alloc all the memory for all items
   timeline_init(&head);
-  cl_assert_equal_i(timeline_iter_init(&iterator1, &state1, &head, TimelineIterDirectionFuture,
+  cl_assert_equal_i(timeline_iter_init(&iterator1, &state1, TimelineIterDirectionFuture,
     1421178000), 0);
-  // should have one alloc for each node in list, + 1 for the current timelineitem
+  // should have one alloc for each node in list, + 1 for the index of the list
+  // + 1 for the current timelineitem
   cl_assert_equal_i(fake_pbl_malloc_num_net_allocs(),
-                    init_net_allocs + ARRAY_LENGTH(s_items) + 1);
+                    init_net_allocs + ARRAY_LENGTH(s_items) + 2);
 
   // second iterator should not alloc any more memory
-  cl_assert_equal_i(timeline_iter_init(&iterator2, &state2, &head, TimelineIterDirectionFuture,
+  cl_assert_equal_i(timeline_iter_init(&iterator2, &state2, TimelineIterDirectionFuture,
     1421178000), 0);
-  // should have one alloc for each node in list, + 1 for the current timelineitem
+  // should have one alloc for each node in list, + 1 for the index of the list
+  // + 1 for the current timelineitem of each iterator
   cl_assert_equal_i(fake_pbl_malloc_num_net_allocs(),
-                    init_net_allocs + ARRAY_LENGTH(s_items) + 2);
+                    init_net_allocs + ARRAY_LENGTH(s_items) + 3);
 
   // deinit should free all the memory
   timeline_iter_deinit(&iterator1, &state1, &head);
@@ -986,7 +1094,7 @@ void test_timeline__delete_on_iterator(void) {
   TimelineNode *head = NULL;
 
   timeline_init(&head);
-  cl_assert_equal_i(timeline_iter_init(&iterator, &state, &head, TimelineIterDirectionFuture, 1421178000), 0);
+  cl_assert_equal_i(timeline_iter_init(&iterator, &state, TimelineIterDirectionFuture, 1421178000), 0);
   // s_items[0] is the earliest pin, followed by s_items[4]
   cl_assert_equal_i(pin_db_delete((uint8_t *)&s_items[0].header.id, sizeof(Uuid)), 0);
 
@@ -1004,7 +1112,7 @@ void test_timeline__skip_deleted_item(void) {
   TimelineNode *head = NULL;
 
   timeline_init(&head);
-  cl_assert_equal_i(timeline_iter_init(&iterator, &state, &head, TimelineIterDirectionFuture, 1421178000), 0);
+  cl_assert_equal_i(timeline_iter_init(&iterator, &state, TimelineIterDirectionFuture, 1421178000), 0);
 
   cl_assert_equal_i(pin_db_delete((uint8_t *)&s_items[4].header.id, sizeof(Uuid)), 0);
 
@@ -1024,7 +1132,7 @@ void test_timeline__delete_last_items(void) {
   TimelineNode *head = NULL;
 
   timeline_init(&head);
-  cl_assert_equal_i(timeline_iter_init(&iterator, &state, &head, TimelineIterDirectionFuture, 1421178000), 0);
+  cl_assert_equal_i(timeline_iter_init(&iterator, &state, TimelineIterDirectionFuture, 1421178000), 0);
 
   // delete item 2, iterate to the end, check that everything still works
   cl_assert_equal_i(pin_db_delete((uint8_t *)&s_items[2].header.id, sizeof(Uuid)), 0);
@@ -1087,7 +1195,7 @@ void test_timeline__multiday(void) {
 
   cl_assert_equal_i(timeline_init(&head), S_SUCCESS);
   // 1425272400 is 21:00 March 1 2015 PST
-  cl_assert_equal_i(timeline_iter_init(&iterator, &state, &head, TimelineIterDirectionFuture, 1425272400),
+  cl_assert_equal_i(timeline_iter_init(&iterator, &state, TimelineIterDirectionFuture, 1425272400),
     S_SUCCESS);
   time_t midnight_march_2_pst = 1425283200;
 
@@ -1141,7 +1249,7 @@ void test_timeline__all_day_single_day(void) {
 
   cl_assert_equal_i(timeline_init(&head), S_SUCCESS);
   const time_t time_21_00_march_1_pst = 1425272400;
-  cl_assert_equal_i(timeline_iter_init(&iterator, &state, &head, TimelineIterDirectionFuture,
+  cl_assert_equal_i(timeline_iter_init(&iterator, &state, TimelineIterDirectionFuture,
                                        time_21_00_march_1_pst), S_SUCCESS);
   const time_t midnight_march_3_pst = 1425369600;
 
@@ -1183,7 +1291,7 @@ void test_timeline__24h_non_all_day_starting_mid_day(void) {
 
   cl_assert_equal_i(timeline_init(&head), S_SUCCESS);
   const time_t time_21_00_march_1_pst = 1425272400;
-  cl_assert_equal_i(timeline_iter_init(&iterator, &state, &head, TimelineIterDirectionFuture,
+  cl_assert_equal_i(timeline_iter_init(&iterator, &state, TimelineIterDirectionFuture,
                                        time_21_00_march_1_pst), S_SUCCESS);
   const time_t midnight_march_2_pst = 1425283200;
 
@@ -1235,7 +1343,7 @@ void test_timeline__24h_non_all_day_starting_midnight(void) {
 
   cl_assert_equal_i(timeline_init(&head), S_SUCCESS);
   const time_t time_21_00_march_1_pst = 1425272400;
-  cl_assert_equal_i(timeline_iter_init(&iterator, &state, &head, TimelineIterDirectionFuture,
+  cl_assert_equal_i(timeline_iter_init(&iterator, &state, TimelineIterDirectionFuture,
                                        time_21_00_march_1_pst), S_SUCCESS);
 
   // day 1
@@ -1285,7 +1393,7 @@ void test_timeline__all_day_multiday(void) {
 
   cl_assert_equal_i(timeline_init(&head), S_SUCCESS);
   // 1425272400 is 21:00 March 1 2015 PST
-  cl_assert_equal_i(timeline_iter_init(&iterator, &state, &head, TimelineIterDirectionFuture, 1425272400),
+  cl_assert_equal_i(timeline_iter_init(&iterator, &state, TimelineIterDirectionFuture, 1425272400),
     S_SUCCESS);
   time_t midnight_march_2_pst = 1425283200;
 
@@ -1348,7 +1456,7 @@ void test_timeline__all_day_ios_bug(void) {
   TimelineNode *head = NULL;
 
   cl_assert_equal_i(timeline_init(&head), S_SUCCESS);
-  cl_assert_equal_i(timeline_iter_init(&iterator, &state, &head, TimelineIterDirectionFuture,
+  cl_assert_equal_i(timeline_iter_init(&iterator, &state, TimelineIterDirectionFuture,
       1430236800 - 60 * 60), S_SUCCESS);
   const time_t midnight_apr_28_pst = 1430208000;
 
@@ -1391,7 +1499,7 @@ void test_timeline__all_day_ios_bug_2(void) {
   TimelineNode *head = NULL;
 
   cl_assert_equal_i(timeline_init(&head), S_SUCCESS);
-  cl_assert_equal_i(timeline_iter_init(&iterator, &state, &head, TimelineIterDirectionFuture,
+  cl_assert_equal_i(timeline_iter_init(&iterator, &state, TimelineIterDirectionFuture,
       1430200800 - 60 * 60), S_SUCCESS);
   const time_t midnight_apr_28_msk = 1430168400;
 
@@ -1420,7 +1528,7 @@ void test_timeline__0_duration_all_day(void) {
 
   cl_assert_equal_i(timeline_init(&head), S_SUCCESS);
   const time_t time_21_00_march_1_pst = 1425272400;
-  cl_assert_equal_i(timeline_iter_init(&iterator, &state, &head, TimelineIterDirectionFuture,
+  cl_assert_equal_i(timeline_iter_init(&iterator, &state, TimelineIterDirectionFuture,
                                        time_21_00_march_1_pst), S_SUCCESS);
   const time_t midnight_march_3_pst = 1425369600;
 
@@ -1462,7 +1570,7 @@ void test_timeline__0_duration(void) {
 
   cl_assert_equal_i(timeline_init(&head), S_SUCCESS);
   const time_t time_21_00_march_1_pst = 1425272400;
-  cl_assert_equal_i(timeline_iter_init(&iterator, &state, &head, TimelineIterDirectionFuture,
+  cl_assert_equal_i(timeline_iter_init(&iterator, &state, TimelineIterDirectionFuture,
                                        time_21_00_march_1_pst), S_SUCCESS);
   const time_t midnight_march_2_pst = 1425283200;
 
@@ -334,6 +334,12 @@ void test_session_send_buffer__send_queue_interface(void) {
   cl_assert_equal_i(memcmp(pp_data_out + sizeof(PebbleProtocolHeader) - offset,
                            fake_data_payload, max_payload_length - offset), 0);
 
+  // ..._get_read_pointer_at():
+  const uint8_t *data_at_offset;
+  cl_assert_equal_i(s_default_kernel_send_job_impl.get_read_pointer_at(job, offset,
+                                                                       &data_at_offset),
+                    expected_bytes_incl_pebble_protocol_header - offset);
+  cl_assert_equal_m(data_at_offset, pp_data_out, max_payload_length - offset);
 
   // ..._get_read_pointer():
   uint16_t bytes_read = 0;
@@ -358,7 +364,8 @@ void test_session_send_buffer__send_queue_interface(void) {
   }
   cl_assert_equal_i(bytes_read, expected_bytes_incl_pebble_protocol_header);
 
-  cl_assert_equal_i(comm_session_send_queue_get_length(s_valid_session), 0);
+  // The job was consumed directly rather than through the send queue, so check the job itself:
+  cl_assert_equal_i(s_default_kernel_send_job_impl.get_length(job), 0);
 
   prv_cleanup_send_buffer(write_sb);
 }
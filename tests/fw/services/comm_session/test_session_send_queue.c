@@ -6,6 +6,8 @@
 #include "services/common/comm_session/session_internal.h"
 #include "services/common/comm_session/session_send_queue.h"
 #include "util/math.h"
+#include "util/size.h"
+
 
 extern void comm_session_send_queue_cleanup(CommSession *session);
 
@@ -53,7 +55,11 @@ static const uint8_t *prv_get_read_pointer(const TestSendJob *sb) {
   return (sb->data + sb->consumed_length);
 }
 
+static int s_get_length_count;
+static size_t s_bytes_copied;
+
 static size_t prv_send_job_impl_get_length(const SessionSendQueueJob *send_job) {
+  ++s_get_length_count;
   return prv_get_length((TestSendJob *)send_job);
 }
 
@@ -64,6 +70,7 @@ size_t prv_send_job_impl_copy(const SessionSendQueueJob *send_job, int start_off
   const size_t length_after_offset = (length_remaining - start_offset);
   const size_t length_to_copy = MIN(length_after_offset, length);
   memcpy(data_out, prv_get_read_pointer(sb) + start_offset, length_to_copy);
+  s_bytes_copied += length_to_copy;
   return length_to_copy;
 }
 
@@ -74,6 +81,13 @@ size_t prv_send_job_impl_get_read_pointer(const SessionSendQueueJob *send_job,
   return prv_get_length(sb);
 }
 
+size_t prv_send_job_impl_get_read_pointer_at(const SessionSendQueueJob *send_job,
+                                             uint32_t start_offset, const uint8_t **data_out) {
+  TestSendJob *sb = (TestSendJob *)send_job;
+  *data_out = prv_get_read_pointer(sb) + start_offset;
+  return prv_get_length(sb) - start_offset;
+}
+
 void prv_send_job_impl_consume(const SessionSendQueueJob *send_job, size_t length) {
   TestSendJob *sb = (TestSendJob *)send_job;
   sb->consumed_length += length;
@@ -90,6 +104,7 @@ static const SessionSendJobImpl s_test_job_impl = {
   .get_length = prv_send_job_impl_get_length,
   .copy = prv_send_job_impl_copy,
   .get_read_pointer = prv_send_job_impl_get_read_pointer,
+  .get_read_pointer_at = prv_send_job_impl_get_read_pointer_at,
   .consume = prv_send_job_impl_consume,
   .free = prv_send_job_impl_free,
 };
@@ -117,6 +132,8 @@ static const uint8_t TEST_DATA[] = {0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff};
 void test_session_send_queue__initialize(void) {
   s_valid_session = &s_session;
   s_free_count = 0;
+  s_get_length_count = 0;
+  s_bytes_copied = 0;
   fake_kernel_malloc_init();
   fake_kernel_malloc_enable_stats(true);
   fake_kernel_malloc_mark();
@@ -288,3 +305,128 @@ void test_session_send_queue__session_closed_when_add_is_called(void) {
   cl_assert(!job);
   cl_assert_equal_i(s_free_count, 1);
 }
+
+void test_session_send_queue__get_length_does_not_walk_the_queue(void) {
+  int num_jobs = 3;
+  prv_add_jobs(num_jobs);
+
+  s_get_length_count = 0;
+  cl_assert_equal_i(num_jobs * sizeof(TEST_DATA),
+                    comm_session_send_queue_get_length(s_valid_session));
+  cl_assert_equal_i(s_get_length_count, 0);
+
+  comm_session_send_queue_consume(s_valid_session, sizeof(TEST_DATA) + 1);
+  cl_assert_equal_i((num_jobs * sizeof(TEST_DATA)) - sizeof(TEST_DATA) - 1,
+                    comm_session_send_queue_get_length(s_valid_session));
+
+  comm_session_send_queue_consume(s_valid_session, UINT32_MAX);
+  cl_assert_equal_i(0, comm_session_send_queue_get_length(s_valid_session));
+}
+
+static size_t prv_get_chain_length(const MBuf *m) {
+  size_t length = 0;
+  for (; m; m = m->next) {
+    length += m->length;
+  }
+  return length;
+}
+
+void test_session_send_queue__get_mbufs_empty_queue(void) {
+  MBuf mbufs[2];
+  cl_assert_equal_i(0, comm_session_send_queue_get_mbufs(s_valid_session, 0, 10,
+                                                         mbufs, ARRAY_LENGTH(mbufs)));
+}
+
+void test_session_send_queue__get_mbufs_overlapping_multiple_jobs_with_offset(void) {
+  int num_jobs = 3;
+  prv_add_jobs(num_jobs);
+
+  MBuf mbufs[4];
+  const int offset = sizeof(TEST_DATA) + 1;
+  const size_t length = sizeof(TEST_DATA);
+  cl_assert_equal_i(length, comm_session_send_queue_get_mbufs(s_valid_session, offset, length,
+                                                              mbufs, ARRAY_LENGTH(mbufs)));
+
+  // The chain points into the jobs, nothing gets copied:
+  cl_assert_equal_i(s_bytes_copied, 0);
+  cl_assert_equal_i(prv_get_chain_length(&mbufs[0]), length);
+  cl_assert_equal_i(mbufs[0].length, sizeof(TEST_DATA) - 1);
+  cl_assert_equal_m(mbufs[0].data, TEST_DATA + 1, sizeof(TEST_DATA) - 1);
+  cl_assert_equal_p(mbufs[0].next, &mbufs[1]);
+  cl_assert_equal_i(mbufs[1].length, 1);
+  cl_assert_equal_m(mbufs[1].data, TEST_DATA, 1);
+  cl_assert_equal_p(mbufs[1].next, NULL);
+}
+
+void test_session_send_queue__get_mbufs_limited_by_number_of_mbufs(void) {
+  int num_jobs = 3;
+  prv_add_jobs(num_jobs);
+
+  MBuf mbufs[2];
+  cl_assert_equal_i(2 * sizeof(TEST_DATA),
+                    comm_session_send_queue_get_mbufs(s_valid_session, 0, UINT32_MAX,
+                                                      mbufs, ARRAY_LENGTH(mbufs)));
+  cl_assert_equal_i(prv_get_chain_length(&mbufs[0]), 2 * sizeof(TEST_DATA));
+}
+
+#define TRANSPORT_TOTAL_LENGTH (1024 * 1024)
+#define TRANSPORT_JOB_LENGTH (256)
+#define TRANSPORT_MAX_QUEUED_JOBS (8)
+//! Roughly the payload of a PPoGATT packet with a 158 byte MTU
+#define TRANSPORT_PACKET_LENGTH (154)
+
+//! Pushes TRANSPORT_TOTAL_LENGTH bytes through the send queue, the way a transport would: keep a
+//! few messages queued and send them out packet by packet.
+static uint32_t prv_push_through_fake_transport(bool use_mbufs) {
+  uint8_t job_data[TRANSPORT_JOB_LENGTH];
+  for (int i = 0; i < TRANSPORT_JOB_LENGTH; ++i) {
+    job_data[i] = i;
+  }
+
+  uint32_t checksum = 0;
+  size_t bytes_queued = 0;
+  size_t bytes_sent = 0;
+  while (bytes_sent < TRANSPORT_TOTAL_LENGTH) {
+    while (bytes_queued < TRANSPORT_TOTAL_LENGTH &&
+           comm_session_send_queue_get_length(s_valid_session) <
+               TRANSPORT_MAX_QUEUED_JOBS * TRANSPORT_JOB_LENGTH) {
+      SessionSendQueueJob *job = prv_create_test_job(job_data, sizeof(job_data));
+      comm_session_send_queue_add_job(s_valid_session, &job);
+      bytes_queued += sizeof(job_data);
+    }
+
+    const size_t length = MIN(comm_session_send_queue_get_length(s_valid_session),
+                              TRANSPORT_PACKET_LENGTH);
+    if (use_mbufs) {
+      MBuf mbufs[4];
+      const size_t mbufs_length = comm_session_send_queue_get_mbufs(s_valid_session, 0, length,
+                                                                    mbufs, ARRAY_LENGTH(mbufs));
+      cl_assert_equal_i(mbufs_length, length);
+      for (MBuf *m = &mbufs[0]; m; m = m->next) {
+        for (uint32_t i = 0; i < m->length; ++i) {
+          checksum += ((uint8_t *)m->data)[i];
+        }
+      }
+    } else {
+      uint8_t packet[TRANSPORT_PACKET_LENGTH];
+      cl_assert_equal_i(comm_session_send_queue_copy(s_valid_session, 0, length, packet), length);
+      for (uint32_t i = 0; i < length; ++i) {
+        checksum += packet[i];
+      }
+    }
+    comm_session_send_queue_consume(s_valid_session, length);
+    bytes_sent += length;
+  }
+  cl_assert_equal_i(0, comm_session_send_queue_get_length(s_valid_session));
+  return checksum;
+}
+
+void test_session_send_queue__get_mbufs_sends_same_data_as_copy(void) {
+  const uint32_t copy_checksum = prv_push_through_fake_transport(false /* use_mbufs */);
+  cl_assert_equal_i(s_bytes_copied, TRANSPORT_TOTAL_LENGTH);
+
+  s_bytes_copied = 0;
+  const uint32_t mbufs_checksum = prv_push_through_fake_transport(true /* use_mbufs */);
+  cl_assert_equal_i(mbufs_checksum, copy_checksum);
+  cl_assert_equal_i(s_bytes_copied, 0);
+}
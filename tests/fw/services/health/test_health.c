@@ -277,6 +277,34 @@ bool sys_activity_get_minute_history(HealthMinuteData *minute_data, uint32_t *nu
   return true;
 }
 
+typedef struct {
+  struct {
+    time_t utc_start;
+    time_t utc_end;
+  } in;
+  struct {
+    ActivityMinuteAggregate aggregate;
+    bool result;
+  } out;
+  int call_count;
+} sys_activity_get_minute_aggregate_values;
+
+static sys_activity_get_minute_aggregate_values s_sys_activity_get_minute_aggregate_values;
+
+bool sys_activity_get_minute_aggregate(time_t utc_start, time_t utc_end,
+                                       ActivityMinuteAggregate *aggregate) {
+  cl_assert(aggregate);
+  s_sys_activity_get_minute_aggregate_values.call_count++;
+  s_sys_activity_get_minute_aggregate_values.in.utc_start = utc_start;
+  s_sys_activity_get_minute_aggregate_values.in.utc_end = utc_end;
+
+  if (!s_sys_activity_get_minute_aggregate_values.out.result) {
+    return false;
+  }
+  *aggregate = s_sys_activity_get_minute_aggregate_values.out.aggregate;
+  return true;
+}
+
 static bool s_activity_sessions_ongoing[ActivitySessionTypeCount];
 
 bool sys_activity_sessions_is_session_type_ongoing(ActivitySessionType type) {
@@ -315,6 +343,8 @@ void test_health__initialize(void) {
     .out[0].asserts = true,
   };
 
+  s_sys_activity_get_minute_aggregate_values = (sys_activity_get_minute_aggregate_values) {};
+
   s_activity_prefs_heart_rate_enabled = true;
 }
 
@@ -620,6 +650,51 @@ void test_health__sum_fraction_days(void) {
   cl_assert_equal_i(result, 500);
 }
 
+void test_health__sum_minute_aggregate(void) {
+  s_sys_activity_get_minute_aggregate_values.out = (typeof(
+      s_sys_activity_get_minute_aggregate_values.out)) {
+    .aggregate = {
+      .steps = 1234,
+      .active_minutes = 17,
+      .distance_cm = 123456,
+      .resting_calories = 45600,
+      .active_calories = 7800,
+    },
+    .result = true,
+  };
+  // 33142 seconds into today, so a daily total of 33142 would prorate to 1 per second
+  s_sys_activity_get_metric_values.out.history[0] = 33142;
+
+  // Sums over the last few hours come from the minute aggregate
+  const time_t now = rtc_get_time();
+  const time_t time_start = now - 3 * SECONDS_PER_HOUR;
+  cl_assert_equal_i(health_service_sum(HealthMetricStepCount, time_start, now), 1234);
+  cl_assert_equal_i(s_sys_activity_get_minute_aggregate_values.in.utc_start, time_start);
+  cl_assert_equal_i(s_sys_activity_get_minute_aggregate_values.in.utc_end, now);
+  cl_assert_equal_i(health_service_sum(HealthMetricActiveSeconds, time_start, now),
+                    17 * SECONDS_PER_MINUTE);
+  cl_assert_equal_i(health_service_sum(HealthMetricWalkedDistanceMeters, time_start, now), 1235);
+  cl_assert_equal_i(health_service_sum(HealthMetricRestingKCalories, time_start, now), 46);
+  cl_assert_equal_i(health_service_sum(HealthMetricActiveKCalories, time_start, now), 8);
+  cl_assert_equal_i(s_sys_activity_get_minute_aggregate_values.call_count, 5);
+
+  // Sleep isn't kept per minute, so it still comes from the daily totals
+  cl_assert_equal_i(health_service_sum(HealthMetricSleepSeconds, time_start, now),
+                    3 * SECONDS_PER_HOUR);
+  cl_assert_equal_i(s_sys_activity_get_minute_aggregate_values.call_count, 5);
+
+  // Ranges reaching back further than the index covers don't even ask for it
+  const time_t old_start = now - ACTIVITY_MINUTE_AGGREGATE_MAX_AGE_SEC - SECONDS_PER_MINUTE;
+  cl_assert_equal_i(health_service_sum(HealthMetricStepCount, old_start, now), now - old_start);
+  cl_assert_equal_i(s_sys_activity_get_minute_aggregate_values.call_count, 5);
+
+  // If the index can't answer (e.g. right after a reboot) we fall back to the daily totals
+  s_sys_activity_get_minute_aggregate_values.out.result = false;
+  cl_assert_equal_i(health_service_sum(HealthMetricStepCount, time_start, now),
+                    3 * SECONDS_PER_HOUR);
+  cl_assert_equal_i(s_sys_activity_get_minute_aggregate_values.call_count, 6);
+}
+
 void test_health__cache(void) {
   cl_assert_equal_p(s_health_service.cache, NULL);
   health_service_events_subscribe(NULL, NULL);
@@ -1766,6 +1841,42 @@ void test_health__heart_rate_scope_once(void) {
 }
 
 
+void test_health__heart_rate_minute_aggregate(void) {
+  const time_t now = rtc_get_time();
+  const time_t time_start = now - 2 * SECONDS_PER_HOUR;
+  const time_t time_end = now - 5 * SECONDS_PER_MINUTE;
+
+  // The minute history stub asserts if it gets called
+  s_sys_activity_get_minute_aggregate_values.out = (typeof(
+      s_sys_activity_get_minute_aggregate_values.out)) {
+    .aggregate = {
+      .heart_rate_samples = 100,
+      .heart_rate_sum_bpm = 7549,
+      .heart_rate_min_bpm = 52,
+      .heart_rate_max_bpm = 143,
+    },
+    .result = true,
+  };
+  cl_assert_equal_i(health_service_aggregate_averaged(HealthMetricHeartRateBPM, time_start,
+                                                      time_end, HealthAggregationAvg,
+                                                      HealthServiceTimeScopeOnce), 75);
+  cl_assert_equal_i(health_service_aggregate_averaged(HealthMetricHeartRateBPM, time_start,
+                                                      time_end, HealthAggregationMin,
+                                                      HealthServiceTimeScopeOnce), 52);
+  cl_assert_equal_i(health_service_aggregate_averaged(HealthMetricHeartRateBPM, time_start,
+                                                      time_end, HealthAggregationMax,
+                                                      HealthServiceTimeScopeOnce), 143);
+  cl_assert_equal_i(s_sys_activity_get_minute_aggregate_values.in.utc_start, time_start);
+  cl_assert_equal_i(s_sys_activity_get_minute_aggregate_values.in.utc_end, time_end);
+
+  // No readings at all
+  s_sys_activity_get_minute_aggregate_values.out.aggregate = (ActivityMinuteAggregate) {};
+  cl_assert_equal_i(health_service_aggregate_averaged(HealthMetricHeartRateBPM, time_start,
+                                                      time_end, HealthAggregationMax,
+                                                      HealthServiceTimeScopeOnce), 0);
+}
+
+
 // --------------------------------------------------------------------------------------
 int s_metric_alert_count;
 static void prv_test_event_handler(HealthEventType event, void *context) {
@@ -11,6 +11,8 @@
 #include "clar.h"
 
 #include "stdbool.h"
+#include <inttypes.h>
+#include <stdio.h>
 
 // Stubs
 ////////////////////////////////////
@@ -888,3 +890,137 @@ void test_notification_storage__should_detect_corruption(void) {
   notification_storage_store(&e4);
   cl_assert_equal_b(notification_storage_get(&i4, &r), false);
 }
+
+#define BENCHMARK_NUM_NOTIFICATIONS (150)
+#define BENCHMARK_PAGE_CROSSING_READS (2)
+
+void test_notification_storage__benchmark_flash_reads_per_lookup(void) {
+  TimelineItem e = {
+    .header = {
+      .type = TimelineItemTypeNotification,
+      .layout = LayoutIdGeneric,
+    },
+    .attr_list = {
+      .num_attributes = 2,
+      .attributes = attributes,
+    },
+  };
+  const size_t notif_size = sizeof(SerializedTimelineItemHeader) +
+      timeline_item_get_serialized_payload_size(&e);
+  cl_assert(notif_size * BENCHMARK_NUM_NOTIFICATIONS < NOTIFICATION_STORAGE_FILE_SIZE);
+
+  Uuid uuids[BENCHMARK_NUM_NOTIFICATIONS];
+  for (int i = 0; i < BENCHMARK_NUM_NOTIFICATIONS; i++) {
+    uuid_generate(&uuids[i]);
+    e.header.id = uuids[i];
+    e.header.ancs_uid = i;
+    e.header.timestamp = 0x53f0dda5 + i;
+    notification_storage_store(&e);
+  }
+
+  const int positions[] = { 0, BENCHMARK_NUM_NOTIFICATIONS / 2, BENCHMARK_NUM_NOTIFICATIONS - 1 };
+  uint32_t get_reads[ARRAY_LENGTH(positions)];
+  uint32_t status_reads[ARRAY_LENGTH(positions)];
+  uint32_t ancs_reads[ARRAY_LENGTH(positions)];
+  uint32_t timestamp_reads[ARRAY_LENGTH(positions)];
+  for (int i = 0; i < ARRAY_LENGTH(positions); i++) {
+    const int pos = positions[i];
+
+    uint32_t reads = fake_flash_read_count();
+    TimelineItem r;
+    cl_assert(notification_storage_get(&uuids[pos], &r));
+    get_reads[i] = fake_flash_read_count() - reads;
+    cl_assert(uuid_equal(&r.header.id, &uuids[pos]));
+    free(r.allocated_buffer);
+
+    reads = fake_flash_read_count();
+    notification_storage_set_status(&uuids[pos], TimelineItemStatusRead);
+    status_reads[i] = fake_flash_read_count() - reads;
+
+    reads = fake_flash_read_count();
+    Uuid u;
+    cl_assert(notification_storage_find_ancs_notification_id(pos, &u));
+    ancs_reads[i] = fake_flash_read_count() - reads;
+    cl_assert(uuid_equal(&u, &uuids[pos]));
+
+    TimelineItem test = e;
+    test.header.id = UUID_INVALID;
+    test.header.timestamp = 0x53f0dda5 + pos;
+    CommonTimelineItemHeader h;
+    reads = fake_flash_read_count();
+    cl_assert(notification_storage_find_ancs_notification_by_timestamp(&test, &h));
+    timestamp_reads[i] = fake_flash_read_count() - reads;
+    cl_assert(uuid_equal(&h.id, &uuids[pos]));
+    cl_assert_equal_i(h.status, TimelineItemStatusRead);
+
+    printf("\nnotification %d of %d, flash reads: get %"PRIu32", set_status %"PRIu32", "
+           "ANCS uid %"PRIu32", timestamp %"PRIu32,
+           pos + 1, BENCHMARK_NUM_NOTIFICATIONS, get_reads[i], status_reads[i], ancs_reads[i],
+           timestamp_reads[i]);
+  }
+  printf("\n");
+
+  // The cost of a lookup doesn't depend on where the notification is in the file, apart from the
+  // header or payload straddling a flash page
+  for (int i = 1; i < ARRAY_LENGTH(positions); i++) {
+    cl_assert(get_reads[i] <= get_reads[0] + BENCHMARK_PAGE_CROSSING_READS);
+    cl_assert(status_reads[i] <= status_reads[0] + BENCHMARK_PAGE_CROSSING_READS);
+    cl_assert(ancs_reads[i] <= ancs_reads[0] + BENCHMARK_PAGE_CROSSING_READS);
+    cl_assert(timestamp_reads[i] <= timestamp_reads[0] + BENCHMARK_PAGE_CROSSING_READS);
+  }
+
+  // Removed notifications can't be found anymore
+  notification_storage_remove(&uuids[0]);
+  cl_assert(!notification_storage_notification_exists(&uuids[0]));
+  Uuid u;
+  cl_assert(!notification_storage_find_ancs_notification_id(0, &u));
+  cl_assert(notification_storage_notification_exists(&uuids[1]));
+}
+
+void test_notification_storage__index_survives_compression(void) {
+  TimelineItem e = {
+    .header = {
+      .type = TimelineItemTypeNotification,
+      .layout = LayoutIdGeneric,
+    },
+    .attr_list = {
+      .num_attributes = ARRAY_LENGTH(attributes),
+      .attributes = attributes,
+    },
+  };
+  const size_t notif_size = sizeof(SerializedTimelineItemHeader) +
+      timeline_item_get_serialized_payload_size(&e);
+  // Enough to wrap around the file twice
+  const int count = 2 * NOTIFICATION_STORAGE_FILE_SIZE / notif_size;
+  Uuid uuids[count];
+  for (int i = 0; i < count; i++) {
+    uuid_generate(&uuids[i]);
+    e.header.id = uuids[i];
+    e.header.ancs_uid = i;
+    e.header.timestamp = 0x53f0dda5 + i;
+    notification_storage_store(&e);
+    if (i % 3 == 0) {
+      notification_storage_remove(&uuids[i]);
+    }
+  }
+
+  // Whatever is still stored has to be found through the index, at its new place in the file
+  int num_found = 0;
+  for (int i = 0; i < count; i++) {
+    TimelineItem r;
+    const bool found = notification_storage_get(&uuids[i], &r);
+    Uuid u;
+    cl_assert_equal_b(notification_storage_find_ancs_notification_id(i, &u), found);
+    if (found) {
+      cl_assert(i % 3 != 0);
+      cl_assert(uuid_equal(&r.header.id, &uuids[i]));
+      cl_assert(uuid_equal(&u, &uuids[i]));
+      cl_assert_equal_i(r.header.ancs_uid, i);
+      free(r.allocated_buffer);
+      num_found++;
+    }
+  }
+  // The most recent notifications are never the ones that get reclaimed
+  cl_assert(notification_storage_notification_exists(&uuids[count - 1]));
+  cl_assert(num_found > 0);
+}
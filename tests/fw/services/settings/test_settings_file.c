@@ -7,6 +7,9 @@
 
 #include "clar.h"
 
+#include "kernel/pbl_malloc.h"
+#include "util/size.h"
+
 #include "services/normal/filesystem/pfs.h"
 #include "flash_region/flash_region.h"
 
@@ -660,6 +663,17 @@ void test_settings_file__iterator_wrapping(void) {
   // Force us to move to the record `search_for_idx` + 1
   settings_raw_iter_next(&file.iter);
 
+  // The key index takes us straight to the record without stepping through any others.
+  before_count = settings_raw_iter_prv_get_num_record_searches();
+  cl_must_pass(settings_file_get(&file, key, key_len, val, val_len));
+  after_count = settings_raw_iter_prv_get_num_record_searches();
+  cl_assert_equal_i(0, after_count - before_count);
+
+  // Drop the index to exercise the scanning fallback used when we are short on memory.
+  kernel_free(file.index);
+  file.index = NULL;
+  settings_raw_iter_next(&file.iter);
+
   // We now are forced to start searching in the middle, wrap around, and continue searching
   // from the beginning. This will result in us calling `settings_raw_iter_next` NUM_RECORDS - 1
   // times.
@@ -668,3 +682,93 @@ void test_settings_file__iterator_wrapping(void) {
   after_count = settings_raw_iter_prv_get_num_record_searches();
   cl_assert_equal_i(NUM_RECORDS - 1, after_count - before_count);
 }
+
+// Fills a file with num_records records, overwriting and deleting some of them along the way,
+// and returns the average number of flash reads needed to look up a key.
+static uint32_t prv_reads_per_lookup(int num_records, bool use_index) {
+  char name[32];
+  snprintf(name, sizeof(name), "test_lookup_%d_%d", num_records, use_index);
+  SettingsFile file;
+  cl_must_pass(settings_file_open(&file, name, 64 * 1024));
+
+  char key[8];
+  const int key_len = 5;
+  uint32_t val;
+  for (int i = 0; i < num_records; i++) {
+    snprintf(key, sizeof(key), "k%04d", i);
+    val = i;
+    cl_must_pass(settings_file_set(&file, key, key_len, &val, sizeof(val)));
+  }
+  // Overwrite every 3rd record and delete every 7th so that the file has dead records in it.
+  for (int i = 0; i < num_records; i += 3) {
+    snprintf(key, sizeof(key), "k%04d", i);
+    val = i + 1;
+    cl_must_pass(settings_file_set(&file, key, key_len, &val, sizeof(val)));
+  }
+  for (int i = 0; i < num_records; i += 7) {
+    snprintf(key, sizeof(key), "k%04d", i);
+    cl_must_pass(settings_file_delete(&file, key, key_len));
+  }
+
+  // Make sure the index survives a close and re-open.
+  settings_file_close(&file);
+  cl_must_pass(settings_file_open(&file, name, 64 * 1024));
+  if (!use_index) {
+    kernel_free(file.index);
+    file.index = NULL;
+  }
+
+  const uint32_t reads_before = fake_flash_read_count();
+  for (int i = 0; i < num_records; i++) {
+    snprintf(key, sizeof(key), "k%04d", i);
+    if ((i % 7) == 0) {
+      cl_assert(!settings_file_exists(&file, key, key_len));
+      continue;
+    }
+    cl_must_pass(settings_file_get(&file, key, key_len, &val, sizeof(val)));
+    cl_assert_equal_i(val, ((i % 3) == 0) ? i + 1 : i);
+  }
+  snprintf(key, sizeof(key), "nokey");
+  cl_assert(!settings_file_exists(&file, key, key_len));
+  const uint32_t reads = fake_flash_read_count() - reads_before;
+
+  settings_file_close(&file);
+  return reads / (num_records + 1);
+}
+
+void test_settings_file__indexed_lookup_flash_reads(void) {
+  const int record_counts[] = { 10, 100, 1000 };
+  for (unsigned i = 0; i < ARRAY_LENGTH(record_counts); i++) {
+    const uint32_t scan_reads = prv_reads_per_lookup(record_counts[i], false);
+    const uint32_t index_reads = prv_reads_per_lookup(record_counts[i], true);
+    printf("%4d records: %"PRIu32" flash reads per lookup scanning, %"PRIu32" indexed\n",
+           record_counts[i], scan_reads, index_reads);
+    cl_assert(index_reads <= scan_reads);
+    // A lookup reads the header and key of only the few records sharing its key hash.
+    cl_assert(index_reads < 32);
+  }
+}
+
+void test_settings_file__index_tracks_compaction(void) {
+  SettingsFile file;
+  cl_must_pass(settings_file_open(&file, "test_index_compaction", 1024));
+
+  // Keep rewriting a small set of keys so the file gets compacted several times underneath
+  // the index.
+  char key[8];
+  const int key_len = 4;
+  for (uint32_t round = 0; round < 50; round++) {
+    for (uint32_t i = 0; i < 10; i++) {
+      snprintf(key, sizeof(key), "k%03"PRIu32, i);
+      const uint32_t val = round * 100 + i;
+      cl_must_pass(settings_file_set(&file, key, key_len, &val, sizeof(val)));
+    }
+  }
+  for (uint32_t i = 0; i < 10; i++) {
+    snprintf(key, sizeof(key), "k%03"PRIu32, i);
+    uint32_t val;
+    cl_must_pass(settings_file_get(&file, key, key_len, &val, sizeof(val)));
+    cl_assert_equal_i(val, 49 * 100 + i);
+  }
+  settings_file_close(&file);
+}
@@ -1,6 +1,7 @@
 /* SPDX-FileCopyrightText: 2024 Google LLC */
 /* SPDX-License-Identifier: Apache-2.0 */
 
+#include <inttypes.h>
 #include <string.h>
 #include <stdlib.h>
 
@@ -986,3 +987,220 @@ void test_pfs__doesnt_give_out_fd_zero(void) {
     cl_assert(fd > 0);
   }
 }
+
+// Every page costs one flash read to check its flags since the flags cache is disabled in
+// unit tests. Anything beyond that is what locate_flash_file() spends reading file names.
+static uint32_t prv_page_flag_reads(void) {
+  return (pfs_get_size() + SECTOR_SIZE_BYTES) / PFS_SECTOR_SIZE;
+}
+
+void test_pfs__name_index_flash_reads_per_open(void) {
+  const int num_files = 100;
+  char filename[10];
+  for (int i = 0; i < num_files; i++) {
+    snprintf(filename, sizeof(filename), "file%03d", i);
+    int fd = pfs_open(filename, OP_FLAG_WRITE, FILE_TYPE_STATIC, 10);
+    cl_assert(fd >= 0);
+    pfs_close(fd);
+  }
+
+  // simulate a reboot so that nothing is left in the fd cache
+  pfs_init(false);
+
+  // Without the index each of the equal length names would need 2 reads
+  const uint32_t max_name_reads = 16;
+
+  uint32_t reads_before = fake_flash_read_count();
+  int fd = pfs_open("file050", OP_FLAG_READ, 0, 0);
+  cl_assert(fd >= 0);
+  uint32_t reads = fake_flash_read_count() - reads_before;
+  printf("Flash reads to open file050: %"PRIu32"\n", reads);
+  cl_assert(reads < (prv_page_flag_reads() + max_name_reads));
+  pfs_close(fd);
+
+  reads_before = fake_flash_read_count();
+  cl_assert_equal_i(pfs_open("file999", OP_FLAG_READ, 0, 0), E_DOES_NOT_EXIST);
+  reads = fake_flash_read_count() - reads_before;
+  printf("Flash reads for a missing file: %"PRIu32"\n", reads - prv_page_flag_reads());
+  cl_assert(reads < (prv_page_flag_reads() + max_name_reads));
+}
+
+void test_pfs__name_index_tracks_changes(void) {
+  char filename[10];
+  uint16_t start_page = 0;
+  for (int i = 0; i < 20; i++) {
+    snprintf(filename, sizeof(filename), "file%d", i);
+    int fd = pfs_open(filename, OP_FLAG_WRITE, FILE_TYPE_STATIC, PFS_SECTOR_SIZE);
+    cl_assert(fd >= 0);
+    if (i == 0) {
+      start_page = test_get_file_start_page(fd);
+    }
+    pfs_close(fd);
+  }
+
+  // remove every other file and move the survivors around with a garbage collection
+  for (int i = 0; i < 20; i += 2) {
+    snprintf(filename, sizeof(filename), "file%d", i);
+    cl_assert_equal_i(pfs_remove(filename), S_SUCCESS);
+  }
+  test_force_garbage_collection(start_page);
+
+  // reuse the freed pages for files with new names
+  for (int i = 0; i < 20; i += 2) {
+    snprintf(filename, sizeof(filename), "new%d", i);
+    int fd = pfs_open(filename, OP_FLAG_WRITE, FILE_TYPE_STATIC, PFS_SECTOR_SIZE);
+    cl_assert(fd >= 0);
+    pfs_close(fd);
+  }
+
+  // evict everything from the fd cache so lookups have to go through the index
+  pfs_init(false);
+
+  for (int i = 0; i < 20; i++) {
+    snprintf(filename, sizeof(filename), "file%d", i);
+    int fd = pfs_open(filename, OP_FLAG_READ, 0, 0);
+    if ((i % 2) == 0) {
+      cl_assert_equal_i(fd, E_DOES_NOT_EXIST);
+      snprintf(filename, sizeof(filename), "new%d", i);
+      fd = pfs_open(filename, OP_FLAG_READ, 0, 0);
+    }
+    cl_assert(fd >= 0);
+    pfs_close(fd);
+  }
+}
+
+extern uint32_t test_get_region_erase_count(uint16_t region);
+extern uint16_t test_get_num_erase_regions(void);
+extern uint16_t test_get_erased_page_count(void);
+extern uint16_t test_recount_erased_page_count(void);
+
+#define CHURN_FILE_SIZE (PFS_SECTOR_SIZE * 2)
+#define CHURN_NUM_FILES 250
+#define CHURN_NUM_OPS 600
+#define BACKGROUND_GC_FREE_SECTOR_RESERVE 2
+
+static bool s_background_gc_requested;
+
+static bool prv_background_gc_request(void) {
+  s_background_gc_requested = true;
+  return true;
+}
+
+// Stands in for the system task, running one step at a time until the reserve is refilled
+static void prv_run_background_gc(void) {
+  while (s_background_gc_requested) {
+    s_background_gc_requested = pfs_background_gc_step();
+  }
+}
+
+static void prv_write_churn_file(int id) {
+  char name[16];
+  snprintf(name, sizeof(name), "churn%d", id);
+  static uint8_t buf[CHURN_FILE_SIZE];
+  memset(buf, id & 0xff, sizeof(buf));
+  int fd = pfs_open(name, OP_FLAG_WRITE, FILE_TYPE_STATIC, sizeof(buf));
+  cl_assert(fd >= 0);
+  cl_assert_equal_i(pfs_write(fd, buf, sizeof(buf)), sizeof(buf));
+  cl_assert_equal_i(pfs_close(fd), S_SUCCESS);
+}
+
+static void prv_check_churn_file(int id) {
+  char name[16];
+  snprintf(name, sizeof(name), "churn%d", id);
+  static uint8_t buf[CHURN_FILE_SIZE];
+  int fd = pfs_open(name, OP_FLAG_READ, 0, 0);
+  cl_assert(fd >= 0);
+  cl_assert_equal_i(pfs_read(fd, buf, sizeof(buf)), sizeof(buf));
+  for (size_t i = 0; i < sizeof(buf); i++) {
+    cl_assert_equal_i(buf[i], id & 0xff);
+  }
+  pfs_close(fd);
+}
+
+//! Keeps CHURN_NUM_FILES files around, replacing the oldest one on every operation
+//! @return the largest number of flash erases a single replacement had to wait for
+static uint32_t prv_churn(bool background_gc) {
+  s_background_gc_requested = false;
+  if (background_gc) {
+    pfs_background_gc_enable(BACKGROUND_GC_FREE_SECTOR_RESERVE, prv_background_gc_request);
+  }
+
+  for (int i = 0; i < CHURN_NUM_FILES; i++) {
+    prv_write_churn_file(i);
+    prv_run_background_gc();
+  }
+
+  uint32_t max_erases = 0;
+  for (int i = CHURN_NUM_FILES; i < CHURN_NUM_FILES + CHURN_NUM_OPS; i++) {
+    char name[16];
+    snprintf(name, sizeof(name), "churn%d", i - CHURN_NUM_FILES);
+
+    uint32_t erases_before = fake_flash_erase_count();
+    cl_assert_equal_i(pfs_remove(name), S_SUCCESS);
+    prv_write_churn_file(i);
+    max_erases = MAX(max_erases, fake_flash_erase_count() - erases_before);
+
+    prv_run_background_gc();
+
+    // the incrementally maintained count must match a full rescan
+    const uint16_t erased_pages = test_get_erased_page_count();
+    cl_assert_equal_i(test_recount_erased_page_count(), erased_pages);
+  }
+
+  for (int i = CHURN_NUM_OPS; i < CHURN_NUM_FILES + CHURN_NUM_OPS; i++) {
+    prv_check_churn_file(i);
+  }
+
+  pfs_background_gc_enable(0, NULL);
+  return max_erases;
+}
+
+static void prv_get_erase_count_spread(uint32_t *min, uint32_t *max) {
+  *min = UINT32_MAX;
+  *max = 0;
+  for (uint16_t region = 0; region < test_get_num_erase_regions(); region++) {
+    uint32_t erase_count = test_get_region_erase_count(region);
+    *min = MIN(*min, erase_count);
+    *max = MAX(*max, erase_count);
+  }
+}
+
+void test_pfs__background_gc_worst_case_write_erases(void) {
+  const uint32_t foreground_max_erases = prv_churn(false /* background_gc */);
+
+  pfs_format(true /* write erase headers */);
+  pfs_init(false);
+  const uint32_t background_max_erases = prv_churn(true /* background_gc */);
+
+  printf("Worst case erases per file replacement: %"PRIu32" foreground GC, "
+         "%"PRIu32" background GC\n", foreground_max_erases, background_max_erases);
+  cl_assert(foreground_max_erases > 0);
+  // a pre-erased page is always left to write to
+  cl_assert_equal_i(background_max_erases, 0);
+}
+
+void test_pfs__background_gc_erase_count_spread(void) {
+  pfs_format(true /* write erase headers */);
+  pfs_init(false);
+  prv_churn(true /* background_gc */);
+
+  uint32_t min_erases, max_erases;
+  prv_get_erase_count_spread(&min_erases, &max_erases);
+  printf("Erase count spread: min %"PRIu32", max %"PRIu32"\n", min_erases, max_erases);
+  cl_assert((max_erases - min_erases) <= 2);
+}
+
+void test_pfs__background_gc_disabled_without_reserve(void) {
+  s_background_gc_requested = false;
+  pfs_background_gc_enable(0, prv_background_gc_request);
+  for (int i = 0; i < 20; i++) {
+    prv_write_churn_file(i);
+  }
+  for (int i = 0; i < 20; i++) {
+    char name[16];
+    snprintf(name, sizeof(name), "churn%d", i);
+    cl_assert_equal_i(pfs_remove(name), S_SUCCESS);
+  }
+  cl_assert(!s_background_gc_requested);
+  cl_assert(!pfs_background_gc_step());
+}
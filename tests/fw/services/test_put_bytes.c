@@ -4,12 +4,16 @@
 #include "services/common/put_bytes/put_bytes.h"
 
 #include "services/common/comm_session/session_receive_router.h"
+#include "services/common/put_bytes/put_bytes_storage.h"
 #include "os/tick.h"
 #include "system/bootbits.h"
 #include "system/firmware_storage.h"
 #include "system/logging.h"
 #include "util/attributes.h"
+#include "util/crc32.h"
+#include "util/legacy_checksum.h"
 #include "util/net.h"
+#include "util/size.h"
 
 #include <bluetooth/conn_event_stats.h>
 
@@ -79,7 +83,7 @@ void app_storage_get_file_name(char *name, size_t buf_length,
 }
 
 void bluetooth_analytics_handle_put_bytes_stats(bool successful, uint8_t type, uint32_t total_size,
-                                                uint32_t elapsed_time_ms,
+                                                uint32_t elapsed_time_ms, uint32_t commit_time_ms,
                                                 const SlaveConnEventStats *orig_stats) {
 }
 
@@ -149,12 +153,15 @@ static uint32_t s_last_response_cookie;
 
 static CommSession *s_session;
 
+static uint32_t s_expected_crc;
+
 // Helpers
 ///////////////////////////////////////////////////////////
 
 #define VALID_OBJECT_SIZE (4)
 #define PUT_BYTES_TIMEOUT_MS (30000)
-#define EXPECTED_CRC (0x12345678)
+// Legacy checksum of the { 0xaa, 0xbb, 0xcc, 0xdd } chunk most tests put
+#define EXPECTED_CRC (s_expected_crc)
 #define EXPECTED_COOKIE (0xabcd1234)
 #define EXPECT_INIT_TIMEOUT_MS (1000)
 
@@ -195,6 +202,25 @@ static void prv_receive_init_cookie(uint32_t total_size, PutBytesObjectType obje
   prv_receive_data(s_session, (const uint8_t *) &init_msg, sizeof(init_msg));
 }
 
+static void prv_receive_init_append(uint32_t total_size, PutBytesObjectType object_type,
+                                    uint32_t append_offset) {
+  struct PACKED {
+    InitRequest request;
+    uint32_t init_req_magic;
+    uint32_t append_offset;
+  } init_msg = {
+    .request = {
+      .cmd = CmdInit,
+      .total_size = htonl(total_size),
+      .type = object_type,
+      .cookie = htonl(1),
+    },
+    .init_req_magic = htonl(0xBE4354EF),
+    .append_offset = htonl(append_offset),
+  };
+  prv_receive_data(s_session, (const uint8_t *) &init_msg, sizeof(init_msg));
+}
+
 static void prv_receive_init_file(uint32_t total_size, const char *fn, size_t fn_len) {
   uint8_t buffer[sizeof(InitRequest) + fn_len];
 
@@ -334,7 +360,8 @@ static void prv_system_msg_sent_callback(uint16_t endpoint_id,
 
 void test_put_bytes__initialize(void) {
   fake_pb_storage_mem_reset();
-  fake_pb_storage_mem_set_crc(EXPECTED_CRC);
+  const uint8_t chunk[] = { 0xaa, 0xbb, 0xcc, 0xdd };
+  s_expected_crc = legacy_defective_checksum_memory(chunk, sizeof(chunk));
   fake_comm_session_init();
   fake_event_reset_count();
 
@@ -779,6 +806,7 @@ void test_put_bytes__commit_message_crc_mismatch(void) {
 }
 
 void test_put_bytes__commit_message_fw_description_is_written(void) {
+  const uint8_t chunk[] = { 0xaa, 0xbb, 0xcc, 0xdd };
   prv_receive_init_and_put_fw_object();
   prv_receive_commit(s_last_response_cookie, EXPECTED_CRC);
   fake_comm_session_process_send_next();
@@ -788,11 +816,94 @@ void test_put_bytes__commit_message_fw_description_is_written(void) {
   const FirmwareDescription fw_descr = {
     .description_length = sizeof(FirmwareDescription),
     .firmware_length = VALID_OBJECT_SIZE,
+#if CAPABILITY_HAS_DEFECTIVE_FW_CRC
     .checksum = EXPECTED_CRC,
+#else
+    .checksum = crc32(CRC32_INIT, chunk, sizeof(chunk)),
+#endif
+  };
+  fake_pb_storage_mem_assert_fw_description_written(&fw_descr);
+}
+
+void test_put_bytes__commit_uses_checksums_accumulated_while_putting(void) {
+  const uint8_t chunks[3][4] = {
+    { 0x01, 0x02, 0x03, 0x04 }, { 0x05, 0x06, 0x07, 0x08 }, { 0x09, 0x0a, 0x0b, 0x0c },
+  };
+  prv_receive_init(sizeof(chunks), ObjectFirmware);
+  prv_process_and_reset_test_counters();
+  for (int i = 0; i < ARRAY_LENGTH(chunks); ++i) {
+    prv_receive_put(s_last_response_cookie, chunks[i], sizeof(chunks[i]));
+    prv_process_and_reset_test_counters();
+  }
+
+  prv_receive_commit(s_last_response_cookie,
+                     legacy_defective_checksum_memory(chunks, sizeof(chunks)));
+  fake_comm_session_process_send_next();
+  fake_system_task_callbacks_invoke_pending();
+  cl_assert_equal_i(s_acks_received, 1);
+  cl_assert_equal_i(s_nacks_received, 0);
+
+  // Neither the CRC check nor the FW description needed the object to be read back:
+  cl_assert_equal_i(fake_pb_storage_mem_get_calculate_crc_count(), 0);
+  const FirmwareDescription fw_descr = {
+    .description_length = sizeof(FirmwareDescription),
+    .firmware_length = sizeof(chunks),
+#if CAPABILITY_HAS_DEFECTIVE_FW_CRC
+    .checksum = legacy_defective_checksum_memory(chunks, sizeof(chunks)),
+#else
+    .checksum = crc32(CRC32_INIT, chunks, sizeof(chunks)),
+#endif
   };
   fake_pb_storage_mem_assert_fw_description_written(&fw_descr);
 }
 
+void test_put_bytes__commit_resumed_transfer(void) {
+  const uint8_t chunk[] = { 0xaa, 0xbb, 0xcc, 0xdd };
+  const uint8_t resumed_chunk[] = { 0x11, 0x22, 0x33, 0x44 };
+  prv_receive_init(sizeof(chunk) + sizeof(resumed_chunk), ObjectFirmware);
+  prv_process_and_reset_test_counters();
+  prv_receive_put(s_last_response_cookie, chunk, sizeof(chunk));
+  prv_process_and_reset_test_counters();
+  prv_receive_abort(s_last_response_cookie);
+  prv_process_and_reset_test_counters();
+
+  // Pick up where the aborted transfer left off, the data it wrote is part of the checksum:
+  prv_receive_init_append(sizeof(resumed_chunk), ObjectFirmware, sizeof(chunk));
+  prv_process_and_reset_test_counters();
+  prv_receive_put(s_last_response_cookie, resumed_chunk, sizeof(resumed_chunk));
+  prv_process_and_reset_test_counters();
+
+  const uint8_t object[] = { 0xaa, 0xbb, 0xcc, 0xdd, 0x11, 0x22, 0x33, 0x44 };
+  prv_receive_commit(s_last_response_cookie, legacy_defective_checksum_memory(object,
+                                                                              sizeof(object)));
+  assert_ack_count(1);
+  assert_nack_count(0);
+  cl_assert_equal_i(fake_pb_storage_mem_get_calculate_crc_count(), 0);
+}
+
+void test_put_bytes__storage_reads_back_after_out_of_order_write(void) {
+  PutBytesStorage storage = {};
+  PutBytesStorageInfo info = {};
+  cl_assert(pb_storage_init(&storage, ObjectFirmware, VALID_OBJECT_SIZE, &info, 0));
+
+  const uint8_t chunk[] = { 0xaa, 0xbb, 0xcc, 0xdd };
+  pb_storage_append(&storage, chunk, sizeof(chunk));
+  cl_assert_equal_i(pb_storage_calculate_crc(&storage, PutBytesCrcType_Legacy), EXPECTED_CRC);
+  cl_assert_equal_i(pb_storage_calculate_crc(&storage, PutBytesCrcType_CRC32),
+                    crc32(CRC32_INIT, chunk, sizeof(chunk)));
+  cl_assert_equal_i(fake_pb_storage_mem_get_calculate_crc_count(), 0);
+
+  // Overwriting part of the object can't be followed, so the object gets read back instead:
+  const uint8_t patch[] = { 0x55, 0x66 };
+  pb_storage_write(&storage, sizeof(FirmwareDescription) + 1, patch, sizeof(patch));
+  const uint8_t patched[] = { 0xaa, 0x55, 0x66, 0xdd };
+  cl_assert_equal_i(pb_storage_calculate_crc(&storage, PutBytesCrcType_Legacy),
+                    legacy_defective_checksum_memory(patched, sizeof(patched)));
+  cl_assert_equal_i(fake_pb_storage_mem_get_calculate_crc_count(), 1);
+
+  pb_storage_deinit(&storage, false);
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // Abort Message
 
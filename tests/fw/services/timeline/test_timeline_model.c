@@ -232,14 +232,16 @@ void test_timeline_model__initialize(void) {
   fake_spi_flash_init(0, 0x1000000);
   fake_rtc_init(0, 0);
   pfs_init(false);
-  // Note: creating a settings file is going to result in one malloc for the FD name
+  fake_pbl_malloc_clear_tracking();
+  // Note: creating a settings file is going to result in one malloc for the FD name, which gets
+  // freed and reallocated when the file has to grow to make room for a lot of pins
   pin_db_init();
   time_util_update_timezone(&tz);
-  fake_pbl_malloc_clear_tracking();
+  const int num_allocs = fake_pbl_malloc_num_net_allocs();
   for (unsigned int i = 0; i < ARRAY_LENGTH(s_items); ++i) {
     cl_assert_equal_i(pin_db_insert_item(&s_items[i]), 0);
   }
-  cl_assert_equal_i(fake_pbl_malloc_num_net_allocs(), 0);
+  cl_assert_equal_i(fake_pbl_malloc_num_net_allocs(), num_allocs);
 }
 
 void test_timeline_model__cleanup(void) {
@@ -487,3 +489,48 @@ void test_timeline_model__is_empty_immediate(void) {
 
   cl_assert(timeline_model_is_empty());
 }
+
+#define MANY_PINS_NUM_PINS (500)
+
+void test_timeline_model__many_pins(void) {
+  const time_t first_time = 1421178000;
+  // Note: 1421178000 = Tue Jan 13 11:40:00 PST 2015
+  // Start tomorrow so that no pin crosses midnight and gets split up into multiple nodes
+  const time_t tomorrow = time_util_get_midnight_of(first_time) + SECONDS_PER_DAY;
+  const int max_duration = 120;
+  uint32_t seed = 1;
+  for (int i = 0; i < MANY_PINS_NUM_PINS; i++) {
+    seed = seed * 1103515245 + 12345;
+    TimelineItem item = {
+      .header = {
+        .id = {0x6b, 0xf6, 0x21, 0x5b, 0xc9, 0x7f, 0x40, 0x9e,
+               0x8c, 0x31, 0x4f, 0x55, 0x00, 0x00, i >> 8, i & 0xff},
+        // Spread over two days, in whole minutes so that some pins share a timestamp
+        .timestamp = tomorrow + ((seed >> 8) % 2) * SECONDS_PER_DAY +
+                     ((seed >> 16) % (MINUTES_PER_DAY - max_duration)) * SECONDS_PER_MINUTE,
+        .duration = (seed >> 4) % max_duration,
+        .type = TimelineItemTypePin,
+        .layout = LayoutIdTest,
+      },
+    };
+    cl_assert_equal_i(pin_db_insert_item(&item), 0);
+  }
+
+  TimelineModel model = {0};
+  model.direction = TimelineIterDirectionFuture;
+  timeline_model_init(first_time, &model);
+
+  int num_items = 1;
+  TimelineItem prev = timeline_model_get_iter_state(0)->pin;
+  while (timeline_model_iter_next(NULL, NULL)) {
+    TimelineItem *pin = &timeline_model_get_iter_state(0)->pin;
+    cl_assert(prev.header.timestamp < pin->header.timestamp ||
+              (prev.header.timestamp == pin->header.timestamp &&
+               prev.header.duration <= pin->header.duration));
+    prev = *pin;
+    num_items++;
+  }
+
+  cl_assert_equal_i(num_items, MANY_PINS_NUM_PINS + ARRAY_LENGTH(s_items));
+  timeline_model_deinit();
+}
@@ -0,0 +1,252 @@
+/* SPDX-FileCopyrightText: 2024 Google LLC */
+/* SPDX-License-Identifier: Apache-2.0 */
+
+#include "util/heap.h"
+
+#include "applib/app_heap_util.h"
+
+#include "clar.h"
+
+#include "fake_pebble_tasks.h"
+#include "stubs_serial.h"
+#include "stubs_passert.h"
+#include "stubs_logging.h"
+#include "stubs_app_state.h"
+#include "stubs_worker_state.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HEAP_SIZE_BYTES (64 * 1024)
+#define FRAGMENTATION_HEAP_SIZE_BYTES (32 * 1024)
+#define MAX_ALLOCATIONS (512)
+
+// Stubs
+///////////////////////////////////////////////////////////
+
+void MPU_vTaskSuspendAll(void) {}
+void MPU_xTaskResumeAll(void) {}
+
+// Helpers
+///////////////////////////////////////////////////////////
+
+typedef struct {
+  uint8_t *ptr;
+  size_t size;
+  uint8_t pattern;
+} Allocation;
+
+static Heap s_heap;
+static void *s_heap_space;
+static Allocation s_allocations[MAX_ALLOCATIONS];
+static uint32_t s_rand_state;
+static void *s_corrupt_block;
+
+static uint32_t prv_rand(void) {
+  s_rand_state = s_rand_state * 1103515245 + 12345;
+  return s_rand_state >> 16;
+}
+
+static void prv_corruption_handler(void *ptr) {
+  s_corrupt_block = ptr;
+}
+
+static void prv_init_heap_with_size(bool use_free_lists, size_t size) {
+  memset(s_allocations, 0, sizeof(s_allocations));
+  heap_init(&s_heap, s_heap_space, (uint8_t *)s_heap_space + size, false);
+  if (use_free_lists) {
+    heap_enable_free_lists(&s_heap);
+  }
+}
+
+static void prv_init_heap(bool use_free_lists) {
+  prv_init_heap_with_size(use_free_lists, HEAP_SIZE_BYTES);
+}
+
+//! Small allocations dominate, like layers, text buffers and animations in an app
+static size_t prv_random_size(void) {
+  return ((prv_rand() % 8) == 0) ? (256 + prv_rand() % 1024) : (1 + prv_rand() % 96);
+}
+
+static void prv_check_totals(void) {
+  unsigned int used, free, max_free;
+  heap_calc_totals(&s_heap, &used, &free, &max_free);
+  cl_assert_equal_i(used, s_heap.current_size);
+  cl_assert_equal_i(used + free, heap_size(&s_heap));
+}
+
+static void prv_check_contents(void) {
+  for (int i = 0; i < MAX_ALLOCATIONS; i++) {
+    const Allocation *allocation = &s_allocations[i];
+    for (size_t j = 0; j < allocation->size; j++) {
+      cl_assert_equal_i(allocation->ptr[j], allocation->pattern);
+    }
+  }
+}
+
+//! Randomly allocates and frees blocks, returning the number of failed allocations
+static int prv_churn(int iterations) {
+  int failures = 0;
+  for (int i = 0; i < iterations; i++) {
+    Allocation *allocation = &s_allocations[prv_rand() % MAX_ALLOCATIONS];
+    if (allocation->ptr) {
+      heap_free(&s_heap, allocation->ptr, 0);
+      *allocation = (Allocation) {};
+      continue;
+    }
+    const size_t size = prv_random_size();
+    allocation->ptr = heap_malloc(&s_heap, size, 0);
+    if (!allocation->ptr) {
+      failures++;
+      continue;
+    }
+    allocation->size = size;
+    allocation->pattern = prv_rand();
+    memset(allocation->ptr, allocation->pattern, size);
+  }
+  return failures;
+}
+
+static void prv_free_all(void) {
+  for (int i = 0; i < MAX_ALLOCATIONS; i++) {
+    heap_free(&s_heap, s_allocations[i].ptr, 0);
+    s_allocations[i] = (Allocation) {};
+  }
+}
+
+// Tests
+///////////////////////////////////////////////////////////
+
+void test_heap_free_lists__initialize(void) {
+  s_heap_space = malloc(HEAP_SIZE_BYTES);
+  s_rand_state = 1;
+  s_corrupt_block = NULL;
+}
+
+void test_heap_free_lists__cleanup(void) {
+  free(s_heap_space);
+}
+
+void test_heap_free_lists__random_churn_keeps_heap_consistent(void) {
+  prv_init_heap(true /* use_free_lists */);
+
+  for (int round = 0; round < 50; round++) {
+    prv_churn(200);
+    prv_check_contents();
+    prv_check_totals();
+  }
+  cl_assert(s_heap.use_free_lists);
+
+  // Freeing everything coalesces back into a single free block
+  prv_free_all();
+  unsigned int used, free, max_free;
+  heap_calc_totals(&s_heap, &used, &free, &max_free);
+  cl_assert_equal_i(used, 0);
+  cl_assert_equal_i(max_free, heap_size(&s_heap));
+  cl_assert_equal_i(s_heap.current_size, 0);
+}
+
+void test_heap_free_lists__small_allocation_reuses_exact_fit(void) {
+  prv_init_heap(true /* use_free_lists */);
+
+  void *a = heap_malloc(&s_heap, 48, 0);
+  void *guard1 = heap_malloc(&s_heap, 8, 0);
+  void *b = heap_malloc(&s_heap, 24, 0);
+  void *guard2 = heap_malloc(&s_heap, 8, 0);
+  heap_free(&s_heap, a, 0);
+  heap_free(&s_heap, b, 0);
+
+  // Each request is served from the hole of its own size, not the first hole that fits
+  cl_assert_equal_p(heap_malloc(&s_heap, 24, 0), b);
+  cl_assert_equal_p(heap_malloc(&s_heap, 48, 0), a);
+
+  heap_free(&s_heap, guard1, 0);
+  heap_free(&s_heap, guard2, 0);
+}
+
+void test_heap_free_lists__coalescing_updates_free_lists(void) {
+  prv_init_heap(true /* use_free_lists */);
+
+  void *a = heap_malloc(&s_heap, 100, 0);
+  void *b = heap_malloc(&s_heap, 100, 0);
+  void *c = heap_malloc(&s_heap, 100, 0);
+  void *guard = heap_malloc(&s_heap, 100, 0);
+
+  heap_free(&s_heap, a, 0);
+  heap_free(&s_heap, c, 0);
+  // Merges with both neighbours, which have to be taken off their free lists
+  heap_free(&s_heap, b, 0);
+
+  // The merged hole is the only one big enough that isn't at the end of the heap
+  void *merged = heap_malloc(&s_heap, 300, 0);
+  cl_assert((uint8_t *)merged >= (uint8_t *)a);
+  cl_assert((uint8_t *)merged < (uint8_t *)guard);
+
+  heap_free(&s_heap, merged, 0);
+  heap_free(&s_heap, guard, 0);
+  prv_check_totals();
+  cl_assert(s_heap.use_free_lists);
+}
+
+void test_heap_free_lists__enable_after_allocations(void) {
+  prv_init_heap(false /* use_free_lists */);
+  prv_churn(500);
+
+  heap_enable_free_lists(&s_heap);
+  prv_churn(2000);
+  prv_check_contents();
+  prv_check_totals();
+  cl_assert(s_heap.use_free_lists);
+}
+
+void test_heap_free_lists__write_after_free_is_detected(void) {
+  prv_init_heap(true /* use_free_lists */);
+  heap_set_corruption_handler(&s_heap, prv_corruption_handler);
+
+  uint32_t *a = heap_malloc(&s_heap, 32, 0);
+  void *guard1 = heap_malloc(&s_heap, 32, 0);
+  uint32_t *b = heap_malloc(&s_heap, 32, 0);
+  void *guard2 = heap_malloc(&s_heap, 32, 0);
+  heap_free(&s_heap, a, 0);
+  heap_free(&s_heap, b, 0);
+
+  // Scribble over the free list links of b
+  b[0] = 0x12345678;
+
+  // Reusing b notices the broken links
+  heap_malloc(&s_heap, 32, 0);
+  cl_assert(s_corrupt_block != NULL);
+
+  // The heap falls back to searching for free blocks and keeps working
+  cl_assert(!s_heap.use_free_lists);
+  void *c = heap_malloc(&s_heap, 32, 0);
+  cl_assert(c != NULL);
+  heap_free(&s_heap, c, 0);
+  heap_free(&s_heap, guard1, 0);
+  heap_free(&s_heap, guard2, 0);
+}
+
+void test_heap_free_lists__fragmentation(void) {
+  unsigned int max_free[2];
+  int failures[2];
+  for (int use_free_lists = 0; use_free_lists < 2; use_free_lists++) {
+    s_rand_state = 1;
+    // Small enough that the heap runs out of space regularly
+    prv_init_heap_with_size(use_free_lists, FRAGMENTATION_HEAP_SIZE_BYTES);
+    failures[use_free_lists] = prv_churn(20000);
+    prv_check_contents();
+    prv_check_totals();
+
+    unsigned int used, free;
+    heap_calc_totals(&s_heap, &used, &free, &max_free[use_free_lists]);
+    printf("\n%s: %d failed allocations, %u of %u free bytes in the largest block",
+           use_free_lists ? "free lists" : "first fit ", failures[use_free_lists],
+           max_free[use_free_lists], free);
+    prv_free_all();
+  }
+  printf("\n");
+
+  // Size-class fits shouldn't fragment the heap worse than first fit
+  cl_assert(failures[1] <= failures[0]);
+}
@@ -4,8 +4,11 @@
 #include "resource/resource_ids.auto.h"
 #include "resource/resource_storage.h"
 #include "resource/resource_storage_impl.h"
+#include "util/size.h"
 
+#include <inttypes.h>
 #include <limits.h>
+#include <stdio.h>
 
 #include "clar.h"
 #include "fixtures/load_test_resources.h"
@@ -429,3 +432,131 @@ void test_resource__overflow_data_section_length(void) {
   cl_assert_equal_i(prv_get_store_length(&entry, &manifest), 0);
 }
 
+
+// The icons and fonts a launcher render looks up, every glyph drawn reads from the font again
+static const uint32_t s_launcher_resources[] = {
+  RESOURCE_ID_GOTHIC_09,
+  RESOURCE_ID_GOTHIC_14,
+  RESOURCE_ID_GOTHIC_18_BOLD,
+  RESOURCE_ID_GOTHIC_24_BOLD,
+  RESOURCE_ID_MENU_ICON_TICTOC_WATCH,
+  RESOURCE_ID_MENU_ICON_KICKSTART_WATCH,
+  RESOURCE_ID_SETTINGS_ICON_BLUETOOTH,
+  RESOURCE_ID_SETTINGS_ICON_AIRPLANE,
+};
+#define LAUNCHER_READS_PER_RESOURCE 20
+
+//! @return the number of table of contents reads (cache misses) of the render
+static uint32_t prv_render_launcher(void) {
+  uint32_t hits_before, misses_before;
+  resource_get_entry_cache_stats(&hits_before, &misses_before);
+  for (unsigned int i = 0; i < ARRAY_LENGTH(s_launcher_resources); i++) {
+    const uint32_t resource_id = s_launcher_resources[i];
+    const size_t size = resource_size(SYSTEM_APP, resource_id);
+    cl_assert(size > 0);
+    for (int j = 0; j < LAUNCHER_READS_PER_RESOURCE; j++) {
+      uint8_t buffer[4];
+      cl_assert_equal_i(resource_load_byte_range_system(SYSTEM_APP, resource_id,
+                                                        (j * sizeof(buffer)) % size, buffer, 1), 1);
+    }
+  }
+  uint32_t hits, misses;
+  resource_get_entry_cache_stats(&hits, &misses);
+  return misses - misses_before;
+}
+
+void test_resource__entry_cache_launcher_render(void) {
+  resource_init();
+
+  const uint32_t num_lookups = ARRAY_LENGTH(s_launcher_resources) *
+                               (LAUNCHER_READS_PER_RESOURCE + 1);
+
+  uint32_t flash_reads = fake_flash_read_count();
+  const uint32_t first_misses = prv_render_launcher();
+  const uint32_t first_flash_reads = fake_flash_read_count() - flash_reads;
+
+  flash_reads = fake_flash_read_count();
+  const uint32_t second_misses = prv_render_launcher();
+  const uint32_t second_flash_reads = fake_flash_read_count() - flash_reads;
+
+  printf("\nLauncher render, %"PRIu32" resource lookups:\n", num_lookups);
+  printf("  first render: %"PRIu32" table of contents reads, %"PRIu32" flash reads\n",
+         first_misses, first_flash_reads);
+  printf("  next render: %"PRIu32" table of contents reads, %"PRIu32" flash reads\n",
+         second_misses, second_flash_reads);
+
+  // only the first lookup of every resource reads the table of contents
+  cl_assert_equal_i(first_misses, ARRAY_LENGTH(s_launcher_resources));
+  cl_assert_equal_i(second_misses, 0);
+  cl_assert(second_flash_reads < first_flash_reads);
+}
+
+void test_resource__entry_cache_bank_change(void) {
+  resource_init();
+
+  prv_render_launcher();
+  cl_assert_equal_i(prv_render_launcher(), 0);
+
+  // reloading the system bank drops all of its entries
+  load_resource_fixture_in_flash(RESOURCES_FIXTURE_PATH, SYSTEM_RESOURCES_FIXTURE_NAME,
+                                 false /* is_next */);
+  cl_assert_equal_i(prv_render_launcher(), ARRAY_LENGTH(s_launcher_resources));
+}
+
+void test_resource__entry_cache_keeps_cached_resources(void) {
+  resource_init();
+  cl_assert_equal_i(resource_get_and_cache(SYSTEM_APP, RESOURCE_ID_GOTHIC_14),
+                    RESOURCE_ID_GOTHIC_14);
+
+  // many more lookups than the entry cache holds don't evict it
+  for (uint32_t resource_id = 1; resource_id <= 100; resource_id++) {
+    resource_size(SYSTEM_APP, resource_id);
+  }
+  uint32_t hits, misses;
+  resource_get_entry_cache_stats(&hits, &misses);
+  cl_assert(resource_size(SYSTEM_APP, RESOURCE_ID_GOTHIC_14) > 0);
+  uint32_t hits_after, misses_after;
+  resource_get_entry_cache_stats(&hits_after, &misses_after);
+  cl_assert_equal_i(misses_after, misses);
+
+  // but it is read again from a new system bank
+  load_resource_fixture_in_flash(RESOURCES_FIXTURE_PATH, SYSTEM_RESOURCES_FIXTURE_NAME,
+                                 false /* is_next */);
+  cl_assert(resource_size(SYSTEM_APP, RESOURCE_ID_GOTHIC_14) > 0);
+  resource_get_entry_cache_stats(&hits, &misses);
+  cl_assert_equal_i(misses, misses_after);
+}
+
+void test_resource__entry_cache_file_update(void) {
+  // watches the resource files for changes
+  resource_init();
+
+  load_resource_fixture_on_pfs(RESOURCES_FIXTURE_PATH, PUG_FIXTURE_NAME, "pug");
+  cl_assert_equal_i(resource_size(SYSTEM_APP, RESOURCE_ID_PUG), sizeof(pug));
+  cl_assert_equal_i(resource_size(SYSTEM_APP, RESOURCE_ID_PUG), sizeof(pug));
+
+  // the first resource of the app pack takes the place of the pug
+  pfs_remove("pug");
+  load_resource_fixture_on_pfs(RESOURCES_FIXTURE_PATH, APP_RESOURCES_FIXTURE_NAME, "pug");
+  cl_assert_equal_i(resource_size(SYSTEM_APP, RESOURCE_ID_PUG), sizeof(no_litter));
+}
+
+void test_resource__entry_cache_app_bank(void) {
+  char filename[32];
+  resource_storage_get_file_name(filename, sizeof(filename), resource_bank);
+  load_resource_fixture_on_pfs(RESOURCES_FIXTURE_PATH, APP_RESOURCES_FIXTURE_NAME, filename);
+  cl_assert(resource_init_app(resource_bank, NULL));
+
+  uint32_t hits, misses;
+  resource_get_entry_cache_stats(&hits, &misses);
+  cl_assert_equal_i(resource_size(resource_bank, no_litter_res_id), sizeof(no_litter));
+  cl_assert_equal_i(resource_size(resource_bank, no_litter_res_id), sizeof(no_litter));
+  uint32_t hits_after, misses_after;
+  resource_get_entry_cache_stats(&hits_after, &misses_after);
+  cl_assert_equal_i(hits_after - hits, 1);
+  cl_assert_equal_i(misses_after - misses, 1);
+
+  // removing the app removes its resources
+  resource_storage_clear(resource_bank);
+  cl_assert_equal_i(resource_size(resource_bank, no_litter_res_id), 0);
+}
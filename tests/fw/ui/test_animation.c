@@ -3738,3 +3738,91 @@ void test_animation__current_interpolate_override(void) {
 
   animation_destroy(a);
 }
+
+// --------------------------------------------------------------------------------------
+// Many animations created and destroyed in a mixed order must all still be found by handle. The
+// animations kept alive have handles much further apart than the size of the handle table, so
+// they collide in it, and destroying them leaves holes in the middle of probe sequences.
+#define MANY_NUM_ANIMATIONS 400
+#define MANY_KEEP_EVERY 16
+
+static void prv_check_many_animations(Animation **animations, const bool *destroyed) {
+  for (int i = 0; i < MANY_NUM_ANIMATIONS; i++) {
+    AnimationPrivate *animation = animation_private_animation_find(animations[i]);
+    if (destroyed[i]) {
+      cl_assert_equal_p(animation, NULL);
+    } else {
+      cl_assert(animation);
+      cl_assert_equal_p(animation->handle, animations[i]);
+    }
+  }
+}
+
+static void prv_many_update(Animation *animation, const AnimationProgress progress) {
+}
+
+static const AnimationImplementation s_many_implementation = {
+  .update = prv_many_update,
+};
+
+void test_animation__find_many_animations(void) {
+  Animation *animations[MANY_NUM_ANIMATIONS];
+  bool destroyed[MANY_NUM_ANIMATIONS] = {};
+  for (int i = 0; i < MANY_NUM_ANIMATIONS; i++) {
+    animations[i] = animation_create();
+    cl_assert(animations[i]);
+    animation_set_implementation(animations[i], &s_many_implementation);
+    animation_set_duration(animations[i], 1000);
+    if (i % MANY_KEEP_EVERY) {
+      animation_destroy(animations[i]);
+      destroyed[i] = true;
+    } else if (i % 2) {
+      cl_assert(animation_schedule(animations[i]));
+    }
+  }
+  prv_check_many_animations(animations, destroyed);
+
+  // Destroy every third of the remaining ones, then the rest in reverse order
+  for (int i = 0; i < MANY_NUM_ANIMATIONS; i += 3 * MANY_KEEP_EVERY) {
+    animation_destroy(animations[i]);
+    destroyed[i] = true;
+  }
+  prv_check_many_animations(animations, destroyed);
+  for (int i = MANY_NUM_ANIMATIONS - 1; i >= 0; i--) {
+    if (!destroyed[i]) {
+      animation_destroy(animations[i]);
+      destroyed[i] = true;
+      prv_check_many_animations(animations, destroyed);
+    }
+  }
+}
+
+void test_animation__find_without_handle_table(void) {
+  Animation *a = animation_create();
+  Animation *b = animation_create();
+  cl_assert(a && b);
+  animation_set_implementation(b, &s_many_implementation);
+  cl_assert(animation_schedule(b));
+
+  // Drop the handle table, as if it couldn't be allocated. Lookups have to walk the lists instead
+  AnimationAuxState *aux = kernel_applib_get_animation_state()->aux;
+  free(aux->handle_table);
+  aux->handle_table = NULL;
+  aux->handle_table_size = 0;
+  aux->handle_table_count = 0;
+  cl_assert_equal_p(animation_private_animation_find(a)->handle, a);
+  cl_assert_equal_p(animation_private_animation_find(b)->handle, b);
+
+  // The next animation created rebuilds the table from the lists
+  Animation *c = animation_create();
+  cl_assert(aux->handle_table);
+  cl_assert_equal_i(aux->handle_table_count, 3);
+  cl_assert_equal_p(animation_private_animation_find(a)->handle, a);
+  cl_assert_equal_p(animation_private_animation_find(b)->handle, b);
+  cl_assert_equal_p(animation_private_animation_find(c)->handle, c);
+
+  animation_destroy(a);
+  animation_destroy(b);
+  animation_destroy(c);
+  cl_assert_equal_i(aux->handle_table_count, 0);
+}
@@ -418,3 +418,171 @@ void test_layer__find_layer_contains_point_override_layer_contains_point(void) {
   // outside the bounds of child a, so child b is not found
   cl_assert_equal_p(layer_find_layer_containing_point(&parent, &GPoint(15, 15)), &parent);
 }
+
+typedef struct {
+  const Layer *layer;
+  GRect clip_box;
+  GRect drawing_box;
+} RenderRecord;
+
+static RenderRecord s_render_records[16];
+static int s_num_render_records;
+
+static void prv_recording_update_proc(Layer *layer, GContext *ctx) {
+  cl_assert(s_num_render_records < ARRAY_LENGTH(s_render_records));
+  s_render_records[s_num_render_records++] = (RenderRecord) {
+    .layer = layer,
+    .clip_box = ctx->draw_state.clip_box,
+    .drawing_box = ctx->draw_state.drawing_box,
+  };
+}
+
+static GContext prv_render_context(void) {
+  s_num_render_records = 0;
+  return (GContext) {
+    .draw_state = {
+      .clip_box = GRect(0, 0, 144, 168),
+      .drawing_box = GRect(0, 0, 144, 168),
+    },
+  };
+}
+
+static void prv_init_render_layer(Layer *layer, GRect frame) {
+  layer_init(layer, &frame);
+  layer_set_update_proc(layer, prv_recording_update_proc);
+}
+
+void test_layer__render_tree_draw_state(void) {
+  Layer root, a, b, a_child, a_grandchild;
+  prv_init_render_layer(&root, GRect(0, 0, 144, 168));
+  prv_init_render_layer(&a, GRect(10, 20, 50, 50));
+  prv_init_render_layer(&b, GRect(70, 20, 50, 50));
+  prv_init_render_layer(&a_child, GRect(5, 5, 100, 10));
+  prv_init_render_layer(&a_grandchild, GRect(-2, 0, 8, 8));
+  layer_set_bounds(&a, &GRect(3, 4, 50, 50));
+  layer_set_clips(&a_child, false);
+  layer_add_child(&root, &a);
+  layer_add_child(&root, &b);
+  layer_add_child(&a, &a_child);
+  layer_add_child(&a_child, &a_grandchild);
+
+  GContext ctx = prv_render_context();
+  layer_render_tree(&root, &ctx);
+
+  cl_assert_equal_i(s_num_render_records, 5);
+  cl_assert_equal_p(s_render_records[0].layer, &root);
+  cl_assert_equal_p(s_render_records[1].layer, &a);
+  cl_assert(grect_equal(&s_render_records[1].clip_box, &GRect(10, 20, 50, 50)));
+  cl_assert(grect_equal(&s_render_records[1].drawing_box, &GRect(13, 24, 50, 50)));
+  // Doesn't clip to its own frame, only to its parent's
+  cl_assert_equal_p(s_render_records[2].layer, &a_child);
+  cl_assert(grect_equal(&s_render_records[2].clip_box, &GRect(10, 20, 50, 50)));
+  cl_assert(grect_equal(&s_render_records[2].drawing_box, &GRect(18, 29, 100, 10)));
+  cl_assert_equal_p(s_render_records[3].layer, &a_grandchild);
+  cl_assert(grect_equal(&s_render_records[3].clip_box, &GRect(16, 29, 8, 8)));
+  cl_assert(grect_equal(&s_render_records[3].drawing_box, &GRect(16, 29, 8, 8)));
+  // Sibling of a layer deeper in the tree starts from its parent's draw state again
+  cl_assert_equal_p(s_render_records[4].layer, &b);
+  cl_assert(grect_equal(&s_render_records[4].clip_box, &GRect(70, 20, 50, 50)));
+  cl_assert(grect_equal(&s_render_records[4].drawing_box, &GRect(70, 20, 50, 50)));
+
+  // The draw state is restored after rendering
+  cl_assert(grect_equal(&ctx.draw_state.clip_box, &GRect(0, 0, 144, 168)));
+}
+
+void test_layer__render_tree_dirty_region(void) {
+  Layer root, a, b, c, b_child;
+  prv_init_render_layer(&root, GRect(0, 0, 144, 168));
+  prv_init_render_layer(&a, GRect(0, 0, 144, 40));
+  prv_init_render_layer(&b, GRect(0, 50, 144, 40));
+  prv_init_render_layer(&c, GRect(0, 100, 144, 40));
+  prv_init_render_layer(&b_child, GRect(10, 10, 20, 20));
+  layer_add_child(&root, &a);
+  layer_add_child(&root, &b);
+  layer_add_child(&root, &c);
+  layer_add_child(&b, &b_child);
+
+  // A full render clears all dirty flags
+  GContext ctx = prv_render_context();
+  layer_render_tree(&root, &ctx);
+  cl_assert_equal_i(s_num_render_records, 5);
+
+  // Nothing is dirty, nothing is rendered
+  ctx = prv_render_context();
+  layer_render_tree_dirty_region(&root, &ctx);
+  cl_assert_equal_i(s_num_render_records, 0);
+
+  // Only the layers overlapping the dirty layer are rendered, clipped to it
+  layer_mark_dirty(&b_child);
+  ctx = prv_render_context();
+  layer_render_tree_dirty_region(&root, &ctx);
+  cl_assert_equal_i(s_num_render_records, 3);
+  cl_assert_equal_p(s_render_records[0].layer, &root);
+  cl_assert(grect_equal(&s_render_records[0].clip_box, &GRect(10, 60, 20, 20)));
+  cl_assert(grect_equal(&s_render_records[0].drawing_box, &GRect(0, 0, 144, 168)));
+  cl_assert_equal_p(s_render_records[1].layer, &b);
+  cl_assert(grect_equal(&s_render_records[1].clip_box, &GRect(10, 60, 20, 20)));
+  cl_assert_equal_p(s_render_records[2].layer, &b_child);
+  cl_assert(grect_equal(&s_render_records[2].clip_box, &GRect(10, 60, 20, 20)));
+
+  // Dirty flags are consumed by the render
+  ctx = prv_render_context();
+  layer_render_tree_dirty_region(&root, &ctx);
+  cl_assert_equal_i(s_num_render_records, 0);
+
+  // Several dirty layers are combined into their bounding box
+  layer_mark_dirty(&a);
+  layer_mark_dirty(&b_child);
+  ctx = prv_render_context();
+  layer_render_tree_dirty_region(&root, &ctx);
+  cl_assert_equal_i(s_num_render_records, 4);
+  cl_assert(grect_equal(&s_render_records[0].clip_box, &GRect(0, 0, 144, 80)));
+  cl_assert_equal_p(s_render_records[1].layer, &a);
+  cl_assert_equal_p(s_render_records[2].layer, &b);
+  cl_assert_equal_p(s_render_records[3].layer, &b_child);
+}
+
+void test_layer__render_tree_dirty_region_tree_changes(void) {
+  Layer root, a, b, b_child;
+  prv_init_render_layer(&root, GRect(0, 0, 144, 168));
+  prv_init_render_layer(&a, GRect(0, 0, 144, 40));
+  prv_init_render_layer(&b, GRect(0, 50, 144, 40));
+  prv_init_render_layer(&b_child, GRect(10, 10, 20, 20));
+  layer_add_child(&root, &a);
+  layer_add_child(&root, &b);
+  layer_add_child(&b, &b_child);
+  GContext ctx = prv_render_context();
+  layer_render_tree(&root, &ctx);
+
+  // Moving a layer redraws the area it moved away from, which is covered by its parent
+  layer_set_frame(&b_child, &GRect(50, 10, 20, 20));
+  ctx = prv_render_context();
+  layer_render_tree_dirty_region(&root, &ctx);
+  cl_assert_equal_i(s_num_render_records, 3);
+  cl_assert(grect_equal(&s_render_records[0].clip_box, &GRect(0, 50, 144, 40)));
+
+  // Hiding a layer redraws its parent
+  layer_set_hidden(&b_child, true);
+  ctx = prv_render_context();
+  layer_render_tree_dirty_region(&root, &ctx);
+  cl_assert_equal_i(s_num_render_records, 2);
+  cl_assert_equal_p(s_render_records[1].layer, &b);
+  layer_set_hidden(&b_child, false);
+
+  // Removing a layer redraws its old parent
+  layer_render_tree(&root, &ctx);
+  layer_remove_from_parent(&a);
+  ctx = prv_render_context();
+  layer_render_tree_dirty_region(&root, &ctx);
+  cl_assert_equal_i(s_num_render_records, 3);
+  cl_assert(grect_equal(&s_render_records[0].clip_box, &GRect(0, 0, 144, 168)));
+
+  // A dirty layer that doesn't clip marks the closest ancestor that does
+  layer_set_clips(&b_child, false);
+  layer_render_tree(&root, &ctx);
+  layer_mark_dirty(&b_child);
+  ctx = prv_render_context();
+  layer_render_tree_dirty_region(&root, &ctx);
+  cl_assert_equal_i(s_num_render_records, 3);
+  cl_assert(grect_equal(&s_render_records[0].clip_box, &GRect(0, 50, 144, 40)));
+}
@@ -6,6 +6,7 @@
 
 #include "applib/ui/menu_layer.h"
 #include "applib/ui/content_indicator_private.h"
+#include "util/size.h"
 
 // Stubs
 /////////////////////
@@ -447,3 +448,223 @@ void test_menu_layer__center_focused_updates_height_on_reload(void) {
   cl_assert_equal_i(s_num_rows - 1, l.selection.index.row);
   cl_assert_equal_i(focused_height, l.selection.h);
 }
+
+// Geometry index
+//////////////////////
+
+#define GEOMETRY_NUM_SECTIONS 51
+#define GEOMETRY_EMPTY_SECTION 25
+#define GEOMETRY_NUM_ROWS_PER_SECTION 100
+#define GEOMETRY_MAX_DRAWN_ROWS 64
+
+typedef struct GeometryMenu {
+  int16_t height_offset;
+  uint32_t num_geometry_calls;
+  int num_drawn_rows;
+  MenuIndex drawn_index[GEOMETRY_MAX_DRAWN_ROWS];
+  int16_t drawn_y[GEOMETRY_MAX_DRAWN_ROWS];
+} GeometryMenu;
+
+static uint16_t prv_geometry_get_num_sections(struct MenuLayer *menu_layer,
+                                              void *callback_context) {
+  return GEOMETRY_NUM_SECTIONS;
+}
+
+static uint16_t prv_geometry_get_num_rows(struct MenuLayer *menu_layer, uint16_t section_index,
+                                          void *callback_context) {
+  return (section_index == GEOMETRY_EMPTY_SECTION) ? 0 : GEOMETRY_NUM_ROWS_PER_SECTION;
+}
+
+static int16_t prv_geometry_get_cell_height(struct MenuLayer *menu_layer, MenuIndex *cell_index,
+                                            void *callback_context) {
+  GeometryMenu *menu = callback_context;
+  menu->num_geometry_calls++;
+  return 2 + (cell_index->section + cell_index->row) % 3 + menu->height_offset;
+}
+
+static int16_t prv_geometry_get_header_height(struct MenuLayer *menu_layer,
+                                              uint16_t section_index, void *callback_context) {
+  GeometryMenu *menu = callback_context;
+  menu->num_geometry_calls++;
+  return (section_index % 4 == 0) ? 0 : 3;
+}
+
+static int16_t prv_geometry_get_separator_height(struct MenuLayer *menu_layer,
+                                                 MenuIndex *cell_index, void *callback_context) {
+  GeometryMenu *menu = callback_context;
+  menu->num_geometry_calls++;
+  return 1;
+}
+
+static void prv_geometry_draw_row(GContext* ctx, const Layer *cell_layer, MenuIndex *cell_index,
+                                  void *callback_context) {
+  GeometryMenu *menu = callback_context;
+  cl_assert(menu->num_drawn_rows < GEOMETRY_MAX_DRAWN_ROWS);
+  menu->drawn_index[menu->num_drawn_rows] = *cell_index;
+  menu->drawn_y[menu->num_drawn_rows] = cell_layer->frame.origin.y;
+  menu->num_drawn_rows++;
+}
+
+static void prv_geometry_draw_header(GContext* ctx, const Layer *cell_layer,
+                                     uint16_t section_index, void *callback_context) {}
+
+static void prv_geometry_menu_init(MenuLayer *l, GeometryMenu *menu, bool center_focused,
+                                   bool indexed) {
+  *menu = (GeometryMenu) {};
+  menu_layer_init(l, &GRect(0, 0, DISP_COLS, DISP_ROWS));
+  menu_layer_set_center_focused(l, center_focused);
+  menu_layer_set_geometry_index_enabled(l, indexed);
+  menu_layer_set_callbacks(l, menu, &(MenuLayerCallbacks) {
+    .get_num_sections = prv_geometry_get_num_sections,
+    .get_num_rows = prv_geometry_get_num_rows,
+    .get_cell_height = prv_geometry_get_cell_height,
+    .get_header_height = prv_geometry_get_header_height,
+    .get_separator_height = prv_geometry_get_separator_height,
+    .draw_row = prv_geometry_draw_row,
+    .draw_header = prv_geometry_draw_header,
+  });
+}
+
+static void prv_geometry_render(MenuLayer *l, GeometryMenu *menu) {
+  GContext ctx = {};
+  menu->num_drawn_rows = 0;
+  l->scroll_layer.content_sublayer.update_proc(&l->scroll_layer.content_sublayer, &ctx);
+}
+
+static void prv_assert_same_geometry(MenuLayer *walked, MenuLayer *indexed) {
+  cl_assert_equal_i(walked->selection.index.section, indexed->selection.index.section);
+  cl_assert_equal_i(walked->selection.index.row, indexed->selection.index.row);
+  cl_assert_equal_i(walked->selection.y, indexed->selection.y);
+  cl_assert_equal_i(walked->selection.h, indexed->selection.h);
+  cl_assert_equal_i(walked->selection.sep, indexed->selection.sep);
+  cl_assert_equal_i(scroll_layer_get_content_size(&walked->scroll_layer).h,
+                    scroll_layer_get_content_size(&indexed->scroll_layer).h);
+  cl_assert_equal_i(scroll_layer_get_content_offset(&walked->scroll_layer).y,
+                    scroll_layer_get_content_offset(&indexed->scroll_layer).y);
+}
+
+static void prv_assert_same_rows_drawn(GeometryMenu *walked, GeometryMenu *indexed) {
+  cl_assert(walked->num_drawn_rows > 0);
+  cl_assert_equal_i(walked->num_drawn_rows, indexed->num_drawn_rows);
+  for (int i = 0; i < walked->num_drawn_rows; i++) {
+    // the rows are drawn in walking order, which depends on the cached cursor
+    bool found = false;
+    for (int j = 0; j < indexed->num_drawn_rows; j++) {
+      if (menu_index_compare(&walked->drawn_index[i], &indexed->drawn_index[j]) == 0) {
+        cl_assert_equal_i(walked->drawn_y[i], indexed->drawn_y[j]);
+        found = true;
+      }
+    }
+    cl_assert(found);
+  }
+}
+
+static uint32_t s_geometry_seed;
+
+static MenuIndex prv_geometry_random_index(void) {
+  s_geometry_seed = s_geometry_seed * 1103515245 + 12345;
+  uint16_t section = (s_geometry_seed >> 8) % GEOMETRY_NUM_SECTIONS;
+  if (section == GEOMETRY_EMPTY_SECTION) {
+    section++;
+  }
+  return MenuIndex(section, (s_geometry_seed >> 20) % GEOMETRY_NUM_ROWS_PER_SECTION);
+}
+
+void test_menu_layer__geometry_index_matches_walk(void) {
+  const MenuRowAlign aligns[] = {
+    MenuRowAlignNone, MenuRowAlignCenter, MenuRowAlignTop, MenuRowAlignBottom,
+  };
+  for (int center_focused = 0; center_focused <= 1; center_focused++) {
+    MenuLayer walked;
+    MenuLayer indexed;
+    GeometryMenu walked_menu;
+    GeometryMenu indexed_menu;
+    prv_geometry_menu_init(&walked, &walked_menu, center_focused, false);
+    prv_geometry_menu_init(&indexed, &indexed_menu, center_focused, true);
+    cl_assert(walked.geometry_index == NULL);
+    cl_assert(indexed.geometry_index != NULL);
+    prv_assert_same_geometry(&walked, &indexed);
+
+    s_geometry_seed = 1;
+    for (int i = 0; i < 200; i++) {
+      MenuIndex index = prv_geometry_random_index();
+      if (i % 4 == 3) {
+        // the first row of a section gets its separator from the header or the section above
+        index.row = 0;
+      }
+      const MenuRowAlign align = aligns[i % ARRAY_LENGTH(aligns)];
+      menu_layer_set_selected_index(&walked, index, align, false);
+      menu_layer_set_selected_index(&indexed, index, align, false);
+      prv_assert_same_geometry(&walked, &indexed);
+
+      if (i % 10 == 0) {
+        const bool up = (i % 20 == 0);
+        menu_layer_set_selected_next(&walked, up, align, false);
+        menu_layer_set_selected_next(&indexed, up, align, false);
+        prv_assert_same_geometry(&walked, &indexed);
+
+        prv_geometry_render(&walked, &walked_menu);
+        prv_geometry_render(&indexed, &indexed_menu);
+        prv_assert_same_rows_drawn(&walked_menu, &indexed_menu);
+      }
+
+      if (!center_focused && i % 10 == 5) {
+        // scroll far away from the selection, as if paging through the menu
+        const GPoint offset = GPoint(0, -(int16_t)((s_geometry_seed >> 4) % 20000));
+        scroll_layer_set_content_offset(&walked.scroll_layer, offset, false);
+        scroll_layer_set_content_offset(&indexed.scroll_layer, offset, false);
+        prv_geometry_render(&walked, &walked_menu);
+        prv_geometry_render(&indexed, &indexed_menu);
+        prv_assert_same_rows_drawn(&walked_menu, &indexed_menu);
+      }
+    }
+
+    // reloading picks up the new row heights
+    walked_menu.height_offset = indexed_menu.height_offset = 1;
+    menu_layer_reload_data(&walked);
+    menu_layer_reload_data(&indexed);
+    prv_assert_same_geometry(&walked, &indexed);
+    menu_layer_set_selected_index(&walked, MenuIndex(40, 50), MenuRowAlignCenter, false);
+    menu_layer_set_selected_index(&indexed, MenuIndex(40, 50), MenuRowAlignCenter, false);
+    prv_assert_same_geometry(&walked, &indexed);
+
+    menu_layer_set_geometry_index_enabled(&indexed, false);
+    cl_assert(indexed.geometry_index == NULL);
+
+    menu_layer_deinit(&walked);
+    menu_layer_deinit(&indexed);
+  }
+}
+
+void test_menu_layer__geometry_index_5000_rows_callbacks(void) {
+  const int num_jumps = 500;
+  uint32_t jump_calls[2];
+  uint32_t scroll_calls[2];
+  for (int indexed = 0; indexed <= 1; indexed++) {
+    MenuLayer l;
+    GeometryMenu menu;
+    prv_geometry_menu_init(&l, &menu, false, indexed);
+
+    s_geometry_seed = 2;
+    menu.num_geometry_calls = 0;
+    for (int i = 0; i < num_jumps; i++) {
+      menu_layer_set_selected_index(&l, prv_geometry_random_index(), MenuRowAlignCenter, false);
+    }
+    jump_calls[indexed] = menu.num_geometry_calls;
+
+    menu.num_geometry_calls = 0;
+    for (int i = 0; i < num_jumps; i++) {
+      const GPoint offset = GPoint(0, -(int16_t)((i * 7919) % 20000));
+      scroll_layer_set_content_offset(&l.scroll_layer, offset, false);
+      prv_geometry_render(&l, &menu);
+    }
+    scroll_calls[indexed] = menu.num_geometry_calls;
+
+    menu_layer_deinit(&l);
+  }
+
+  // a jump costs a few callbacks for the selected row instead of one per row in between
+  cl_assert(jump_calls[1] <= 8 * num_jumps);
+  cl_assert(jump_calls[1] * 50 < jump_calls[0]);
+  cl_assert(scroll_calls[1] * 10 < scroll_calls[0]);
+}
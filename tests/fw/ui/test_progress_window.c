@@ -0,0 +1,129 @@
+/* SPDX-FileCopyrightText: 2024 Google LLC */
+/* SPDX-License-Identifier: Apache-2.0 */
+
+#include "applib/ui/progress_window.h"
+#include "applib/ui/window_private.h"
+
+#include "clar.h"
+
+// Stubs
+////////////////////////////////////
+
+#include "stubs_app_install_manager.h"
+#include "stubs_app_state.h"
+#include "stubs_app_window_stack.h"
+#include "stubs_click.h"
+#include "stubs_compositor_transitions.h"
+#include "stubs_evented_timer.h"
+#include "stubs_fonts.h"
+#include "stubs_graphics_context.h"
+#include "stubs_heap.h"
+#include "stubs_logging.h"
+#include "stubs_passert.h"
+#include "stubs_pbl_malloc.h"
+#include "stubs_pebble_tasks.h"
+#include "stubs_peek_layer.h"
+#include "stubs_process_manager.h"
+#include "stubs_property_animation.h"
+#include "stubs_resources.h"
+#include "stubs_status_bar_layer.h"
+#include "stubs_syscalls.h"
+#include "stubs_unobstructed_area.h"
+#include "stubs_window_manager.h"
+#include "stubs_window_stack.h"
+
+// Overrides
+////////////////////////////////////
+
+#define MAX_FILLS 8
+
+static GRect s_fill_clip_boxes[MAX_FILLS];
+static int s_num_fills;
+
+//! Only the window background uses graphics_fill_rect, so each call records the area a render of
+//! the window covered.
+void graphics_fill_rect(GContext *ctx, const GRect *rect) {
+  cl_assert(s_num_fills < MAX_FILLS);
+  s_fill_clip_boxes[s_num_fills++] = ctx->draw_state.clip_box;
+}
+
+void graphics_fill_round_rect(GContext *ctx, const GRect *rect, uint16_t radius,
+                              GCornerMask corner_mask) {}
+
+void graphics_draw_round_rect(GContext *ctx, const GRect *rect, uint16_t radius) {}
+
+GDrawState graphics_context_get_drawing_state(GContext *ctx) {
+  return ctx->draw_state;
+}
+
+void graphics_context_set_drawing_state(GContext *ctx, GDrawState draw_state) {
+  ctx->draw_state = draw_state;
+}
+
+bool graphics_release_frame_buffer(GContext *ctx, GBitmap *buffer) {
+  return false;
+}
+
+bool layer_is_status_bar_layer(Layer *layer) {
+  return false;
+}
+
+static GContext prv_render_context(void) {
+  s_num_fills = 0;
+  return (GContext) {
+    .draw_state = {
+      .clip_box = GRect(0, 0, DISP_COLS, DISP_ROWS),
+      .drawing_box = GRect(0, 0, DISP_COLS, DISP_ROWS),
+    },
+  };
+}
+
+// Setup
+////////////////////////////////////
+
+static ProgressWindow s_progress_window;
+
+void test_progress_window__initialize(void) {
+  s_progress_window = (ProgressWindow) {};
+  progress_window_init(&s_progress_window);
+  window_set_on_screen(&s_progress_window.window, true, true);
+}
+
+void test_progress_window__cleanup(void) {
+  progress_window_deinit(&s_progress_window);
+}
+
+// Tests
+////////////////////////////////////
+
+void test_progress_window__progress_redraws_only_the_bar(void) {
+  Window *window = &s_progress_window.window;
+  const GRect screen = GRect(0, 0, DISP_COLS, DISP_ROWS);
+  const GRect bar = s_progress_window.progress_layer.layer.frame;
+  cl_assert(!grect_equal(&bar, &screen));
+
+  // The first render covers the whole window
+  GContext ctx = prv_render_context();
+  window_render(window, &ctx);
+  cl_assert_equal_i(s_num_fills, 1);
+  cl_assert(grect_equal(&s_fill_clip_boxes[0], &screen));
+
+  // Progress updates only redraw the progress bar
+  progress_window_set_progress(&s_progress_window, 50);
+  ctx = prv_render_context();
+  window_render(window, &ctx);
+  cl_assert_equal_i(s_num_fills, 1);
+  cl_assert(grect_equal(&s_fill_clip_boxes[0], &bar));
+
+  // Nothing changed, nothing is redrawn
+  ctx = prv_render_context();
+  window_render(window, &ctx);
+  cl_assert_equal_i(s_num_fills, 0);
+
+  // An invalidated window is redrawn in full again
+  window_invalidate(window);
+  ctx = prv_render_context();
+  window_render(window, &ctx);
+  cl_assert_equal_i(s_num_fills, 1);
+  cl_assert(grect_equal(&s_fill_clip_boxes[0], &screen));
+}
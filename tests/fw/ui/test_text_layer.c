@@ -36,6 +36,14 @@ void graphics_text_layout_cache_init(GTextLayoutCacheRef *layout_cache) {
 }
 
 void graphics_text_layout_cache_deinit(GTextLayoutCacheRef *layout_cache) {}
+void graphics_text_layout_cache_init_with_line_cache(GTextLayoutCacheRef *layout_cache) {
+  *layout_cache = MOCKED_CREATED_LAYOUT;
+}
+
+void graphics_text_layout_cache_deinit_with_line_cache(GTextLayoutCacheRef *layout_cache) {}
+TextLayoutLineCache *graphics_text_layout_get_line_cache(GTextLayoutCacheRef layout_cache) {
+  return NULL;
+}
 void graphics_text_layout_set_line_spacing_delta(GTextLayoutCacheRef layout, int16_t delta) {}
 
 int16_t graphics_text_layout_get_line_spacing_delta(const GTextLayoutCacheRef layout) {
@@ -110,3 +110,82 @@ void test_lru_cache__use_and_evict(void) {
   }
 }
 
+
+void test_lru_cache__hit_miss_counters(void) {
+  uint32_t input = 0xdeadbeef;
+  lru_cache_put(&s_cache, 1, &input);
+  lru_cache_get(&s_cache, 1);
+  lru_cache_get(&s_cache, 1);
+  lru_cache_get(&s_cache, 2);
+  cl_assert_equal_i(s_cache.hits, 2);
+  cl_assert_equal_i(s_cache.misses, 1);
+
+  // Flushing drops the items but not the counters
+  lru_cache_flush(&s_cache);
+  lru_cache_get(&s_cache, 1);
+  cl_assert_equal_i(s_cache.hits, 2);
+  cl_assert_equal_i(s_cache.misses, 2);
+}
+
+void test_lru_cache__buffer_too_small(void) {
+  LRUCache cache;
+  uint8_t buffer[sizeof(CacheEntry)];
+  lru_cache_init(&cache, sizeof(uint32_t), buffer, sizeof(buffer));
+  uint32_t input = 0xdeadbeef;
+  lru_cache_put(&cache, 1, &input);
+  cl_assert(lru_cache_get(&cache, 1) == NULL);
+}
+
+#define MODEL_MAX_ITEMS 100
+
+//! Checks the cache against a straightforward LRU list with random keys that collide a lot
+void test_lru_cache__matches_model(void) {
+  static uint8_t buffer[MODEL_MAX_ITEMS * (sizeof(CacheEntry) + sizeof(uint32_t))];
+  LRUCache cache;
+  lru_cache_init(&cache, sizeof(uint32_t), buffer, sizeof(buffer));
+  cl_assert_equal_i(cache.max_items, MODEL_MAX_ITEMS);
+
+  // model[0] is the least recently used key
+  uint32_t model[MODEL_MAX_ITEMS];
+  int num_model = 0;
+  uint32_t rand_state = 1;
+  for (int i = 0; i < 20000; i++) {
+    rand_state = rand_state * 1103515245 + 12345;
+    const uint32_t key = (rand_state >> 16) % (MODEL_MAX_ITEMS * 2);
+    const bool is_put = (rand_state >> 8) & 1;
+
+    int found = -1;
+    for (int j = 0; j < num_model; j++) {
+      if (model[j] == key) {
+        found = j;
+        break;
+      }
+    }
+
+    if (is_put) {
+      const uint32_t value = key * 3;
+      lru_cache_put(&cache, key, (void *)&value);
+      if (found < 0 && num_model == MODEL_MAX_ITEMS) {
+        found = 0;
+      }
+    } else {
+      uint32_t *output = lru_cache_get(&cache, key);
+      cl_assert_equal_b(output != NULL, found >= 0);
+      if (found < 0) {
+        continue;
+      }
+      cl_assert_equal_i(*output, key * 3);
+    }
+
+    // Move the key to the most recently used end of the model
+    if (found >= 0) {
+      memmove(&model[found], &model[found + 1], (num_model - found - 1) * sizeof(uint32_t));
+      num_model--;
+    }
+    model[num_model++] = key;
+  }
+
+  for (int j = 0; j < num_model; j++) {
+    cl_assert(lru_cache_get(&cache, model[j]));
+  }
+}
@@ -71,3 +71,30 @@ void test_crc32__null_residue(void) {
   crc = crc32(crc, data, 4);
   assert_equal_hex(crc, CRC32_RESIDUE);
 }
+
+void test_crc32__slice_by_4_matches_nibble_reference(void) {
+  uint8_t data[1024 + 3];
+  uint32_t seed = 1;
+  for (size_t i = 0; i < sizeof(data); i++) {
+    seed = seed * 1103515245 + 12345;
+    data[i] = seed >> 16;
+  }
+
+  // Cover every alignment of the start and end of the buffer, including lengths shorter than a
+  // word, as well as chaining from a non-initial CRC.
+  for (size_t offset = 0; offset < 4; offset++) {
+    for (size_t length = 0; length <= 64; length++) {
+      assert_equal_hex(crc32_slice_by_4(CRC32_INIT, &data[offset], length),
+                       crc32_nibble(CRC32_INIT, &data[offset], length));
+      assert_equal_hex(crc32_slice_by_4(0xdeadbeef, &data[offset], length),
+                       crc32_nibble(0xdeadbeef, &data[offset], length));
+    }
+    assert_equal_hex(crc32_slice_by_4(CRC32_INIT, &data[offset], 1024),
+                     crc32_nibble(CRC32_INIT, &data[offset], 1024));
+  }
+
+  assert_equal_hex(crc32_slice_by_4(CRC32_INIT, "123456789", 9), 0xCBF43926);
+  assert_equal_hex(crc32_slice_by_4(CRC32_INIT, NULL, 0), 0);
+  assert_equal_hex(crc32(CRC32_INIT, data, sizeof(data)),
+                   crc32_nibble(CRC32_INIT, data, sizeof(data)));
+}
@@ -102,3 +102,36 @@ void test_sort__sort_structs(void) {
   };
   cl_assert_equal_m(array, sorted, sizeof(array));
 }
+
+void test_sort__heap_int32_array(void) {
+  int32_t array[] = {-9, 1, 8, 2, 7, 3, -6, 4, 6, 5, 5};
+
+  sort_heap(array, ARRAY_LENGTH(array), sizeof(int32_t), prv_int32_cmp);
+
+  int32_t sorted[] = {-9, -6, 1, 2, 3, 4, 5, 5, 6, 7, 8};
+  cl_assert_equal_m(array, sorted, sizeof(array));
+}
+
+void test_sort__heap_empty_and_single_element_array(void) {
+  int32_t array[] = {1};
+
+  sort_heap(array, 0, sizeof(int32_t), prv_int32_cmp);
+  sort_heap(array, ARRAY_LENGTH(array), sizeof(int32_t), prv_int32_cmp);
+
+  int32_t sorted[] = {1};
+  cl_assert_equal_m(array, sorted, sizeof(array));
+}
+
+void test_sort__heap_matches_bubble(void) {
+  uint8_t heap_array[257];
+  uint8_t bubble_array[257];
+  for (unsigned int i = 0; i < ARRAY_LENGTH(heap_array); i++) {
+    heap_array[i] = (i * 149 + 7) % 251;
+  }
+  memcpy(bubble_array, heap_array, sizeof(heap_array));
+
+  sort_heap(heap_array, ARRAY_LENGTH(heap_array), sizeof(uint8_t), prv_uint8_cmp);
+  sort_bubble(bubble_array, ARRAY_LENGTH(bubble_array), sizeof(uint8_t), prv_uint8_cmp);
+
+  cl_assert_equal_m(heap_array, bubble_array, sizeof(heap_array));
+}
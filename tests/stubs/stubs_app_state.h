@@ -84,6 +84,16 @@ Layer** kernel_applib_get_layer_tree_stack(void) {
   return s_layer_tree_stack;
 }
 
+static LayerTreeDrawState s_layer_tree_draw_state_stack[LAYER_TREE_STACK_SIZE];
+
+LayerTreeDrawState *app_state_get_layer_tree_draw_state_stack(void) {
+  return s_layer_tree_draw_state_stack;
+}
+
+LayerTreeDrawState *kernel_applib_get_layer_tree_draw_state_stack(void) {
+  return s_layer_tree_draw_state_stack;
+}
+
 static WindowStack s_window_stack;
 
 WindowStack *app_state_get_window_stack(void) {
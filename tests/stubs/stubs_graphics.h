@@ -22,6 +22,13 @@ void WEAK graphics_draw_text(GContext* ctx, const char* text, GFont const font,
                              GRect box, const GTextOverflowMode overflow_mode,
                              const GTextAlignment alignment, GTextLayoutCacheRef const layout) {}
 
+void WEAK graphics_draw_text_with_line_cache(GContext *ctx, const char *text, GFont const font,
+                                             const GRect box,
+                                             const GTextOverflowMode overflow_mode,
+                                             const GTextAlignment alignment,
+                                             GTextAttributes *text_attributes,
+                                             TextLayoutLineCache *line_cache) {}
+
 GBitmap *WEAK graphics_capture_frame_buffer(GContext* ctx) { return NULL; }
 
 bool WEAK graphics_release_frame_buffer(GContext* ctx, GBitmap* buffer) { return true; }
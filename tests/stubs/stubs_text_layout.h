@@ -12,6 +12,17 @@ void WEAK graphics_text_layout_cache_init(GTextLayoutCacheRef *layout_cache) {
 }
 
 void WEAK graphics_text_layout_cache_deinit(GTextLayoutCacheRef *layout_cache) {}
+
+void WEAK graphics_text_layout_cache_init_with_line_cache(GTextLayoutCacheRef *layout_cache) {
+  graphics_text_layout_cache_init(layout_cache);
+}
+
+void WEAK graphics_text_layout_cache_deinit_with_line_cache(GTextLayoutCacheRef *layout_cache) {}
+
+TextLayoutLineCache * WEAK graphics_text_layout_get_line_cache(GTextLayoutCacheRef layout_cache) {
+  return NULL;
+}
+
 void WEAK graphics_text_layout_set_line_spacing_delta(GTextLayoutCacheRef layout, int16_t delta) {}
 
 int16_t WEAK graphics_text_layout_get_line_spacing_delta(const GTextLayoutCacheRef layout) {
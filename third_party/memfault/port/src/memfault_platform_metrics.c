@@ -141,6 +141,15 @@ void memfault_metric_set_device_from_pebble_analytics(AnalyticsMetric metric, in
     case ANALYTICS_DEVICE_METRIC_FLASH_ERASE_COUNT:
       MEMFAULT_METRIC_SET_UNSIGNED(ANALYTICS_DEVICE_METRIC_FLASH_ERASE_COUNT, val);
       break;
+    case ANALYTICS_DEVICE_METRIC_FLASH_READ_CACHE_HIT_COUNT:
+      MEMFAULT_METRIC_SET_UNSIGNED(ANALYTICS_DEVICE_METRIC_FLASH_READ_CACHE_HIT_COUNT, val);
+      break;
+    case ANALYTICS_DEVICE_METRIC_FLASH_READ_CACHE_MISS_COUNT:
+      MEMFAULT_METRIC_SET_UNSIGNED(ANALYTICS_DEVICE_METRIC_FLASH_READ_CACHE_MISS_COUNT, val);
+      break;
+    case ANALYTICS_DEVICE_METRIC_FLASH_READ_CACHE_SAVED_BYTES_COUNT:
+      MEMFAULT_METRIC_SET_UNSIGNED(ANALYTICS_DEVICE_METRIC_FLASH_READ_CACHE_SAVED_BYTES_COUNT, val);
+      break;
 
     // Phone Call Handling
     case ANALYTICS_DEVICE_METRIC_PHONE_CALL_INCOMING_COUNT: